@@ -54,6 +54,17 @@ extern "C" {
 #include "m68kconf.h"
 #endif
 
+/* With M68K_USER_CONTEXT, the memory functions and callbacks take the user
+ * context as their first argument
+ */
+#if M68K_USER_CONTEXT
+	#define M68K_USER_PARAM void* user,
+	#define M68K_USER_VOID  void* user
+#else
+	#define M68K_USER_PARAM
+	#define M68K_USER_VOID  void
+#endif /* M68K_USER_CONTEXT */
+
 /* ======================================================================== */
 /* ============================ GENERAL DEFINES =========================== */
 
@@ -90,6 +101,27 @@ extern "C" {
 #define M68K_INT_ACK_SPURIOUS      0xfffffffe
 
 
+/* Access flags for m68k_map_memory() */
+#define M68K_MAP_READ              1
+#define M68K_MAP_WRITE             2
+#define M68K_MAP_RW                (M68K_MAP_READ | M68K_MAP_WRITE)
+
+/* A device in guest memory for m68k_map_region().  Each handler gets device
+ * and the address being accessed.  A NULL handler leaves accesses of that
+ * size and direction to the memory callbacks.
+ */
+typedef struct
+{
+	void* device;
+	unsigned (*read_8)(void* device, unsigned address);
+	unsigned (*read_16)(void* device, unsigned address);
+	unsigned (*read_32)(void* device, unsigned address);
+	void (*write_8)(void* device, unsigned address, unsigned value);
+	void (*write_16)(void* device, unsigned address, unsigned value);
+	void (*write_32)(void* device, unsigned address, unsigned value);
+} m68k_region;
+
+
 /* CPU types for use in m68k_set_cpu_type() */
 enum
 {
@@ -176,18 +208,18 @@ typedef enum
  */
 
 /* Read from anywhere */
-unsigned  m68k_read_memory_8(unsigned address);
-unsigned  m68k_read_memory_16(unsigned address);
-unsigned  m68k_read_memory_32(unsigned address);
+unsigned  m68k_read_memory_8(M68K_USER_PARAM unsigned address);
+unsigned  m68k_read_memory_16(M68K_USER_PARAM unsigned address);
+unsigned  m68k_read_memory_32(M68K_USER_PARAM unsigned address);
 
 /* Read data immediately following the PC */
-unsigned  m68k_read_immediate_16(unsigned address);
-unsigned  m68k_read_immediate_32(unsigned address);
+unsigned  m68k_read_immediate_16(M68K_USER_PARAM unsigned address);
+unsigned  m68k_read_immediate_32(M68K_USER_PARAM unsigned address);
 
 /* Read data relative to the PC */
-unsigned  m68k_read_pcrelative_8(unsigned address);
-unsigned  m68k_read_pcrelative_16(unsigned address);
-unsigned  m68k_read_pcrelative_32(unsigned address);
+unsigned  m68k_read_pcrelative_8(M68K_USER_PARAM unsigned address);
+unsigned  m68k_read_pcrelative_16(M68K_USER_PARAM unsigned address);
+unsigned  m68k_read_pcrelative_32(M68K_USER_PARAM unsigned address);
 
 /* Memory access for the disassembler */
 unsigned m68k_read_disassembler_8  (unsigned address);
@@ -195,9 +227,9 @@ unsigned m68k_read_disassembler_16 (unsigned address);
 unsigned m68k_read_disassembler_32 (unsigned address);
 
 /* Write to anywhere */
-void m68k_write_memory_8(unsigned address, unsigned value);
-void m68k_write_memory_16(unsigned address, unsigned value);
-void m68k_write_memory_32(unsigned address, unsigned value);
+void m68k_write_memory_8(M68K_USER_PARAM unsigned address, unsigned value);
+void m68k_write_memory_16(M68K_USER_PARAM unsigned address, unsigned value);
+void m68k_write_memory_32(M68K_USER_PARAM unsigned address, unsigned value);
 
 /* Special call to simulate undocumented 68k behavior when move.l with a
  * predecrement destination mode is executed.
@@ -206,7 +238,48 @@ void m68k_write_memory_32(unsigned address, unsigned value);
  *
  * Enable this functionality with M68K_SIMULATE_PD_WRITES in m68kconf.h.
  */
-void m68k_write_memory_32_pd(unsigned address, unsigned value);
+void m68k_write_memory_32_pd(M68K_USER_PARAM unsigned address, unsigned value);
+
+/* Read or write count values of size bytes (2 or 4) at consecutive addresses
+ * from address, in ascending address order.  MOVEM, MOVE16 and FMOVEM call
+ * these once for all the registers they move, instead of calling the read or
+ * write function for each one.
+ *
+ * Enable this functionality with M68K_BULK_TRANSFERS in m68kconf.h.
+ */
+void m68k_read_memory_block(M68K_USER_PARAM unsigned address, unsigned size, unsigned count, unsigned* values);
+void m68k_write_memory_block(M68K_USER_PARAM unsigned address, unsigned size, unsigned count, const unsigned* values);
+
+/* Read-modify-write cycle, used by the instructions that read an operand and
+ * write the result back to the same address (TAS, CAS, ADDQ, NOT, BSET, ...).
+ * Read the value at address, pass it to modify(), and if modify() returns
+ * nonzero, write the value it has left in *value back to address.  Doing
+ * both halves here lets the host look the address up once, and carry out
+ * TAS or CAS atomically.  context must be passed to modify() as is.
+ *
+ * Enable this functionality with M68K_RMW_CALLBACKS in m68kconf.h.
+ */
+void m68k_rmw_memory_8(M68K_USER_PARAM unsigned address, int (*modify)(unsigned* value, void* context), void* context);
+void m68k_rmw_memory_16(M68K_USER_PARAM unsigned address, int (*modify)(unsigned* value, void* context), void* context);
+void m68k_rmw_memory_32(M68K_USER_PARAM unsigned address, int (*modify)(unsigned* value, void* context), void* context);
+
+/* The memory functions above, taking the function code of the access
+ * (see ADDRESS SPACES in the readme).  The CPU calls these instead when
+ * M68K_MEMORY_FC is enabled in m68kconf.h, and doesn't call the set fc
+ * callback.  The M68K_SEPARATE_READS functions are unchanged.
+ */
+unsigned m68k_read_memory_8_fc(M68K_USER_PARAM unsigned address, unsigned fc);
+unsigned m68k_read_memory_16_fc(M68K_USER_PARAM unsigned address, unsigned fc);
+unsigned m68k_read_memory_32_fc(M68K_USER_PARAM unsigned address, unsigned fc);
+void m68k_write_memory_8_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value);
+void m68k_write_memory_16_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value);
+void m68k_write_memory_32_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value);
+void m68k_write_memory_32_pd_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value);
+void m68k_read_memory_block_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned size, unsigned count, unsigned* values);
+void m68k_write_memory_block_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned size, unsigned count, const unsigned* values);
+void m68k_rmw_memory_8_fc(M68K_USER_PARAM unsigned address, unsigned fc, int (*modify)(unsigned* value, void* context), void* context);
+void m68k_rmw_memory_16_fc(M68K_USER_PARAM unsigned address, unsigned fc, int (*modify)(unsigned* value, void* context), void* context);
+void m68k_rmw_memory_32_fc(M68K_USER_PARAM unsigned address, unsigned fc, int (*modify)(unsigned* value, void* context), void* context);
 
 
 
@@ -232,7 +305,7 @@ void m68k_write_memory_32_pd(unsigned address, unsigned value);
  * services the interrupt.
  * Default behavior: return M68K_INT_ACK_AUTOVECTOR.
  */
-void m68k_set_int_ack_callback(int  (*callback)(int int_level));
+void m68k_set_int_ack_callback(int  (*callback)(M68K_USER_PARAM int int_level));
 
 
 /* Set the callback for a breakpoint acknowledge (68010+).
@@ -241,7 +314,7 @@ void m68k_set_int_ack_callback(int  (*callback)(int int_level));
  * BKPT instruction for 68020+, or 0 for 68010.
  * Default behavior: do nothing.
  */
-void m68k_set_bkpt_ack_callback(void (*callback)(unsigned data));
+void m68k_set_bkpt_ack_callback(void (*callback)(M68K_USER_PARAM unsigned data));
 
 
 /* Set the callback for the RESET instruction.
@@ -249,7 +322,7 @@ void m68k_set_bkpt_ack_callback(void (*callback)(unsigned data));
  * The CPU calls this callback every time it encounters a RESET instruction.
  * Default behavior: do nothing.
  */
-void m68k_set_reset_instr_callback(void  (*callback)(void));
+void m68k_set_reset_instr_callback(void  (*callback)(M68K_USER_VOID));
 
 
 /* Set the callback for informing of a large PC change.
@@ -258,14 +331,14 @@ void m68k_set_reset_instr_callback(void  (*callback)(void));
  * by a large value (currently set for changes by longwords).
  * Default behavior: do nothing.
  */
-void m68k_set_pc_changed_callback(void  (*callback)(unsigned new_pc));
+void m68k_set_pc_changed_callback(void  (*callback)(M68K_USER_PARAM unsigned new_pc));
 
 /* Set the callback for the TAS instruction.
  * You must enable M68K_TAS_HAS_CALLBACK in m68kconf.h.
  * The CPU calls this callback every time it encounters a TAS instruction.
  * Default behavior: return 1, allow writeback.
  */
-void m68k_set_tas_instr_callback(int  (*callback)(void));
+void m68k_set_tas_instr_callback(int  (*callback)(M68K_USER_VOID));
 
 /* Set the callback for illegal instructions.
  * You must enable M68K_ILLG_HAS_CALLBACK in m68kconf.h.
@@ -273,7 +346,7 @@ void m68k_set_tas_instr_callback(int  (*callback)(void));
  * which must return 1 if it handles the instruction normally or 0 if it's really an illegal instruction.
  * Default behavior: return 0, exception will occur.
  */
-void m68k_set_illg_instr_callback(int  (*callback)(int));
+void m68k_set_illg_instr_callback(int  (*callback)(M68K_USER_PARAM int));
 
 /* Set the callback for CPU function code changes.
  * You must enable M68K_EMULATE_FC in m68kconf.h.
@@ -282,7 +355,7 @@ void m68k_set_illg_instr_callback(int  (*callback)(int));
  * access it is (supervisor/user, program/data and such).
  * Default behavior: do nothing.
  */
-void m68k_set_fc_callback(void  (*callback)(unsigned new_fc));
+void m68k_set_fc_callback(void  (*callback)(M68K_USER_PARAM unsigned new_fc));
 
 
 /* Set a callback for the instruction cycle of the CPU.
@@ -291,7 +364,31 @@ void m68k_set_fc_callback(void  (*callback)(unsigned new_fc));
  * instruction cycle.
  * Default behavior: do nothing.
  */
-void m68k_set_instr_hook_callback(void  (*callback)(unsigned pc));
+void m68k_set_instr_hook_callback(void  (*callback)(M68K_USER_PARAM unsigned pc));
+
+
+/* Set the callback that tells the CPU whether a loop polling an address is
+ * idle.
+ * You must enable M68K_IDLE_SKIP in m68kconf.h.
+ * The CPU calls this callback with the address a btst/tst + bcc loop reads.
+ * Return nonzero if reading it has no side effects and its value can't change
+ * until m68k_execute() returns (or the next event fires, with M68K_EVENTS),
+ * in which case the rest of the timeslice is skipped.
+ * Default behavior: return 0, the loop runs normally.
+ */
+void m68k_set_idle_read_callback(int  (*callback)(M68K_USER_PARAM unsigned address));
+
+
+/* Set the pointer the CPU passes as the first argument to the memory
+ * functions and to every callback above.
+ * You must enable M68K_USER_CONTEXT in m68kconf.h.
+ * It is part of the CPU context, so each context saved with
+ * m68k_get_context() keeps its own.  The M68K_SEPARATE_READS functions get it
+ * too, but not the disassembler's reads.
+ * Default: NULL.
+ */
+void  m68k_set_user_context(void* user);
+void* m68k_get_user_context(void);
 
 
 
@@ -321,6 +418,13 @@ void m68k_pulse_reset(void);
 /* execute num_cycles worth of instructions.  returns number of cycles used */
 int m68k_execute(int num_cycles);
 
+/* execute exactly one instruction (after taking any interrupt that came in).
+ * This needs less setup than m68k_execute(), which makes it cheaper for
+ * running several CPUs in lockstep.  Returns the number of cycles used, or
+ * 0 if the CPU is stopped.
+ */
+int m68k_step(void);
+
 /* These functions let you read/write/modify the number of cycles left to run
  * while m68k_execute() is running.
  * These are useful if the 68k accesses a memory-mapped port on another device
@@ -331,6 +435,35 @@ int m68k_cycles_remaining(void);        /* Number of cycles left */
 void m68k_modify_timeslice(int cycles); /* Modify cycles left */
 void m68k_end_timeslice(void);          /* End timeslice now */
 
+/* Number of clocks skipped over by idle loop detection (M68K_IDLE_SKIP) since
+ * m68k_init().  Always 0 if it is disabled.
+ */
+unsigned long long m68k_get_idle_cycles(void);
+
+/* Number of PMMU translations found in the address translation cache, and
+ * number that had to walk the translation tables, since m68k_init()
+ * (M68K_PMMU_ATC).  Both are always 0 if it is disabled.
+ */
+void m68k_get_atc_stats(unsigned long long* hits, unsigned long long* misses);
+
+/* Timed device events (M68K_EVENTS).
+ * m68k_add_event() returns a handle for an event that calls callback with
+ * that handle, or -1 if M68K_MAX_EVENTS have been added already.
+ * m68k_set_event() arms the event (again) to fire after cycles more clocks
+ * (at least 1), at the end of the instruction running at that time.  Called
+ * from an event callback, it counts from when that event was due, so
+ * periodic events don't drift.  m68k_cancel_event() disarms it.
+ * m68k_execute() runs up to each event in turn, and while the CPU is stopped
+ * it goes straight to the next one.  m68k_step() fires any that came due.
+ * m68k_get_time() is the number of clocks run since m68k_init().
+ * The events and the clock belong to the current CPU context.
+ * m68k_init() removes all events.  These do nothing if M68K_EVENTS is off.
+ */
+int  m68k_add_event(void (*callback)(M68K_USER_PARAM int event));
+void m68k_set_event(int event, int cycles);
+void m68k_cancel_event(int event);
+unsigned long long m68k_get_time(void);
+
 /* Set the IPL0-IPL2 pins on the CPU (IRQ).
  * A transition from < 7 to 7 will cause a non-maskable interrupt (NMI).
  * Setting IRQ to 0 will clear an interrupt request.
@@ -348,10 +481,84 @@ unsigned m68k_get_virq(unsigned level);
 void m68k_pulse_halt(void);
 
 
-/* Trigger a bus error exception */
+/* Trigger a bus error exception.  The data and address registers are put
+ * back the way they were at the start of the instruction that was cut short.
+ * If you call this from outside m68k_execute() or m68k_step(), no instruction
+ * is running and the registers are left as they are.
+ */
 void m68k_pulse_bus_error(void);
 
 
+/* Tell the block cache (M68K_BLOCK_CACHE) that the host has modified memory
+ * behind the CPU's back, e.g. by DMA, bank switching or loading new code.
+ * Writes made by the CPU itself are tracked automatically.
+ * m68k_invalidate_block_cache() also turns off any recompiled code
+ * (M68K_STATIC_CODE) the change overlaps.
+ * These do nothing if neither option is enabled.
+ */
+void m68k_invalidate_block_cache(unsigned address, unsigned size);
+void m68k_flush_block_cache(void);
+
+
+/* Turn translation of hot blocks to host code (M68K_JIT) on or off.
+ * It is on by default, and this does nothing if M68K_JIT is disabled.
+ */
+void m68k_set_jit(int enable);
+
+
+/* Run code recompiled by m68krec (M68K_STATIC_CODE) whenever the PC is in
+ * the size bytes at start.  execute runs the recompiled block at pc and
+ * returns nonzero, or returns 0 if pc isn't the start of a block.
+ * Any write to the range turns the recompiled code off until this is called
+ * again.  Pass a NULL execute to turn it off yourself.
+ */
+void m68k_set_static_code(unsigned start, unsigned size, int (*execute)(unsigned pc));
+
+
+/* Let the CPU access the size bytes at start directly in host memory at host
+ * (M68K_MEMORY_MAP), laid out big-endian like the 68k sees it, or as
+ * host-endian words with M68K_MEMORY_MAP_HOST_ENDIAN.  flags says
+ * which of reads (M68K_MAP_READ) and writes (M68K_MAP_WRITE) bypass the
+ * m68k_read_memory_xx() and m68k_write_memory_xx() callbacks; flags 0
+ * unmaps the range.  start and size must be multiples of the page size
+ * (1 << M68K_MEMORY_MAP_PAGE_SHIFT).  The mapping is shared by all CPU
+ * contexts and survives m68k_init().
+ * Returns 0 (and maps nothing) if the range isn't page aligned or is empty,
+ * or host isn't word aligned with M68K_MEMORY_MAP_HOST_ENDIAN, and always if
+ * M68K_MEMORY_MAP is disabled.
+ */
+int m68k_map_memory(unsigned start, unsigned size, void* host, int flags);
+
+/* Send the CPU's accesses to the size bytes at start to region's handlers
+ * (M68K_MEMORY_REGIONS), unless they are to memory mapped with
+ * m68k_map_memory() for that direction.  Accesses that cross into the next
+ * page and instruction fetches with M68K_SEPARATE_READS still go to the
+ * callbacks.  With the PMMU on, start is a physical address.  A NULL region
+ * unmaps the range.  region must stay valid while it is mapped; like the memory map, the
+ * regions are shared by all CPU contexts and survive m68k_init().
+ * Returns 0 (and maps nothing) if the range isn't page aligned or is empty,
+ * and always if M68K_MEMORY_REGIONS or M68K_MEMORY_MAP is disabled.
+ */
+int m68k_map_region(unsigned start, unsigned size, const m68k_region* region);
+
+/* Fill pages with the numbers (address >> M68K_DIRTY_PAGE_SHIFT) of up to
+ * max pages the CPU has written to since they were last returned, in
+ * ascending order, and return how many it filled in (M68K_DIRTY_PAGES).
+ * The pages returned are marked clean again, so call it until it returns
+ * less than max to get them all.  Writes the host makes itself aren't
+ * tracked.  The bitmap is shared by all CPU contexts.
+ * Always returns 0 if M68K_DIRTY_PAGES is disabled.
+ */
+unsigned m68k_get_dirty_pages(unsigned* pages, unsigned max);
+
+/* Convert size bytes (an even number) of a big-endian memory image at src to
+ * the layout mapped memory is kept in, or back.  This swaps the bytes of each
+ * word if M68K_MEMORY_MAP_HOST_ENDIAN is on and the host is little-endian,
+ * and just copies them otherwise.  dst may be the same as src.
+ */
+void m68k_swap_memory(void* dst, const void* src, unsigned size);
+
+
 /* Context switching to allow multiple CPUs */
 
 /* Get the size of the cpu context in bytes */
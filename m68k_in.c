@@ -54,6 +54,10 @@ must fix:
  *    M68KMAKE_OPCODE_HANDLER_HEADER - header for opcode handler implementation
  *    M68KMAKE_OPCODE_HANDLER_FOOTER - footer for opcode handler implementation
  *    M68KMAKE_OPCODE_HANDLER_BODY   - body section for opcode handler implementation
+ *    M68KMAKE_FUSED_OPCODES         - pairs of opcode handlers to fuse
+ *    M68KMAKE_FLAGLESS_OPCODES      - opcode handlers to make flagless versions of
+ *    M68KMAKE_FLAGS_UNUSED_OPCODES  - opcode handlers that leave the flags alone
+ *    M68KMAKE_THREADED_OPCODES      - opcode handlers to give their own dispatch jump
  *
  * NOTE: M68KMAKE_OPCODE_HANDLER_BODY must be last in the file and
  *       M68KMAKE_TABLE_BODY must be second last in the file.
@@ -112,7 +116,15 @@ M68KMAKE_PROTOTYPE_FOOTER
 /* Build the opcode handler table */
 void m68ki_build_opcode_table(void);
 
-extern void (*m68ki_instruction_jump_table[0x10000])(void); /* opcode handler jump table */
+/* Find the fused handler for a pair of opcode handlers */
+void (*m68ki_find_fused_handler(void (*first)(void), void (*second)(void)))(void);
+
+/* Find the flagless handler for an opcode handler */
+void (*m68ki_find_flagless_handler(void (*handler)(void)))(void);
+
+/* Check if an opcode handler neither uses nor sets N, Z, V and C */
+int m68ki_handler_leaves_flags(void (*handler)(void));
+
 extern unsigned char m68ki_cycles[][0x10000];
 
 
@@ -136,32 +148,64 @@ M68KMAKE_TABLE_HEADER
 
 #define NUM_CPU_TYPES 5
 
+#if M68K_SPECIALIZE_CPU
+void  (*m68ki_handler_sets[M68KI_HANDLER_SETS][0x10000])(void); /* jump table of each handler set */
+void  (**m68ki_instruction_jump_table)(void) = m68ki_handler_sets[0]; /* opcode handler jump table */
+#else
 void  (*m68ki_instruction_jump_table[0x10000])(void); /* opcode handler jump table */
+#endif /* M68K_SPECIALIZE_CPU */
 unsigned char m68ki_cycles[NUM_CPU_TYPES][0x10000]; /* Cycles used by CPU type */
 
 /* This is used to generate the opcode handler jump table */
 typedef struct
 {
+#if M68K_SPECIALIZE_CPU
+	void (*opcode_handler[M68KI_HANDLER_SETS])(void); /* handler function of each set */
+#else
 	void (*opcode_handler)(void);        /* handler function */
+#endif /* M68K_SPECIALIZE_CPU */
 	unsigned      mask;                  /* mask on opcode */
 	unsigned      match;                 /* what to match after masking */
 	unsigned char cycles[NUM_CPU_TYPES]; /* cycles each cpu type takes */
 } opcode_handler_struct;
 
+#if M68K_SPECIALIZE_CPU
+#define M68KI_NO_HANDLER {0}
+#else
+#define M68KI_NO_HANDLER 0
+#endif /* M68K_SPECIALIZE_CPU */
+
 
 /* Opcode handler table */
 static const opcode_handler_struct m68k_opcode_handler_table[] =
 {
-/*   function                      mask    match    000  010  020  040 */
+/*   function                                        mask    match    000  010  020  030  040 */
 
 
 
 XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 M68KMAKE_TABLE_FOOTER
 
-	{0, 0, 0, {0, 0, 0, 0, 0}}
+	{M68KI_NO_HANDLER, 0, 0, {0, 0, 0, 0, 0}}
 };
 
+static const opcode_handler_struct m68k_illegal_opcode_handler =
+	{M68KI_OP_HANDLER(m68k_op_illegal), 0, 0, {0, 0, 0, 0, 0}};
+
+
+/* Put the handler of a table entry into the jump table(s) */
+static void m68ki_set_opcode_handler(int instr, const opcode_handler_struct *ostruct)
+{
+#if M68K_SPECIALIZE_CPU
+	int set;
+
+	for(set = 0; set < M68KI_HANDLER_SETS; set++)
+		m68ki_handler_sets[set][instr] = ostruct->opcode_handler[set];
+#else
+	m68ki_instruction_jump_table[instr] = ostruct->opcode_handler;
+#endif /* M68K_SPECIALIZE_CPU */
+}
+
 
 /* Build the opcode handler jump table */
 void m68ki_build_opcode_table(void)
@@ -176,7 +220,7 @@ void m68ki_build_opcode_table(void)
 	for(i = 0; i < 0x10000; i++)
 	{
 		/* default to illegal */
-		m68ki_instruction_jump_table[i] = m68k_op_illegal;
+		m68ki_set_opcode_handler(i, &m68k_illegal_opcode_handler);
 		for(k=0;k<NUM_CPU_TYPES;k++)
 			m68ki_cycles[k][i] = 0;
 	}
@@ -188,7 +232,7 @@ void m68ki_build_opcode_table(void)
 		{
 			if((i & ostruct->mask) == ostruct->match)
 			{
-				m68ki_instruction_jump_table[i] = ostruct->opcode_handler;
+				m68ki_set_opcode_handler(i, ostruct);
 				for(k=0;k<NUM_CPU_TYPES;k++)
 					m68ki_cycles[k][i] = ostruct->cycles[k];
 			}
@@ -199,7 +243,7 @@ void m68ki_build_opcode_table(void)
 	{
 		for(i = 0;i <= 0xff;i++)
 		{
-			m68ki_instruction_jump_table[ostruct->match | i] = ostruct->opcode_handler;
+			m68ki_set_opcode_handler(ostruct->match | i, ostruct);
 			for(k=0;k<NUM_CPU_TYPES;k++)
 				m68ki_cycles[k][ostruct->match | i] = ostruct->cycles[k];
 		}
@@ -212,7 +256,7 @@ void m68ki_build_opcode_table(void)
 			for(j = 0;j < 8;j++)
 			{
 				instr = ostruct->match | (i << 9) | j;
-				m68ki_instruction_jump_table[instr] = ostruct->opcode_handler;
+				m68ki_set_opcode_handler(instr, ostruct);
 				for(k=0;k<NUM_CPU_TYPES;k++)
 					m68ki_cycles[k][instr] = ostruct->cycles[k];
 				// For all shift operations with known shift distance (encoded in instruction word)
@@ -234,7 +278,7 @@ void m68ki_build_opcode_table(void)
 	{
 		for(i = 0;i <= 0x0f;i++)
 		{
-			m68ki_instruction_jump_table[ostruct->match | i] = ostruct->opcode_handler;
+			m68ki_set_opcode_handler(ostruct->match | i, ostruct);
 			for(k=0;k<NUM_CPU_TYPES;k++)
 				m68ki_cycles[k][ostruct->match | i] = ostruct->cycles[k];
 		}
@@ -244,7 +288,7 @@ void m68ki_build_opcode_table(void)
 	{
 		for(i = 0;i <= 0x07;i++)
 		{
-			m68ki_instruction_jump_table[ostruct->match | (i << 9)] = ostruct->opcode_handler;
+			m68ki_set_opcode_handler(ostruct->match | (i << 9), ostruct);
 			for(k=0;k<NUM_CPU_TYPES;k++)
 				m68ki_cycles[k][ostruct->match | (i << 9)] = ostruct->cycles[k];
 		}
@@ -254,7 +298,7 @@ void m68ki_build_opcode_table(void)
 	{
 		for(i = 0;i <= 0x07;i++)
 		{
-			m68ki_instruction_jump_table[ostruct->match | i] = ostruct->opcode_handler;
+			m68ki_set_opcode_handler(ostruct->match | i, ostruct);
 			for(k=0;k<NUM_CPU_TYPES;k++)
 				m68ki_cycles[k][ostruct->match | i] = ostruct->cycles[k];
 		}
@@ -262,7 +306,7 @@ void m68ki_build_opcode_table(void)
 	}
 	while(ostruct->mask == 0xffff)
 	{
-		m68ki_instruction_jump_table[ostruct->match] = ostruct->opcode_handler;
+		m68ki_set_opcode_handler(ostruct->match, ostruct);
 		for(k=0;k<NUM_CPU_TYPES;k++)
 			m68ki_cycles[k][ostruct->match] = ostruct->cycles[k];
 		ostruct++;
@@ -270,6 +314,86 @@ void m68ki_build_opcode_table(void)
 }
 
 
+/* Find the fused handler for a pair of opcode handlers, or NULL if they
+ * weren't listed in the M68KMAKE_FUSED_OPCODES section.
+ */
+void (*m68ki_find_fused_handler(void (*first)(void), void (*second)(void)))(void)
+{
+#if M68K_FUSED_OPCODES
+	const m68ki_fused_handler_struct *fstruct;
+#if M68K_SPECIALIZE_CPU
+	int set;
+
+	for(fstruct = m68ki_fused_handler_table; fstruct->first[0]; fstruct++)
+		for(set = 0; set < M68KI_HANDLER_SETS; set++)
+			if(fstruct->first[set] == first && fstruct->second[set] == second)
+				return fstruct->fused[set];
+#else
+	for(fstruct = m68ki_fused_handler_table; fstruct->first; fstruct++)
+		if(fstruct->first == first && fstruct->second == second)
+			return fstruct->fused;
+#endif /* M68K_SPECIALIZE_CPU */
+#else
+	(void)first;
+	(void)second;
+#endif /* M68K_FUSED_OPCODES */
+	return NULL;
+}
+
+
+/* Find the flagless handler for an opcode handler, or NULL if it wasn't
+ * listed in the M68KMAKE_FLAGLESS_OPCODES section.
+ */
+void (*m68ki_find_flagless_handler(void (*handler)(void)))(void)
+{
+#if M68K_FLAGLESS_OPCODES
+	const m68ki_flagless_handler_struct *fstruct;
+#if M68K_SPECIALIZE_CPU
+	int set;
+
+	for(fstruct = m68ki_flagless_handler_table; fstruct->handler[0]; fstruct++)
+		for(set = 0; set < M68KI_HANDLER_SETS; set++)
+			if(fstruct->handler[set] == handler)
+				return fstruct->flagless[set];
+#else
+	for(fstruct = m68ki_flagless_handler_table; fstruct->handler; fstruct++)
+		if(fstruct->handler == handler)
+			return fstruct->flagless;
+#endif /* M68K_SPECIALIZE_CPU */
+#else
+	(void)handler;
+#endif /* M68K_FLAGLESS_OPCODES */
+	return NULL;
+}
+
+/* Returns nonzero if an opcode handler was listed in the
+ * M68KMAKE_FLAGS_UNUSED_OPCODES section.
+ */
+int m68ki_handler_leaves_flags(void (*handler)(void))
+{
+#if M68K_FLAGLESS_OPCODES
+	const m68ki_flags_unused_handler_struct *ustruct;
+#if M68K_SPECIALIZE_CPU
+	int set;
+
+	for(ustruct = m68ki_flags_unused_handler_table; ustruct->handler[0]; ustruct++)
+		for(set = 0; set < M68KI_HANDLER_SETS; set++)
+			if(ustruct->handler[set] == handler)
+				return 1;
+#else
+	for(ustruct = m68ki_flags_unused_handler_table; ustruct->handler; ustruct++)
+		if(ustruct->handler == handler)
+			return 1;
+#endif /* M68K_SPECIALIZE_CPU */
+#else
+	(void)handler;
+#endif /* M68K_FLAGLESS_OPCODES */
+	return 0;
+}
+
+#endif /* M68KI_HANDLER_SET */
+
+
 /* ======================================================================== */
 /* ============================== END OF FILE ============================= */
 /* ======================================================================== */
@@ -279,11 +403,62 @@ void m68ki_build_opcode_table(void)
 XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 M68KMAKE_OPCODE_HANDLER_HEADER
 
+#ifndef M68KI_HANDLER_SET
 #include <stdio.h>
 #include "m68kcpu.h"
 extern void m68040_fpu_op0(void);
 extern void m68040_fpu_op1(void);
 extern void m68881_mmu_ops(void);
+extern void m68040_ptest(unsigned address, int write);
+
+#if M68K_THREADED_DISPATCH
+/* A hot opcode handler, and its label in m68ki_threaded_execute() */
+typedef struct
+{
+	void (*handler)(void);
+	const void* label;
+} m68ki_threaded_label_struct;
+#endif /* M68K_THREADED_DISPATCH */
+
+#if M68K_SPECIALIZE_CPU
+/* Compile the handlers once for each handler set (see m68kcpu.h) */
+#undef CPU_TYPE
+#undef CYC_BCC_NOTAKE_B
+#undef CYC_BCC_NOTAKE_W
+#undef CYC_DBCC_F_NOEXP
+#undef CYC_DBCC_F_EXP
+#undef CYC_SCC_R_TRUE
+#undef CYC_MOVEM_W
+#undef CYC_MOVEM_L
+#undef CYC_SHIFT
+#undef CYC_RESET
+#define CPU_TYPE         M68KI_SET_CPU_TYPE
+#define CYC_BCC_NOTAKE_B M68KI_SET_CYC_BCC_NOTAKE_B
+#define CYC_BCC_NOTAKE_W M68KI_SET_CYC_BCC_NOTAKE_W
+#define CYC_DBCC_F_NOEXP M68KI_SET_CYC_DBCC_F_NOEXP
+#define CYC_DBCC_F_EXP   M68KI_SET_CYC_DBCC_F_EXP
+#define CYC_SCC_R_TRUE   M68KI_SET_CYC_SCC_R_TRUE
+#define CYC_MOVEM_W      M68KI_SET_CYC_MOVEM_W
+#define CYC_MOVEM_L      M68KI_SET_CYC_MOVEM_L
+#define CYC_SHIFT        M68KI_SET_CYC_SHIFT
+#define CYC_RESET        M68KI_SET_CYC_RESET
+
+#define M68KI_HANDLER_SET 0
+#include "m68kops.c"
+#undef M68KI_HANDLER_SET
+#define M68KI_HANDLER_SET 1
+#include "m68kops.c"
+#undef M68KI_HANDLER_SET
+#define M68KI_HANDLER_SET 2
+#include "m68kops.c"
+#undef M68KI_HANDLER_SET
+#define M68KI_HANDLER_SET 3
+#include "m68kops.c"
+#undef M68KI_HANDLER_SET
+#endif /* M68K_SPECIALIZE_CPU */
+#endif /* M68KI_HANDLER_SET */
+
+#if !M68K_SPECIALIZE_CPU || defined(M68KI_HANDLER_SET)
 
 /* ======================================================================== */
 /* ========================= INSTRUCTION HANDLERS ========================= */
@@ -294,10 +469,227 @@ extern void m68881_mmu_ops(void);
 XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 M68KMAKE_OPCODE_HANDLER_FOOTER
 
-/* ======================================================================== */
-/* ============================== END OF FILE ============================= */
-/* ======================================================================== */
+#endif /* !M68K_SPECIALIZE_CPU || M68KI_HANDLER_SET */
+
+#ifndef M68KI_HANDLER_SET
+
+#if M68K_FUSED_OPCODES
+/* This is used to look up the fused handler of a pair of opcode handlers */
+typedef struct
+{
+#if M68K_SPECIALIZE_CPU
+	void (*first[M68KI_HANDLER_SETS])(void);  /* handler of the first instruction */
+	void (*second[M68KI_HANDLER_SETS])(void); /* handler of the instruction after it */
+	void (*fused[M68KI_HANDLER_SETS])(void);  /* handler that runs them both */
+#else
+	void (*first)(void);                      /* handler of the first instruction */
+	void (*second)(void);                     /* handler of the instruction after it */
+	void (*fused)(void);                      /* handler that runs them both */
+#endif /* M68K_SPECIALIZE_CPU */
+} m68ki_fused_handler_struct;
+
+#if M68K_SPECIALIZE_CPU
+#define M68KI_NO_FUSED_HANDLER {0}
+#else
+#define M68KI_NO_FUSED_HANDLER 0
+#endif /* M68K_SPECIALIZE_CPU */
+#endif /* M68K_FUSED_OPCODES */
+
+#if M68K_FLAGLESS_OPCODES
+/* This is used to look up the flagless handler of an opcode handler */
+typedef struct
+{
+#if M68K_SPECIALIZE_CPU
+	void (*handler[M68KI_HANDLER_SETS])(void);  /* opcode handler */
+	void (*flagless[M68KI_HANDLER_SETS])(void); /* the same without setting N, Z, V and C */
+#else
+	void (*handler)(void);                      /* opcode handler */
+	void (*flagless)(void);                     /* the same without setting N, Z, V and C */
+#endif /* M68K_SPECIALIZE_CPU */
+} m68ki_flagless_handler_struct;
+
+/* This is used to look up opcode handlers that leave the flags alone */
+typedef struct
+{
+#if M68K_SPECIALIZE_CPU
+	void (*handler[M68KI_HANDLER_SETS])(void);  /* opcode handler */
+#else
+	void (*handler)(void);                      /* opcode handler */
+#endif /* M68K_SPECIALIZE_CPU */
+} m68ki_flags_unused_handler_struct;
+
+#if M68K_SPECIALIZE_CPU
+#define M68KI_NO_FLAGLESS_HANDLER {0}
+#else
+#define M68KI_NO_FLAGLESS_HANDLER 0
+#endif /* M68K_SPECIALIZE_CPU */
+#endif /* M68K_FLAGLESS_OPCODES */
+
+
+
+
+XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+M68KMAKE_FUSED_OPCODES
+
+Pairs of opcode handlers that m68kmake generates fused handlers for, which
+the block cache uses when M68K_FUSED_OPCODES is on.  Each line names the
+handler of an instruction and the handler of the instruction following it,
+without the "m68k_op_" prefix.  The first instruction can't be one that is
+only allowed in supervisor mode.
+
+m68kmake will use a file with the same kind of lines instead if it is given
+as its third argument.
+
+M68KMAKE_FUSED_OPCODES_START
+
+move_32_pi_pi    dbf_16
+move_16_pi_pi    dbf_16
+move_8_pi_pi     dbf_16
+
+cmp_32_d         beq_8
+cmp_32_d         bne_8
+cmp_32_d         bhi_8
+cmp_32_d         bls_8
+cmp_32_d         bcc_8
+cmp_32_d         bcs_8
+cmp_32_d         bge_8
+cmp_32_d         blt_8
+cmp_32_d         bgt_8
+cmp_32_d         ble_8
+cmp_16_d         beq_8
+cmp_16_d         bne_8
+cmp_8_d          beq_8
+cmp_8_d          bne_8
+cmpi_32_d        beq_8
+cmpi_32_d        bne_8
+cmpi_16_d        beq_8
+cmpi_16_d        bne_8
+cmpi_8_d         beq_8
+cmpi_8_d         bne_8
+
+tst_32_d         beq_8
+tst_32_d         bne_8
+tst_32_d         bmi_8
+tst_32_d         bpl_8
+tst_16_d         beq_8
+tst_16_d         bne_8
+tst_8_d          beq_8
+tst_8_d          bne_8
+
+subq_32_d        bne_8
+subq_16_d        bne_8
+subq_8_d         bne_8
+
+
+XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+M68KMAKE_FLAGLESS_OPCODES
+
+Opcode handlers that m68kmake generates flagless versions of, which the block
+cache uses when M68K_FLAGLESS_OPCODES is on.  Every handler listed must set
+N, Z, V and C only through m68ki_set_logic_flags_*, m68ki_set_add_flags_*,
+m68ki_set_sub_flags_* or m68ki_set_cmp_flags_*, and must not otherwise use
+the flags.  It also must not access memory, so that it can't take a bus or
+address error before it sets the flags.  Any number of names can be given on
+a line, without the "m68k_op_" prefix.
+
+M68KMAKE_FLAGLESS_OPCODES_START
+
+move_32_d_d      move_16_d_d      move_8_d_d
+move_32_d_i      move_16_d_i      move_8_d_i
+moveq_32
+
+add_32_er_d      add_16_er_d      add_8_er_d       add_32_er_i
+addq_32_d        addq_16_d        addq_8_d
+addi_32_d        addi_16_d        addi_8_d
+sub_32_er_d      sub_16_er_d      sub_8_er_d       sub_32_er_i
+subq_32_d        subq_16_d        subq_8_d
+subi_32_d        subi_16_d        subi_8_d
+
+and_32_er_d      and_16_er_d      and_8_er_d       and_32_er_i
+andi_32_d        andi_16_d        andi_8_d
+or_32_er_d       or_16_er_d       or_8_er_d        or_32_er_i
+ori_32_d         ori_16_d         ori_8_d
+eor_32_d         eor_16_d         eor_8_d
+eori_32_d        eori_16_d        eori_8_d
+not_32_d         not_16_d         not_8_d
+clr_32_d         clr_16_d         clr_8_d
+
+tst_32_d         tst_16_d         tst_8_d
+cmp_32_d         cmp_16_d         cmp_8_d          cmp_32_i
+cmpi_32_d        cmpi_16_d        cmpi_8_d
+
+
+XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+M68KMAKE_FLAGS_UNUSED_OPCODES
+
+Opcode handlers that neither use nor set N, Z, V and C, which the block cache
+looks past when M68K_FLAGLESS_OPCODES is on to find the instruction that sets
+the flags again.  Every handler listed must work on registers and immediate
+operands only, so that it can't take an exception, and must always take the
+clocks in the cycle table.  m68kmake checks the bodies for this.  Any number
+of names can be given on a line, without the "m68k_op_" prefix.
 
+M68KMAKE_FLAGS_UNUSED_OPCODES_START
+
+movea_32_d       movea_32_a       movea_16_d       movea_16_a       movea_32_i       movea_16_i
+lea_32_ai        lea_32_di        lea_32_aw        lea_32_al        lea_32_pcdi
+adda_32_d        adda_32_a        adda_16_d        adda_16_a        adda_32_i
+suba_32_d        suba_32_a        suba_16_d        suba_16_a
+addq_32_a        addq_16_a        subq_32_a        subq_16_a
+exg_32_dd        exg_32_aa        exg_32_da
+
+
+XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+M68KMAKE_THREADED_OPCODES
+
+Opcode handlers that get a dispatch jump of their own in the threaded
+dispatcher, which m68k_execute() uses when M68K_THREADED_DISPATCH is on.  All
+other opcodes share a single jump through the opcode handler table.  Any
+number of names can be given on a line, without the "m68k_op_" prefix.
+
+M68KMAKE_THREADED_OPCODES_START
+
+moveq_32
+move_32_d_d      move_32_d_a      move_32_d_ai     move_32_d_pi     move_32_d_di     move_32_d_i
+move_32_ai_d     move_32_pi_d     move_32_pd_d     move_32_di_d     move_32_pi_pi    move_32_ai_ai
+move_16_d_d      move_16_d_ai     move_16_d_pi     move_16_d_di     move_16_d_i
+move_16_ai_d     move_16_pi_d     move_16_pd_d     move_16_di_d     move_16_pi_pi
+move_8_d_d       move_8_d_ai      move_8_d_pi      move_8_d_di      move_8_d_i
+move_8_ai_d      move_8_pi_d      move_8_pd_d      move_8_di_d      move_8_pi_pi
+movea_32_d       movea_32_a       movea_32_ai      movea_32_pi      movea_32_di      movea_32_i
+movea_16_i
+lea_32_ai        lea_32_di        lea_32_aw        lea_32_al        lea_32_pcdi
+movem_32_re_pd   movem_32_er_pi
+
+add_32_er_d      add_16_er_d      add_8_er_d       add_32_er_ai     add_32_er_pi     add_32_er_i
+adda_32_d        adda_32_a        adda_16_i        adda_32_i
+addq_32_d        addq_16_d        addq_8_d         addq_32_a        addq_16_a
+sub_32_er_d      sub_16_er_d      sub_8_er_d       sub_32_er_ai     sub_32_er_pi     sub_32_er_i
+suba_32_d        suba_32_a
+subq_32_d        subq_16_d        subq_8_d         subq_32_a        subq_16_a
+
+and_32_er_d      and_16_er_d      and_8_er_d       and_32_er_i      and_16_er_i
+or_32_er_d       or_16_er_d       or_8_er_d        or_32_er_i
+eor_32_d         eor_16_d         eor_8_d
+clr_32_d         clr_16_d         clr_8_d
+ext_32           ext_16           swap_32
+lsl_32_s         lsr_32_s         asl_32_s         asr_32_s         lsl_16_s         lsr_16_s
+btst_32_s_d      btst_32_r_d
+
+tst_32_d         tst_16_d         tst_8_d          tst_32_a         tst_8_ai         tst_8_pi
+cmp_32_d         cmp_16_d         cmp_8_d          cmp_32_i         cmp_16_i         cmp_8_i
+cmp_32_ai        cmp_32_pi        cmp_16_pi        cmp_8_pi
+cmpa_32_d        cmpa_32_a        cmpa_32_i
+cmpi_32_d        cmpi_16_d        cmpi_8_d
+
+bra_8            bra_16
+beq_8            bne_8            bhi_8            bls_8            bcc_8            bcs_8
+bge_8            blt_8            bgt_8            ble_8            bpl_8            bmi_8
+beq_16           bne_16
+dbf_16
+bsr_8            bsr_16           jsr_32_aw        jsr_32_al        jsr_32_di        jsr_32_pcdi
+jmp_32_aw        jmp_32_al        jmp_32_ix        jmp_32_pcdi
+rts_32
 
 
 XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
@@ -770,7 +1162,12 @@ pack      16  mm    axy7  1000111101001111  ..........  . . U U U   .   .  13  1
 pack      16  mm    .     1000...101001...  ..........  . . U U U   .   .  13  13  13
 pea       32  .     .     0100100001......  A..DXWLdx.  U U U U U   6   6   5   5   5
 pflush    32  .     .     1111010100011000  ..........  . . . . S   .   .   .   .   4   TODO: correct timing
+pflush    32  an    .     1111010100010000  ..........  . . . . S   .   .   .   .   4   TODO: correct timing
+pflush    32  ea    .     1111010100001...  ..........  . . . . S   .   .   .   .   4   TODO: correct timing
+pflush    32  ean   .     1111010100000...  ..........  . . . . S   .   .   .   .   4   TODO: correct timing
 pmmu      32  .     .     1111000.........  ..........  . . S S S   .   .   8   8   8
+ptest     32  r     .     1111010101101...  ..........  . . . . S   .   .   .   .   8   TODO: correct timing
+ptest     32  w     .     1111010101001...  ..........  . . . . S   .   .   .   .   8   TODO: correct timing
 reset      0  .     .     0100111001110000  ..........  S S S S S   0   0   0   0   0
 ror        8  s     .     1110...000011...  ..........  U U U U U   6   6   8   8   8
 ror       16  s     .     1110...001011...  ..........  U U U U U   6   6   8   8   8
@@ -1073,12 +1470,9 @@ M68KMAKE_OP(add, 8, er, d)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
+	m68ki_set_add_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -1089,12 +1483,9 @@ M68KMAKE_OP(add, 8, er, .)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
+	m68ki_set_add_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -1105,12 +1496,9 @@ M68KMAKE_OP(add, 16, er, d)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_add_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -1121,12 +1509,9 @@ M68KMAKE_OP(add, 16, er, a)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_add_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -1137,12 +1522,9 @@ M68KMAKE_OP(add, 16, er, .)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_add_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -1153,12 +1535,9 @@ M68KMAKE_OP(add, 32, er, d)
 	unsigned dst = *r_dst;
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_add_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -1169,12 +1548,9 @@ M68KMAKE_OP(add, 32, er, a)
 	unsigned dst = *r_dst;
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_add_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -1185,12 +1561,9 @@ M68KMAKE_OP(add, 32, er, .)
 	unsigned dst = *r_dst;
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_add_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -1198,15 +1571,10 @@ M68KMAKE_OP(add, 8, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
 	unsigned src = MASK_OUT_ABOVE_8(DX);
-	unsigned dst = m68ki_read_8(ea);
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-
-	m68ki_write_8(ea, FLAG_Z);
+	m68ki_set_add_flags_8(src, dst, res);
 }
 
 
@@ -1214,15 +1582,10 @@ M68KMAKE_OP(add, 16, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
 	unsigned src = MASK_OUT_ABOVE_16(DX);
-	unsigned dst = m68ki_read_16(ea);
+	unsigned dst = m68ki_rmw_16(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-
-	m68ki_write_16(ea, FLAG_Z);
+	m68ki_set_add_flags_16(src, dst, res);
 }
 
 
@@ -1230,15 +1593,10 @@ M68KMAKE_OP(add, 32, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
 	unsigned src = DX;
-	unsigned dst = m68ki_read_32(ea);
+	unsigned dst = m68ki_rmw_32(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-
-	m68ki_write_32(ea, FLAG_Z);
+	m68ki_set_add_flags_32(src, dst, res);
 }
 
 
@@ -1299,12 +1657,9 @@ M68KMAKE_OP(addi, 8, ., d)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
+	m68ki_set_add_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -1312,15 +1667,10 @@ M68KMAKE_OP(addi, 8, ., .)
 {
 	unsigned src = OPER_I_8();
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned dst = m68ki_read_8(ea);
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-
-	m68ki_write_8(ea, FLAG_Z);
+	m68ki_set_add_flags_8(src, dst, res);
 }
 
 
@@ -1331,12 +1681,9 @@ M68KMAKE_OP(addi, 16, ., d)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_add_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -1344,15 +1691,10 @@ M68KMAKE_OP(addi, 16, ., .)
 {
 	unsigned src = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned dst = m68ki_read_16(ea);
+	unsigned dst = m68ki_rmw_16(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-
-	m68ki_write_16(ea, FLAG_Z);
+	m68ki_set_add_flags_16(src, dst, res);
 }
 
 
@@ -1363,12 +1705,9 @@ M68KMAKE_OP(addi, 32, ., d)
 	unsigned dst = *r_dst;
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_add_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -1376,15 +1715,10 @@ M68KMAKE_OP(addi, 32, ., .)
 {
 	unsigned src = OPER_I_32();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned dst = m68ki_read_32(ea);
+	unsigned dst = m68ki_rmw_32(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-
-	m68ki_write_32(ea, FLAG_Z);
+	m68ki_set_add_flags_32(src, dst, res);
 }
 
 
@@ -1395,12 +1729,9 @@ M68KMAKE_OP(addq, 8, ., d)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
+	m68ki_set_add_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -1408,15 +1739,10 @@ M68KMAKE_OP(addq, 8, ., .)
 {
 	unsigned src = (((REG_IR >> 9) - 1) & 7) + 1;
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned dst = m68ki_read_8(ea);
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_V = VFLAG_ADD_8(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-
-	m68ki_write_8(ea, FLAG_Z);
+	m68ki_set_add_flags_8(src, dst, res);
 }
 
 
@@ -1427,12 +1753,9 @@ M68KMAKE_OP(addq, 16, ., d)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_add_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -1448,15 +1771,10 @@ M68KMAKE_OP(addq, 16, ., .)
 {
 	unsigned src = (((REG_IR >> 9) - 1) & 7) + 1;
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned dst = m68ki_read_16(ea);
+	unsigned dst = m68ki_rmw_16(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_V = VFLAG_ADD_16(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-
-	m68ki_write_16(ea, FLAG_Z);
+	m68ki_set_add_flags_16(src, dst, res);
 }
 
 
@@ -1467,12 +1785,9 @@ M68KMAKE_OP(addq, 32, ., d)
 	unsigned dst = *r_dst;
 	unsigned res = src + dst;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_add_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -1488,16 +1803,11 @@ M68KMAKE_OP(addq, 32, ., .)
 {
 	unsigned src = (((REG_IR >> 9) - 1) & 7) + 1;
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned dst = m68ki_read_32(ea);
+	unsigned dst = m68ki_rmw_32(ea, M68KI_RMW_ADD, src);
 	unsigned res = src + dst;
 
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_ADD_32(src, dst, res);
-	FLAG_X = FLAG_C = CFLAG_ADD_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-
-	m68ki_write_32(ea, FLAG_Z);
+	m68ki_set_add_flags_32(src, dst, res);
 }
 
 
@@ -1665,113 +1975,90 @@ M68KMAKE_OP(addx, 32, mm, .)
 
 M68KMAKE_OP(and, 8, er, d)
 {
-	FLAG_Z = MASK_OUT_ABOVE_8(DX &= (DY | 0xffffff00));
+	unsigned res = MASK_OUT_ABOVE_8(DX &= (DY | 0xffffff00));
 
-	FLAG_N = NFLAG_8(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
 M68KMAKE_OP(and, 8, er, .)
 {
-	FLAG_Z = MASK_OUT_ABOVE_8(DX &= (M68KMAKE_GET_OPER_AY_8 | 0xffffff00));
+	unsigned res = MASK_OUT_ABOVE_8(DX &= (M68KMAKE_GET_OPER_AY_8 | 0xffffff00));
 
-	FLAG_N = NFLAG_8(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
 M68KMAKE_OP(and, 16, er, d)
 {
-	FLAG_Z = MASK_OUT_ABOVE_16(DX &= (DY | 0xffff0000));
+	unsigned res = MASK_OUT_ABOVE_16(DX &= (DY | 0xffff0000));
 
-	FLAG_N = NFLAG_16(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
 M68KMAKE_OP(and, 16, er, .)
 {
-	FLAG_Z = MASK_OUT_ABOVE_16(DX &= (M68KMAKE_GET_OPER_AY_16 | 0xffff0000));
+	unsigned res = MASK_OUT_ABOVE_16(DX &= (M68KMAKE_GET_OPER_AY_16 | 0xffff0000));
 
-	FLAG_N = NFLAG_16(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
 M68KMAKE_OP(and, 32, er, d)
 {
-	FLAG_Z = DX &= DY;
+	unsigned res = DX &= DY;
 
-	FLAG_N = NFLAG_32(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
 M68KMAKE_OP(and, 32, er, .)
 {
-	FLAG_Z = DX &= M68KMAKE_GET_OPER_AY_32;
+	unsigned res = DX &= M68KMAKE_GET_OPER_AY_32;
 
-	FLAG_N = NFLAG_32(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
 M68KMAKE_OP(and, 8, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = DX & m68ki_read_8(ea);
+	unsigned res = DX & m68ki_rmw_8(ea, M68KI_RMW_AND, DX);
 
 	FLAG_N = NFLAG_8(res);
 	FLAG_C = CFLAG_CLEAR;
 	FLAG_V = VFLAG_CLEAR;
 	FLAG_Z = MASK_OUT_ABOVE_8(res);
-
-	m68ki_write_8(ea, FLAG_Z);
 }
 
 
 M68KMAKE_OP(and, 16, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = DX & m68ki_read_16(ea);
+	unsigned res = DX & m68ki_rmw_16(ea, M68KI_RMW_AND, DX);
 
 	FLAG_N = NFLAG_16(res);
 	FLAG_C = CFLAG_CLEAR;
 	FLAG_V = VFLAG_CLEAR;
 	FLAG_Z = MASK_OUT_ABOVE_16(res);
-
-	m68ki_write_16(ea, FLAG_Z);
 }
 
 
 M68KMAKE_OP(and, 32, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = DX & m68ki_read_32(ea);
-
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	unsigned res = DX & m68ki_rmw_32(ea, M68KI_RMW_AND, DX);
 
-	m68ki_write_32(ea, res);
+	m68ki_set_logic_flags_32(res);
 }
 
 
 M68KMAKE_OP(andi, 8, ., d)
 {
-	FLAG_Z = MASK_OUT_ABOVE_8(DY &= (OPER_I_8() | 0xffffff00));
+	unsigned res = MASK_OUT_ABOVE_8(DY &= (OPER_I_8() | 0xffffff00));
 
-	FLAG_N = NFLAG_8(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -1779,24 +2066,17 @@ M68KMAKE_OP(andi, 8, ., .)
 {
 	unsigned src = OPER_I_8();
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = src & m68ki_read_8(ea);
-
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	unsigned res = src & m68ki_rmw_8(ea, M68KI_RMW_AND, src);
 
-	m68ki_write_8(ea, res);
+	m68ki_set_logic_flags_8(res);
 }
 
 
 M68KMAKE_OP(andi, 16, ., d)
 {
-	FLAG_Z = MASK_OUT_ABOVE_16(DY &= (OPER_I_16() | 0xffff0000));
+	unsigned res = MASK_OUT_ABOVE_16(DY &= (OPER_I_16() | 0xffff0000));
 
-	FLAG_N = NFLAG_16(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -1804,24 +2084,17 @@ M68KMAKE_OP(andi, 16, ., .)
 {
 	unsigned src = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = src & m68ki_read_16(ea);
-
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	unsigned res = src & m68ki_rmw_16(ea, M68KI_RMW_AND, src);
 
-	m68ki_write_16(ea, res);
+	m68ki_set_logic_flags_16(res);
 }
 
 
 M68KMAKE_OP(andi, 32, ., d)
 {
-	FLAG_Z = DY &= (OPER_I_32());
+	unsigned res = DY &= (OPER_I_32());
 
-	FLAG_N = NFLAG_32(FLAG_Z);
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -1829,14 +2102,9 @@ M68KMAKE_OP(andi, 32, ., .)
 {
 	unsigned src = OPER_I_32();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = src & m68ki_read_32(ea);
-
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	unsigned res = src & m68ki_rmw_32(ea, M68KI_RMW_AND, src);
 
-	m68ki_write_32(ea, res);
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -1970,10 +2238,7 @@ M68KMAKE_OP(asr, 8, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_8(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(src);
 }
 
 
@@ -2022,10 +2287,7 @@ M68KMAKE_OP(asr, 16, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_16(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(src);
 }
 
 
@@ -2074,10 +2336,7 @@ M68KMAKE_OP(asr, 32, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_32(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(src);
 }
 
 
@@ -2189,10 +2448,7 @@ M68KMAKE_OP(asl, 8, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_8(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(src);
 }
 
 
@@ -2226,10 +2482,7 @@ M68KMAKE_OP(asl, 16, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_16(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(src);
 }
 
 
@@ -2263,10 +2516,7 @@ M68KMAKE_OP(asl, 32, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_32(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(src);
 }
 
 
@@ -2292,6 +2542,7 @@ M68KMAKE_OP(bcc, 8, ., .)
 	{
 		m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
 		m68ki_branch_8(MASK_OUT_ABOVE_8(REG_IR));
+		m68ki_idle_bcc();			   /* auto-disable (see m68kcpu.h) */
 		return;
 	}
 	USE_CYCLES(CYC_BCC_NOTAKE_B);
@@ -2306,6 +2557,7 @@ M68KMAKE_OP(bcc, 16, ., .)
 		REG_PC -= 2;
 		m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
 		m68ki_branch_16(offset);
+		m68ki_idle_bcc();			   /* auto-disable (see m68kcpu.h) */
 		return;
 	}
 	REG_PC += 2;
@@ -2354,11 +2606,10 @@ M68KMAKE_OP(bchg, 32, r, d)
 M68KMAKE_OP(bchg, 8, r, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
 	unsigned mask = 1 << (DX & 7);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_EOR, mask);
 
 	FLAG_Z = src & mask;
-	m68ki_write_8(ea, src ^ mask);
 }
 
 
@@ -2376,10 +2627,9 @@ M68KMAKE_OP(bchg, 8, s, .)
 {
 	unsigned mask = 1 << (OPER_I_8() & 7);
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_EOR, mask);
 
 	FLAG_Z = src & mask;
-	m68ki_write_8(ea, src ^ mask);
 }
 
 
@@ -2396,11 +2646,10 @@ M68KMAKE_OP(bclr, 32, r, d)
 M68KMAKE_OP(bclr, 8, r, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
 	unsigned mask = 1 << (DX & 7);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_AND, ~mask);
 
 	FLAG_Z = src & mask;
-	m68ki_write_8(ea, src & ~mask);
 }
 
 
@@ -2418,10 +2667,9 @@ M68KMAKE_OP(bclr, 8, s, .)
 {
 	unsigned mask = 1 << (OPER_I_8() & 7);
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_AND, ~mask);
 
 	FLAG_Z = src & mask;
-	m68ki_write_8(ea, src & ~mask);
 }
 
 
@@ -3204,11 +3452,10 @@ M68KMAKE_OP(bset, 32, r, d)
 M68KMAKE_OP(bset, 8, r, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
 	unsigned mask = 1 << (DX & 7);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_OR, mask);
 
 	FLAG_Z = src & mask;
-	m68ki_write_8(ea, src | mask);
 }
 
 
@@ -3226,10 +3473,9 @@ M68KMAKE_OP(bset, 8, s, .)
 {
 	unsigned mask = 1 << (OPER_I_8() & 7);
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_OR, mask);
 
 	FLAG_Z = src & mask;
-	m68ki_write_8(ea, src | mask);
 }
 
 
@@ -3322,8 +3568,8 @@ M68KMAKE_OP(cas, 8, ., .)
 	{
 		unsigned word2 = OPER_I_16();
 		unsigned ea = M68KMAKE_GET_EA_AY_8;
-		unsigned dest = m68ki_read_8(ea);
 		unsigned* compare = &REG_D[word2 & 7];
+		unsigned dest = m68ki_cas_8(ea, MASK_OUT_ABOVE_8(*compare), MASK_OUT_ABOVE_8(REG_D[(word2 >> 6) & 7]));
 		unsigned res = dest - MASK_OUT_ABOVE_8(*compare);
 
 		m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
@@ -3335,10 +3581,7 @@ M68KMAKE_OP(cas, 8, ., .)
 		if(COND_NE())
 			*compare = MASK_OUT_BELOW_8(*compare) | dest;
 		else
-		{
 			USE_CYCLES(3);
-			m68ki_write_8(ea, MASK_OUT_ABOVE_8(REG_D[(word2 >> 6) & 7]));
-		}
 		return;
 	}
 	m68ki_exception_illegal();
@@ -3351,8 +3594,8 @@ M68KMAKE_OP(cas, 16, ., .)
 	{
 		unsigned word2 = OPER_I_16();
 		unsigned ea = M68KMAKE_GET_EA_AY_16;
-		unsigned dest = m68ki_read_16(ea);
 		unsigned* compare = &REG_D[word2 & 7];
+		unsigned dest = m68ki_cas_16(ea, MASK_OUT_ABOVE_16(*compare), MASK_OUT_ABOVE_16(REG_D[(word2 >> 6) & 7]));
 		unsigned res = dest - MASK_OUT_ABOVE_16(*compare);
 
 		m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
@@ -3364,10 +3607,7 @@ M68KMAKE_OP(cas, 16, ., .)
 		if(COND_NE())
 			*compare = MASK_OUT_BELOW_16(*compare) | dest;
 		else
-		{
 			USE_CYCLES(3);
-			m68ki_write_16(ea, MASK_OUT_ABOVE_16(REG_D[(word2 >> 6) & 7]));
-		}
 		return;
 	}
 	m68ki_exception_illegal();
@@ -3380,8 +3620,8 @@ M68KMAKE_OP(cas, 32, ., .)
 	{
 		unsigned word2 = OPER_I_16();
 		unsigned ea = M68KMAKE_GET_EA_AY_32;
-		unsigned dest = m68ki_read_32(ea);
 		unsigned* compare = &REG_D[word2 & 7];
+		unsigned dest = m68ki_cas_32(ea, *compare, REG_D[(word2 >> 6) & 7]);
 		unsigned res = dest - *compare;
 
 		m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
@@ -3393,10 +3633,7 @@ M68KMAKE_OP(cas, 32, ., .)
 		if(COND_NE())
 			*compare = dest;
 		else
-		{
 			USE_CYCLES(3);
-			m68ki_write_32(ea, REG_D[(word2 >> 6) & 7]);
-		}
 		return;
 	}
 	m68ki_exception_illegal();
@@ -3871,10 +4108,7 @@ M68KMAKE_OP(clr, 8, ., d)
 {
 	DY &= 0xffffff00;
 
-	FLAG_N = NFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_Z = ZFLAG_SET;
+	m68ki_set_logic_flags_8(0);
 }
 
 
@@ -3882,10 +4116,7 @@ M68KMAKE_OP(clr, 8, ., .)
 {
 	m68ki_write_8(M68KMAKE_GET_EA_AY_8, 0);
 
-	FLAG_N = NFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_Z = ZFLAG_SET;
+	m68ki_set_logic_flags_8(0);
 }
 
 
@@ -3893,10 +4124,7 @@ M68KMAKE_OP(clr, 16, ., d)
 {
 	DY &= 0xffff0000;
 
-	FLAG_N = NFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_Z = ZFLAG_SET;
+	m68ki_set_logic_flags_16(0);
 }
 
 
@@ -3904,10 +4132,7 @@ M68KMAKE_OP(clr, 16, ., .)
 {
 	m68ki_write_16(M68KMAKE_GET_EA_AY_16, 0);
 
-	FLAG_N = NFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_Z = ZFLAG_SET;
+	m68ki_set_logic_flags_16(0);
 }
 
 
@@ -3915,10 +4140,7 @@ M68KMAKE_OP(clr, 32, ., d)
 {
 	DY = 0;
 
-	FLAG_N = NFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_Z = ZFLAG_SET;
+	m68ki_set_logic_flags_32(0);
 }
 
 
@@ -3926,10 +4148,7 @@ M68KMAKE_OP(clr, 32, ., .)
 {
 	m68ki_write_32(M68KMAKE_GET_EA_AY_32, 0);
 
-	FLAG_N = NFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_Z = ZFLAG_SET;
+	m68ki_set_logic_flags_32(0);
 }
 
 
@@ -3939,10 +4158,7 @@ M68KMAKE_OP(cmp, 8, ., d)
 	unsigned dst = MASK_OUT_ABOVE_8(DX);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -3952,10 +4168,7 @@ M68KMAKE_OP(cmp, 8, ., .)
 	unsigned dst = MASK_OUT_ABOVE_8(DX);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -3965,10 +4178,7 @@ M68KMAKE_OP(cmp, 16, ., d)
 	unsigned dst = MASK_OUT_ABOVE_16(DX);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_C = CFLAG_16(res);
+	m68ki_set_cmp_flags_16(src, dst, res);
 }
 
 
@@ -3978,10 +4188,7 @@ M68KMAKE_OP(cmp, 16, ., a)
 	unsigned dst = MASK_OUT_ABOVE_16(DX);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_C = CFLAG_16(res);
+	m68ki_set_cmp_flags_16(src, dst, res);
 }
 
 
@@ -3991,10 +4198,7 @@ M68KMAKE_OP(cmp, 16, ., .)
 	unsigned dst = MASK_OUT_ABOVE_16(DX);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_C = CFLAG_16(res);
+	m68ki_set_cmp_flags_16(src, dst, res);
 }
 
 
@@ -4004,10 +4208,7 @@ M68KMAKE_OP(cmp, 32, ., d)
 	unsigned dst = DX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4017,10 +4218,7 @@ M68KMAKE_OP(cmp, 32, ., a)
 	unsigned dst = DX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4030,10 +4228,7 @@ M68KMAKE_OP(cmp, 32, ., .)
 	unsigned dst = DX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4043,10 +4238,7 @@ M68KMAKE_OP(cmpa, 16, ., d)
 	unsigned dst = AX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4056,10 +4248,7 @@ M68KMAKE_OP(cmpa, 16, ., a)
 	unsigned dst = AX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4069,10 +4258,7 @@ M68KMAKE_OP(cmpa, 16, ., .)
 	unsigned dst = AX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4082,10 +4268,7 @@ M68KMAKE_OP(cmpa, 32, ., d)
 	unsigned dst = AX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4095,10 +4278,7 @@ M68KMAKE_OP(cmpa, 32, ., a)
 	unsigned dst = AX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4108,10 +4288,7 @@ M68KMAKE_OP(cmpa, 32, ., .)
 	unsigned dst = AX;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4121,10 +4298,7 @@ M68KMAKE_OP(cmpi, 8, ., d)
 	unsigned dst = MASK_OUT_ABOVE_8(DY);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -4134,10 +4308,7 @@ M68KMAKE_OP(cmpi, 8, ., .)
 	unsigned dst = M68KMAKE_GET_OPER_AY_8;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -4149,10 +4320,7 @@ M68KMAKE_OP(cmpi, 8, ., pcdi)
 		unsigned dst = OPER_PCDI_8();
 		unsigned res = dst - src;
 
-		FLAG_N = NFLAG_8(res);
-		FLAG_Z = MASK_OUT_ABOVE_8(res);
-		FLAG_V = VFLAG_SUB_8(src, dst, res);
-		FLAG_C = CFLAG_8(res);
+		m68ki_set_cmp_flags_8(src, dst, res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -4167,10 +4335,7 @@ M68KMAKE_OP(cmpi, 8, ., pcix)
 		unsigned dst = OPER_PCIX_8();
 		unsigned res = dst - src;
 
-		FLAG_N = NFLAG_8(res);
-		FLAG_Z = MASK_OUT_ABOVE_8(res);
-		FLAG_V = VFLAG_SUB_8(src, dst, res);
-		FLAG_C = CFLAG_8(res);
+		m68ki_set_cmp_flags_8(src, dst, res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -4183,10 +4348,7 @@ M68KMAKE_OP(cmpi, 16, ., d)
 	unsigned dst = MASK_OUT_ABOVE_16(DY);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_C = CFLAG_16(res);
+	m68ki_set_cmp_flags_16(src, dst, res);
 }
 
 
@@ -4196,10 +4358,7 @@ M68KMAKE_OP(cmpi, 16, ., .)
 	unsigned dst = M68KMAKE_GET_OPER_AY_16;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_C = CFLAG_16(res);
+	m68ki_set_cmp_flags_16(src, dst, res);
 }
 
 
@@ -4211,10 +4370,7 @@ M68KMAKE_OP(cmpi, 16, ., pcdi)
 		unsigned dst = OPER_PCDI_16();
 		unsigned res = dst - src;
 
-		FLAG_N = NFLAG_16(res);
-		FLAG_Z = MASK_OUT_ABOVE_16(res);
-		FLAG_V = VFLAG_SUB_16(src, dst, res);
-		FLAG_C = CFLAG_16(res);
+		m68ki_set_cmp_flags_16(src, dst, res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -4229,10 +4385,7 @@ M68KMAKE_OP(cmpi, 16, ., pcix)
 		unsigned dst = OPER_PCIX_16();
 		unsigned res = dst - src;
 
-		FLAG_N = NFLAG_16(res);
-		FLAG_Z = MASK_OUT_ABOVE_16(res);
-		FLAG_V = VFLAG_SUB_16(src, dst, res);
-		FLAG_C = CFLAG_16(res);
+		m68ki_set_cmp_flags_16(src, dst, res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -4245,11 +4398,11 @@ M68KMAKE_OP(cmpi, 32, ., d)
 	unsigned dst = DY;
 	unsigned res = dst - src;
 
-	m68ki_cmpild_callback(src, REG_IR & 7);		   /* auto-disable (see m68kcpu.h) */
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	if(!m68ki_fault_pending())
+	{
+		m68ki_cmpild_callback(src, REG_IR & 7);	   /* auto-disable (see m68kcpu.h) */
+	}
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4259,10 +4412,7 @@ M68KMAKE_OP(cmpi, 32, ., .)
 	unsigned dst = M68KMAKE_GET_OPER_AY_32;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4274,10 +4424,7 @@ M68KMAKE_OP(cmpi, 32, ., pcdi)
 		unsigned dst = OPER_PCDI_32();
 		unsigned res = dst - src;
 
-		FLAG_N = NFLAG_32(res);
-		FLAG_Z = MASK_OUT_ABOVE_32(res);
-		FLAG_V = VFLAG_SUB_32(src, dst, res);
-		FLAG_C = CFLAG_SUB_32(src, dst, res);
+		m68ki_set_cmp_flags_32(src, dst, res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -4292,10 +4439,7 @@ M68KMAKE_OP(cmpi, 32, ., pcix)
 		unsigned dst = OPER_PCIX_32();
 		unsigned res = dst - src;
 
-		FLAG_N = NFLAG_32(res);
-		FLAG_Z = MASK_OUT_ABOVE_32(res);
-		FLAG_V = VFLAG_SUB_32(src, dst, res);
-		FLAG_C = CFLAG_SUB_32(src, dst, res);
+		m68ki_set_cmp_flags_32(src, dst, res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -4308,10 +4452,7 @@ M68KMAKE_OP(cmpm, 8, ., ax7)
 	unsigned dst = OPER_A7_PI_8();
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -4321,10 +4462,7 @@ M68KMAKE_OP(cmpm, 8, ., ay7)
 	unsigned dst = OPER_AX_PI_8();
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -4334,10 +4472,7 @@ M68KMAKE_OP(cmpm, 8, ., axy7)
 	unsigned dst = OPER_A7_PI_8();
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -4347,10 +4482,7 @@ M68KMAKE_OP(cmpm, 8, ., .)
 	unsigned dst = OPER_AX_PI_8();
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_C = CFLAG_8(res);
+	m68ki_set_cmp_flags_8(src, dst, res);
 }
 
 
@@ -4360,10 +4492,7 @@ M68KMAKE_OP(cmpm, 16, ., .)
 	unsigned dst = OPER_AX_PI_16();
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_C = CFLAG_16(res);
+	m68ki_set_cmp_flags_16(src, dst, res);
 }
 
 
@@ -4373,10 +4502,7 @@ M68KMAKE_OP(cmpm, 32, ., .)
 	unsigned dst = OPER_AX_PI_32();
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_C = CFLAG_SUB_32(src, dst, res);
+	m68ki_set_cmp_flags_32(src, dst, res);
 }
 
 
@@ -4456,16 +4582,19 @@ M68KMAKE_OP(dbf, 16, ., .)
 	unsigned* r_dst = &DY;
 	unsigned res = MASK_OUT_ABOVE_16(*r_dst - 1);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 	if(res != 0xffff)
 	{
+		/* Fetch the displacement before changing Dn (see m68ki_save_da()) */
 		unsigned offset = OPER_I_16();
+		*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 		REG_PC -= 2;
 		m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
 		m68ki_branch_16(offset);
 		USE_CYCLES(CYC_DBCC_F_NOEXP);
+		m68ki_idle_dbf(r_dst);		   /* auto-disable (see m68kcpu.h) */
 		return;
 	}
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 	REG_PC += 2;
 	USE_CYCLES(CYC_DBCC_F_EXP);
 }
@@ -4478,16 +4607,18 @@ M68KMAKE_OP(dbcc, 16, ., .)
 		unsigned* r_dst = &DY;
 		unsigned res = MASK_OUT_ABOVE_16(*r_dst - 1);
 
-		*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 		if(res != 0xffff)
 		{
+			/* Fetch the displacement before changing Dn (see m68ki_save_da()) */
 			unsigned offset = OPER_I_16();
+			*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 			REG_PC -= 2;
 			m68ki_trace_t0();			   /* auto-disable (see m68kcpu.h) */
 			m68ki_branch_16(offset);
 			USE_CYCLES(CYC_DBCC_F_NOEXP);
 			return;
 		}
+		*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 		REG_PC += 2;
 		USE_CYCLES(CYC_DBCC_F_EXP);
 		return;
@@ -5050,24 +5181,16 @@ M68KMAKE_OP(eor, 8, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_8(DY ^= MASK_OUT_ABOVE_8(DX));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
 M68KMAKE_OP(eor, 8, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = MASK_OUT_ABOVE_8(DX ^ m68ki_read_8(ea));
-
-	m68ki_write_8(ea, res);
+	unsigned res = MASK_OUT_ABOVE_8(DX ^ m68ki_rmw_8(ea, M68KI_RMW_EOR, DX));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5075,24 +5198,16 @@ M68KMAKE_OP(eor, 16, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_16(DY ^= MASK_OUT_ABOVE_16(DX));
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
 M68KMAKE_OP(eor, 16, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = MASK_OUT_ABOVE_16(DX ^ m68ki_read_16(ea));
+	unsigned res = MASK_OUT_ABOVE_16(DX ^ m68ki_rmw_16(ea, M68KI_RMW_EOR, DX));
 
-	m68ki_write_16(ea, res);
-
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -5100,24 +5215,16 @@ M68KMAKE_OP(eor, 32, ., d)
 {
 	unsigned res = DY ^= DX;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
 M68KMAKE_OP(eor, 32, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = DX ^ m68ki_read_32(ea);
-
-	m68ki_write_32(ea, res);
+	unsigned res = DX ^ m68ki_rmw_32(ea, M68KI_RMW_EOR, DX);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -5125,10 +5232,7 @@ M68KMAKE_OP(eori, 8, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_8(DY ^= OPER_I_8());
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5136,14 +5240,9 @@ M68KMAKE_OP(eori, 8, ., .)
 {
 	unsigned src = OPER_I_8();
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = src ^ m68ki_read_8(ea);
+	unsigned res = src ^ m68ki_rmw_8(ea, M68KI_RMW_EOR, src);
 
-	m68ki_write_8(ea, res);
-
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5151,10 +5250,7 @@ M68KMAKE_OP(eori, 16, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_16(DY ^= OPER_I_16());
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -5162,14 +5258,9 @@ M68KMAKE_OP(eori, 16, ., .)
 {
 	unsigned src = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = src ^ m68ki_read_16(ea);
-
-	m68ki_write_16(ea, res);
+	unsigned res = src ^ m68ki_rmw_16(ea, M68KI_RMW_EOR, src);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -5177,10 +5268,7 @@ M68KMAKE_OP(eori, 32, ., d)
 {
 	unsigned res = DY ^= OPER_I_32();
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -5188,14 +5276,9 @@ M68KMAKE_OP(eori, 32, ., .)
 {
 	unsigned src = OPER_I_32();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = src ^ m68ki_read_32(ea);
+	unsigned res = src ^ m68ki_rmw_32(ea, M68KI_RMW_EOR, src);
 
-	m68ki_write_32(ea, res);
-
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -5323,6 +5406,7 @@ M68KMAKE_OP(lea, 32, ., .)
 
 M68KMAKE_OP(link, 16, ., a7)
 {
+	m68ki_save_da(15);
 	REG_A[7] -= 4;
 	m68ki_write_32(REG_A[7], REG_A[7]);
 	REG_A[7] = MASK_OUT_ABOVE_32(REG_A[7] + MAKE_INT_16(OPER_I_16()));
@@ -5334,6 +5418,7 @@ M68KMAKE_OP(link, 16, ., .)
 	unsigned* r_dst = &AY;
 
 	m68ki_push_32(*r_dst);
+	m68ki_save_ay();
 	*r_dst = REG_A[7];
 	REG_A[7] = MASK_OUT_ABOVE_32(REG_A[7] + MAKE_INT_16(OPER_I_16()));
 }
@@ -5343,6 +5428,7 @@ M68KMAKE_OP(link, 32, ., a7)
 {
 	if(CPU_TYPE_IS_EC020_PLUS(CPU_TYPE))
 	{
+		m68ki_save_da(15);
 		REG_A[7] -= 4;
 		m68ki_write_32(REG_A[7], REG_A[7]);
 		REG_A[7] = MASK_OUT_ABOVE_32(REG_A[7] + OPER_I_32());
@@ -5359,6 +5445,7 @@ M68KMAKE_OP(link, 32, ., .)
 		unsigned* r_dst = &AY;
 
 		m68ki_push_32(*r_dst);
+		m68ki_save_ay();
 		*r_dst = REG_A[7];
 		REG_A[7] = MASK_OUT_ABOVE_32(REG_A[7] + OPER_I_32());
 		return;
@@ -5454,10 +5541,7 @@ M68KMAKE_OP(lsr, 8, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_8(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(src);
 }
 
 
@@ -5491,10 +5575,7 @@ M68KMAKE_OP(lsr, 16, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_16(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(src);
 }
 
 
@@ -5527,10 +5608,7 @@ M68KMAKE_OP(lsr, 32, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_32(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(src);
 }
 
 
@@ -5636,10 +5714,7 @@ M68KMAKE_OP(lsl, 8, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_8(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(src);
 }
 
 
@@ -5673,10 +5748,7 @@ M68KMAKE_OP(lsl, 16, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_16(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(src);
 }
 
 
@@ -5709,10 +5781,7 @@ M68KMAKE_OP(lsl, 32, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_32(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(src);
 }
 
 
@@ -5738,10 +5807,7 @@ M68KMAKE_OP(move, 8, d, d)
 
 	*r_dst = MASK_OUT_BELOW_8(*r_dst) | res;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5752,10 +5818,7 @@ M68KMAKE_OP(move, 8, d, .)
 
 	*r_dst = MASK_OUT_BELOW_8(*r_dst) | res;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5766,10 +5829,7 @@ M68KMAKE_OP(move, 8, ai, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5780,10 +5840,7 @@ M68KMAKE_OP(move, 8, ai, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5794,10 +5851,7 @@ M68KMAKE_OP(move, 8, pi7, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5808,10 +5862,7 @@ M68KMAKE_OP(move, 8, pi, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5822,10 +5873,7 @@ M68KMAKE_OP(move, 8, pi7, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5836,10 +5884,7 @@ M68KMAKE_OP(move, 8, pi, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5850,10 +5895,7 @@ M68KMAKE_OP(move, 8, pd7, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5864,10 +5906,7 @@ M68KMAKE_OP(move, 8, pd, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5878,10 +5917,7 @@ M68KMAKE_OP(move, 8, pd7, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5892,10 +5928,7 @@ M68KMAKE_OP(move, 8, pd, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5906,10 +5939,7 @@ M68KMAKE_OP(move, 8, di, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5920,10 +5950,7 @@ M68KMAKE_OP(move, 8, di, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5934,10 +5961,7 @@ M68KMAKE_OP(move, 8, ix, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5948,10 +5972,7 @@ M68KMAKE_OP(move, 8, ix, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5962,10 +5983,7 @@ M68KMAKE_OP(move, 8, aw, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5976,10 +5994,7 @@ M68KMAKE_OP(move, 8, aw, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -5990,10 +6005,7 @@ M68KMAKE_OP(move, 8, al, d)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -6004,10 +6016,7 @@ M68KMAKE_OP(move, 8, al, .)
 
 	m68ki_write_8(ea, res);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -6018,10 +6027,7 @@ M68KMAKE_OP(move, 16, d, d)
 
 	*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6032,10 +6038,7 @@ M68KMAKE_OP(move, 16, d, a)
 
 	*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6046,10 +6049,7 @@ M68KMAKE_OP(move, 16, d, .)
 
 	*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6060,10 +6060,7 @@ M68KMAKE_OP(move, 16, ai, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6074,10 +6071,7 @@ M68KMAKE_OP(move, 16, ai, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6088,10 +6082,7 @@ M68KMAKE_OP(move, 16, ai, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6102,10 +6093,7 @@ M68KMAKE_OP(move, 16, pi, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6116,10 +6104,7 @@ M68KMAKE_OP(move, 16, pi, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6130,10 +6115,7 @@ M68KMAKE_OP(move, 16, pi, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6144,10 +6126,7 @@ M68KMAKE_OP(move, 16, pd, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6158,10 +6137,7 @@ M68KMAKE_OP(move, 16, pd, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6172,10 +6148,7 @@ M68KMAKE_OP(move, 16, pd, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6186,10 +6159,7 @@ M68KMAKE_OP(move, 16, di, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6200,10 +6170,7 @@ M68KMAKE_OP(move, 16, di, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6214,10 +6181,7 @@ M68KMAKE_OP(move, 16, di, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6228,10 +6192,7 @@ M68KMAKE_OP(move, 16, ix, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6242,10 +6203,7 @@ M68KMAKE_OP(move, 16, ix, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6256,10 +6214,7 @@ M68KMAKE_OP(move, 16, ix, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6270,10 +6225,7 @@ M68KMAKE_OP(move, 16, aw, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6284,10 +6236,7 @@ M68KMAKE_OP(move, 16, aw, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6298,10 +6247,7 @@ M68KMAKE_OP(move, 16, aw, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6312,10 +6258,7 @@ M68KMAKE_OP(move, 16, al, d)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6326,10 +6269,7 @@ M68KMAKE_OP(move, 16, al, a)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6340,10 +6280,7 @@ M68KMAKE_OP(move, 16, al, .)
 
 	m68ki_write_16(ea, res);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -6354,10 +6291,7 @@ M68KMAKE_OP(move, 32, d, d)
 
 	*r_dst = res;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6368,10 +6302,7 @@ M68KMAKE_OP(move, 32, d, a)
 
 	*r_dst = res;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6382,10 +6313,7 @@ M68KMAKE_OP(move, 32, d, .)
 
 	*r_dst = res;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6396,10 +6324,7 @@ M68KMAKE_OP(move, 32, ai, d)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6410,10 +6335,7 @@ M68KMAKE_OP(move, 32, ai, a)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6424,10 +6346,7 @@ M68KMAKE_OP(move, 32, ai, .)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6438,10 +6357,7 @@ M68KMAKE_OP(move, 32, pi, d)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6452,10 +6368,7 @@ M68KMAKE_OP(move, 32, pi, a)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6466,10 +6379,7 @@ M68KMAKE_OP(move, 32, pi, .)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6481,10 +6391,7 @@ M68KMAKE_OP(move, 32, pd, d)
 	m68ki_write_16(ea+2, res & 0xFFFF );
 	m68ki_write_16(ea, (res >> 16) & 0xFFFF );
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6496,10 +6403,7 @@ M68KMAKE_OP(move, 32, pd, a)
 	m68ki_write_16(ea+2, res & 0xFFFF );
 	m68ki_write_16(ea, (res >> 16) & 0xFFFF );
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6511,10 +6415,7 @@ M68KMAKE_OP(move, 32, pd, .)
 	m68ki_write_16(ea+2, res & 0xFFFF );
 	m68ki_write_16(ea, (res >> 16) & 0xFFFF );
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6525,10 +6426,7 @@ M68KMAKE_OP(move, 32, di, d)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6539,10 +6437,7 @@ M68KMAKE_OP(move, 32, di, a)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6553,10 +6448,7 @@ M68KMAKE_OP(move, 32, di, .)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6567,10 +6459,7 @@ M68KMAKE_OP(move, 32, ix, d)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6581,10 +6470,7 @@ M68KMAKE_OP(move, 32, ix, a)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6595,10 +6481,7 @@ M68KMAKE_OP(move, 32, ix, .)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6609,10 +6492,7 @@ M68KMAKE_OP(move, 32, aw, d)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6623,10 +6503,7 @@ M68KMAKE_OP(move, 32, aw, a)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6637,10 +6514,7 @@ M68KMAKE_OP(move, 32, aw, .)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6651,10 +6525,7 @@ M68KMAKE_OP(move, 32, al, d)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6665,10 +6536,7 @@ M68KMAKE_OP(move, 32, al, a)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6679,10 +6547,7 @@ M68KMAKE_OP(move, 32, al, .)
 
 	m68ki_write_32(ea, res);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -6883,7 +6748,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x003:				/* TC */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_tc;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6891,7 +6756,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x004:				/* ITT0 */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_itt0;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6899,7 +6764,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x005:				/* ITT1 */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_itt1;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6907,7 +6772,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x006:				/* DTT0 */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_dtt0;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6915,7 +6780,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x007:				/* DTT1 */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_dtt1;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6923,7 +6788,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x805:				/* MMUSR */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_sr_040;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6931,7 +6796,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x806:				/* URP */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_urp_aptr;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -6939,7 +6804,7 @@ M68KMAKE_OP(movec, 32, cr, .)
 			case 0x807:				/* SRP */
 				if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					REG_DA[(word2 >> 12) & 15] = m68ki_cpu.mmu_srp_aptr;
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7038,7 +6903,10 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x003:			/* TC */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_tc = REG_DA[(word2 >> 12) & 15] & 0xc000;
+					m68ki_cpu.pmmu_enabled = HAS_PMMU && (m68ki_cpu.mmu_tc & 0x8000);
+					m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+					m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7046,7 +6914,8 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x004:			/* ITT0 */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_itt0 = REG_DA[(word2 >> 12) & 15] & 0xffffe364;
+					m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7054,7 +6923,8 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x005:			/* ITT1 */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_itt1 = REG_DA[(word2 >> 12) & 15] & 0xffffe364;
+					m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7062,7 +6932,8 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x006:			/* DTT0 */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_dtt0 = REG_DA[(word2 >> 12) & 15] & 0xffffe364;
+					m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7070,7 +6941,8 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x007:			/* DTT1 */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_dtt1 = REG_DA[(word2 >> 12) & 15] & 0xffffe364;
+					m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7078,7 +6950,7 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x805:			/* MMUSR */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_sr_040 = REG_DA[(word2 >> 12) & 15];
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7086,7 +6958,8 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x806:			/* URP */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_urp_aptr = REG_DA[(word2 >> 12) & 15] & 0xfffffe00;
+					m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7094,7 +6967,8 @@ M68KMAKE_OP(movec, 32, rc, .)
 			case 0x807:			/* SRP */
 				if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
 				{
-					/* TODO */
+					m68ki_cpu.mmu_srp_aptr = REG_DA[(word2 >> 12) & 15] & 0xfffffe00;
+					m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				m68ki_exception_illegal();
@@ -7113,19 +6987,10 @@ M68KMAKE_OP(movec, 32, rc, .)
 
 M68KMAKE_OP(movem, 16, re, pd)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
-	unsigned ea = AY;
-	unsigned count = 0;
+	unsigned count = m68ki_movem_store_pd(register_list, AY, 2);
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			ea -= 2;
-			m68ki_write_16(ea, MASK_OUT_ABOVE_16(REG_DA[15-i]));
-			count++;
-		}
-	AY = ea;
+	AY -= count*2;
 
 	USE_CYCLES(count<<CYC_MOVEM_W);
 }
@@ -7133,18 +6998,9 @@ M68KMAKE_OP(movem, 16, re, pd)
 
 M68KMAKE_OP(movem, 16, re, .)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned count = 0;
-
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			m68ki_write_16(ea, MASK_OUT_ABOVE_16(REG_DA[i]));
-			ea += 2;
-			count++;
-		}
+	unsigned count = m68ki_movem_store(register_list, ea, 2);
 
 	USE_CYCLES(count<<CYC_MOVEM_W);
 }
@@ -7152,20 +7008,10 @@ M68KMAKE_OP(movem, 16, re, .)
 
 M68KMAKE_OP(movem, 32, re, pd)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
-	unsigned ea = AY;
-	unsigned count = 0;
+	unsigned count = m68ki_movem_store_pd(register_list, AY, 4);
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			ea -= 4;
-			m68ki_write_16(ea+2, REG_DA[15-i] & 0xFFFF );
-			m68ki_write_16(ea, (REG_DA[15-i] >> 16) & 0xFFFF );
-			count++;
-		}
-	AY = ea;
+	AY -= count*4;
 
 	USE_CYCLES(count<<CYC_MOVEM_L);
 }
@@ -7173,18 +7019,9 @@ M68KMAKE_OP(movem, 32, re, pd)
 
 M68KMAKE_OP(movem, 32, re, .)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned count = 0;
-
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			m68ki_write_32(ea, REG_DA[i]);
-			ea += 4;
-			count++;
-		}
+	unsigned count = m68ki_movem_store(register_list, ea, 4);
 
 	USE_CYCLES(count<<CYC_MOVEM_L);
 }
@@ -7192,19 +7029,11 @@ M68KMAKE_OP(movem, 32, re, .)
 
 M68KMAKE_OP(movem, 16, er, pi)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = AY;
-	unsigned count = 0;
+	unsigned count = m68ki_movem_load(register_list, ea, 2);
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_16(ea)));
-			ea += 2;
-			count++;
-		}
-	AY = ea;
+	AY = ea + count*2;
 
 	USE_CYCLES(count<<CYC_MOVEM_W);
 }
@@ -7212,18 +7041,19 @@ M68KMAKE_OP(movem, 16, er, pi)
 
 M68KMAKE_OP(movem, 16, er, pcdi)
 {
-	unsigned i = 0;
+	unsigned i;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = EA_PCDI_16();
 	unsigned count = 0;
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_pcrel_16(ea)));
-			ea += 2;
-			count++;
-		}
+	for(; register_list; register_list &= register_list - 1)
+	{
+		i = m68ki_ctz(register_list);
+		m68ki_save_da(i);
+		REG_DA[i] = MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_pcrel_16(ea)));
+		ea += 2;
+		count++;
+	}
 
 	USE_CYCLES(count<<CYC_MOVEM_W);
 }
@@ -7231,18 +7061,19 @@ M68KMAKE_OP(movem, 16, er, pcdi)
 
 M68KMAKE_OP(movem, 16, er, pcix)
 {
-	unsigned i = 0;
+	unsigned i;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = EA_PCIX_16();
 	unsigned count = 0;
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_pcrel_16(ea)));
-			ea += 2;
-			count++;
-		}
+	for(; register_list; register_list &= register_list - 1)
+	{
+		i = m68ki_ctz(register_list);
+		m68ki_save_da(i);
+		REG_DA[i] = MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_pcrel_16(ea)));
+		ea += 2;
+		count++;
+	}
 
 	USE_CYCLES(count<<CYC_MOVEM_W);
 }
@@ -7250,18 +7081,9 @@ M68KMAKE_OP(movem, 16, er, pcix)
 
 M68KMAKE_OP(movem, 16, er, .)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned count = 0;
-
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_16(ea)));
-			ea += 2;
-			count++;
-		}
+	unsigned count = m68ki_movem_load(register_list, ea, 2);
 
 	USE_CYCLES(count<<CYC_MOVEM_W);
 }
@@ -7269,19 +7091,11 @@ M68KMAKE_OP(movem, 16, er, .)
 
 M68KMAKE_OP(movem, 32, er, pi)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = AY;
-	unsigned count = 0;
+	unsigned count = m68ki_movem_load(register_list, ea, 4);
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = m68ki_read_32(ea);
-			ea += 4;
-			count++;
-		}
-	AY = ea;
+	AY = ea + count*4;
 
 	USE_CYCLES(count<<CYC_MOVEM_L);
 }
@@ -7289,18 +7103,19 @@ M68KMAKE_OP(movem, 32, er, pi)
 
 M68KMAKE_OP(movem, 32, er, pcdi)
 {
-	unsigned i = 0;
+	unsigned i;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = EA_PCDI_32();
 	unsigned count = 0;
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = m68ki_read_pcrel_32(ea);
-			ea += 4;
-			count++;
-		}
+	for(; register_list; register_list &= register_list - 1)
+	{
+		i = m68ki_ctz(register_list);
+		m68ki_save_da(i);
+		REG_DA[i] = m68ki_read_pcrel_32(ea);
+		ea += 4;
+		count++;
+	}
 
 	USE_CYCLES(count<<CYC_MOVEM_L);
 }
@@ -7308,18 +7123,19 @@ M68KMAKE_OP(movem, 32, er, pcdi)
 
 M68KMAKE_OP(movem, 32, er, pcix)
 {
-	unsigned i = 0;
+	unsigned i;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = EA_PCIX_32();
 	unsigned count = 0;
 
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = m68ki_read_pcrel_32(ea);
-			ea += 4;
-			count++;
-		}
+	for(; register_list; register_list &= register_list - 1)
+	{
+		i = m68ki_ctz(register_list);
+		m68ki_save_da(i);
+		REG_DA[i] = m68ki_read_pcrel_32(ea);
+		ea += 4;
+		count++;
+	}
 
 	USE_CYCLES(count<<CYC_MOVEM_L);
 }
@@ -7327,18 +7143,9 @@ M68KMAKE_OP(movem, 32, er, pcix)
 
 M68KMAKE_OP(movem, 32, er, .)
 {
-	unsigned i = 0;
 	unsigned register_list = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned count = 0;
-
-	for(; i < 16; i++)
-		if(register_list & (1 << i))
-		{
-			REG_DA[i] = m68ki_read_32(ea);
-			ea += 4;
-			count++;
-		}
+	unsigned count = m68ki_movem_load(register_list, ea, 4);
 
 	USE_CYCLES(count<<CYC_MOVEM_L);
 }
@@ -7488,10 +7295,7 @@ M68KMAKE_OP(moveq, 32, ., .)
 {
 	unsigned res = DX = MAKE_INT_8(MASK_OUT_ABOVE_8(REG_IR));
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -7500,11 +7304,25 @@ M68KMAKE_OP(move16, 32, ., .)
 	uint16_t w2 = OPER_I_16();
 	int ax = REG_IR & 7;
 	int ay = (w2 >> 12) & 7;
+	unsigned line[4];
 
-	m68ki_write_32(REG_A[ay],    m68ki_read_32(REG_A[ax]));
-	m68ki_write_32(REG_A[ay]+4,  m68ki_read_32(REG_A[ax]+4));
-	m68ki_write_32(REG_A[ay]+8,  m68ki_read_32(REG_A[ax]+8));
-	m68ki_write_32(REG_A[ay]+12, m68ki_read_32(REG_A[ax]+12));
+	if(m68ki_read_block_32(REG_A[ax], 4, line))
+	{
+		if(!m68ki_write_block_32(REG_A[ay], 4, line))
+		{
+			m68ki_write_32(REG_A[ay],    line[0]);
+			m68ki_write_32(REG_A[ay]+4,  line[1]);
+			m68ki_write_32(REG_A[ay]+8,  line[2]);
+			m68ki_write_32(REG_A[ay]+12, line[3]);
+		}
+	}
+	else
+	{
+		m68ki_write_32(REG_A[ay],    m68ki_read_32(REG_A[ax]));
+		m68ki_write_32(REG_A[ay]+4,  m68ki_read_32(REG_A[ax]+4));
+		m68ki_write_32(REG_A[ay]+8,  m68ki_read_32(REG_A[ax]+8));
+		m68ki_write_32(REG_A[ay]+12, m68ki_read_32(REG_A[ax]+12));
+	}
 
 	REG_A[ax] += 16;
 	REG_A[ay] += 16;
@@ -7518,10 +7336,7 @@ M68KMAKE_OP(muls, 16, ., d)
 
 	*r_dst = res;
 
-	FLAG_Z = res;
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -7532,10 +7347,7 @@ M68KMAKE_OP(muls, 16, ., .)
 
 	*r_dst = res;
 
-	FLAG_Z = res;
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -7546,10 +7358,7 @@ M68KMAKE_OP(mulu, 16, ., d)
 
 	*r_dst = res;
 
-	FLAG_Z = res;
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -7560,10 +7369,7 @@ M68KMAKE_OP(mulu, 16, ., .)
 
 	*r_dst = res;
 
-	FLAG_Z = res;
-	FLAG_N = NFLAG_32(res);
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -7898,15 +7704,13 @@ M68KMAKE_OP(neg, 8, ., d)
 M68KMAKE_OP(neg, 8, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_NEG, 0);
 	unsigned res = 0 - src;
 
 	FLAG_N = NFLAG_8(res);
 	FLAG_C = FLAG_X = CFLAG_8(res);
 	FLAG_V = src & res;
 	FLAG_Z = MASK_OUT_ABOVE_8(res);
-
-	m68ki_write_8(ea, FLAG_Z);
 }
 
 
@@ -7927,15 +7731,13 @@ M68KMAKE_OP(neg, 16, ., d)
 M68KMAKE_OP(neg, 16, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned src = m68ki_read_16(ea);
+	unsigned src = m68ki_rmw_16(ea, M68KI_RMW_NEG, 0);
 	unsigned res = 0 - src;
 
 	FLAG_N = NFLAG_16(res);
 	FLAG_C = FLAG_X = CFLAG_16(res);
 	FLAG_V = (src & res)>>8;
 	FLAG_Z = MASK_OUT_ABOVE_16(res);
-
-	m68ki_write_16(ea, FLAG_Z);
 }
 
 
@@ -7956,15 +7758,13 @@ M68KMAKE_OP(neg, 32, ., d)
 M68KMAKE_OP(neg, 32, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned src = m68ki_read_32(ea);
+	unsigned src = m68ki_rmw_32(ea, M68KI_RMW_NEG, 0);
 	unsigned res = 0 - src;
 
 	FLAG_N = NFLAG_32(res);
 	FLAG_C = FLAG_X = CFLAG_SUB_32(src, 0, res);
 	FLAG_V = (src & res)>>24;
 	FLAG_Z = MASK_OUT_ABOVE_32(res);
-
-	m68ki_write_32(ea, FLAG_Z);
 }
 
 
@@ -7987,7 +7787,7 @@ M68KMAKE_OP(negx, 8, ., d)
 M68KMAKE_OP(negx, 8, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned src = m68ki_read_8(ea);
+	unsigned src = m68ki_rmw_8(ea, M68KI_RMW_NEG, XFLAG_AS_1());
 	unsigned res = 0 - src - XFLAG_AS_1();
 
 	FLAG_N = NFLAG_8(res);
@@ -7996,8 +7796,6 @@ M68KMAKE_OP(negx, 8, ., .)
 
 	res = MASK_OUT_ABOVE_8(res);
 	FLAG_Z |= res;
-
-	m68ki_write_8(ea, res);
 }
 
 
@@ -8020,7 +7818,7 @@ M68KMAKE_OP(negx, 16, ., d)
 M68KMAKE_OP(negx, 16, ., .)
 {
 	unsigned ea  = M68KMAKE_GET_EA_AY_16;
-	unsigned src = m68ki_read_16(ea);
+	unsigned src = m68ki_rmw_16(ea, M68KI_RMW_NEG, XFLAG_AS_1());
 	unsigned res = 0 - MASK_OUT_ABOVE_16(src) - XFLAG_AS_1();
 
 	FLAG_N = NFLAG_16(res);
@@ -8029,8 +7827,6 @@ M68KMAKE_OP(negx, 16, ., .)
 
 	res = MASK_OUT_ABOVE_16(res);
 	FLAG_Z |= res;
-
-	m68ki_write_16(ea, res);
 }
 
 
@@ -8053,7 +7849,7 @@ M68KMAKE_OP(negx, 32, ., d)
 M68KMAKE_OP(negx, 32, ., .)
 {
 	unsigned ea  = M68KMAKE_GET_EA_AY_32;
-	unsigned src = m68ki_read_32(ea);
+	unsigned src = m68ki_rmw_32(ea, M68KI_RMW_NEG, XFLAG_AS_1());
 	unsigned res = 0 - MASK_OUT_ABOVE_32(src) - XFLAG_AS_1();
 
 	FLAG_N = NFLAG_32(res);
@@ -8062,8 +7858,6 @@ M68KMAKE_OP(negx, 32, ., .)
 
 	res = MASK_OUT_ABOVE_32(res);
 	FLAG_Z |= res;
-
-	m68ki_write_32(ea, res);
 }
 
 
@@ -8080,24 +7874,16 @@ M68KMAKE_OP(not, 8, ., d)
 
 	*r_dst = MASK_OUT_BELOW_8(*r_dst) | res;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
 M68KMAKE_OP(not, 8, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = MASK_OUT_ABOVE_8(~m68ki_read_8(ea));
-
-	m68ki_write_8(ea, res);
+	unsigned res = MASK_OUT_ABOVE_8(~m68ki_rmw_8(ea, M68KI_RMW_EOR, 0xff));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -8108,24 +7894,16 @@ M68KMAKE_OP(not, 16, ., d)
 
 	*r_dst = MASK_OUT_BELOW_16(*r_dst) | res;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
 M68KMAKE_OP(not, 16, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = MASK_OUT_ABOVE_16(~m68ki_read_16(ea));
+	unsigned res = MASK_OUT_ABOVE_16(~m68ki_rmw_16(ea, M68KI_RMW_EOR, 0xffff));
 
-	m68ki_write_16(ea, res);
-
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -8134,24 +7912,16 @@ M68KMAKE_OP(not, 32, ., d)
 	unsigned* r_dst = &DY;
 	unsigned res = *r_dst = MASK_OUT_ABOVE_32(~*r_dst);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
 M68KMAKE_OP(not, 32, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = MASK_OUT_ABOVE_32(~m68ki_read_32(ea));
+	unsigned res = MASK_OUT_ABOVE_32(~m68ki_rmw_32(ea, M68KI_RMW_EOR, 0xffffffff));
 
-	m68ki_write_32(ea, res);
-
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -8159,10 +7929,7 @@ M68KMAKE_OP(or, 8, er, d)
 {
 	unsigned res = MASK_OUT_ABOVE_8((DX |= MASK_OUT_ABOVE_8(DY)));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -8170,10 +7937,7 @@ M68KMAKE_OP(or, 8, er, .)
 {
 	unsigned res = MASK_OUT_ABOVE_8((DX |= M68KMAKE_GET_OPER_AY_8));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -8181,10 +7945,7 @@ M68KMAKE_OP(or, 16, er, d)
 {
 	unsigned res = MASK_OUT_ABOVE_16((DX |= MASK_OUT_ABOVE_16(DY)));
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -8192,10 +7953,7 @@ M68KMAKE_OP(or, 16, er, .)
 {
 	unsigned res = MASK_OUT_ABOVE_16((DX |= M68KMAKE_GET_OPER_AY_16));
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -8203,10 +7961,7 @@ M68KMAKE_OP(or, 32, er, d)
 {
 	unsigned res = DX |= DY;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -8214,52 +7969,34 @@ M68KMAKE_OP(or, 32, er, .)
 {
 	unsigned res = DX |= M68KMAKE_GET_OPER_AY_32;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
 M68KMAKE_OP(or, 8, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = MASK_OUT_ABOVE_8(DX | m68ki_read_8(ea));
+	unsigned res = MASK_OUT_ABOVE_8(DX | m68ki_rmw_8(ea, M68KI_RMW_OR, DX));
 
-	m68ki_write_8(ea, res);
-
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
 M68KMAKE_OP(or, 16, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = MASK_OUT_ABOVE_16(DX | m68ki_read_16(ea));
-
-	m68ki_write_16(ea, res);
+	unsigned res = MASK_OUT_ABOVE_16(DX | m68ki_rmw_16(ea, M68KI_RMW_OR, DX));
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
 M68KMAKE_OP(or, 32, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = DX | m68ki_read_32(ea);
-
-	m68ki_write_32(ea, res);
+	unsigned res = DX | m68ki_rmw_32(ea, M68KI_RMW_OR, DX);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -8267,10 +8004,7 @@ M68KMAKE_OP(ori, 8, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_8((DY |= OPER_I_8()));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -8278,14 +8012,9 @@ M68KMAKE_OP(ori, 8, ., .)
 {
 	unsigned src = OPER_I_8();
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned res = MASK_OUT_ABOVE_8(src | m68ki_read_8(ea));
-
-	m68ki_write_8(ea, res);
+	unsigned res = MASK_OUT_ABOVE_8(src | m68ki_rmw_8(ea, M68KI_RMW_OR, src));
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -8293,10 +8022,7 @@ M68KMAKE_OP(ori, 16, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_16(DY |= OPER_I_16());
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -8304,14 +8030,9 @@ M68KMAKE_OP(ori, 16, ., .)
 {
 	unsigned src = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned res = MASK_OUT_ABOVE_16(src | m68ki_read_16(ea));
-
-	m68ki_write_16(ea, res);
+	unsigned res = MASK_OUT_ABOVE_16(src | m68ki_rmw_16(ea, M68KI_RMW_OR, src));
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -8319,10 +8040,7 @@ M68KMAKE_OP(ori, 32, ., d)
 {
 	unsigned res = DY |= OPER_I_32();
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -8330,14 +8048,9 @@ M68KMAKE_OP(ori, 32, ., .)
 {
 	unsigned src = OPER_I_32();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned res = src | m68ki_read_32(ea);
-
-	m68ki_write_32(ea, res);
+	unsigned res = src | m68ki_rmw_32(ea, M68KI_RMW_OR, src);
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -8438,22 +8151,55 @@ M68KMAKE_OP(pack, 16, mm, .)
 		m68ki_write_8(EA_AX_PD_8(), ((src >> 4) & 0x00f0) | (src & 0x000f));
 		return;
 	}
-	m68ki_exception_illegal();
+	m68ki_exception_illegal();
+}
+
+
+M68KMAKE_OP(pea, 32, ., .)
+{
+	unsigned ea = M68KMAKE_GET_EA_AY_32;
+
+	m68ki_push_32(ea);
+}
+
+M68KMAKE_OP(pflush, 32, ., .)
+{
+	if ((CPU_TYPE_IS_EC020_PLUS(CPU_TYPE)) && (HAS_PMMU))
+	{
+		m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
+		return;
+	}
+	m68ki_exception_1111();
+}
+
+/* The ATC doesn't tell global pages apart, so PFLUSHAN and PFLUSHN flush
+ * them as well
+ */
+M68KMAKE_OP(pflush, 32, an, .)
+{
+	if ((CPU_TYPE_IS_040_PLUS(CPU_TYPE)) && (HAS_PMMU))
+	{
+		m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
+		return;
+	}
+	m68ki_exception_1111();
 }
 
-
-M68KMAKE_OP(pea, 32, ., .)
+M68KMAKE_OP(pflush, 32, ea, .)
 {
-	unsigned ea = M68KMAKE_GET_EA_AY_32;
-
-	m68ki_push_32(ea);
+	if ((CPU_TYPE_IS_040_PLUS(CPU_TYPE)) && (HAS_PMMU))
+	{
+		m68ki_atc_flush_page(AY, REG_DFC); /* auto-disable (see m68kcpu.h) */
+		return;
+	}
+	m68ki_exception_1111();
 }
 
-M68KMAKE_OP(pflush, 32, ., .)
+M68KMAKE_OP(pflush, 32, ean, .)
 {
-	if ((CPU_TYPE_IS_EC020_PLUS(CPU_TYPE)) && (HAS_PMMU))
+	if ((CPU_TYPE_IS_040_PLUS(CPU_TYPE)) && (HAS_PMMU))
 	{
-		fprintf(stderr,"68040: unhandled PFLUSH\n");
+		m68ki_atc_flush_page(AY, REG_DFC); /* auto-disable (see m68kcpu.h) */
 		return;
 	}
 	m68ki_exception_1111();
@@ -8471,6 +8217,36 @@ M68KMAKE_OP(pmmu, 32, ., .)
 	}
 }
 
+M68KMAKE_OP(ptest, 32, r, .)
+{
+	if ((CPU_TYPE_IS_040_PLUS(CPU_TYPE)) && (HAS_PMMU))
+	{
+		if(FLAG_S)
+		{
+			m68040_ptest(AY, 0);
+			return;
+		}
+		m68ki_exception_privilege_violation();
+		return;
+	}
+	m68ki_exception_1111();
+}
+
+M68KMAKE_OP(ptest, 32, w, .)
+{
+	if ((CPU_TYPE_IS_040_PLUS(CPU_TYPE)) && (HAS_PMMU))
+	{
+		if(FLAG_S)
+		{
+			m68040_ptest(AY, 1);
+			return;
+		}
+		m68ki_exception_privilege_violation();
+		return;
+	}
+	m68ki_exception_1111();
+}
+
 M68KMAKE_OP(reset, 0, ., .)
 {
 	if(FLAG_S)
@@ -8561,10 +8337,7 @@ M68KMAKE_OP(ror, 8, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_8(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(src);
 }
 
 
@@ -8588,10 +8361,7 @@ M68KMAKE_OP(ror, 16, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_16(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(src);
 }
 
 
@@ -8615,10 +8385,7 @@ M68KMAKE_OP(ror, 32, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_32(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(src);
 }
 
 
@@ -8723,10 +8490,7 @@ M68KMAKE_OP(rol, 8, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_8(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_8(src);
 }
 
 
@@ -8758,10 +8522,7 @@ M68KMAKE_OP(rol, 16, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_16(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_16(src);
 }
 
 
@@ -8786,10 +8547,7 @@ M68KMAKE_OP(rol, 32, r, .)
 		return;
 	}
 
-	FLAG_C = CFLAG_CLEAR;
-	FLAG_N = NFLAG_32(src);
-	FLAG_Z = src;
-	FLAG_V = VFLAG_CLEAR;
+	m68ki_set_logic_flags_32(src);
 }
 
 
@@ -9373,6 +9131,33 @@ rte_loop:
 				CPU_INSTR_MODE = INSTRUCTION_YES;
 				CPU_RUN_MODE = RUN_MODE_NORMAL;
 				return;
+			case 7: /* Access error (68040) */
+				if(!CPU_TYPE_IS_040_PLUS(CPU_TYPE))
+					break;
+				/* There are no writebacks to do, so restart the instruction */
+				new_sr = m68ki_pull_16();
+				new_pc = m68ki_pull_32();
+				m68ki_fake_pull_16();	/* format word */
+				m68ki_fake_pull_32();	/* effective address */
+				m68ki_fake_pull_16();	/* special status word */
+				m68ki_fake_pull_16();	/* writeback 3 status */
+				m68ki_fake_pull_16();	/* writeback 2 status */
+				m68ki_fake_pull_16();	/* writeback 1 status */
+				m68ki_fake_pull_32();	/* fault address */
+				m68ki_fake_pull_32();	/* writeback 3 address */
+				m68ki_fake_pull_32();	/* writeback 3 data */
+				m68ki_fake_pull_32();	/* writeback 2 address */
+				m68ki_fake_pull_32();	/* writeback 2 data */
+				m68ki_fake_pull_32();	/* writeback 1 address */
+				m68ki_fake_pull_32();	/* writeback 1 data */
+				m68ki_fake_pull_32();	/* push data 1 */
+				m68ki_fake_pull_32();	/* push data 2 */
+				m68ki_fake_pull_32();	/* push data 3 */
+				m68ki_jump(new_pc);
+				m68ki_set_sr(new_sr);
+				CPU_INSTR_MODE = INSTRUCTION_YES;
+				CPU_RUN_MODE = RUN_MODE_NORMAL;
+				return;
 		}
 		/* Not handling long or short bus fault */
 		CPU_INSTR_MODE = INSTRUCTION_YES;
@@ -9610,12 +9395,9 @@ M68KMAKE_OP(sub, 8, er, d)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
+	m68ki_set_sub_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -9626,12 +9408,9 @@ M68KMAKE_OP(sub, 8, er, .)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
+	m68ki_set_sub_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -9642,12 +9421,9 @@ M68KMAKE_OP(sub, 16, er, d)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_sub_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -9658,12 +9434,9 @@ M68KMAKE_OP(sub, 16, er, a)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_sub_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -9674,12 +9447,9 @@ M68KMAKE_OP(sub, 16, er, .)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
+	m68ki_set_sub_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -9690,12 +9460,9 @@ M68KMAKE_OP(sub, 32, er, d)
 	unsigned dst = *r_dst;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_sub_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -9706,12 +9473,9 @@ M68KMAKE_OP(sub, 32, er, a)
 	unsigned dst = *r_dst;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_sub_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -9722,12 +9486,9 @@ M68KMAKE_OP(sub, 32, er, .)
 	unsigned dst = *r_dst;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
+	m68ki_set_sub_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -9735,15 +9496,10 @@ M68KMAKE_OP(sub, 8, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
 	unsigned src = MASK_OUT_ABOVE_8(DX);
-	unsigned dst = m68ki_read_8(ea);
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-
-	m68ki_write_8(ea, FLAG_Z);
+	m68ki_set_sub_flags_8(src, dst, res);
 }
 
 
@@ -9751,15 +9507,10 @@ M68KMAKE_OP(sub, 16, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
 	unsigned src = MASK_OUT_ABOVE_16(DX);
-	unsigned dst = m68ki_read_16(ea);
+	unsigned dst = m68ki_rmw_16(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-
-	m68ki_write_16(ea, FLAG_Z);
+	m68ki_set_sub_flags_16(src, dst, res);
 }
 
 
@@ -9767,15 +9518,10 @@ M68KMAKE_OP(sub, 32, re, .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
 	unsigned src = DX;
-	unsigned dst = m68ki_read_32(ea);
+	unsigned dst = m68ki_rmw_32(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-
-	m68ki_write_32(ea, FLAG_Z);
+	m68ki_set_sub_flags_32(src, dst, res);
 }
 
 
@@ -9836,12 +9582,9 @@ M68KMAKE_OP(subi, 8, ., d)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
+	m68ki_set_sub_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -9849,15 +9592,10 @@ M68KMAKE_OP(subi, 8, ., .)
 {
 	unsigned src = OPER_I_8();
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned dst = m68ki_read_8(ea);
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-
-	m68ki_write_8(ea, FLAG_Z);
+	m68ki_set_sub_flags_8(src, dst, res);
 }
 
 
@@ -9868,12 +9606,9 @@ M68KMAKE_OP(subi, 16, ., d)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
+	m68ki_set_sub_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -9881,15 +9616,10 @@ M68KMAKE_OP(subi, 16, ., .)
 {
 	unsigned src = OPER_I_16();
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned dst = m68ki_read_16(ea);
+	unsigned dst = m68ki_rmw_16(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-
-	m68ki_write_16(ea, FLAG_Z);
+	m68ki_set_sub_flags_16(src, dst, res);
 }
 
 
@@ -9900,12 +9630,9 @@ M68KMAKE_OP(subi, 32, ., d)
 	unsigned dst = *r_dst;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
+	m68ki_set_sub_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -9913,15 +9640,10 @@ M68KMAKE_OP(subi, 32, ., .)
 {
 	unsigned src = OPER_I_32();
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned dst = m68ki_read_32(ea);
+	unsigned dst = m68ki_rmw_32(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-
-	m68ki_write_32(ea, FLAG_Z);
+	m68ki_set_sub_flags_32(src, dst, res);
 }
 
 
@@ -9932,12 +9654,9 @@ M68KMAKE_OP(subq, 8, ., d)
 	unsigned dst = MASK_OUT_ABOVE_8(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
+	m68ki_set_sub_flags_8(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_8(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_8(*r_dst) | MASK_OUT_ABOVE_8(res);
 }
 
 
@@ -9945,15 +9664,10 @@ M68KMAKE_OP(subq, 8, ., .)
 {
 	unsigned src = (((REG_IR >> 9) - 1) & 7) + 1;
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned dst = m68ki_read_8(ea);
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = MASK_OUT_ABOVE_8(res);
-	FLAG_X = FLAG_C = CFLAG_8(res);
-	FLAG_V = VFLAG_SUB_8(src, dst, res);
-
-	m68ki_write_8(ea, FLAG_Z);
+	m68ki_set_sub_flags_8(src, dst, res);
 }
 
 
@@ -9964,12 +9678,9 @@ M68KMAKE_OP(subq, 16, ., d)
 	unsigned dst = MASK_OUT_ABOVE_16(*r_dst);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
+	m68ki_set_sub_flags_16(src, dst, res);
 
-	*r_dst = MASK_OUT_BELOW_16(*r_dst) | FLAG_Z;
+	*r_dst = MASK_OUT_BELOW_16(*r_dst) | MASK_OUT_ABOVE_16(res);
 }
 
 
@@ -9985,15 +9696,10 @@ M68KMAKE_OP(subq, 16, ., .)
 {
 	unsigned src = (((REG_IR >> 9) - 1) & 7) + 1;
 	unsigned ea = M68KMAKE_GET_EA_AY_16;
-	unsigned dst = m68ki_read_16(ea);
+	unsigned dst = m68ki_rmw_16(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = MASK_OUT_ABOVE_16(res);
-	FLAG_X = FLAG_C = CFLAG_16(res);
-	FLAG_V = VFLAG_SUB_16(src, dst, res);
-
-	m68ki_write_16(ea, FLAG_Z);
+	m68ki_set_sub_flags_16(src, dst, res);
 }
 
 
@@ -10004,12 +9710,9 @@ M68KMAKE_OP(subq, 32, ., d)
 	unsigned dst = *r_dst;
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
+	m68ki_set_sub_flags_32(src, dst, res);
 
-	*r_dst = FLAG_Z;
+	*r_dst = MASK_OUT_ABOVE_32(res);
 }
 
 
@@ -10025,15 +9728,10 @@ M68KMAKE_OP(subq, 32, ., .)
 {
 	unsigned src = (((REG_IR >> 9) - 1) & 7) + 1;
 	unsigned ea = M68KMAKE_GET_EA_AY_32;
-	unsigned dst = m68ki_read_32(ea);
+	unsigned dst = m68ki_rmw_32(ea, M68KI_RMW_SUB, src);
 	unsigned res = dst - src;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = MASK_OUT_ABOVE_32(res);
-	FLAG_X = FLAG_C = CFLAG_SUB_32(src, dst, res);
-	FLAG_V = VFLAG_SUB_32(src, dst, res);
-
-	m68ki_write_32(ea, FLAG_Z);
+	m68ki_set_sub_flags_32(src, dst, res);
 }
 
 
@@ -10228,21 +9926,9 @@ M68KMAKE_OP(tas, 8, ., d)
 M68KMAKE_OP(tas, 8, ., .)
 {
 	unsigned ea = M68KMAKE_GET_EA_AY_8;
-	unsigned dst = m68ki_read_8(ea);
-	unsigned allow_writeback;
+	unsigned dst = m68ki_rmw_8(ea, M68KI_RMW_TAS, 0x80);
 
-	FLAG_Z = dst;
-	FLAG_N = NFLAG_8(dst);
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
-
-	/* The Genesis/Megadrive games Gargoyles and Ex-Mutants need the TAS writeback
-       disabled in order to function properly.  Some Amiga software may also rely
-       on this, but only when accessing specific addresses so additional functionality
-       will be needed. */
-	allow_writeback = m68ki_tas_callback();
-
-	if (allow_writeback==1) m68ki_write_8(ea, dst | 0x80);
+	m68ki_set_logic_flags_8(dst);
 }
 
 
@@ -10376,10 +10062,7 @@ M68KMAKE_OP(tst, 8, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_8(DY);
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -10387,10 +10070,7 @@ M68KMAKE_OP(tst, 8, ., .)
 {
 	unsigned res = M68KMAKE_GET_OPER_AY_8;
 
-	FLAG_N = NFLAG_8(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_8(res);
 }
 
 
@@ -10400,10 +10080,7 @@ M68KMAKE_OP(tst, 8, ., pcdi)
 	{
 		unsigned res = OPER_PCDI_8();
 
-		FLAG_N = NFLAG_8(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_8(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10416,10 +10093,7 @@ M68KMAKE_OP(tst, 8, ., pcix)
 	{
 		unsigned res = OPER_PCIX_8();
 
-		FLAG_N = NFLAG_8(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_8(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10432,10 +10106,7 @@ M68KMAKE_OP(tst, 8, ., i)
 	{
 		unsigned res = OPER_I_8();
 
-		FLAG_N = NFLAG_8(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_8(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10446,10 +10117,7 @@ M68KMAKE_OP(tst, 16, ., d)
 {
 	unsigned res = MASK_OUT_ABOVE_16(DY);
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -10459,10 +10127,7 @@ M68KMAKE_OP(tst, 16, ., a)
 	{
 		unsigned res = MAKE_INT_16(AY);
 
-		FLAG_N = NFLAG_16(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_16(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10473,10 +10138,7 @@ M68KMAKE_OP(tst, 16, ., .)
 {
 	unsigned res = M68KMAKE_GET_OPER_AY_16;
 
-	FLAG_N = NFLAG_16(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_16(res);
 }
 
 
@@ -10486,10 +10148,7 @@ M68KMAKE_OP(tst, 16, ., pcdi)
 	{
 		unsigned res = OPER_PCDI_16();
 
-		FLAG_N = NFLAG_16(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_16(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10502,10 +10161,7 @@ M68KMAKE_OP(tst, 16, ., pcix)
 	{
 		unsigned res = OPER_PCIX_16();
 
-		FLAG_N = NFLAG_16(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_16(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10518,10 +10174,7 @@ M68KMAKE_OP(tst, 16, ., i)
 	{
 		unsigned res = OPER_I_16();
 
-		FLAG_N = NFLAG_16(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_16(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10532,10 +10185,7 @@ M68KMAKE_OP(tst, 32, ., d)
 {
 	unsigned res = DY;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -10545,10 +10195,7 @@ M68KMAKE_OP(tst, 32, ., a)
 	{
 		unsigned res = AY;
 
-		FLAG_N = NFLAG_32(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_32(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10559,10 +10206,7 @@ M68KMAKE_OP(tst, 32, ., .)
 {
 	unsigned res = M68KMAKE_GET_OPER_AY_32;
 
-	FLAG_N = NFLAG_32(res);
-	FLAG_Z = res;
-	FLAG_V = VFLAG_CLEAR;
-	FLAG_C = CFLAG_CLEAR;
+	m68ki_set_logic_flags_32(res);
 }
 
 
@@ -10572,10 +10216,7 @@ M68KMAKE_OP(tst, 32, ., pcdi)
 	{
 		unsigned res = OPER_PCDI_32();
 
-		FLAG_N = NFLAG_32(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_32(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10588,10 +10229,7 @@ M68KMAKE_OP(tst, 32, ., pcix)
 	{
 		unsigned res = OPER_PCIX_32();
 
-		FLAG_N = NFLAG_32(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_32(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10604,10 +10242,7 @@ M68KMAKE_OP(tst, 32, ., i)
 	{
 		unsigned res = OPER_I_32();
 
-		FLAG_N = NFLAG_32(res);
-		FLAG_Z = res;
-		FLAG_V = VFLAG_CLEAR;
-		FLAG_C = CFLAG_CLEAR;
+		m68ki_set_logic_flags_32(res);
 		return;
 	}
 	m68ki_exception_illegal();
@@ -10624,6 +10259,7 @@ M68KMAKE_OP(unlk, 32, ., .)
 {
 	unsigned* r_dst = &AY;
 
+	m68ki_save_da(15);
 	REG_A[7] = *r_dst;
 	*r_dst = m68ki_pull_32();
 }
@@ -150,6 +150,22 @@
 #define M68K_EMULATE_FC             OPT_OFF
 #define M68K_SET_FC_CALLBACK(A)     your_set_fc_handler_function(A)
 
+/* If ON, the CPU will pass the function code of each access straight to the
+ * memory functions, calling m68k_read_memory_8_fc() and so on in place of
+ * m68k_read_memory_8() and the set fc callback.
+ */
+#define M68K_MEMORY_FC              OPT_OFF
+
+/* If ON, the memory functions and callbacks get the pointer set with
+ * m68k_set_user_context() as their first argument, so a host running
+ * several CPUs can tell which machine an access belongs to.
+ * The handlers named with OPT_SPECIFY_HANDLER get it too, so their macros
+ * take it as an extra first parameter, e.g.
+ * #define M68K_INT_ACK_CALLBACK(U, A) your_int_ack_handler_function(U, A)
+ * #define M68K_RESET_CALLBACK(U)      your_reset_handler_function(U)
+ */
+#define M68K_USER_CONTEXT           OPT_OFF
+
 /* If ON, CPU will call the pc changed callback when it changes the PC by a
  * large value.  This allows host programs to be nicer when it comes to
  * fetching immediate data and instructions on a banked memory system.
@@ -169,6 +185,183 @@
 #define M68K_EMULATE_PREFETCH       OPT_OFF
 
 
+/* If ON, the CPU will decode runs of instructions (up to the next change of
+ * flow) once and replay them from a block cache, which saves the opcode and
+ * extension word fetches for code that has already been seen.
+ * Writes made by the CPU invalidate any cached code they touch.  Writes made
+ * by the host (DMA, bank switching, loading code) must be reported using
+ * m68k_invalidate_block_cache() or m68k_flush_block_cache().
+ * M68K_BLOCK_CACHE_BLOCKS is the number of cached blocks (a power of 2), and
+ * M68K_BLOCK_CACHE_LENGTH the maximum number of instructions per block.
+ * NOTE: This cannot be used together with M68K_EMULATE_PREFETCH.
+ */
+#define M68K_BLOCK_CACHE            OPT_OFF
+#define M68K_BLOCK_CACHE_BLOCKS     1024
+#define M68K_BLOCK_CACHE_LENGTH     16
+
+
+/* If ON, the block cache will run pairs of instructions listed in the
+ * M68KMAKE_FUSED_OPCODES section of m68k_in.c (or in the file given to
+ * m68kmake as its third argument) with one dispatch, through fused handlers
+ * that m68kmake generates.  Timing, tracing and interrupts are the same as
+ * when the two instructions are run one at a time.
+ * NOTE: This needs M68K_BLOCK_CACHE, and cannot be used together with
+ *       M68K_INSTRUCTION_HOOK.
+ */
+#define M68K_FUSED_OPCODES          OPT_OFF
+
+
+/* If ON, the block cache will run the opcode handlers listed in the
+ * M68KMAKE_FLAGLESS_OPCODES section of m68k_in.c through flagless versions
+ * that m68kmake generates, which don't set N, Z, V and C, wherever a later
+ * instruction in the same block is also listed and so sets all four again
+ * before anything can see them.  Only the instructions listed in the
+ * M68KMAKE_FLAGS_UNUSED_OPCODES section may come in between.  The flagless
+ * version is only used when that instruction is sure to be reached, so
+ * tracing, interrupts and the end of the timeslice see the same flags as
+ * without it.
+ * NOTE: This needs M68K_BLOCK_CACHE, and cannot be used together with
+ *       M68K_INSTRUCTION_HOOK.
+ */
+#define M68K_FLAGLESS_OPCODES       OPT_OFF
+
+
+/* If ON, blocks that the block cache replays often are translated to x86-64
+ * code.  Moves, add, sub, cmp and lea with register, (An), (An)+, -(An) and
+ * d16(An) operands, Bcc, DBcc and some register to register ALU instructions
+ * are computed in place, reading and writing memory mapped with
+ * m68k_map_memory() directly.  Everything else calls its opcode handler, so
+ * flags, timing, exceptions and memory accesses are exactly the same as when
+ * interpreting.
+ * It can be switched on and off while running with m68k_set_jit().
+ * M68K_JIT_THRESHOLD is how many times a block is replayed before it is
+ * translated, and M68K_JIT_CODE_SIZE the bytes of memory for translations.
+ * This needs an x86-64 Unix host (others silently use the block cache alone).
+ * NOTE: This needs M68K_BLOCK_CACHE.
+ */
+#define M68K_JIT                    OPT_OFF
+#define M68K_JIT_THRESHOLD          16
+#define M68K_JIT_CODE_SIZE          (4 << 20)
+
+
+/* If ON, the CPU will run code that was recompiled to C ahead of time by
+ * m68krec, whenever the PC lands on the start of a recompiled block (see
+ * m68k_set_static_code()).  The recompiled code calls the same opcode
+ * handlers as the interpreter, so it behaves exactly the same.
+ * NOTE: This cannot be used together with M68K_EMULATE_PREFETCH.
+ */
+#define M68K_STATIC_CODE            OPT_OFF
+
+
+/* If ON, m68k_execute() will run instructions in a dispatcher generated by
+ * m68kmake, which jumps from one opcode handler to the next with a computed
+ * goto.  The hot handlers listed in the M68KMAKE_THREADED_OPCODES section of
+ * m68k_in.c get a dispatch jump of their own, which the host branch predictor
+ * can tell apart, and the rest are called through the opcode handler table.
+ * This needs GCC or Clang (other compilers fall back to the normal loop).
+ * The block cache and recompiled code still take over whenever they can.
+ */
+#define M68K_THREADED_DISPATCH      OPT_OFF
+
+
+/* If ON, the opcode handlers will be compiled once for each CPU family
+ * (68000, 68010, 68020/68030 and 68040), with the CPU type tests and timing
+ * values of that family known at compile time, and m68k_set_cpu_type() will
+ * switch between the resulting jump tables.  This makes m68kops.c about four
+ * times as large and slow to compile, and is only useful with optimizations
+ * turned on.
+ */
+#define M68K_SPECIALIZE_CPU         OPT_OFF
+
+
+/* If ON, MOVE, MOVEQ, TST, CLR, the logical instructions and ADD, SUB and
+ * CMP (and a few others that set the flags the same way) only note their
+ * source and result, and N, Z, V and C are worked out when something reads
+ * them: a conditional instruction, one that changes only some of the flags,
+ * MOVE from SR or CCR, an exception or m68k_get_reg().  Most of the time the
+ * next instruction sets them again first.  X is still set straight away.
+ * The flags seen by the guest and the host are the same either way.
+ */
+#define M68K_LAZY_FLAGS             OPT_OFF
+
+
+/* If ON, the CPU will recognize loops that do nothing but wait and skip
+ * ahead to the end of the timeslice (or of the loop count), using up the
+ * clocks the skipped times round would have taken.  These are a dbf to
+ * itself, and a btst or tst followed by a bcc back to it, where the btst/tst
+ * reads a data register or an address the idle read callback returns nonzero
+ * for.  It must only do so if reading the address has no side effects and
+ * its value can't change before m68k_execute() returns (or, with M68K_EVENTS,
+ * before the next event).
+ * m68k_get_idle_cycles() tells how many clocks were skipped.  The instruction
+ * hook isn't called for the skipped instructions.
+ * The default callback returns 0, so only register loops are skipped.
+ */
+#define M68K_IDLE_SKIP              OPT_OFF
+#define M68K_IDLE_READ_CALLBACK(A)  your_idle_read_handler_function(A)
+
+
+/* If ON, devices can register timed events (see m68k_add_event()), and
+ * m68k_execute() will run up to each event in turn and call it back, so the
+ * host doesn't have to pick timeslice lengths and poll its devices after each
+ * one.  While the CPU is stopped, it goes straight to the next event.
+ * Each CPU context has its own events.
+ * M68K_MAX_EVENTS is the number of events that can be added.
+ */
+#define M68K_EVENTS                 OPT_OFF
+#define M68K_MAX_EVENTS             32
+
+
+/* If ON, the host can map pages of guest memory straight to host memory (see
+ * m68k_map_memory()), and the CPU will read and write those without calling
+ * the memory callbacks.  Word and long word accesses that cross into the
+ * next page still go to the callbacks, so they must cover mapped memory too.
+ * M68K_MEMORY_MAP_PAGE_SHIFT sets the page size.  The page tables take
+ * 2 pointers per page of the 4GB address space.
+ * If M68K_MEMORY_MAP_HOST_ENDIAN is ON, mapped memory holds each word in host
+ * byte order instead of big-endian, so word and long word accesses don't
+ * need to swap bytes (see m68k_swap_memory()).
+ */
+#define M68K_MEMORY_MAP             OPT_OFF
+#define M68K_MEMORY_MAP_PAGE_SHIFT  16
+#define M68K_MEMORY_MAP_HOST_ENDIAN OPT_OFF
+
+
+/* If ON along with M68K_MEMORY_MAP, the host can also hand pages of guest
+ * memory to devices (see m68k_map_region()), and the CPU will call the
+ * device's handler for the access size instead of the memory callbacks, so
+ * the host doesn't have to decode those addresses itself.  The region table
+ * takes another pointer per page.
+ */
+#define M68K_MEMORY_REGIONS         OPT_OFF
+
+
+/* If ON, MOVEM, MOVE16 and FMOVEM will move their data with one call to
+ * m68k_read_memory_block() or m68k_write_memory_block() when it isn't all in
+ * one page of mapped memory (see M68K_MEMORY_MAP), instead of one memory
+ * callback per register.
+ */
+#define M68K_BULK_TRANSFERS         OPT_OFF
+
+
+/* If ON, instructions that read, modify and write back the same memory
+ * operand (TAS, CAS, ADDQ, NOT, NEG, BSET, ...) will make one call to
+ * m68k_rmw_memory_8/16/32() instead of a read callback and a write callback,
+ * unless the operand is in mapped memory (see M68K_MEMORY_MAP).
+ */
+#define M68K_RMW_CALLBACKS          OPT_OFF
+
+
+/* If ON, every write the CPU makes (to mapped memory or through the write
+ * callbacks) marks its page in a dirty page bitmap, which the host reads and
+ * clears with m68k_get_dirty_pages().
+ * M68K_DIRTY_PAGE_SHIFT sets the page size.  The bitmap takes 1 bit per page
+ * of the 4GB address space.
+ */
+#define M68K_DIRTY_PAGES            OPT_OFF
+#define M68K_DIRTY_PAGE_SHIFT       12
+
+
 /* If ON, the CPU will generate address error exceptions if it tries to
  * access a word or longword at an odd address.
  * NOTE: This is only emulated properly for 68000 mode.
@@ -176,6 +369,18 @@
 #define M68K_EMULATE_ADDRESS_ERROR  OPT_OFF
 
 
+/* If ON, bus errors and address errors won't longjmp() out of the instruction
+ * that caused them.  The exception is taken straight away, and the rest of
+ * the instruction then runs without accessing memory or calling back the
+ * host, after which the CPU is put back into the state the exception left it
+ * in.  This saves calling setjmp() every time m68k_execute() or m68k_step()
+ * is entered, which adds up when running in very short timeslices.
+ * NOTE: m68k_pulse_bus_error() will return to the memory handler that called
+ * it, which should then return without carrying out the access.
+ */
+#define M68K_PENDING_FAULTS         OPT_OFF
+
+
 /* Turn ON to enable logging of illegal instruction calls.
  * M68K_LOG_FILEHANDLE must be #defined to a stdio file stream.
  * Turn on M68K_LOG_1010_1111 to log all 1010 and 1111 calls.
@@ -188,6 +393,19 @@
  * so enable this only if it's useful */
 #define M68K_EMULATE_PMMU   OPT_ON
 
+/* If ON, PMMU translations are kept in an address translation cache, like
+ * the 68030's ATC, so the translation tables are only walked on a miss.
+ * PFLUSH and PMOVE to TC, SRP or CRP flush it and PLOAD fills it.  As on a
+ * real 68030, the guest has to flush it after changing a descriptor.
+ * With M68K_MEMORY_MAP, each entry also points to the mapped memory behind
+ * its page, so a translated access to RAM is a tag compare and a load.
+ * On a 68040 it is split into instruction and data halves of
+ * M68K_PMMU_ATC_SIZE entries each, and PFLUSH/MOVEC flush it instead.
+ * M68K_PMMU_ATC_SIZE is the number of entries (a power of 2).
+ */
+#define M68K_PMMU_ATC               OPT_OFF
+#define M68K_PMMU_ATC_SIZE          256
+
 /* ----------------------------- COMPATIBILITY ---------------------------- */
 
 /* The following options set optimizations that violate the current ANSI
@@ -42,12 +42,15 @@ extern void m68040_fpu_op0(void);
 extern void m68040_fpu_op1(void);
 extern void m68881_mmu_ops(void);
 extern unsigned char m68ki_cycles[][0x10000];
-extern void (*m68ki_instruction_jump_table[0x10000])(void); /* opcode handler jump table */
 extern void m68ki_build_opcode_table(void);
 
+#include <string.h>
 #include "m68kops.h"
 #include "m68kcpu.h"
 
+#if M68KI_MAP_SWAPPED && defined(__SSE2__)
+#include <emmintrin.h>
+#endif /* M68KI_MAP_SWAPPED && __SSE2__ */
 #include "m68kfpu.c"
 #include "m68kmmu.h" // uses some functions from m68kfpu.c which are static !
 
@@ -90,7 +93,83 @@ unsigned    m68ki_aerr_address;
 unsigned    m68ki_aerr_write_mode;
 unsigned    m68ki_aerr_fc;
 
+#if M68K_PENDING_FAULTS
+m68ki_cpu_core m68ki_fault_cpu;                      /* CPU state once a fault was taken */
+int m68ki_fault_cycles;                              /* Clocks remaining at that point */
+#else
 jmp_buf m68ki_bus_error_jmp_buf;
+#endif /* M68K_PENDING_FAULTS */
+
+#if M68K_THREADED_DISPATCH && M68K_SPECIALIZE_CPU
+void (*m68ki_threaded_execute)(void) = m68ki_threaded_execute_0;
+#endif /* M68K_THREADED_DISPATCH && M68K_SPECIALIZE_CPU */
+
+#if M68K_BLOCK_CACHE
+/* Predecoded blocks, indexed by PC */
+static m68ki_block_cache_block m68ki_block_cache[M68K_BLOCK_CACHE_BLOCKS];
+
+/* One bit per page of address space, set if a block may cover the page */
+uint8_t         m68ki_block_cache_pages[1 << (32 - M68K_BLOCK_CACHE_PAGE_SHIFT - 3)];
+
+/* The blocks covering each page, hashed by page */
+static m68ki_block_cache_link* m68ki_block_cache_page_lists[M68K_BLOCK_CACHE_BLOCKS];
+
+/* Last id given to a CPU (see m68ki_block_cache_new_cpu()) */
+static unsigned m68ki_block_cache_last_id;
+
+/* Instruction stream of the block being replayed */
+unsigned        m68ki_block_cache_fetch_pc;
+unsigned        m68ki_block_cache_fetch_length;
+const uint16_t* m68ki_block_cache_fetch_words;
+
+/* End of the last instruction stream fetch from memory */
+unsigned        m68ki_block_cache_fetch_end;
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_FUSED_OPCODES
+/* Address of the second instruction of the fused pair being run (see m68kcpu.h) */
+unsigned        m68ki_fused_pc;
+#endif /* M68K_FUSED_OPCODES */
+
+#if M68K_STATIC_CODE
+/* Statically recompiled code (see m68k_set_static_code()) */
+unsigned m68ki_static_code_start;
+unsigned m68ki_static_code_size;                     /* 0 if there isn't any */
+static int (*m68ki_static_code_execute)(unsigned pc);
+#endif /* M68K_STATIC_CODE */
+
+#if M68K_MEMORY_MAP
+/* Host memory behind each page of the address space, or NULL if the callbacks
+ * handle it (see m68k_map_memory())
+ */
+uint8_t* m68ki_map_read_pages[M68KI_MAP_PAGES];
+uint8_t* m68ki_map_write_pages[M68KI_MAP_PAGES];
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+/* Device behind each page, or NULL (see m68k_map_region()) */
+const m68k_region* m68ki_map_regions[M68KI_MAP_PAGES];
+#endif /* M68KI_MAP_REGIONS */
+
+#if M68K_DIRTY_PAGES
+/* One bit per page of address space, set when the CPU writes to the page */
+uint64_t m68ki_dirty_pages[M68KI_DIRTY_WORDS];
+#endif /* M68K_DIRTY_PAGES */
+
+#if M68KI_CODE_PAGE
+/* Mapped page the instruction stream is fetched from (see m68kcpu.h) */
+const uint8_t* m68ki_code_page;
+unsigned m68ki_code_page_start;
+unsigned m68ki_code_page_limit;                      /* 0 if there's no page */
+#endif /* M68KI_CODE_PAGE */
+
+#if M68K_PMMU_ATC
+/* PMMU translations (see m68kmmu.h), shared by all CPU contexts */
+m68ki_atc_entry m68ki_atc[2 * M68K_PMMU_ATC_SIZE];   /* Data half, then instruction half */
+unsigned m68ki_atc_shift;                            /* log2 of the ATC page size */
+unsigned long long m68ki_atc_hits;
+unsigned long long m68ki_atc_misses;
+#endif /* M68K_PMMU_ATC */
 
 /* Used by shift & rotate instructions */
 const uint8_t m68ki_shift_8_table[65] =
@@ -533,8 +612,9 @@ const uint8_t m68ki_ea_idx_cycle_table[64] =
 
 /* Interrupt acknowledge */
 static int default_int_ack_callback_data;
-static int default_int_ack_callback(int int_level)
+static int default_int_ack_callback(M68K_USER_PARAM int int_level)
 {
+	m68ki_ignore_user();
 	default_int_ack_callback_data = int_level;
 	CPU_INT_LEVEL = 0;
 	return M68K_INT_ACK_AUTOVECTOR;
@@ -542,67 +622,865 @@ static int default_int_ack_callback(int int_level)
 
 /* Breakpoint acknowledge */
 static unsigned default_bkpt_ack_callback_data;
-static void default_bkpt_ack_callback(unsigned data)
+static void default_bkpt_ack_callback(M68K_USER_PARAM unsigned data)
 {
+	m68ki_ignore_user();
 	default_bkpt_ack_callback_data = data;
 }
 
 /* Called when a reset instruction is executed */
-static void default_reset_instr_callback(void)
+static void default_reset_instr_callback(M68K_USER_VOID)
 {
+	m68ki_ignore_user();
 }
 
 /* Called when a cmpi.l #v, dn instruction is executed */
-static void default_cmpild_instr_callback(unsigned val, int reg)
+static void default_cmpild_instr_callback(M68K_USER_PARAM unsigned val, int reg)
 {
+	m68ki_ignore_user();
 	(void)val;
 	(void)reg;
 }
 
 /* Called when a rte instruction is executed */
-static void default_rte_instr_callback(void)
+static void default_rte_instr_callback(M68K_USER_VOID)
 {
+	m68ki_ignore_user();
 }
 
 /* Called when a tas instruction is executed */
-static int default_tas_instr_callback(void)
+static int default_tas_instr_callback(M68K_USER_VOID)
 {
+	m68ki_ignore_user();
 	return 1; // allow writeback
 }
 
 /* Called when an illegal instruction is encountered */
-static int default_illg_instr_callback(int opcode)
+static int default_illg_instr_callback(M68K_USER_PARAM int opcode)
 {
+	m68ki_ignore_user();
 	(void)opcode;
 	return 0; // not handled : exception will occur
 }
 
 /* Called when the program counter changed by a large value */
 static unsigned default_pc_changed_callback_data;
-static void default_pc_changed_callback(unsigned new_pc)
+static void default_pc_changed_callback(M68K_USER_PARAM unsigned new_pc)
 {
+	m68ki_ignore_user();
 	default_pc_changed_callback_data = new_pc;
 }
 
 /* Called every time there's bus activity (read/write to/from memory */
 static unsigned default_set_fc_callback_data;
-static void default_set_fc_callback(unsigned new_fc)
+static void default_set_fc_callback(M68K_USER_PARAM unsigned new_fc)
 {
+	m68ki_ignore_user();
 	default_set_fc_callback_data = new_fc;
 }
 
 /* Called every instruction cycle prior to execution */
-static void default_instr_hook_callback(unsigned pc)
+static void default_instr_hook_callback(M68K_USER_PARAM unsigned pc)
 {
+	m68ki_ignore_user();
 	(void)pc;
 }
 
+/* Called when a loop polls an address */
+static int default_idle_read_callback(M68K_USER_PARAM unsigned address)
+{
+	m68ki_ignore_user();
+	(void)address;
+	return 0; // not idle : the loop runs normally
+}
+
 
 #if M68K_EMULATE_ADDRESS_ERROR
 	#include <setjmp.h>
 	jmp_buf m68ki_aerr_trap;
 #endif /* M68K_EMULATE_ADDRESS_ERROR */
 
+/* ======================================================================== */
+/* ============================== BLOCK CACHE ============================= */
+/* ======================================================================== */
+
+#if M68K_BLOCK_CACHE
+
+/* Take a block off the lists of the pages it covers */
+static void m68ki_block_cache_unlink(m68ki_block_cache_block* block)
+{
+	m68ki_block_cache_link* link;
+
+	for(link = block->link; link < block->link + block->links; link++)
+	{
+		*link->prev = link->next;
+		if(link->next)
+			link->next->prev = link->prev;
+	}
+	block->links = 0;
+}
+
+/* Invalidate the blocks listed under a page that a write of SIZE bytes at
+ * ADDRESS lands in.  Once no blocks are left in the page, writes to it
+ * don't come here any more.
+ */
+void m68ki_block_cache_invalidate(unsigned page, unsigned address, unsigned size)
+{
+	m68ki_block_cache_link* link = m68ki_block_cache_page_lists[page & (M68K_BLOCK_CACHE_BLOCKS-1)];
+	int left = 0;
+
+	while(link)
+	{
+		m68ki_block_cache_block* block = link->block;
+		unsigned start = block->pc;
+
+		/* Blocks and writes may wrap around the end of the address space */
+		if(link->page == page)
+		{
+			if(ADDRESS_68K(address - start) < block->span || ADDRESS_68K(start - address) < size)
+			{
+				/* Unlinking may take the next link off the list too */
+				block->valid = 0;
+				m68ki_block_cache_unlink(block);
+				link = m68ki_block_cache_page_lists[page & (M68K_BLOCK_CACHE_BLOCKS-1)];
+				left = 0;
+#if M68K_FUSED_OPCODES
+				/* Don't go on to the second half of a fused pair that may have changed */
+				m68ki_fused_pc = 1;
+#endif /* M68K_FUSED_OPCODES */
+				continue;
+			}
+			left = 1;
+		}
+		link = link->next;
+	}
+
+	if(!left)
+		m68ki_block_cache_pages[page >> 3] &= ~(1 << (page & 7));
+}
+
+/* Invalidate all blocks covering a page */
+static void m68ki_block_cache_invalidate_page(unsigned page)
+{
+	m68ki_block_cache_invalidate(page, page << M68K_BLOCK_CACHE_PAGE_SHIFT, 1 << M68K_BLOCK_CACHE_PAGE_SHIFT);
+}
+
+/* List a block under the pages covered by the SIZE bytes at ADDRESS */
+static void m68ki_block_cache_add_pages(m68ki_block_cache_block* block, unsigned address, unsigned size)
+{
+	unsigned page = ADDRESS_68K(address) >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+	unsigned last = ADDRESS_68K(address + size - 1) >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+	m68ki_block_cache_link** list;
+	m68ki_block_cache_link* link;
+
+	for(;; page = last)
+	{
+		for(link = block->link; link < block->link + block->links; link++)
+			if(link->page == page)
+				break;
+		if(link == block->link + block->links)
+		{
+			list = &m68ki_block_cache_page_lists[page & (M68K_BLOCK_CACHE_BLOCKS-1)];
+			link->block = block;
+			link->page = page;
+			link->prev = list;
+			link->next = *list;
+			if(*list)
+				(*list)->prev = &link->next;
+			*list = link;
+			block->links++;
+			m68ki_block_cache_pages[page >> 3] |= 1 << (page & 7);
+		}
+		if(page == last)
+			break;
+	}
+}
+
+/* Address space instructions are fetched from */
+#define m68ki_block_cache_fc() (FLAG_S | FUNCTION_CODE_USER_PROGRAM)
+
+/* Blocks must not cross a change of address space if the host can see it */
+#if M68KI_EMULATE_FC
+	#define m68ki_block_cache_same_fc(B) (m68ki_block_cache_fc() == (B)->fc)
+#else
+	#define m68ki_block_cache_same_fc(B) 1
+#endif /* M68KI_EMULATE_FC */
+
+#if M68K_FLAGLESS_OPCODES
+/* Work back from the end of a block to find the instructions whose N, Z, V
+ * and C are never seen.  The flags are live at the end of the block.  An
+ * instruction listed in M68KMAKE_FLAGLESS_OPCODES sets them all without
+ * looking at them first, so they are dead before it, back past any
+ * instructions listed in M68KMAKE_FLAGS_UNUSED_OPCODES.  Anything else
+ * might look at them.
+ */
+static void m68ki_block_cache_find_dead_flags(m68ki_block_cache_block* block)
+{
+	unsigned cycles = 0; /* Clocks to the instruction that sets the flags */
+	int dead = 0;
+	int i;
+
+	for(i = block->count - 1; i >= 0; i--)
+	{
+		m68ki_block_cache_instr* instr = &block->instr[i];
+
+		cycles += instr->cycles;
+		instr->flagless = dead ? m68ki_find_flagless_handler(instr->handler) : NULL;
+		instr->flags_cycles = cycles;
+
+		if(m68ki_find_flagless_handler(instr->handler))
+		{
+			dead = 1;
+			cycles = 0;
+		}
+		else if(!m68ki_handler_leaves_flags(instr->handler))
+			dead = 0;
+	}
+}
+#else
+#define m68ki_block_cache_find_dead_flags(B)
+#endif /* M68K_FLAGLESS_OPCODES */
+
+/* Execute instructions normally, predecoding them into a block as we go.
+ * Anything other than stepping to the following instruction (a branch,
+ * jump, exception or interrupt) ends the block.
+ */
+static void m68ki_block_cache_record(m68ki_block_cache_block* block)
+{
+	unsigned linear;
+
+	m68ki_block_cache_unlink(block);
+	block->pc = REG_PC;
+	block->fc = m68ki_block_cache_fc();
+	block->cpu_id = m68ki_cpu.block_cache_id;
+	block->length = 0;
+	block->span = 0;
+	block->count = 0;
+	block->valid = 1;
+#if M68K_JIT
+	block->hits = 0;
+	block->jit = NULL;
+#endif /* M68K_JIT */
+
+	do
+	{
+		m68ki_block_cache_instr* instr = &block->instr[block->count];
+		unsigned end;
+		int i;
+
+		m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+		m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+		m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_INSTRUCTION_HOOK
+		/* The instruction hook moved the PC, so end the block */
+		if(REG_PC != block->pc + block->length)
+		{
+			block->valid = block->count != 0;
+			REG_PPC = REG_PC;
+			m68ki_start_rollback();
+			REG_IR = m68ki_read_imm_16();
+			m68ki_instruction_jump_table[REG_IR]();
+			USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+			m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+			return;
+		}
+#endif /* M68K_INSTRUCTION_HOOK */
+
+		/* Until we know how long it is, a write anywhere the instruction
+		 * could be invalidates the block.
+		 */
+		block->span = block->length + M68K_BLOCK_CACHE_MAX_WORDS*2;
+		m68ki_block_cache_add_pages(block, REG_PC, M68K_BLOCK_CACHE_MAX_WORDS*2);
+
+		REG_PPC = REG_PC;
+		m68ki_start_rollback();
+
+		REG_IR = m68ki_read_imm_16();
+		instr->pc = REG_PPC;
+		instr->ir = REG_IR;
+		instr->cycles = CYC_INSTRUCTION[REG_IR];
+		instr->handler = m68ki_instruction_jump_table[REG_IR];
+#if M68K_FUSED_OPCODES
+		instr->fused = NULL;
+#endif /* M68K_FUSED_OPCODES */
+		instr->handler();
+
+		/* The instruction faulted, so it doesn't belong in the block */
+		if(m68ki_fault_pending())
+			break;
+
+		USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+		m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+
+		/* The instruction wrote to code we already predecoded */
+		if(!block->valid)
+			break;
+
+		/* If we stepped forward, cache everything up to the new PC, including
+		 * any words the handler skipped over (such as the displacement of a
+		 * bcc that wasn't taken).  Otherwise cache as much of the instruction
+		 * as was fetched.  The cached words are a copy of memory, so it does
+		 * no harm if a handler never uses them.
+		 */
+		end = REG_PC;
+		linear = end - instr->pc >= 2 && end - instr->pc <= M68K_BLOCK_CACHE_MAX_WORDS*2;
+		if(!linear)
+		{
+			end = m68ki_block_cache_fetch_end;
+			if(end - instr->pc < 2 || end - instr->pc > M68K_BLOCK_CACHE_MAX_WORDS*2)
+				end = instr->pc + 2;
+		}
+
+		block->words[block->length >> 1] = instr->ir;
+		for(i = (block->length >> 1) + 1; i < (int)(end - block->pc) >> 1; i++)
+			block->words[i] = m68k_read_immediate_16(ADDRESS_68K(block->pc + i*2));
+		block->length = block->span = end - block->pc;
+#if M68K_FUSED_OPCODES
+		/* Pair this instruction up with the one before it if we can */
+		if(block->count)
+			instr[-1].fused = m68ki_find_fused_handler(instr[-1].handler, instr->handler);
+#endif /* M68K_FUSED_OPCODES */
+		block->count++;
+	} while(linear && block->count < M68K_BLOCK_CACHE_LENGTH && block->length < M68K_BLOCK_CACHE_WORDS*2 &&
+			m68ki_block_cache_same_fc(block) && GET_CYCLES() > 0);
+
+	m68ki_block_cache_find_dead_flags(block);
+}
+
+/* Get ready to replay an instruction.  Returns nonzero if the instruction
+ * hook moved the PC, in which case the instruction at the new PC has been
+ * run instead and we must leave the block.
+ */
+static inline int m68ki_block_cache_start_instr(const m68ki_block_cache_instr* instr)
+{
+	m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+	m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+	m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+
+	REG_PPC = REG_PC;
+	m68ki_start_rollback();
+
+#if M68K_INSTRUCTION_HOOK
+	if(REG_PC != instr->pc)
+	{
+		m68ki_block_cache_fetch_length = 0;
+		REG_IR = m68ki_read_imm_16();
+		m68ki_instruction_jump_table[REG_IR]();
+		USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+		m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+		return 1;
+	}
+#else
+	(void)instr;
+#endif /* M68K_INSTRUCTION_HOOK */
+
+	return 0;
+}
+
+#if M68K_FLAGLESS_OPCODES
+/* Returns nonzero if the flags an instruction sets can be left out, because
+ * the replay is sure to go straight on to the instruction that sets them
+ * again.  The instructions in between can't fault or leave the block, but a
+ * trace exception or the end of the timeslice before it would see them.
+ */
+static inline int m68ki_block_cache_flags_dead(const m68ki_block_cache_instr* instr)
+{
+#if M68K_EMULATE_TRACE
+	if(m68ki_tracing)
+		return 0;
+#endif /* M68K_EMULATE_TRACE */
+	return GET_CYCLES() > (int)instr->flags_cycles;
+}
+#endif /* M68K_FLAGLESS_OPCODES */
+
+/* Replay a predecoded block */
+static void m68ki_block_cache_replay(m68ki_block_cache_block* block)
+{
+	const m68ki_block_cache_instr* instr = block->instr;
+	const m68ki_block_cache_instr* end = instr + block->count;
+
+	/* Immediate reads now come from the cached words */
+	m68ki_block_cache_fetch_pc = block->pc;
+	m68ki_block_cache_fetch_words = block->words;
+	m68ki_block_cache_fetch_length = block->length;
+
+	do
+	{
+		if(m68ki_block_cache_start_instr(instr))
+			return;
+
+		REG_IR = instr->ir;
+		REG_PC += 2;
+#if M68K_FUSED_OPCODES
+		if(instr->fused)
+		{
+			/* Run this and the next instruction with one dispatch.  If the
+			 * next one was started, it is left for us to finish.
+			 */
+			m68ki_fused_pc = instr[1].pc;
+			instr->fused();
+			if(!m68ki_fused_pc)
+				instr++;
+		}
+		else
+#endif /* M68K_FUSED_OPCODES */
+#if M68K_FLAGLESS_OPCODES
+		if(instr->flagless && m68ki_block_cache_flags_dead(instr))
+			instr->flagless();
+		else
+#endif /* M68K_FLAGLESS_OPCODES */
+		instr->handler();
+		if(m68ki_fault_pending())
+			break;
+		USE_CYCLES(instr->cycles);
+
+		m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+	} while(++instr != end && REG_PC == instr->pc && block->valid &&
+			m68ki_block_cache_same_fc(block) && GET_CYCLES() > 0);
+
+	m68ki_block_cache_fetch_length = 0;
+}
+
+#include "m68kjit.c"
+
+/* Run the block at PC, predecoding it first if it isn't cached */
+static void m68ki_block_cache_execute(void)
+{
+	m68ki_block_cache_block* block = &m68ki_block_cache[(REG_PC >> 1) & (M68K_BLOCK_CACHE_BLOCKS-1)];
+
+	/* A bus or address error in the first instruction leaves an empty block */
+	if(block->valid && block->count && block->pc == REG_PC && block->fc == m68ki_block_cache_fc() &&
+		block->cpu_id == m68ki_cpu.block_cache_id)
+	{
+#if M68K_JIT
+		if(m68ki_jit_enabled)
+		{
+			if(!block->jit && ++block->hits == M68K_JIT_THRESHOLD)
+				m68ki_jit_compile(block);
+			if(block->jit)
+			{
+				m68ki_jit_run(block);
+				return;
+			}
+		}
+#endif /* M68K_JIT */
+		m68ki_block_cache_replay(block);
+	}
+	else
+		m68ki_block_cache_record(block);
+}
+
+/* Give the CPU in m68ki_cpu an id of its own.  The id is kept in the
+ * context, so blocks recorded by one CPU are never replayed by another, or
+ * by the same CPU after it has changed type.
+ */
+static void m68ki_block_cache_new_cpu(void)
+{
+	m68ki_cpu.block_cache_id = ++m68ki_block_cache_last_id;
+}
+
+#else
+
+#define m68ki_block_cache_new_cpu()
+
+#endif /* M68K_BLOCK_CACHE */
+
+
+
+/* ======================================================================== */
+/* ============================== LAZY FLAGS ============================== */
+/* ======================================================================== */
+
+#if M68K_LAZY_FLAGS
+
+/* Set N, Z, V and C for the instruction recorded by m68ki_set_*_flags(),
+ * exactly as it would have set them itself.  The destination operand is
+ * worked back out of the source and the result.
+ */
+void m68ki_lazy_flags_compute(m68ki_cpu_core* cpu)
+{
+	unsigned src = cpu->lazy_src;
+	unsigned res = cpu->lazy_res;
+	unsigned dst;
+
+	switch(cpu->lazy_op)
+	{
+		case M68KI_LAZY_LOGIC_8:
+			cpu->n_flag = NFLAG_8(res);
+			cpu->not_z_flag = res;
+			cpu->v_flag = VFLAG_CLEAR;
+			cpu->c_flag = CFLAG_CLEAR;
+			break;
+		case M68KI_LAZY_LOGIC_16:
+			cpu->n_flag = NFLAG_16(res);
+			cpu->not_z_flag = res;
+			cpu->v_flag = VFLAG_CLEAR;
+			cpu->c_flag = CFLAG_CLEAR;
+			break;
+		case M68KI_LAZY_LOGIC_32:
+			cpu->n_flag = NFLAG_32(res);
+			cpu->not_z_flag = res;
+			cpu->v_flag = VFLAG_CLEAR;
+			cpu->c_flag = CFLAG_CLEAR;
+			break;
+		case M68KI_LAZY_ADD_8:
+			dst = res - src;
+			cpu->n_flag = NFLAG_8(res);
+			cpu->not_z_flag = MASK_OUT_ABOVE_8(res);
+			cpu->v_flag = VFLAG_ADD_8(src, dst, res);
+			cpu->c_flag = CFLAG_8(res);
+			break;
+		case M68KI_LAZY_ADD_16:
+			dst = res - src;
+			cpu->n_flag = NFLAG_16(res);
+			cpu->not_z_flag = MASK_OUT_ABOVE_16(res);
+			cpu->v_flag = VFLAG_ADD_16(src, dst, res);
+			cpu->c_flag = CFLAG_16(res);
+			break;
+		case M68KI_LAZY_ADD_32:
+			dst = res - src;
+			cpu->n_flag = NFLAG_32(res);
+			cpu->not_z_flag = MASK_OUT_ABOVE_32(res);
+			cpu->v_flag = VFLAG_ADD_32(src, dst, res);
+			cpu->c_flag = CFLAG_ADD_32(src, dst, res);
+			break;
+		case M68KI_LAZY_SUB_8:
+			dst = res + src;
+			cpu->n_flag = NFLAG_8(res);
+			cpu->not_z_flag = MASK_OUT_ABOVE_8(res);
+			cpu->v_flag = VFLAG_SUB_8(src, dst, res);
+			cpu->c_flag = CFLAG_8(res);
+			break;
+		case M68KI_LAZY_SUB_16:
+			dst = res + src;
+			cpu->n_flag = NFLAG_16(res);
+			cpu->not_z_flag = MASK_OUT_ABOVE_16(res);
+			cpu->v_flag = VFLAG_SUB_16(src, dst, res);
+			cpu->c_flag = CFLAG_16(res);
+			break;
+		case M68KI_LAZY_SUB_32:
+			dst = res + src;
+			cpu->n_flag = NFLAG_32(res);
+			cpu->not_z_flag = MASK_OUT_ABOVE_32(res);
+			cpu->v_flag = VFLAG_SUB_32(src, dst, res);
+			cpu->c_flag = CFLAG_SUB_32(src, dst, res);
+			break;
+	}
+	cpu->lazy_op = M68KI_LAZY_NONE;
+}
+
+#endif /* M68K_LAZY_FLAGS */
+
+
+
+/* ======================================================================== */
+/* ============================== IDLE LOOPS ============================== */
+/* ======================================================================== */
+
+#if M68K_IDLE_SKIP
+
+/* Read what the loop tests, without the function code or address checks */
+static unsigned m68ki_idle_read_value(unsigned address, unsigned size)
+{
+#if M68K_MEMORY_MAP
+	const uint8_t* host = m68ki_map_find(m68ki_map_read_pages, address, size);
+
+	if(host)
+		return size == 1 ? m68ki_map_get_8(host) : size == 2 ? m68ki_map_get_16(host) : m68ki_map_get_32(host);
+#endif /* M68K_MEMORY_MAP */
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(address, size);
+		unsigned (*handler)(void* device, unsigned address) = !region ? NULL :
+				size == 1 ? region->read_8 : size == 2 ? region->read_16 : region->read_32;
+
+		if(handler)
+			return handler(region->device, address);
+	}
+#endif /* M68KI_MAP_REGIONS */
+	return size == 1 ? m68ki_host_read_8(address, FLAG_S | FUNCTION_CODE_USER_DATA) :
+			size == 2 ? m68ki_host_read_16(address, FLAG_S | FUNCTION_CODE_USER_DATA) :
+			m68ki_host_read_32(address, FLAG_S | FUNCTION_CODE_USER_DATA);
+}
+
+/* Called when a bcc has gone back over 1 to 4 words.  If it went back to a
+ * btst or tst just before it, which reads a data register or an address that
+ * is idle to poll, and the test would give the same flags the bcc just
+ * branched on, the loop will go round the same way until the timeslice runs
+ * out.  So skip every time round that would get as far as the bcc.
+ */
+void m68ki_idle_poll(void)
+{
+	unsigned pc = REG_PC;
+	unsigned ir, mode, reg, value;
+	unsigned length = 2;
+	unsigned size = 1;                         /* Bytes tested */
+	unsigned bit = 0;
+	unsigned address = 0;
+	int btst = 1;
+	int loop_cycles, left;
+
+	/* Code and data addresses aren't physical with the PMMU on */
+	if(m68ki_tracing || PMMU_ENABLED)
+		return;
+
+	ir = m68k_read_immediate_16(ADDRESS_68K(pc));
+	if((ir & 0xffc0) == 0x0800)                /* btst #n, <ea> */
+	{
+		bit = m68k_read_immediate_16(ADDRESS_68K(pc + 2));
+		length = 4;
+	}
+	else if((ir & 0xf1c0) == 0x0100)           /* btst Dn, <ea> */
+		bit = REG_D[(ir >> 9) & 7];
+	else if((ir & 0xff00) == 0x4a00 && (ir & 0xc0) != 0xc0) /* tst <ea> */
+	{
+		size = 1 << ((ir >> 6) & 3);
+		btst = 0;
+	}
+	else
+		return;
+
+	mode = (ir >> 3) & 7;
+	reg = ir & 7;
+	switch(mode)
+	{
+		case 0:                                /* Dn */
+			break;
+		case 2:                                /* (An) */
+			address = REG_A[reg];
+			break;
+		case 5:                                /* (d16, An) */
+			address = REG_A[reg] + MAKE_INT_16(m68k_read_immediate_16(ADDRESS_68K(pc + length)));
+			length += 2;
+			break;
+		case 7:
+			if(reg == 0)                       /* (xxx).W */
+			{
+				address = MAKE_INT_16(m68k_read_immediate_16(ADDRESS_68K(pc + length)));
+				length += 2;
+				break;
+			}
+			if(reg == 1)                       /* (xxx).L */
+			{
+				address = m68k_read_immediate_32(ADDRESS_68K(pc + length));
+				length += 4;
+				break;
+			}
+			return;
+		default:
+			return;
+	}
+
+	if(pc + length != REG_PPC)
+		return;
+
+	if(mode == 0)
+	{
+		value = REG_D[reg];
+		if(btst)
+			size = 4;
+	}
+	else
+	{
+		address = ADDRESS_68K(address);
+		if((size > 1 && (address & 1)) || !m68ki_idle_read(address))
+			return;
+		value = m68ki_idle_read_value(address, size);
+	}
+
+	/* The flags may be left over from before an interrupt changed things */
+	m68ki_lazy_flags_sync();
+	if(btst)
+	{
+		if(!FLAG_Z != !(value & (1 << (bit & (size*8 - 1)))))
+			return;
+	}
+	else
+	{
+		value = MASK_OUT_ABOVE_32(value << (32 - size*8));
+		if(!FLAG_Z != !value || ((FLAG_N ^ (value >> 24)) & NFLAG_SET) ||
+			(FLAG_V & VFLAG_SET) || (FLAG_C & CFLAG_SET))
+			return;
+	}
+
+	/* Going round once, and what's left once this bcc is paid for */
+	loop_cycles = CYC_INSTRUCTION[ir] + CYC_INSTRUCTION[REG_IR];
+	left = GET_CYCLES() - CYC_INSTRUCTION[REG_IR];
+	if(left > CYC_INSTRUCTION[ir])
+		m68ki_idle_skip((left - CYC_INSTRUCTION[ir] - 1) / loop_cycles + 1, loop_cycles);
+}
+
+#endif /* M68K_IDLE_SKIP */
+
+
+
+/* ======================================================================== */
+/* ============================= MAPPED MEMORY ============================ */
+/* ======================================================================== */
+
+#if M68KI_CODE_PAGE
+/* Called when an instruction fetch is outside the code page */
+void m68ki_code_page_refresh(unsigned address)
+{
+	const uint8_t* page = m68ki_map_read_pages[address >> M68K_MEMORY_MAP_PAGE_SHIFT];
+
+	/* The PMMU's translation isn't cached, so fetch through it every time */
+	if(page && !PMMU_ENABLED)
+	{
+		m68ki_code_page = page;
+		m68ki_code_page_start = address & ~(M68KI_MAP_PAGE_SIZE - 1);
+		m68ki_code_page_limit = M68KI_MAP_PAGE_SIZE - 1;
+	}
+	else
+		m68ki_code_page_limit = 0;
+}
+#endif /* M68KI_CODE_PAGE */
+
+#if M68K_RMW_CALLBACKS
+/* The modify half of a read-modify-write, called by m68k_rmw_memory_N() */
+int m68ki_rmw_modify(unsigned* value, void* context)
+{
+	m68ki_rmw* rmw = (m68ki_rmw*)context;
+
+	return rmw->written = m68ki_rmw_apply(rmw, value);
+}
+#endif /* M68K_RMW_CALLBACKS */
+
+
+
+/* ======================================================================== */
+/* ================================ EVENTS ================================ */
+/* ======================================================================== */
+
+#if M68K_EVENTS
+/* The m68k_execute() timeslice is handed out in chunks that end at the next
+ * armed event, so the main loop itself never has to look at the events.
+ */
+
+static unsigned long long m68ki_event_now(void)
+{
+	if(CPU_EVENTS.running)
+		return CPU_EVENTS.clock + m68ki_initial_cycles - GET_CYCLES();
+	return CPU_EVENTS.clock;
+}
+
+static void m68ki_event_place(int pos, int event)
+{
+	CPU_EVENTS.heap[pos] = event;
+	CPU_EVENTS.event[event].pos = pos;
+}
+
+/* Move the event at pos up or down the heap to where its time belongs */
+static void m68ki_event_sift(int pos)
+{
+	int event = CPU_EVENTS.heap[pos];
+	unsigned long long time = CPU_EVENTS.event[event].time;
+	int child;
+
+	while(pos > 0 && CPU_EVENTS.event[CPU_EVENTS.heap[(pos - 1) / 2]].time > time)
+	{
+		m68ki_event_place(pos, CPU_EVENTS.heap[(pos - 1) / 2]);
+		pos = (pos - 1) / 2;
+	}
+	while((child = pos * 2 + 1) < CPU_EVENTS.heap_size)
+	{
+		if(child + 1 < CPU_EVENTS.heap_size &&
+			CPU_EVENTS.event[CPU_EVENTS.heap[child + 1]].time < CPU_EVENTS.event[CPU_EVENTS.heap[child]].time)
+			child++;
+		if(CPU_EVENTS.event[CPU_EVENTS.heap[child]].time >= time)
+			break;
+		m68ki_event_place(pos, CPU_EVENTS.heap[child]);
+		pos = child;
+	}
+	m68ki_event_place(pos, event);
+}
+
+static void m68ki_event_remove(int event)
+{
+	int pos = CPU_EVENTS.event[event].pos;
+
+	CPU_EVENTS.event[event].pos = -1;
+	if(pos < --CPU_EVENTS.heap_size)
+	{
+		m68ki_event_place(pos, CPU_EVENTS.heap[CPU_EVENTS.heap_size]);
+		m68ki_event_sift(pos);
+	}
+}
+
+/* Call back every event that has come due */
+static void m68ki_event_fire(void)
+{
+	while(CPU_EVENTS.heap_size)
+	{
+		int event = CPU_EVENTS.heap[0];
+
+		if(CPU_EVENTS.event[event].time > m68ki_event_now())
+			break;
+		m68ki_event_remove(event);
+		CPU_EVENTS.firing = 1;
+		CPU_EVENTS.due = CPU_EVENTS.event[event].time;
+		CPU_EVENTS.event[event].callback(M68KI_USER event);
+		CPU_EVENTS.firing = 0;
+	}
+}
+
+/* Hand out the clocks up to the next event, or the rest of the timeslice */
+static void m68ki_event_grant(void)
+{
+	int cycles = CPU_EVENTS.left;
+
+	if(CPU_EVENTS.heap_size)
+	{
+		long long wait = (long long)(CPU_EVENTS.event[CPU_EVENTS.heap[0]].time - m68ki_event_now());
+
+		if(wait < cycles)
+			cycles = wait > 0 ? (int)wait : 0;
+	}
+	CPU_EVENTS.left -= cycles;
+	m68ki_initial_cycles += cycles;
+	ADD_CYCLES(cycles);
+}
+
+/* Called by m68k_execute() once its timeslice is set */
+void m68ki_event_start(void)
+{
+	CPU_EVENTS.running = 1;
+	CPU_EVENTS.left = GET_CYCLES();
+	m68ki_initial_cycles -= CPU_EVENTS.left;
+	SET_CYCLES(0);
+	m68ki_event_grant();
+}
+
+/* Called by m68k_execute() when a chunk runs out.  Fires the events that
+ * came due and returns nonzero if there is more of the timeslice to run.
+ */
+int m68ki_event_next(void)
+{
+	do
+	{
+		m68ki_event_fire();
+		if(CPU_EVENTS.left <= 0)
+			return 0;
+
+		/* The events may have raised an interrupt */
+		m68ki_check_interrupts();
+		m68ki_event_grant();
+	} while(GET_CYCLES() <= 0);
+	return 1;
+}
+
+/* Called by m68k_execute() before it returns */
+void m68ki_event_stop(void)
+{
+	CPU_EVENTS.clock += m68ki_initial_cycles - GET_CYCLES();
+	CPU_EVENTS.running = 0;
+}
+#endif /* M68K_EVENTS */
+
+
+
 /* ======================================================================== */
 /* ================================= API ================================== */
 /* ======================================================================== */
@@ -612,6 +1490,11 @@ unsigned m68k_get_reg(void* context, m68k_register_t regnum)
 {
 	m68ki_cpu_core* cpu = context != NULL ?(m68ki_cpu_core*)context : &m68ki_cpu;
 
+#if M68K_LAZY_FLAGS
+	if(regnum == M68K_REG_SR && cpu->lazy_op)
+		m68ki_lazy_flags_compute(cpu);
+#endif /* M68K_LAZY_FLAGS */
+
 	switch(regnum)
 	{
 		case M68K_REG_D0:	return cpu->dar[0];
@@ -720,219 +1603,188 @@ void m68k_set_reg(m68k_register_t regnum, unsigned value)
 }
 
 /* Set the callbacks */
-void m68k_set_int_ack_callback(int  (*callback)(int int_level))
+void m68k_set_int_ack_callback(int  (*callback)(M68K_USER_PARAM int int_level))
 {
 	CALLBACK_INT_ACK = callback ? callback : default_int_ack_callback;
 }
 
-void m68k_set_bkpt_ack_callback(void  (*callback)(unsigned data))
+void m68k_set_bkpt_ack_callback(void  (*callback)(M68K_USER_PARAM unsigned data))
 {
 	CALLBACK_BKPT_ACK = callback ? callback : default_bkpt_ack_callback;
 }
 
-void m68k_set_reset_instr_callback(void  (*callback)(void))
+void m68k_set_reset_instr_callback(void  (*callback)(M68K_USER_VOID))
 {
 	CALLBACK_RESET_INSTR = callback ? callback : default_reset_instr_callback;
 }
 
-static void m68k_set_cmpild_instr_callback(void  (*callback)(unsigned, int))
+static void m68k_set_cmpild_instr_callback(void  (*callback)(M68K_USER_PARAM unsigned, int))
 {
 	CALLBACK_CMPILD_INSTR = callback ? callback : default_cmpild_instr_callback;
 }
 
-static void m68k_set_rte_instr_callback(void  (*callback)(void))
+static void m68k_set_rte_instr_callback(void  (*callback)(M68K_USER_VOID))
 {
 	CALLBACK_RTE_INSTR = callback ? callback : default_rte_instr_callback;
 }
 
-void m68k_set_tas_instr_callback(int  (*callback)(void))
+void m68k_set_tas_instr_callback(int  (*callback)(M68K_USER_VOID))
 {
 	CALLBACK_TAS_INSTR = callback ? callback : default_tas_instr_callback;
 }
 
-void m68k_set_illg_instr_callback(int  (*callback)(int))
+void m68k_set_illg_instr_callback(int  (*callback)(M68K_USER_PARAM int))
 {
 	CALLBACK_ILLG_INSTR = callback ? callback : default_illg_instr_callback;
 }
 
-void m68k_set_pc_changed_callback(void  (*callback)(unsigned new_pc))
+void m68k_set_pc_changed_callback(void  (*callback)(M68K_USER_PARAM unsigned new_pc))
 {
 	CALLBACK_PC_CHANGED = callback ? callback : default_pc_changed_callback;
 }
 
-void m68k_set_fc_callback(void  (*callback)(unsigned new_fc))
+void m68k_set_fc_callback(void  (*callback)(M68K_USER_PARAM unsigned new_fc))
 {
 	CALLBACK_SET_FC = callback ? callback : default_set_fc_callback;
 }
 
-void m68k_set_instr_hook_callback(void  (*callback)(unsigned pc))
+void m68k_set_instr_hook_callback(void  (*callback)(M68K_USER_PARAM unsigned pc))
 {
 	CALLBACK_INSTR_HOOK = callback ? callback : default_instr_hook_callback;
 }
 
+void m68k_set_idle_read_callback(int  (*callback)(M68K_USER_PARAM unsigned address))
+{
+	CALLBACK_IDLE_READ = callback ? callback : default_idle_read_callback;
+}
+
+void m68k_set_user_context(void* user)
+{
+	CPU_USER_CONTEXT = user;
+}
+
+void* m68k_get_user_context(void)
+{
+	return CPU_USER_CONTEXT;
+}
+
+/* Switch to the opcode handlers compiled for the current CPU type */
+static void m68ki_select_handler_set(void)
+{
+#if M68K_SPECIALIZE_CPU
+#if M68K_THREADED_DISPATCH
+	static void (*const threaded_sets[M68KI_HANDLER_SETS])(void) =
+	{
+		m68ki_threaded_execute_0, m68ki_threaded_execute_1,
+		m68ki_threaded_execute_2, m68ki_threaded_execute_3
+	};
+
+	m68ki_threaded_execute = threaded_sets[M68KI_HANDLER_SET_OF(CPU_TYPE)];
+#endif /* M68K_THREADED_DISPATCH */
+	m68ki_instruction_jump_table = m68ki_handler_sets[M68KI_HANDLER_SET_OF(CPU_TYPE)];
+#endif /* M68K_SPECIALIZE_CPU */
+}
+
+/* Load the clocks of the family whose instruction timings are
+ * m68ki_cycles[TABLE]
+ */
+static void m68ki_set_cycles(int table)
+{
+	CYC_INSTRUCTION  = m68ki_cycles[table];
+	CYC_EXCEPTION    = m68ki_exception_cycle_table[table];
+	CYC_BCC_NOTAKE_B = M68KI_CYC_BCC_NOTAKE_B(table);
+	CYC_BCC_NOTAKE_W = M68KI_CYC_BCC_NOTAKE_W(table);
+	CYC_DBCC_F_NOEXP = M68KI_CYC_DBCC_F_NOEXP(table);
+	CYC_DBCC_F_EXP   = M68KI_CYC_DBCC_F_EXP(table);
+	CYC_SCC_R_TRUE   = M68KI_CYC_SCC_R_TRUE(table);
+	CYC_MOVEM_W      = M68KI_CYC_MOVEM_W(table);
+	CYC_MOVEM_L      = M68KI_CYC_MOVEM_L(table);
+	CYC_SHIFT        = M68KI_CYC_SHIFT(table);
+	CYC_RESET        = M68KI_CYC_RESET(table);
+}
+
 /* Set the CPU type. */
 void m68k_set_cpu_type(unsigned cpu_type)
 {
+	/* Cached blocks hold the cycle counts of the old CPU type */
+	m68k_flush_block_cache();
+	m68ki_block_cache_new_cpu();
+
+	/* The address mask may change */
+	m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+
 	switch(cpu_type)
 	{
 		case M68K_CPU_TYPE_68000:
 			CPU_TYPE         = CPU_TYPE_000;
 			CPU_ADDRESS_MASK = 0x00ffffff;
 			CPU_SR_MASK      = 0xa71f; /* T1 -- S  -- -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[0];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[0];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 2;
-			CYC_DBCC_F_NOEXP = -2;
-			CYC_DBCC_F_EXP   = 2;
-			CYC_SCC_R_TRUE   = 2;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 3;
-			CYC_SHIFT        = 1;
-			CYC_RESET        = 132;
+			m68ki_set_cycles(0);
 			HAS_PMMU	 = 0;
-			return;
+			break;
 		case M68K_CPU_TYPE_SCC68070:
 			m68k_set_cpu_type(M68K_CPU_TYPE_68010);
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_TYPE         = CPU_TYPE_SCC070;
-			return;
+			break;
 		case M68K_CPU_TYPE_68010:
 			CPU_TYPE         = CPU_TYPE_010;
 			CPU_ADDRESS_MASK = 0x00ffffff;
 			CPU_SR_MASK      = 0xa71f; /* T1 -- S  -- -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[1];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[1];
-			CYC_BCC_NOTAKE_B = -4;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 6;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 3;
-			CYC_SHIFT        = 1;
-			CYC_RESET        = 130;
+			m68ki_set_cycles(1);
 			HAS_PMMU	 = 0;
-			return;
+			break;
 		case M68K_CPU_TYPE_68EC020:
 			CPU_TYPE         = CPU_TYPE_EC020;
 			CPU_ADDRESS_MASK = 0x00ffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[2];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[2];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 4;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 2;
-			CYC_SHIFT        = 0;
-			CYC_RESET        = 518;
+			m68ki_set_cycles(2);
 			HAS_PMMU	 = 0;
-			return;
+			break;
 		case M68K_CPU_TYPE_68020:
 			CPU_TYPE         = CPU_TYPE_020;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[2];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[2];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 4;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 2;
-			CYC_SHIFT        = 0;
-			CYC_RESET        = 518;
+			m68ki_set_cycles(2);
 			HAS_PMMU	 = 0;
-			return;
+			break;
 		case M68K_CPU_TYPE_68030:
 			CPU_TYPE         = CPU_TYPE_030;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[3];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[3];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 4;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 2;
-			CYC_SHIFT        = 0;
-			CYC_RESET        = 518;
+			m68ki_set_cycles(3);
 			HAS_PMMU	       = 1;
-			return;
+			break;
 		case M68K_CPU_TYPE_68EC030:
 			CPU_TYPE         = CPU_TYPE_EC030;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK          = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[3];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[3];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 4;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 2;
-			CYC_SHIFT        = 0;
-			CYC_RESET        = 518;
+			m68ki_set_cycles(3);
 			HAS_PMMU	       = 0;		/* EC030 lacks the PMMU and is effectively a die-shrink 68020 */
-			return;
+			break;
 		case M68K_CPU_TYPE_68040:		// TODO: these values are not correct
 			CPU_TYPE         = CPU_TYPE_040;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[4];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[4];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 4;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 2;
-			CYC_SHIFT        = 0;
-			CYC_RESET        = 518;
+			m68ki_set_cycles(4);
 			HAS_PMMU	 = 1;
-			return;
+			break;
 		case M68K_CPU_TYPE_68EC040: // Just a 68040 without pmmu apparently...
 			CPU_TYPE         = CPU_TYPE_EC040;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = m68ki_cycles[4];
-			CYC_EXCEPTION    = m68ki_exception_cycle_table[4];
-			CYC_BCC_NOTAKE_B = -2;
-			CYC_BCC_NOTAKE_W = 0;
-			CYC_DBCC_F_NOEXP = 0;
-			CYC_DBCC_F_EXP   = 4;
-			CYC_SCC_R_TRUE   = 0;
-			CYC_MOVEM_W      = 2;
-			CYC_MOVEM_L      = 2;
-			CYC_SHIFT        = 0;
-			CYC_RESET        = 518;
+			m68ki_set_cycles(4);
 			HAS_PMMU	 = 0;
-			return;
+			break;
 		case M68K_CPU_TYPE_68LC040:
 			CPU_TYPE         = CPU_TYPE_LC040;
 			m68ki_cpu.sr_mask          = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			m68ki_cpu.cyc_instruction  = m68ki_cycles[4];
-			m68ki_cpu.cyc_exception    = m68ki_exception_cycle_table[4];
-			m68ki_cpu.cyc_bcc_notake_b = -2;
-			m68ki_cpu.cyc_bcc_notake_w = 0;
-			m68ki_cpu.cyc_dbcc_f_noexp = 0;
-			m68ki_cpu.cyc_dbcc_f_exp   = 4;
-			m68ki_cpu.cyc_scc_r_true   = 0;
-			m68ki_cpu.cyc_movem_w      = 2;
-			m68ki_cpu.cyc_movem_l      = 2;
-			m68ki_cpu.cyc_shift        = 0;
-			m68ki_cpu.cyc_reset        = 518;
+			m68ki_set_cycles(4);
 			HAS_PMMU	       = 1;
-			return;
+			break;
 	}
+
+	m68ki_select_handler_set();
 }
 
 /* Execute some instructions until we use up num_cycles clock cycles */
@@ -952,55 +1804,177 @@ int m68k_execute(int num_cycles)
 	SET_CYCLES(num_cycles);
 	m68ki_initial_cycles = num_cycles;
 
+	/* Only run up to the first device event */
+	m68ki_event_start(); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_PENDING_FAULTS
+	/* Forget any bus error pulsed while we weren't executing */
+	CPU_FAULT_PENDING = 0;
+#endif /* M68K_PENDING_FAULTS */
+
 	/* See if interrupts came in */
 	m68ki_check_interrupts();
 
-	/* Make sure we're not stopped */
-	if(!CPU_STOPPED)
+	/* Run up to each device event in turn (see m68ki_event_next()) */
+	do
 	{
-		/* Return point if we had an address error */
-		m68ki_set_address_error_trap(); /* auto-disable (see m68kcpu.h) */
+		/* Make sure we're not stopped */
+		if(!CPU_STOPPED)
+		{
+			/* Return point if we had an address error */
+			m68ki_set_address_error_trap(); /* auto-disable (see m68kcpu.h) */
 
-		m68ki_check_bus_error_trap();
+			/* Return point if we had a bus error */
+			m68ki_set_bus_error_trap(); /* auto-disable (see m68kcpu.h) */
 
-		/* Main loop.  Keep going until we run out of clock cycles */
-		do
-		{
-			int i;
-			/* Set tracing accodring to T1. (T0 is done inside instruction) */
-			m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+#if M68K_BLOCK_CACHE
+			/* We may have been thrown out of a cached instruction */
+			m68ki_block_cache_fetch_length = 0;
+#endif /* M68K_BLOCK_CACHE */
+
+			/* Main loop.  Keep going until we run out of clock cycles */
+			do
+			{
+#if M68K_STATIC_CODE
+				/* Run recompiled code if we have some for this PC */
+				if(REG_PC - m68ki_static_code_start < m68ki_static_code_size && !PMMU_ENABLED &&
+					m68ki_static_code_execute(REG_PC))
+				{
+					m68ki_unwind_fault(); /* auto-disable (see m68kcpu.h) */
+					continue;
+				}
+#endif /* M68K_STATIC_CODE */
+
+#if M68K_BLOCK_CACHE
+				/* Run from the block cache unless the PMMU is translating */
+				if(!PMMU_ENABLED && !(REG_PC & 1))
+				{
+					m68ki_block_cache_execute();
+					m68ki_unwind_fault(); /* auto-disable (see m68kcpu.h) */
+					continue;
+				}
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_THREADED_DISPATCH
+				/* Run instructions until we're out of clocks, or until one of
+				 * the above can take over
+				 */
+				m68ki_threaded_execute();
+#else
+				/* Set tracing accodring to T1. (T0 is done inside instruction) */
+				m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+
+				/* Set the address space for reads */
+				m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+
+				/* Call external hook to peek at CPU */
+				m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+
+				/* Record previous program counter */
+				REG_PPC = REG_PC;
+
+				/* Nothing to roll back yet (in case of bus error) */
+				m68ki_start_rollback();
+
+				/* Read an instruction and call its handler */
+				REG_IR = m68ki_read_imm_16();
+				m68ki_instruction_jump_table[REG_IR]();
+				USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
 
-			/* Set the address space for reads */
-			m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+				/* Trace m68k_exception, if necessary */
+				m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+#endif /* M68K_THREADED_DISPATCH */
 
-			/* Call external hook to peek at CPU */
-			m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+				/* Throw away the rest of an instruction that faulted */
+				m68ki_unwind_fault(); /* auto-disable (see m68kcpu.h) */
+			} while(GET_CYCLES() > 0);
 
-			/* Record previous program counter */
+			/* set previous PC to current PC for the next entry into the loop */
 			REG_PPC = REG_PC;
 
-			/* Record previous D/A register state (in case of bus error) */
-			for (i = 15; i >= 0; i--){
-				REG_DA_SAVE[i] = REG_DA[i];
-			}
+			/* A bus error from outside of an instruction has nothing to roll back */
+			REG_DA_SAVE_MASK = 0;
+		}
+		else
+			SET_CYCLES(0);
+	} while(m68ki_event_next()); /* auto-disable (see m68kcpu.h) */
 
-			/* Read an instruction and call its handler */
-			REG_IR = m68ki_read_imm_16();
-			m68ki_instruction_jump_table[REG_IR]();
-			USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+	m68ki_event_stop(); /* auto-disable (see m68kcpu.h) */
 
-			/* Trace m68k_exception, if necessary */
-			m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
-		} while(GET_CYCLES() > 0);
+	/* return how many clocks we used */
+	return m68ki_initial_cycles - GET_CYCLES();
+}
+
+/* Finish off m68k_step(), and return how many clocks it used */
+static int m68ki_step_end(void)
+{
+	/* set previous PC to current PC for the next instruction */
+	REG_PPC = REG_PC;
+
+	/* A bus error from outside of an instruction has nothing to roll back */
+	REG_DA_SAVE_MASK = 0;
+
+	/* A bus error's exception can take fewer clocks than the instruction
+	 * it cut short was charged
+	 */
+	if(GET_CYCLES() > 0)
+		SET_CYCLES(0);
+
+#if M68K_EVENTS
+	/* Fire the events that came due during the instruction */
+	CPU_EVENTS.clock -= GET_CYCLES();
+	m68ki_event_fire();
+#endif /* M68K_EVENTS */
+
+	return -GET_CYCLES();
+}
+
+/* Execute a single instruction, with as little setup as possible */
+int m68k_step(void)
+{
+	/* eat up any reset cycles */
+	if(RESET_CYCLES)
+	{
+		int rc = RESET_CYCLES;
+		RESET_CYCLES = 0;
+		return rc;
+	}
+
+	/* Count up the clocks used from nothing */
+	SET_CYCLES(0);
+	m68ki_initial_cycles = 0;
+
+#if M68K_PENDING_FAULTS
+	/* Forget any bus error pulsed while we weren't executing */
+	CPU_FAULT_PENDING = 0;
+#endif /* M68K_PENDING_FAULTS */
+
+	/* See if interrupts came in */
+	m68ki_check_interrupts();
+
+	if(!CPU_STOPPED)
+	{
+		/* Return points if we had an address or bus error */
+		m68ki_set_step_address_error_trap(); /* auto-disable (see m68kcpu.h) */
+		m68ki_set_step_bus_error_trap(); /* auto-disable (see m68kcpu.h) */
+
+		m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+		m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+		m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
 
-		/* set previous PC to current PC for the next entry into the loop */
 		REG_PPC = REG_PC;
+		m68ki_start_rollback();
+
+		REG_IR = m68ki_read_imm_16();
+		m68ki_instruction_jump_table[REG_IR]();
+		USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+		m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+
+		m68ki_rollback_fault(); /* auto-disable (see m68kcpu.h) */
 	}
-	else
-		SET_CYCLES(0);
 
-	/* return how many clocks we used */
-	return m68ki_initial_cycles - GET_CYCLES();
+	return m68ki_step_end();
 }
 
 
@@ -1011,12 +1985,27 @@ int m68k_cycles_run(void)
 
 int m68k_cycles_remaining(void)
 {
+#if M68K_EVENTS
+	if(CPU_EVENTS.running)
+		return GET_CYCLES() + CPU_EVENTS.left;
+#endif /* M68K_EVENTS */
 	return GET_CYCLES();
 }
 
 /* Change the timeslice */
 void m68k_modify_timeslice(int cycles)
 {
+#if M68K_EVENTS
+	/* Only the part after the next event changes, unless it's all taken away */
+	if(CPU_EVENTS.running)
+	{
+		CPU_EVENTS.left += cycles;
+		if(CPU_EVENTS.left >= 0)
+			return;
+		cycles = CPU_EVENTS.left;
+		CPU_EVENTS.left = 0;
+	}
+#endif /* M68K_EVENTS */
 	m68ki_initial_cycles += cycles;
 	ADD_CYCLES(cycles);
 }
@@ -1024,10 +2013,98 @@ void m68k_modify_timeslice(int cycles)
 
 void m68k_end_timeslice(void)
 {
+#if M68K_EVENTS
+	/* Keep m68k_execute() returning the clocks actually run */
+	CPU_EVENTS.left = 0;
+	m68ki_initial_cycles -= GET_CYCLES();
+#else
 	m68ki_initial_cycles = GET_CYCLES();
+#endif /* M68K_EVENTS */
 	SET_CYCLES(0);
 }
 
+unsigned long long m68k_get_idle_cycles(void)
+{
+	return IDLE_CYCLES;
+}
+
+void m68k_get_atc_stats(unsigned long long* hits, unsigned long long* misses)
+{
+#if M68K_PMMU_ATC
+	*hits = m68ki_atc_hits;
+	*misses = m68ki_atc_misses;
+#else
+	*hits = 0;
+	*misses = 0;
+#endif /* M68K_PMMU_ATC */
+}
+
+int m68k_add_event(void (*callback)(M68K_USER_PARAM int event))
+{
+#if M68K_EVENTS
+	if(callback && CPU_EVENTS.count < M68K_MAX_EVENTS)
+	{
+		CPU_EVENTS.event[CPU_EVENTS.count].callback = callback;
+		CPU_EVENTS.event[CPU_EVENTS.count].pos = -1;
+		return CPU_EVENTS.count++;
+	}
+#else
+	(void)callback;
+#endif /* M68K_EVENTS */
+	return -1;
+}
+
+void m68k_set_event(int event, int cycles)
+{
+#if M68K_EVENTS
+	long long wait;
+
+	if((unsigned)event >= (unsigned)CPU_EVENTS.count)
+		return;
+	if(cycles < 1)
+		cycles = 1;
+
+	/* Periodic events count from when they were due, not when they fired */
+	CPU_EVENTS.event[event].time = (CPU_EVENTS.firing ? CPU_EVENTS.due : m68ki_event_now()) + cycles;
+	if(CPU_EVENTS.event[event].pos < 0)
+		m68ki_event_place(CPU_EVENTS.heap_size++, event);
+	m68ki_event_sift(CPU_EVENTS.event[event].pos);
+
+	/* Stop the running chunk at the event if it's due before the chunk ends */
+	wait = (long long)(CPU_EVENTS.event[event].time - m68ki_event_now());
+	if(CPU_EVENTS.running && GET_CYCLES() > wait)
+	{
+		int extra = GET_CYCLES() - (int)wait;
+
+		ADD_CYCLES(-extra);
+		m68ki_initial_cycles -= extra;
+		CPU_EVENTS.left += extra;
+	}
+#else
+	(void)event;
+	(void)cycles;
+#endif /* M68K_EVENTS */
+}
+
+void m68k_cancel_event(int event)
+{
+#if M68K_EVENTS
+	if((unsigned)event < (unsigned)CPU_EVENTS.count && CPU_EVENTS.event[event].pos >= 0)
+		m68ki_event_remove(event);
+#else
+	(void)event;
+#endif /* M68K_EVENTS */
+}
+
+unsigned long long m68k_get_time(void)
+{
+#if M68K_EVENTS
+	return m68ki_event_now();
+#else
+	return 0;
+#endif /* M68K_EVENTS */
+}
+
 
 /* ASG: rewrote so that the int_level is a mask of the IPL0/IPL1/IPL2 bits */
 /* KS: Modified so that IPL* bits match with mask positions in the SR
@@ -1087,6 +2164,20 @@ void m68k_init(void)
 	m68k_set_pc_changed_callback(NULL);
 	m68k_set_fc_callback(NULL);
 	m68k_set_instr_hook_callback(NULL);
+	m68k_set_idle_read_callback(NULL);
+	IDLE_CYCLES = 0;
+
+#if M68K_PMMU_ATC
+	m68ki_atc_hits = 0;
+	m68ki_atc_misses = 0;
+	m68ki_atc_flush();
+#endif /* M68K_PMMU_ATC */
+
+#if M68K_EVENTS
+	CPU_EVENTS.count = 0;
+	CPU_EVENTS.heap_size = 0;
+	CPU_EVENTS.clock = 0;
+#endif /* M68K_EVENTS */
 }
 
 /* Trigger a Bus Error exception */
@@ -1098,12 +2189,25 @@ void m68k_pulse_bus_error(void)
 /* Pulse the RESET line on the CPU */
 void m68k_pulse_reset(void)
 {
-	/* Disable the PMMU on reset */
+	/* Disable the PMMU and the transparent translation windows on reset */
 	m68ki_cpu.pmmu_enabled = 0;
+	m68ki_cpu.mmu_tt0 &= ~0x8000;
+	m68ki_cpu.mmu_tt1 &= ~0x8000;
+	m68ki_cpu.mmu_itt0 &= ~0x8000;
+	m68ki_cpu.mmu_itt1 &= ~0x8000;
+	m68ki_cpu.mmu_dtt0 &= ~0x8000;
+	m68ki_cpu.mmu_dtt1 &= ~0x8000;
+
+	/* Forget any code we have predecoded */
+	m68k_flush_block_cache();
+	m68ki_block_cache_new_cpu();
+	m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+	m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 
 	/* Clear all stop levels and eat up all remaining cycles */
 	CPU_STOPPED = 0;
 	SET_CYCLES(0);
+	CPU_FAULT_PENDING = 0;
 
 	CPU_RUN_MODE = RUN_MODE_BERR_AERR_RESET;
 	CPU_INSTR_MODE = INSTRUCTION_YES;
@@ -1143,6 +2247,195 @@ void m68k_pulse_halt(void)
 	CPU_STOPPED |= STOP_LEVEL_HALT;
 }
 
+/* Tell the block cache that the host has changed memory */
+void m68k_invalidate_block_cache(unsigned address, unsigned size)
+{
+#if M68K_BLOCK_CACHE
+	unsigned page = address >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+	unsigned last = (address + size - 1) >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+#endif /* M68K_BLOCK_CACHE */
+
+	if(size == 0)
+		return;
+
+#if M68K_STATIC_CODE
+	/* Recompiled code that was changed goes back to the interpreter */
+	if(address - m68ki_static_code_start < m68ki_static_code_size ||
+		m68ki_static_code_start - address < size)
+		m68ki_static_code_size = 0;
+#endif /* M68K_STATIC_CODE */
+
+#if M68K_BLOCK_CACHE
+	if(last < page)
+		last = 0xffffffff >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+
+	for(;; page++)
+	{
+		if(m68ki_block_cache_is_code(page))
+			m68ki_block_cache_invalidate_page(page);
+		if(page == last)
+			break;
+	}
+#elif !M68K_STATIC_CODE
+	(void)address;
+#endif /* M68K_BLOCK_CACHE */
+}
+
+void m68k_flush_block_cache(void)
+{
+#if M68K_BLOCK_CACHE
+	unsigned i;
+
+	for(i = 0; i < M68K_BLOCK_CACHE_BLOCKS; i++)
+	{
+		m68ki_block_cache[i].valid = 0;
+		m68ki_block_cache[i].links = 0;
+	}
+	memset(m68ki_block_cache_page_lists, 0, sizeof(m68ki_block_cache_page_lists));
+	memset(m68ki_block_cache_pages, 0, sizeof(m68ki_block_cache_pages));
+	m68ki_block_cache_fetch_length = 0;
+#endif /* M68K_BLOCK_CACHE */
+}
+
+void m68k_set_static_code(unsigned start, unsigned size, int (*execute)(unsigned pc))
+{
+#if M68K_STATIC_CODE
+	m68ki_static_code_start = start;
+	m68ki_static_code_size = execute ? size : 0;
+	m68ki_static_code_execute = execute;
+#else
+	(void)start;
+	(void)size;
+	(void)execute;
+#endif /* M68K_STATIC_CODE */
+}
+
+int m68k_map_memory(unsigned start, unsigned size, void* host, int flags)
+{
+#if M68K_MEMORY_MAP
+	unsigned page = start >> M68K_MEMORY_MAP_PAGE_SHIFT;
+	unsigned count = size >> M68K_MEMORY_MAP_PAGE_SHIFT;
+	unsigned i;
+
+	if(!count || ((start | size) & (M68KI_MAP_PAGE_SIZE - 1)) || count > M68KI_MAP_PAGES - page)
+		return 0;
+#if M68KI_MAP_SWAPPED
+	/* Words are accessed in place */
+	if((uintptr_t)host & 1)
+		return 0;
+#endif /* M68KI_MAP_SWAPPED */
+	if(!host)
+		flags = 0;
+
+	for(i = 0; i < count; i++)
+	{
+		uint8_t* pointer = (flags & M68K_MAP_RW) ? (uint8_t*)host + i * M68KI_MAP_PAGE_SIZE : NULL;
+
+		m68ki_map_read_pages[page + i] = (flags & M68K_MAP_READ) ? pointer : NULL;
+		m68ki_map_write_pages[page + i] = (flags & M68K_MAP_WRITE) ? pointer : NULL;
+	}
+	m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+	m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
+	return 1;
+#else
+	(void)start;
+	(void)size;
+	(void)host;
+	(void)flags;
+	return 0;
+#endif /* M68K_MEMORY_MAP */
+}
+
+int m68k_map_region(unsigned start, unsigned size, const m68k_region* region)
+{
+#if M68KI_MAP_REGIONS
+	unsigned page = start >> M68K_MEMORY_MAP_PAGE_SHIFT;
+	unsigned count = size >> M68K_MEMORY_MAP_PAGE_SHIFT;
+	unsigned i;
+
+	if(!count || ((start | size) & (M68KI_MAP_PAGE_SIZE - 1)) || count > M68KI_MAP_PAGES - page)
+		return 0;
+
+	for(i = 0; i < count; i++)
+		m68ki_map_regions[page + i] = region;
+	return 1;
+#else
+	(void)start;
+	(void)size;
+	(void)region;
+	return 0;
+#endif /* M68KI_MAP_REGIONS */
+}
+
+unsigned m68k_get_dirty_pages(unsigned* pages, unsigned max)
+{
+	unsigned count = 0;
+#if M68K_DIRTY_PAGES
+	unsigned i;
+
+	/* Skip clean pages 64 at a time */
+	for(i = 0; i < M68KI_DIRTY_WORDS && count < max; i++)
+	{
+		uint64_t word = m68ki_dirty_pages[i];
+
+		while(word && count < max)
+		{
+			uint64_t bit = word & -word;
+			unsigned index = 0;
+
+#if defined(__GNUC__)
+			index = __builtin_ctzll(word);
+#else
+			while(!(bit >> index & 1))
+				index++;
+#endif /* __GNUC__ */
+			pages[count++] = i * 64 + index;
+			word ^= bit;
+		}
+		m68ki_dirty_pages[i] = word;
+	}
+#else
+	(void)pages;
+	(void)max;
+#endif /* M68K_DIRTY_PAGES */
+	return count;
+}
+
+void m68k_swap_memory(void* dst, const void* src, unsigned size)
+{
+#if M68KI_MAP_SWAPPED
+	uint8_t* d = (uint8_t*)dst;
+	const uint8_t* s = (const uint8_t*)src;
+	unsigned i = 0;
+
+#if defined(__SSE2__)
+	for(; i + 16 <= size; i += 16)
+	{
+		__m128i words = _mm_loadu_si128((const __m128i*)(s + i));
+		_mm_storeu_si128((__m128i*)(d + i), _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8)));
+	}
+#endif /* __SSE2__ */
+	for(; i + 2 <= size; i += 2)
+	{
+		uint8_t high = s[i];
+		d[i] = s[i + 1];
+		d[i + 1] = high;
+	}
+#else
+	if(dst != src)
+		memmove(dst, src, size);
+#endif /* M68KI_MAP_SWAPPED */
+}
+
+void m68k_set_jit(int enable)
+{
+#if M68K_JIT
+	m68ki_jit_enabled = enable != 0;
+#else
+	(void)enable;
+#endif /* M68K_JIT */
+}
+
 /* Get and set the current CPU context */
 /* This is to allow for multiple CPUs */
 unsigned m68k_context_size(void)
@@ -1159,6 +2452,15 @@ unsigned m68k_get_context(void* dst)
 void m68k_set_context(void* src)
 {
 	if(src) m68ki_cpu = *(m68ki_cpu_core*)src;
+	m68ki_select_handler_set();
+
+	/* The code page is shared by all contexts, and this one may have the
+	 * PMMU on
+	 */
+	m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+
+	/* And the ATC */
+	m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 }
 
 /* ======================================================================== */
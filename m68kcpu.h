@@ -84,6 +84,19 @@ extern "C" {
 #endif /* UINT_MAX == 0xffffffff */
 
 
+/* Index of the lowest set bit, for walking register lists */
+#if defined(__GNUC__)
+	#define m68ki_ctz(A) (unsigned)__builtin_ctz(A)
+#else
+	static inline unsigned m68ki_ctz(unsigned value) {
+		unsigned index = 0;
+		for(; !(value & 1); value >>= 1)
+			index++;
+		return index;
+	}
+#endif /* __GNUC__ */
+
+
 
 /* ======================================================================== */
 /* ============================ GENERAL DEFINES =========================== */
@@ -267,6 +280,7 @@ extern "C" {
 
 #define REG_DA           m68ki_cpu.dar /* easy access to data and address regs */
 #define REG_DA_SAVE      m68ki_cpu.dar_save
+#define REG_DA_SAVE_MASK m68ki_cpu.dar_save_mask
 #define REG_D            m68ki_cpu.dar
 #define REG_A            (m68ki_cpu.dar+8)
 #define REG_PPC          m68ki_cpu.ppc
@@ -307,6 +321,7 @@ extern "C" {
 #define CPU_SR_MASK      m68ki_cpu.sr_mask
 #define CPU_INSTR_MODE   m68ki_cpu.instr_mode
 #define CPU_RUN_MODE     m68ki_cpu.run_mode
+#define CPU_FAULT_PENDING m68ki_cpu.fault_pending
 
 #define CYC_INSTRUCTION  m68ki_cpu.cyc_instruction
 #define CYC_EXCEPTION    m68ki_cpu.cyc_exception
@@ -322,6 +337,23 @@ extern "C" {
 #define HAS_PMMU         m68ki_cpu.has_pmmu
 #define PMMU_ENABLED     m68ki_cpu.pmmu_enabled
 #define RESET_CYCLES     m68ki_cpu.reset_cycles
+#define IDLE_CYCLES      m68ki_cpu.idle_cycles
+#define CPU_EVENTS       m68ki_cpu.events
+
+/* Clocks that vary by CPU family, for the family whose instruction timings
+ * are m68ki_cycles[T] (T = 0: 68000, 1: 68010, 2: 68020, 3: 68030,
+ * 4: 68040).  m68k_set_cpu_type() and the specialized handler sets both take
+ * them from here.
+ */
+#define M68KI_CYC_BCC_NOTAKE_B(T) ((T) == 1 ? -4 : -2)
+#define M68KI_CYC_BCC_NOTAKE_W(T) ((T) == 0 ? 2 : 0)
+#define M68KI_CYC_DBCC_F_NOEXP(T) ((T) == 0 ? -2 : 0)
+#define M68KI_CYC_DBCC_F_EXP(T)   ((T) == 0 ? 2 : (T) == 1 ? 6 : 4)
+#define M68KI_CYC_SCC_R_TRUE(T)   ((T) == 0 ? 2 : 0)
+#define M68KI_CYC_MOVEM_W(T)      2
+#define M68KI_CYC_MOVEM_L(T)      ((T) <= 1 ? 3 : 2)
+#define M68KI_CYC_SHIFT(T)        ((T) <= 1 ? 1 : 0)
+#define M68KI_CYC_RESET(T)        ((T) == 0 ? 132 : (T) == 1 ? 130 : 518)
 
 
 #define CALLBACK_INT_ACK        m68ki_cpu.int_ack_callback
@@ -334,6 +366,24 @@ extern "C" {
 #define CALLBACK_PC_CHANGED     m68ki_cpu.pc_changed_callback
 #define CALLBACK_SET_FC         m68ki_cpu.set_fc_callback
 #define CALLBACK_INSTR_HOOK     m68ki_cpu.instr_hook_callback
+#define CALLBACK_IDLE_READ      m68ki_cpu.idle_read_callback
+#define CPU_USER_CONTEXT        m68ki_cpu.user_context
+
+/* Pass the user context to the host (see M68K_USER_CONTEXT) */
+#if M68K_USER_CONTEXT
+	#define M68KI_USER          CPU_USER_CONTEXT,
+	#define M68KI_USER_ONLY     CPU_USER_CONTEXT
+	#define m68ki_ignore_user() (void)user
+#else
+	#define M68KI_USER
+	#define M68KI_USER_ONLY
+	#define m68ki_ignore_user()
+#endif /* M68K_USER_CONTEXT */
+
+/* Call a handler named with OPT_SPECIFY_HANDLER, with the user context
+ * expanded before the handler macro splits its arguments
+ */
+#define M68KI_SPECIFIED(F, ARGS) F ARGS
 
 
 
@@ -404,15 +454,22 @@ extern "C" {
 #define m68k_read_pcrelative_8(A) m68ki_read_program_8(A)
 #define m68k_read_pcrelative_16(A) m68ki_read_program_16(A)
 #define m68k_read_pcrelative_32(A) m68ki_read_program_32(A)
+#elif M68K_USER_CONTEXT
+#define m68k_read_immediate_16(A) m68k_read_immediate_16(M68KI_USER A)
+#define m68k_read_immediate_32(A) m68k_read_immediate_32(M68KI_USER A)
+
+#define m68k_read_pcrelative_8(A) m68k_read_pcrelative_8(M68KI_USER A)
+#define m68k_read_pcrelative_16(A) m68k_read_pcrelative_16(M68KI_USER A)
+#define m68k_read_pcrelative_32(A) m68k_read_pcrelative_32(M68KI_USER A)
 #endif /* M68K_SEPARATE_READS */
 
 
 /* Enable or disable callback functions */
 #if M68K_EMULATE_INT_ACK
 	#if M68K_EMULATE_INT_ACK == OPT_SPECIFY_HANDLER
-		#define m68ki_int_ack(A) M68K_INT_ACK_CALLBACK(A)
+		#define m68ki_int_ack(A) M68KI_SPECIFIED(M68K_INT_ACK_CALLBACK, (M68KI_USER A))
 	#else
-		#define m68ki_int_ack(A) CALLBACK_INT_ACK(A)
+		#define m68ki_int_ack(A) CALLBACK_INT_ACK(M68KI_USER A)
 	#endif
 #else
 	/* Default action is to used autovector mode, which is most common */
@@ -421,9 +478,9 @@ extern "C" {
 
 #if M68K_EMULATE_BKPT_ACK
 	#if M68K_EMULATE_BKPT_ACK == OPT_SPECIFY_HANDLER
-		#define m68ki_bkpt_ack(A) M68K_BKPT_ACK_CALLBACK(A)
+		#define m68ki_bkpt_ack(A) M68KI_SPECIFIED(M68K_BKPT_ACK_CALLBACK, (M68KI_USER A))
 	#else
-		#define m68ki_bkpt_ack(A) CALLBACK_BKPT_ACK(A)
+		#define m68ki_bkpt_ack(A) CALLBACK_BKPT_ACK(M68KI_USER A)
 	#endif
 #else
 	#define m68ki_bkpt_ack(A)
@@ -431,9 +488,9 @@ extern "C" {
 
 #if M68K_EMULATE_RESET
 	#if M68K_EMULATE_RESET == OPT_SPECIFY_HANDLER
-		#define m68ki_output_reset() M68K_RESET_CALLBACK()
+		#define m68ki_output_reset() M68KI_SPECIFIED(M68K_RESET_CALLBACK, (M68KI_USER_ONLY))
 	#else
-		#define m68ki_output_reset() CALLBACK_RESET_INSTR()
+		#define m68ki_output_reset() CALLBACK_RESET_INSTR(M68KI_USER_ONLY)
 	#endif
 #else
 	#define m68ki_output_reset()
@@ -441,9 +498,9 @@ extern "C" {
 
 #if M68K_CMPILD_HAS_CALLBACK
 	#if M68K_CMPILD_HAS_CALLBACK == OPT_SPECIFY_HANDLER
-		#define m68ki_cmpild_callback(v,r) M68K_CMPILD_CALLBACK(v,r)
+		#define m68ki_cmpild_callback(v,r) M68KI_SPECIFIED(M68K_CMPILD_CALLBACK, (M68KI_USER v,r))
 	#else
-		#define m68ki_cmpild_callback(v,r) CALLBACK_CMPILD_INSTR(v,r)
+		#define m68ki_cmpild_callback(v,r) CALLBACK_CMPILD_INSTR(M68KI_USER v,r)
 	#endif
 #else
 	#define m68ki_cmpild_callback(v,r)
@@ -451,9 +508,9 @@ extern "C" {
 
 #if M68K_RTE_HAS_CALLBACK
 	#if M68K_RTE_HAS_CALLBACK == OPT_SPECIFY_HANDLER
-		#define m68ki_rte_callback() M68K_RTE_CALLBACK()
+		#define m68ki_rte_callback() M68KI_SPECIFIED(M68K_RTE_CALLBACK, (M68KI_USER_ONLY))
 	#else
-		#define m68ki_rte_callback() CALLBACK_RTE_INSTR()
+		#define m68ki_rte_callback() CALLBACK_RTE_INSTR(M68KI_USER_ONLY)
 	#endif
 #else
 	#define m68ki_rte_callback()
@@ -461,9 +518,9 @@ extern "C" {
 
 #if M68K_TAS_HAS_CALLBACK
 	#if M68K_TAS_HAS_CALLBACK == OPT_SPECIFY_HANDLER
-		#define m68ki_tas_callback() M68K_TAS_CALLBACK()
+		#define m68ki_tas_callback() M68KI_SPECIFIED(M68K_TAS_CALLBACK, (M68KI_USER_ONLY))
 	#else
-		#define m68ki_tas_callback() CALLBACK_TAS_INSTR()
+		#define m68ki_tas_callback() CALLBACK_TAS_INSTR(M68KI_USER_ONLY)
 	#endif
 #else
 	#define m68ki_tas_callback() 1
@@ -471,9 +528,9 @@ extern "C" {
 
 #if M68K_ILLG_HAS_CALLBACK
 	#if M68K_ILLG_HAS_CALLBACK == OPT_SPECIFY_HANDLER
-		#define m68ki_illg_callback(opcode) M68K_ILLG_CALLBACK(opcode)
+		#define m68ki_illg_callback(opcode) M68KI_SPECIFIED(M68K_ILLG_CALLBACK, (M68KI_USER opcode))
 	#else
-		#define m68ki_illg_callback(opcode) CALLBACK_ILLG_INSTR(opcode)
+		#define m68ki_illg_callback(opcode) CALLBACK_ILLG_INSTR(M68KI_USER opcode)
 	#endif
 #else
 	#define m68ki_illg_callback(opcode) 0 // Default is 0 = not handled, exception will occur
@@ -481,9 +538,9 @@ extern "C" {
 
 #if M68K_INSTRUCTION_HOOK
 	#if M68K_INSTRUCTION_HOOK == OPT_SPECIFY_HANDLER
-		#define m68ki_instr_hook(pc) M68K_INSTRUCTION_CALLBACK(pc)
+		#define m68ki_instr_hook(pc) M68KI_SPECIFIED(M68K_INSTRUCTION_CALLBACK, (M68KI_USER pc))
 	#else
-		#define m68ki_instr_hook(pc) CALLBACK_INSTR_HOOK(pc)
+		#define m68ki_instr_hook(pc) CALLBACK_INSTR_HOOK(M68KI_USER pc)
 	#endif
 #else
 	#define m68ki_instr_hook(pc)
@@ -491,21 +548,125 @@ extern "C" {
 
 #if M68K_MONITOR_PC
 	#if M68K_MONITOR_PC == OPT_SPECIFY_HANDLER
-		#define m68ki_pc_changed(A) M68K_SET_PC_CALLBACK(ADDRESS_68K(A))
+		#define m68ki_pc_changed(A) M68KI_SPECIFIED(M68K_SET_PC_CALLBACK, (M68KI_USER ADDRESS_68K(A)))
 	#else
-		#define m68ki_pc_changed(A) CALLBACK_PC_CHANGED(ADDRESS_68K(A))
+		#define m68ki_pc_changed(A) CALLBACK_PC_CHANGED(M68KI_USER ADDRESS_68K(A))
 	#endif
 #else
 	#define m68ki_pc_changed(A)
 #endif /* M68K_MONITOR_PC */
 
+#if M68K_IDLE_SKIP
+	#if M68K_IDLE_SKIP == OPT_SPECIFY_HANDLER
+		#define m68ki_idle_read(A) M68KI_SPECIFIED(M68K_IDLE_READ_CALLBACK, (M68KI_USER A))
+	#else
+		#define m68ki_idle_read(A) CALLBACK_IDLE_READ(M68KI_USER A)
+	#endif
+	/* A bcc that went back over 1 to 4 words may close a polling loop */
+	#define m68ki_idle_bcc() if(REG_PPC - REG_PC - 2 <= 6) m68ki_idle_poll()
+#else
+	#define m68ki_idle_dbf(R)
+	#define m68ki_idle_bcc()
+#endif /* M68K_IDLE_SKIP */
+
+/* Run m68k_execute() up to each device event in turn */
+#if !M68K_EVENTS
+	#define m68ki_event_start()
+	#define m68ki_event_next() 0
+	#define m68ki_event_stop()
+#endif /* !M68K_EVENTS */
+
+/* Guest memory mapped straight to host memory */
+#if M68K_MEMORY_MAP
+	#ifndef M68K_MEMORY_MAP_PAGE_SHIFT
+		#define M68K_MEMORY_MAP_PAGE_SHIFT 16
+	#endif
+	#define M68KI_MAP_PAGE_SIZE (1u << M68K_MEMORY_MAP_PAGE_SHIFT)
+	#define M68KI_MAP_PAGES     (1u << (32 - M68K_MEMORY_MAP_PAGE_SHIFT))
+
+	/* Instruction fetches go straight to the mapped page the PC is in, unless
+	 * the host wants to see them with M68K_SEPARATE_READS
+	 */
+	#define M68KI_CODE_PAGE     !M68K_SEPARATE_READS
+
+	/* Pages can also be handed to device handlers */
+	#define M68KI_MAP_REGIONS   M68K_MEMORY_REGIONS
+
+	/* Host-endian words are only different from the 68k's on a little-endian
+	 * host
+	 */
+	#if M68K_MEMORY_MAP_HOST_ENDIAN && !(defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		#define M68KI_MAP_SWAPPED 1
+		#include <string.h>
+	#else
+		#define M68KI_MAP_SWAPPED 0
+	#endif
+#else
+	#define M68KI_CODE_PAGE     0
+	#define M68KI_MAP_SWAPPED   0
+	#define M68KI_MAP_REGIONS   0
+#endif /* M68K_MEMORY_MAP */
+
+/* PMMU address translation cache */
+#if M68K_PMMU_ATC
+	#ifndef M68K_PMMU_ATC_SIZE
+		#define M68K_PMMU_ATC_SIZE 256
+	#endif
+	#define M68KI_ATC_EMPTY     2 /* Root of an unused entry */
+	#define m68ki_pmmu_translate(A, FC, MODE, SIZE) m68ki_atc_translate(A, FC, MODE, SIZE)
+
+	/* ATC entries also point to mapped memory, so that translated accesses
+	 * to it don't have to look up the page again
+	 */
+	#define M68KI_ATC_HOST      M68K_MEMORY_MAP
+#else
+	#define m68ki_pmmu_translate(A, FC, MODE, SIZE) m68ki_pmmu_walk(A, FC, MODE, SIZE, NULL)
+	#define m68ki_atc_flush()
+	#define m68ki_atc_flush_page(A, FC)
+	#define M68KI_ATC_HOST      0
+#endif /* M68K_PMMU_ATC */
+
+/* MOVEM, MOVE16 and FMOVEM transfer their data in one go when they can */
+#define M68KI_BLOCK_TRANSFERS (M68K_MEMORY_MAP || M68K_BULK_TRANSFERS)
+
+/* Operations for m68ki_rmw_8/16/32() */
+#define M68KI_RMW_ADD 0 /* value + operand */
+#define M68KI_RMW_SUB 1 /* value - operand */
+#define M68KI_RMW_AND 2 /* value & operand */
+#define M68KI_RMW_OR  3 /* value | operand */
+#define M68KI_RMW_EOR 4 /* value ^ operand */
+#define M68KI_RMW_NEG 5 /* 0 - value - operand */
+#define M68KI_RMW_TAS 6 /* value | operand, if the TAS callback allows it */
+#define M68KI_RMW_CAS 7 /* operand, if value == compare */
+
+/* Dirty page tracking */
+#if M68K_DIRTY_PAGES
+	#ifndef M68K_DIRTY_PAGE_SHIFT
+		#define M68K_DIRTY_PAGE_SHIFT 12
+	#endif
+	#define M68KI_DIRTY_WORDS (1u << (32 - M68K_DIRTY_PAGE_SHIFT - 6)) /* 64 pages per word */
+#else
+	#define m68ki_dirty_write(A, SIZE)
+#endif /* M68K_DIRTY_PAGES */
+
+#if !M68KI_CODE_PAGE
+	#define m68ki_fetch_16(A) m68k_read_immediate_16(A)
+	#define m68ki_fetch_32(A) m68k_read_immediate_32(A)
+	#define m68ki_code_page_invalidate()
+#endif /* !M68KI_CODE_PAGE */
+
 
 /* Enable or disable function code emulation */
-#if M68K_EMULATE_FC
-	#if M68K_EMULATE_FC == OPT_SPECIFY_HANDLER
-		#define m68ki_set_fc(A) M68K_SET_FC_CALLBACK(A)
+#define M68KI_EMULATE_FC (M68K_EMULATE_FC || M68K_MEMORY_FC)
+
+#if M68KI_EMULATE_FC
+	#if M68K_MEMORY_FC
+		/* The memory functions get the function code instead */
+		#define m68ki_set_fc(A)
+	#elif M68K_EMULATE_FC == OPT_SPECIFY_HANDLER
+		#define m68ki_set_fc(A) M68KI_SPECIFIED(M68K_SET_FC_CALLBACK, (M68KI_USER A))
 	#else
-		#define m68ki_set_fc(A) CALLBACK_SET_FC(A)
+		#define m68ki_set_fc(A) CALLBACK_SET_FC(M68KI_USER A)
 	#endif
 	#define m68ki_use_data_space() m68ki_address_space = FUNCTION_CODE_USER_DATA
 	#define m68ki_use_program_space() m68ki_address_space = FUNCTION_CODE_USER_PROGRAM
@@ -515,7 +676,36 @@ extern "C" {
 	#define m68ki_use_data_space()
 	#define m68ki_use_program_space()
 	#define m68ki_get_address_space() FUNCTION_CODE_USER_DATA
-#endif /* M68K_EMULATE_FC */
+#endif /* M68KI_EMULATE_FC */
+
+/* Call the host's memory functions, with or without the function code */
+#if M68K_MEMORY_FC
+	#define m68ki_host_read_8(A, FC)            m68k_read_memory_8_fc(M68KI_USER A, FC)
+	#define m68ki_host_read_16(A, FC)           m68k_read_memory_16_fc(M68KI_USER A, FC)
+	#define m68ki_host_read_32(A, FC)           m68k_read_memory_32_fc(M68KI_USER A, FC)
+	#define m68ki_host_write_8(A, FC, V)        m68k_write_memory_8_fc(M68KI_USER A, FC, V)
+	#define m68ki_host_write_16(A, FC, V)       m68k_write_memory_16_fc(M68KI_USER A, FC, V)
+	#define m68ki_host_write_32(A, FC, V)       m68k_write_memory_32_fc(M68KI_USER A, FC, V)
+	#define m68ki_host_write_32_pd(A, FC, V)    m68k_write_memory_32_pd_fc(M68KI_USER A, FC, V)
+	#define m68ki_host_read_block(A, FC, S, N, V)  m68k_read_memory_block_fc(M68KI_USER A, FC, S, N, V)
+	#define m68ki_host_write_block(A, FC, S, N, V) m68k_write_memory_block_fc(M68KI_USER A, FC, S, N, V)
+	#define m68ki_host_rmw_8(A, FC, F, C)       m68k_rmw_memory_8_fc(M68KI_USER A, FC, F, C)
+	#define m68ki_host_rmw_16(A, FC, F, C)      m68k_rmw_memory_16_fc(M68KI_USER A, FC, F, C)
+	#define m68ki_host_rmw_32(A, FC, F, C)      m68k_rmw_memory_32_fc(M68KI_USER A, FC, F, C)
+#else
+	#define m68ki_host_read_8(A, FC)            m68k_read_memory_8(M68KI_USER A)
+	#define m68ki_host_read_16(A, FC)           m68k_read_memory_16(M68KI_USER A)
+	#define m68ki_host_read_32(A, FC)           m68k_read_memory_32(M68KI_USER A)
+	#define m68ki_host_write_8(A, FC, V)        m68k_write_memory_8(M68KI_USER A, V)
+	#define m68ki_host_write_16(A, FC, V)       m68k_write_memory_16(M68KI_USER A, V)
+	#define m68ki_host_write_32(A, FC, V)       m68k_write_memory_32(M68KI_USER A, V)
+	#define m68ki_host_write_32_pd(A, FC, V)    m68k_write_memory_32_pd(M68KI_USER A, V)
+	#define m68ki_host_read_block(A, FC, S, N, V)  m68k_read_memory_block(M68KI_USER A, S, N, V)
+	#define m68ki_host_write_block(A, FC, S, N, V) m68k_write_memory_block(M68KI_USER A, S, N, V)
+	#define m68ki_host_rmw_8(A, FC, F, C)       m68k_rmw_memory_8(M68KI_USER A, F, C)
+	#define m68ki_host_rmw_16(A, FC, F, C)      m68k_rmw_memory_16(M68KI_USER A, F, C)
+	#define m68ki_host_rmw_32(A, FC, F, C)      m68k_rmw_memory_32(M68KI_USER A, F, C)
+#endif /* M68K_MEMORY_FC */
 
 
 /* Enable or disable trace emulation */
@@ -537,12 +727,60 @@ extern "C" {
 
 
 
-/* Address error */
+/* Bus and address errors */
+#if M68K_PENDING_FAULTS
+	/* The exception is taken where the fault occurs, and m68ki_fault() flags
+	 * the rest of the instruction to be skipped (see m68ki_unwind_fault()).
+	 */
+	#define m68ki_set_bus_error_trap()
+	#define m68ki_set_step_bus_error_trap()
+	#define m68ki_fault_pending() CPU_FAULT_PENDING
+	#define m68ki_skip_read_if_faulted() if(CPU_FAULT_PENDING) return 0
+	#define m68ki_skip_write_if_faulted() if(CPU_FAULT_PENDING) return
+#else
+	extern jmp_buf m68ki_bus_error_jmp_buf;
+
+	#define m68ki_set_bus_error_trap() setjmp(m68ki_bus_error_jmp_buf)
+	/* m68k_step() has run its instruction once the exception is taken */
+	#define m68ki_set_step_bus_error_trap() \
+		if(setjmp(m68ki_bus_error_jmp_buf) != 0) \
+			return m68ki_step_end()
+	#define m68ki_fault() longjmp(m68ki_bus_error_jmp_buf, 1)
+	#define m68ki_fault_pending() 0
+	#define m68ki_skip_read_if_faulted()
+	#define m68ki_skip_write_if_faulted()
+#endif /* M68K_PENDING_FAULTS */
+
+/* Once a fault has been taken, stop executing if the CPU halted or there
+ * are no clocks left.
+ */
+#define m68ki_exit_after_fault() \
+	if(CPU_STOPPED) \
+	{ \
+		SET_CYCLES(0); \
+		return m68ki_initial_cycles; \
+	} \
+	if(GET_CYCLES() <= 0) \
+		return m68ki_initial_cycles - GET_CYCLES()
+
 #if M68K_EMULATE_ADDRESS_ERROR
 	#include <setjmp.h>
 
+#if M68K_PENDING_FAULTS
+	#define m68ki_set_address_error_trap()
+	#define m68ki_set_step_address_error_trap()
+
+	#define m68ki_check_address_error(ADDR, WRITE_MODE, FC) \
+		if((ADDR)&1) \
+		{ \
+			m68ki_aerr_address = ADDR; \
+			m68ki_aerr_write_mode = WRITE_MODE; \
+			m68ki_aerr_fc = FC; \
+			m68ki_exception_address_error(); \
+			m68ki_fault(); \
+		}
 /* sigjmp() on Mac OS X and *BSD in general saves signal contexts and is super-slow, use sigsetjmp() to tell it not to */
-#ifdef _BSD_SETJMP_H
+#elif defined(_BSD_SETJMP_H)
 extern sigjmp_buf m68ki_aerr_trap;
 #define m68ki_set_address_error_trap(m68k) \
 	if(sigsetjmp(m68ki_aerr_trap, 0) != 0) \
@@ -555,6 +793,12 @@ extern sigjmp_buf m68ki_aerr_trap;
 			return m68ki_initial_cycles; \
 		} \
 	}
+#define m68ki_set_step_address_error_trap() \
+	if(sigsetjmp(m68ki_aerr_trap, 0) != 0) \
+	{ \
+		m68ki_exception_address_error(); \
+		return m68ki_step_end(); \
+	}
 
 #define m68ki_check_address_error(ADDR, WRITE_MODE, FC) \
 	if((ADDR)&1) \
@@ -570,18 +814,13 @@ extern jmp_buf m68ki_aerr_trap;
 		if(setjmp(m68ki_aerr_trap) != 0) \
 		{ \
 			m68ki_exception_address_error(); \
-			if(CPU_STOPPED) \
-			{ \
-				SET_CYCLES(0); \
-				return m68ki_initial_cycles; \
-			} \
-			/* ensure we don't re-enter execution loop after an
-			   address error if there's no more cycles remaining */ \
-			if(GET_CYCLES() <= 0) \
-			{ \
-				/* return how many clocks we used */ \
-				return m68ki_initial_cycles - GET_CYCLES(); \
-			} \
+			m68ki_exit_after_fault(); \
+		}
+	#define m68ki_set_step_address_error_trap() \
+		if(setjmp(m68ki_aerr_trap) != 0) \
+		{ \
+			m68ki_exception_address_error(); \
+			return m68ki_step_end(); \
 		}
 
 	#define m68ki_check_address_error(ADDR, WRITE_MODE, FC) \
@@ -601,6 +840,7 @@ extern jmp_buf m68ki_aerr_trap;
 		}
 #else
 	#define m68ki_set_address_error_trap()
+	#define m68ki_set_step_address_error_trap()
 	#define m68ki_check_address_error(ADDR, WRITE_MODE, FC)
 	#define m68ki_check_address_error_010_less(ADDR, WRITE_MODE, FC)
 #endif /* M68K_ADDRESS_ERROR */
@@ -623,6 +863,183 @@ extern jmp_buf m68ki_aerr_trap;
 #endif
 
 
+/* Predecoded block cache */
+#if M68K_BLOCK_CACHE
+	#if M68K_EMULATE_PREFETCH
+		#error M68K_BLOCK_CACHE cannot be used with M68K_EMULATE_PREFETCH
+	#endif
+	#ifndef M68K_BLOCK_CACHE_BLOCKS
+		#define M68K_BLOCK_CACHE_BLOCKS 1024
+	#endif
+	#ifndef M68K_BLOCK_CACHE_LENGTH
+		#define M68K_BLOCK_CACHE_LENGTH 16
+	#endif
+
+	/* Code pages are tracked with a granularity of 4K */
+	#define M68K_BLOCK_CACHE_PAGE_SHIFT 12
+	#define M68K_BLOCK_CACHE_MAX_WORDS  11 /* Longest 68020+ instruction */
+	#define M68K_BLOCK_CACHE_WORDS      (M68K_BLOCK_CACHE_LENGTH*3)
+
+	/* A block, and the instruction being added to it, spans at most 2 pages */
+	#if (M68K_BLOCK_CACHE_WORDS + 2*M68K_BLOCK_CACHE_MAX_WORDS)*2 > (1 << M68K_BLOCK_CACHE_PAGE_SHIFT)
+		#error M68K_BLOCK_CACHE_LENGTH is too large
+	#endif
+
+	#define m68ki_block_cache_is_code(PAGE) (m68ki_block_cache_pages[(PAGE) >> 3] & (1 << ((PAGE) & 7)))
+#else
+	#define m68ki_block_cache_write(A, SIZE)
+#endif /* M68K_BLOCK_CACHE */
+
+
+/* Fused opcode handlers */
+#if M68K_FUSED_OPCODES
+	#if !M68K_BLOCK_CACHE
+		#error M68K_FUSED_OPCODES needs M68K_BLOCK_CACHE
+	#endif
+	#if M68K_INSTRUCTION_HOOK
+		#error M68K_FUSED_OPCODES cannot be used with M68K_INSTRUCTION_HOOK
+	#endif
+#endif /* M68K_FUSED_OPCODES */
+
+
+/* Flagless opcode handlers */
+#if M68K_FLAGLESS_OPCODES
+	#if !M68K_BLOCK_CACHE
+		#error M68K_FLAGLESS_OPCODES needs M68K_BLOCK_CACHE
+	#endif
+	#if M68K_INSTRUCTION_HOOK
+		#error M68K_FLAGLESS_OPCODES cannot be used with M68K_INSTRUCTION_HOOK
+	#endif
+#endif /* M68K_FLAGLESS_OPCODES */
+
+
+/* Translation of hot blocks to x86-64 code */
+#if M68K_JIT && !(defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__)))
+	#undef M68K_JIT
+	#define M68K_JIT OPT_OFF
+#endif
+
+#if M68K_JIT
+	#if !M68K_BLOCK_CACHE
+		#error M68K_JIT needs M68K_BLOCK_CACHE
+	#endif
+	#ifndef M68K_JIT_THRESHOLD
+		#define M68K_JIT_THRESHOLD 16
+	#endif
+	#ifndef M68K_JIT_CODE_SIZE
+		#define M68K_JIT_CODE_SIZE (4 << 20)
+	#endif
+#endif /* M68K_JIT */
+
+
+/* Threaded dispatch */
+#if M68K_THREADED_DISPATCH && !defined(__GNUC__)
+	#undef M68K_THREADED_DISPATCH
+	#define M68K_THREADED_DISPATCH OPT_OFF
+#endif
+
+#if M68K_THREADED_DISPATCH
+	/* The hot opcode handlers are compiled into m68ki_threaded_execute(),
+	 * along with the code that finishes one instruction and starts the next.
+	 */
+	#define M68KI_THREADED_INLINE inline __attribute__((always_inline))
+
+	/* m68ki_threaded_execute() hands the PC back to m68k_execute() whenever
+	 * the block cache or recompiled code could take over from it.
+	 */
+	#if M68K_BLOCK_CACHE
+		#define m68ki_threaded_leave() (!PMMU_ENABLED && !(REG_PC & 1))
+	#elif M68K_STATIC_CODE
+		#define m68ki_threaded_leave() \
+			(REG_PC - m68ki_static_code_start < m68ki_static_code_size && !PMMU_ENABLED)
+	#else
+		#define m68ki_threaded_leave() 0
+	#endif
+#else
+	#define M68KI_THREADED_INLINE
+#endif /* M68K_THREADED_DISPATCH */
+
+
+/* Statically recompiled code */
+#if M68K_STATIC_CODE
+	#if M68K_EMULATE_PREFETCH
+		#error M68K_STATIC_CODE cannot be used with M68K_EMULATE_PREFETCH
+	#endif
+#else
+	#define m68ki_static_code_write(A, SIZE)
+#endif /* M68K_STATIC_CODE */
+
+
+/* Specialized handler sets */
+#if M68K_SPECIALIZE_CPU
+	/* m68kops.c compiles the opcode handlers once for each of these sets,
+	 * with M68KI_HANDLER_SET defined to the set number.  Inside a set,
+	 * CPU_TYPE can only be one of the family members, and the timing values
+	 * are constants (see M68KI_CYC_BCC_NOTAKE_B()).  This lets the
+	 * compiler fold away any CPU type test that the whole family agrees on.
+	 */
+	#define M68KI_HANDLER_SETS 4
+
+	#define M68KI_HANDLER_SET_OF(A) \
+		(((A) & (CPU_TYPE_000 | CPU_TYPE_008)) ? 0 : \
+		 ((A) & (CPU_TYPE_010 | CPU_TYPE_SCC070)) ? 1 : \
+		 ((A) & (CPU_TYPE_EC020 | CPU_TYPE_020 | CPU_TYPE_EC030 | CPU_TYPE_030)) ? 2 : 3)
+
+	#define M68KI_SET_CPU_TYPE_0 (m68ki_cpu.cpu_type == CPU_TYPE_008 ? CPU_TYPE_008 : CPU_TYPE_000)
+	#define M68KI_SET_CPU_TYPE_1 (m68ki_cpu.cpu_type == CPU_TYPE_SCC070 ? CPU_TYPE_SCC070 : CPU_TYPE_010)
+	#define M68KI_SET_CPU_TYPE_2 (m68ki_cpu.cpu_type == CPU_TYPE_EC020 ? CPU_TYPE_EC020 : \
+	                              m68ki_cpu.cpu_type == CPU_TYPE_020   ? CPU_TYPE_020 : \
+	                              m68ki_cpu.cpu_type == CPU_TYPE_EC030 ? CPU_TYPE_EC030 : CPU_TYPE_030)
+	#define M68KI_SET_CPU_TYPE_3 (m68ki_cpu.cpu_type == CPU_TYPE_EC040 ? CPU_TYPE_EC040 : \
+	                              m68ki_cpu.cpu_type == CPU_TYPE_LC040 ? CPU_TYPE_LC040 : CPU_TYPE_040)
+
+	#define M68KI_SET_CPU_TYPE        M68KI_SET_CPU_TYPE_(M68KI_HANDLER_SET)
+	#define M68KI_SET_CPU_TYPE_(S)    M68KI_SET_CPU_TYPE__(S)
+	#define M68KI_SET_CPU_TYPE__(S)   M68KI_SET_CPU_TYPE_##S
+
+	/* The 68020 and 68030 share a handler set, so they must agree on the
+	 * clocks that are constants within a set.
+	 */
+	#if M68KI_CYC_BCC_NOTAKE_B(2) != M68KI_CYC_BCC_NOTAKE_B(3) || \
+	    M68KI_CYC_BCC_NOTAKE_W(2) != M68KI_CYC_BCC_NOTAKE_W(3) || \
+	    M68KI_CYC_DBCC_F_NOEXP(2) != M68KI_CYC_DBCC_F_NOEXP(3) || \
+	    M68KI_CYC_DBCC_F_EXP(2)   != M68KI_CYC_DBCC_F_EXP(3)   || \
+	    M68KI_CYC_SCC_R_TRUE(2)   != M68KI_CYC_SCC_R_TRUE(3)   || \
+	    M68KI_CYC_MOVEM_W(2)      != M68KI_CYC_MOVEM_W(3)      || \
+	    M68KI_CYC_MOVEM_L(2)      != M68KI_CYC_MOVEM_L(3)      || \
+	    M68KI_CYC_SHIFT(2)        != M68KI_CYC_SHIFT(3)        || \
+	    M68KI_CYC_RESET(2)        != M68KI_CYC_RESET(3)
+		#error M68K_SPECIALIZE_CPU needs the 68020 and 68030 to share their family clocks
+	#endif
+
+	/* Timing table of the family each set stands for */
+	#define M68KI_SET_TIMING            (M68KI_HANDLER_SET == 3 ? 4 : M68KI_HANDLER_SET)
+
+	#define M68KI_SET_CYC_BCC_NOTAKE_B  M68KI_CYC_BCC_NOTAKE_B(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_BCC_NOTAKE_W  M68KI_CYC_BCC_NOTAKE_W(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_DBCC_F_NOEXP  M68KI_CYC_DBCC_F_NOEXP(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_DBCC_F_EXP    M68KI_CYC_DBCC_F_EXP(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_SCC_R_TRUE    M68KI_CYC_SCC_R_TRUE(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_MOVEM_W       M68KI_CYC_MOVEM_W(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_MOVEM_L       M68KI_CYC_MOVEM_L(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_SHIFT         M68KI_CYC_SHIFT(M68KI_SET_TIMING)
+	#define M68KI_SET_CYC_RESET         M68KI_CYC_RESET(M68KI_SET_TIMING)
+
+	/* The handlers of a set are named after the set, and the handler table
+	 * holds one entry per set.
+	 */
+	#define M68KI_OP(NAME)             M68KI_OP_IN_SET(NAME, M68KI_HANDLER_SET)
+	#define M68KI_OP_IN_SET(NAME, S)   M68KI_OP_IN_SET_(NAME, S)
+	#define M68KI_OP_IN_SET_(NAME, S)  NAME##_##S
+	#define M68KI_OP_HANDLER(NAME) \
+		{M68KI_OP_IN_SET(NAME, 0), M68KI_OP_IN_SET(NAME, 1), \
+		 M68KI_OP_IN_SET(NAME, 2), M68KI_OP_IN_SET(NAME, 3)}
+#else
+	#define M68KI_OP(NAME)         NAME
+	#define M68KI_OP_HANDLER(NAME) NAME
+#endif /* M68K_SPECIALIZE_CPU */
+
+
 
 /* -------------------------- EA / Operand Access ------------------------- */
 
@@ -643,12 +1060,12 @@ extern jmp_buf m68ki_aerr_trap;
 #define EA_AY_AI_8()   AY                                    /* address register indirect */
 #define EA_AY_AI_16()  EA_AY_AI_8()
 #define EA_AY_AI_32()  EA_AY_AI_8()
-#define EA_AY_PI_8()   (AY++)                                /* postincrement (size = byte) */
-#define EA_AY_PI_16()  ((AY+=2)-2)                           /* postincrement (size = word) */
-#define EA_AY_PI_32()  ((AY+=4)-4)                           /* postincrement (size = long) */
-#define EA_AY_PD_8()   (--AY)                                /* predecrement (size = byte) */
-#define EA_AY_PD_16()  (AY-=2)                               /* predecrement (size = word) */
-#define EA_AY_PD_32()  (AY-=4)                               /* predecrement (size = long) */
+#define EA_AY_PI_8()   (m68ki_save_ay(), AY++)               /* postincrement (size = byte) */
+#define EA_AY_PI_16()  (m68ki_save_ay(), (AY+=2)-2)          /* postincrement (size = word) */
+#define EA_AY_PI_32()  (m68ki_save_ay(), (AY+=4)-4)          /* postincrement (size = long) */
+#define EA_AY_PD_8()   (m68ki_save_ay(), --AY)               /* predecrement (size = byte) */
+#define EA_AY_PD_16()  (m68ki_save_ay(), AY-=2)              /* predecrement (size = word) */
+#define EA_AY_PD_32()  (m68ki_save_ay(), AY-=4)              /* predecrement (size = long) */
 #define EA_AY_DI_8()   (AY+MAKE_INT_16(m68ki_read_imm_16())) /* displacement */
 #define EA_AY_DI_16()  EA_AY_DI_8()
 #define EA_AY_DI_32()  EA_AY_DI_8()
@@ -659,12 +1076,12 @@ extern jmp_buf m68ki_aerr_trap;
 #define EA_AX_AI_8()   AX
 #define EA_AX_AI_16()  EA_AX_AI_8()
 #define EA_AX_AI_32()  EA_AX_AI_8()
-#define EA_AX_PI_8()   (AX++)
-#define EA_AX_PI_16()  ((AX+=2)-2)
-#define EA_AX_PI_32()  ((AX+=4)-4)
-#define EA_AX_PD_8()   (--AX)
-#define EA_AX_PD_16()  (AX-=2)
-#define EA_AX_PD_32()  (AX-=4)
+#define EA_AX_PI_8()   (m68ki_save_ax(), AX++)
+#define EA_AX_PI_16()  (m68ki_save_ax(), (AX+=2)-2)
+#define EA_AX_PI_32()  (m68ki_save_ax(), (AX+=4)-4)
+#define EA_AX_PD_8()   (m68ki_save_ax(), --AX)
+#define EA_AX_PD_16()  (m68ki_save_ax(), AX-=2)
+#define EA_AX_PD_32()  (m68ki_save_ax(), AX-=4)
 #define EA_AX_DI_8()   (AX+MAKE_INT_16(m68ki_read_imm_16()))
 #define EA_AX_DI_16()  EA_AX_DI_8()
 #define EA_AX_DI_32()  EA_AX_DI_8()
@@ -672,8 +1089,8 @@ extern jmp_buf m68ki_aerr_trap;
 #define EA_AX_IX_16()  EA_AX_IX_8()
 #define EA_AX_IX_32()  EA_AX_IX_8()
 
-#define EA_A7_PI_8()   ((REG_A[7]+=2)-2)
-#define EA_A7_PD_8()   (REG_A[7]-=2)
+#define EA_A7_PI_8()   (m68ki_save_da(15), (REG_A[7]+=2)-2)
+#define EA_A7_PD_8()   (m68ki_save_da(15), REG_A[7]-=2)
 
 #define EA_AW_8()      MAKE_INT_16(m68ki_read_imm_16())      /* absolute word */
 #define EA_AW_16()     EA_AW_8()
@@ -790,7 +1207,8 @@ extern jmp_buf m68ki_aerr_trap;
 
 
 /* Get the condition code register */
-#define m68ki_get_ccr() ((COND_XS() >> 4) | \
+#define m68ki_get_ccr() (m68ki_lazy_flags_sync(), \
+						 (COND_XS() >> 4) | \
 						 (COND_MI() >> 4) | \
 						 (COND_EQ() << 2) | \
 						 (COND_VS() >> 6) | \
@@ -804,6 +1222,90 @@ extern jmp_buf m68ki_aerr_trap;
 						 FLAG_INT_MASK        | \
 						 m68ki_get_ccr())
 
+/* Set N, Z, V and C (and X for ADD and SUB) the way the logical instructions
+ * and ADD, SUB and CMP do.  With M68K_LAZY_FLAGS, only X is set, and the
+ * rest is worked out from the source and result when something reads it:
+ * m68kmake calls m68ki_lazy_flags_sync() at the top of every handler that
+ * uses FLAG_N, FLAG_Z, FLAG_V, FLAG_C or a condition, m68ki_get_ccr() calls
+ * it, and m68ki_set_ccr() drops what is pending.
+ */
+#if M68K_LAZY_FLAGS
+	#define M68KI_LAZY_NONE     0
+	#define M68KI_LAZY_LOGIC_8  1
+	#define M68KI_LAZY_LOGIC_16 2
+	#define M68KI_LAZY_LOGIC_32 3
+	#define M68KI_LAZY_ADD_8    4
+	#define M68KI_LAZY_ADD_16   5
+	#define M68KI_LAZY_ADD_32   6
+	#define M68KI_LAZY_SUB_8    7  /* and CMP */
+	#define M68KI_LAZY_SUB_16   8
+	#define M68KI_LAZY_SUB_32   9
+
+	#define m68ki_lazy_flags_sync() (m68ki_cpu.lazy_op ? m68ki_lazy_flags_compute(&m68ki_cpu) : (void)0)
+
+	#define m68ki_lazy_logic(OP, R) \
+		do { m68ki_cpu.lazy_op = OP; m68ki_cpu.lazy_res = R; } while(0)
+	#define m68ki_lazy_arith(OP, S, R) \
+		do { m68ki_cpu.lazy_op = OP; m68ki_cpu.lazy_src = S; m68ki_cpu.lazy_res = R; } while(0)
+
+	#define m68ki_set_logic_flags_8(R)       m68ki_lazy_logic(M68KI_LAZY_LOGIC_8, R)
+	#define m68ki_set_logic_flags_16(R)      m68ki_lazy_logic(M68KI_LAZY_LOGIC_16, R)
+	#define m68ki_set_logic_flags_32(R)      m68ki_lazy_logic(M68KI_LAZY_LOGIC_32, R)
+	#define m68ki_set_add_flags_8(S, D, R)   do { FLAG_X = CFLAG_8(R); m68ki_lazy_arith(M68KI_LAZY_ADD_8, S, R); } while(0)
+	#define m68ki_set_add_flags_16(S, D, R)  do { FLAG_X = CFLAG_16(R); m68ki_lazy_arith(M68KI_LAZY_ADD_16, S, R); } while(0)
+	#define m68ki_set_add_flags_32(S, D, R)  do { FLAG_X = CFLAG_ADD_32(S, D, R); m68ki_lazy_arith(M68KI_LAZY_ADD_32, S, R); } while(0)
+	#define m68ki_set_sub_flags_8(S, D, R)   do { FLAG_X = CFLAG_8(R); m68ki_lazy_arith(M68KI_LAZY_SUB_8, S, R); } while(0)
+	#define m68ki_set_sub_flags_16(S, D, R)  do { FLAG_X = CFLAG_16(R); m68ki_lazy_arith(M68KI_LAZY_SUB_16, S, R); } while(0)
+	#define m68ki_set_sub_flags_32(S, D, R)  do { FLAG_X = CFLAG_SUB_32(S, D, R); m68ki_lazy_arith(M68KI_LAZY_SUB_32, S, R); } while(0)
+	#define m68ki_set_cmp_flags_8(S, D, R)   m68ki_lazy_arith(M68KI_LAZY_SUB_8, S, R)
+	#define m68ki_set_cmp_flags_16(S, D, R)  m68ki_lazy_arith(M68KI_LAZY_SUB_16, S, R)
+	#define m68ki_set_cmp_flags_32(S, D, R)  m68ki_lazy_arith(M68KI_LAZY_SUB_32, S, R)
+#else
+	#define m68ki_lazy_flags_sync() ((void)0)
+
+	#define m68ki_set_logic_flags_8(R) \
+		do { FLAG_N = NFLAG_8(R); FLAG_Z = (R); FLAG_V = VFLAG_CLEAR; FLAG_C = CFLAG_CLEAR; } while(0)
+	#define m68ki_set_logic_flags_16(R) \
+		do { FLAG_N = NFLAG_16(R); FLAG_Z = (R); FLAG_V = VFLAG_CLEAR; FLAG_C = CFLAG_CLEAR; } while(0)
+	#define m68ki_set_logic_flags_32(R) \
+		do { FLAG_N = NFLAG_32(R); FLAG_Z = (R); FLAG_V = VFLAG_CLEAR; FLAG_C = CFLAG_CLEAR; } while(0)
+	#define m68ki_set_add_flags_8(S, D, R) \
+		do { FLAG_N = NFLAG_8(R); FLAG_V = VFLAG_ADD_8(S, D, R); FLAG_X = FLAG_C = CFLAG_8(R); FLAG_Z = MASK_OUT_ABOVE_8(R); } while(0)
+	#define m68ki_set_add_flags_16(S, D, R) \
+		do { FLAG_N = NFLAG_16(R); FLAG_V = VFLAG_ADD_16(S, D, R); FLAG_X = FLAG_C = CFLAG_16(R); FLAG_Z = MASK_OUT_ABOVE_16(R); } while(0)
+	#define m68ki_set_add_flags_32(S, D, R) \
+		do { FLAG_N = NFLAG_32(R); FLAG_V = VFLAG_ADD_32(S, D, R); FLAG_X = FLAG_C = CFLAG_ADD_32(S, D, R); FLAG_Z = MASK_OUT_ABOVE_32(R); } while(0)
+	#define m68ki_set_sub_flags_8(S, D, R) \
+		do { FLAG_N = NFLAG_8(R); FLAG_V = VFLAG_SUB_8(S, D, R); FLAG_X = FLAG_C = CFLAG_8(R); FLAG_Z = MASK_OUT_ABOVE_8(R); } while(0)
+	#define m68ki_set_sub_flags_16(S, D, R) \
+		do { FLAG_N = NFLAG_16(R); FLAG_V = VFLAG_SUB_16(S, D, R); FLAG_X = FLAG_C = CFLAG_16(R); FLAG_Z = MASK_OUT_ABOVE_16(R); } while(0)
+	#define m68ki_set_sub_flags_32(S, D, R) \
+		do { FLAG_N = NFLAG_32(R); FLAG_V = VFLAG_SUB_32(S, D, R); FLAG_X = FLAG_C = CFLAG_SUB_32(S, D, R); FLAG_Z = MASK_OUT_ABOVE_32(R); } while(0)
+	#define m68ki_set_cmp_flags_8(S, D, R) \
+		do { FLAG_N = NFLAG_8(R); FLAG_V = VFLAG_SUB_8(S, D, R); FLAG_C = CFLAG_8(R); FLAG_Z = MASK_OUT_ABOVE_8(R); } while(0)
+	#define m68ki_set_cmp_flags_16(S, D, R) \
+		do { FLAG_N = NFLAG_16(R); FLAG_V = VFLAG_SUB_16(S, D, R); FLAG_C = CFLAG_16(R); FLAG_Z = MASK_OUT_ABOVE_16(R); } while(0)
+	#define m68ki_set_cmp_flags_32(S, D, R) \
+		do { FLAG_N = NFLAG_32(R); FLAG_V = VFLAG_SUB_32(S, D, R); FLAG_C = CFLAG_SUB_32(S, D, R); FLAG_Z = MASK_OUT_ABOVE_32(R); } while(0)
+#endif /* M68K_LAZY_FLAGS */
+
+/* m68kmake uses these instead of the above in flagless handlers, which the
+ * block cache only runs when the next instruction sets N, Z, V and C again.
+ * X is still set.
+ */
+#define m68ki_skip_logic_flags_8(R)       ((void)(R))
+#define m68ki_skip_logic_flags_16(R)      ((void)(R))
+#define m68ki_skip_logic_flags_32(R)      ((void)(R))
+#define m68ki_skip_add_flags_8(S, D, R)   (FLAG_X = CFLAG_8(R))
+#define m68ki_skip_add_flags_16(S, D, R)  (FLAG_X = CFLAG_16(R))
+#define m68ki_skip_add_flags_32(S, D, R)  (FLAG_X = CFLAG_ADD_32(S, D, R))
+#define m68ki_skip_sub_flags_8(S, D, R)   (FLAG_X = CFLAG_8(R))
+#define m68ki_skip_sub_flags_16(S, D, R)  (FLAG_X = CFLAG_16(R))
+#define m68ki_skip_sub_flags_32(S, D, R)  (FLAG_X = CFLAG_SUB_32(S, D, R))
+#define m68ki_skip_cmp_flags_8(S, D, R)   ((void)(R))
+#define m68ki_skip_cmp_flags_16(S, D, R)  ((void)(R))
+#define m68ki_skip_cmp_flags_32(S, D, R)  ((void)(R))
+
 
 
 /* ---------------------------- Cycle Counting ---------------------------- */
@@ -834,6 +1336,20 @@ extern jmp_buf m68ki_aerr_trap;
 #define m68ki_write_32_pd(A, V) m68ki_write_32_fc(A, FLAG_S | FUNCTION_CODE_USER_DATA, V)
 #endif
 
+/* Read-modify-write an operand and return the value read (see m68ki_rmw_fc()) */
+#define m68ki_rmw_8(A, OP, V)  m68ki_rmw_fc(A, FLAG_S | m68ki_get_address_space(), 1, OP, V, 0)
+#define m68ki_rmw_16(A, OP, V) m68ki_rmw_fc(A, FLAG_S | m68ki_get_address_space(), 2, OP, V, 0)
+#define m68ki_rmw_32(A, OP, V) m68ki_rmw_fc(A, FLAG_S | m68ki_get_address_space(), 4, OP, V, 0)
+#define m68ki_cas_8(A, C, V)   m68ki_rmw_fc(A, FLAG_S | m68ki_get_address_space(), 1, M68KI_RMW_CAS, V, C)
+#define m68ki_cas_16(A, C, V)  m68ki_rmw_fc(A, FLAG_S | m68ki_get_address_space(), 2, M68KI_RMW_CAS, V, C)
+#define m68ki_cas_32(A, C, V)  m68ki_rmw_fc(A, FLAG_S | m68ki_get_address_space(), 4, M68KI_RMW_CAS, V, C)
+
+/* Transfer COUNT consecutive values in one go, or return 0 (see m68ki_read_block_fc()) */
+#define m68ki_read_block_16(A, COUNT, V)  m68ki_read_block_fc (A, FLAG_S | m68ki_get_address_space(), 2, COUNT, V)
+#define m68ki_read_block_32(A, COUNT, V)  m68ki_read_block_fc (A, FLAG_S | m68ki_get_address_space(), 4, COUNT, V)
+#define m68ki_write_block_16(A, COUNT, V) m68ki_write_block_fc(A, FLAG_S | FUNCTION_CODE_USER_DATA, 2, COUNT, V)
+#define m68ki_write_block_32(A, COUNT, V) m68ki_write_block_fc(A, FLAG_S | FUNCTION_CODE_USER_DATA, 4, COUNT, V)
+
 /* Map PC-relative reads */
 #define m68ki_read_pcrel_8(A) m68k_read_pcrelative_8(A)
 #define m68ki_read_pcrel_16(A) m68k_read_pcrelative_16(A)
@@ -861,12 +1377,37 @@ typedef union
 	double f;
 } fp_reg;
 
+#if M68K_EVENTS
+/* A timed device event (see m68k_add_event()) */
+typedef struct
+{
+	void (*callback)(M68K_USER_PARAM int event); /* Called when the event comes due */
+	unsigned long long time;                     /* Clock the event is due at */
+	int pos;                                     /* Index in the event heap, or -1 if not armed */
+} m68ki_event;
+
+/* A CPU's device events, and a heap of the armed ones ordered by due time */
+typedef struct
+{
+	m68ki_event event[M68K_MAX_EVENTS];
+	int heap[M68K_MAX_EVENTS];
+	int count;                 /* Events added */
+	int heap_size;             /* Events armed */
+	unsigned long long clock;  /* Clocks run before this m68k_execute() */
+	int left;                  /* Clocks of the timeslice not handed out yet */
+	int running;               /* Inside m68k_execute() */
+	int firing;                /* Inside an event callback */
+	unsigned long long due;    /* Time the firing event was due at */
+} m68ki_event_queue;
+#endif /* M68K_EVENTS */
+
 typedef struct
 {
 	unsigned cpu_type;     /* CPU Type: 68000, 68008, 68010, 68EC020, 68020, 68EC030, 68030, 68EC040, or 68040 */
 	unsigned dar[16];      /* Data and Address Registers */
-	unsigned dar_save[16]; /* Saved Data and Address Registers (pushed onto the
-	                          stack when a bus error occurs)*/
+	unsigned dar_save[16]; /* Saved Data and Address Registers (restored
+	                          when a bus error occurs)*/
+	unsigned dar_save_mask; /* Registers saved by the current instruction */
 	unsigned ppc;          /* Previous program counter */
 	unsigned pc;           /* Program Counter */
 	unsigned sp[7];        /* User, Interrupt, and Master Stack Pointers */
@@ -889,6 +1430,9 @@ typedef struct
 	unsigned not_z_flag;   /* Zero, inverted for speedups */
 	unsigned v_flag;       /* Overflow */
 	unsigned c_flag;       /* Carry */
+	unsigned lazy_op;      /* Instruction N, Z, V and C are still to be set for (M68K_LAZY_FLAGS) */
+	unsigned lazy_src;     /* Its source operand */
+	unsigned lazy_res;     /* Its result */
 	unsigned int_mask;     /* I0-I2 */
 	unsigned int_level;    /* State of interrupt pins IPL0-IPL2 -- ASG: changed from ints_pending */
 	unsigned stopped;      /* Stopped state */
@@ -898,9 +1442,12 @@ typedef struct
 	unsigned sr_mask;      /* Implemented status register bits */
 	unsigned instr_mode;   /* Stores whether we are in instruction mode or group 0/1 exception mode */
 	unsigned run_mode;     /* Stores whether we are processing a reset, bus error, address error, or something else */
+	unsigned fault_pending; /* A bus or address error cut the current instruction short */
 	int      has_pmmu;     /* Indicates if a PMMU available (yes on 030, 040, no on EC030) */
 	int      pmmu_enabled; /* Indicates if the PMMU is enabled */
 	unsigned reset_cycles;
+	unsigned long long idle_cycles; /* Clocks skipped by M68K_IDLE_SKIP */
+	unsigned block_cache_id; /* Tells CPU contexts apart in the block cache */
 
 	/* Clocks required for instructions / exceptions */
 	unsigned cyc_bcc_notake_b;
@@ -921,25 +1468,99 @@ typedef struct
 	unsigned mmu_crp_aptr, mmu_crp_limit;
 	unsigned mmu_srp_aptr, mmu_srp_limit;
 	unsigned mmu_tc;
+	unsigned mmu_tt0, mmu_tt1;
 	uint16_t mmu_sr;
 
+	/* 68040 PMMU registers (its TC and SRP are in mmu_tc and mmu_srp_aptr) */
+	unsigned mmu_urp_aptr;
+	unsigned mmu_itt0, mmu_itt1;
+	unsigned mmu_dtt0, mmu_dtt1;
+	unsigned mmu_sr_040;
+
 	const uint8_t* cyc_instruction;
 	const uint8_t* cyc_exception;
 
 	/* Callbacks to host */
-	int  (*int_ack_callback)(int int_line);           /* Interrupt Acknowledge */
-	void (*bkpt_ack_callback)(unsigned data);         /* Breakpoint Acknowledge */
-	void (*reset_instr_callback)(void);               /* Called when a RESET instruction is encountered */
-	void (*cmpild_instr_callback)(unsigned, int);     /* Called when a CMPI.L #v, Dn instruction is encountered */
-	void (*rte_instr_callback)(void);                 /* Called when a RTE instruction is encountered */
-	int  (*tas_instr_callback)(void);                 /* Called when a TAS instruction is encountered, allows / disallows writeback */
-	int  (*illg_instr_callback)(int);                 /* Called when an illegal instruction is encountered, allows handling */
-	void (*pc_changed_callback)(unsigned new_pc);     /* Called when the PC changes by a large amount */
-	void (*set_fc_callback)(unsigned new_fc);         /* Called when the CPU function code changes */
-	void (*instr_hook_callback)(unsigned pc);         /* Called every instruction cycle prior to execution */
+	int  (*int_ack_callback)(M68K_USER_PARAM int int_line);       /* Interrupt Acknowledge */
+	void (*bkpt_ack_callback)(M68K_USER_PARAM unsigned data);     /* Breakpoint Acknowledge */
+	void (*reset_instr_callback)(M68K_USER_VOID);                 /* Called when a RESET instruction is encountered */
+	void (*cmpild_instr_callback)(M68K_USER_PARAM unsigned, int); /* Called when a CMPI.L #v, Dn instruction is encountered */
+	void (*rte_instr_callback)(M68K_USER_VOID);                   /* Called when a RTE instruction is encountered */
+	int  (*tas_instr_callback)(M68K_USER_VOID);                   /* Called when a TAS instruction is encountered, allows / disallows writeback */
+	int  (*illg_instr_callback)(M68K_USER_PARAM int);             /* Called when an illegal instruction is encountered, allows handling */
+	void (*pc_changed_callback)(M68K_USER_PARAM unsigned new_pc); /* Called when the PC changes by a large amount */
+	void (*set_fc_callback)(M68K_USER_PARAM unsigned new_fc);     /* Called when the CPU function code changes */
+	void (*instr_hook_callback)(M68K_USER_PARAM unsigned pc);     /* Called every instruction cycle prior to execution */
+	int  (*idle_read_callback)(M68K_USER_PARAM unsigned address); /* Called to ask if a loop polling an address is idle */
+	void* user_context;                                           /* Passed to the callbacks (M68K_USER_CONTEXT) */
+
+#if M68K_EVENTS
+	m68ki_event_queue events; /* Device events (see m68k_add_event()) */
+#endif /* M68K_EVENTS */
 
 } m68ki_cpu_core;
 
+#if M68K_BLOCK_CACHE
+/* A predecoded instruction */
+typedef struct
+{
+	void   (*handler)(void);  /* Opcode handler */
+	unsigned pc;              /* Address of the instruction */
+	uint16_t ir;              /* Opcode */
+	uint16_t cycles;          /* Clocks used by the instruction */
+#if M68K_FUSED_OPCODES
+	void   (*fused)(void);    /* Runs this and the next instruction, or NULL */
+#endif /* M68K_FUSED_OPCODES */
+#if M68K_FLAGLESS_OPCODES
+	void   (*flagless)(void); /* Handler that leaves N, Z, V and C to a later instruction, or NULL */
+	unsigned flags_cycles;    /* Clocks from here to the instruction that sets them again */
+#endif /* M68K_FLAGLESS_OPCODES */
+} m68ki_block_cache_instr;
+
+/* Puts a block on the list of blocks covering one of its pages */
+typedef struct m68ki_block_cache_link
+{
+	struct m68ki_block_cache_link*  next;
+	struct m68ki_block_cache_link** prev;  /* Whatever points to this link */
+	struct m68ki_block_cache_block* block;
+	unsigned page;
+} m68ki_block_cache_link;
+
+/* A run of predecoded instructions ending at a change of flow */
+typedef struct m68ki_block_cache_block
+{
+	unsigned pc;              /* Address of the first instruction */
+	unsigned fc;              /* Address space the block was fetched from */
+	unsigned cpu_id;          /* CPU the block was recorded by (see m68ki_block_cache_new_cpu()) */
+	unsigned length;          /* Bytes of instruction stream covered */
+	unsigned span;            /* Bytes of memory a write to invalidates the block */
+	unsigned valid;           /* Cleared when the code is written to */
+	unsigned links;           /* Number of pages the block is listed under */
+	m68ki_block_cache_link link[2];
+	unsigned count;           /* Number of instructions */
+#if M68K_JIT
+	unsigned hits;            /* Times replayed while not translated */
+	void   (*jit)(void);      /* Translated code, or NULL */
+#endif /* M68K_JIT */
+	m68ki_block_cache_instr instr[M68K_BLOCK_CACHE_LENGTH];
+	uint16_t words[M68K_BLOCK_CACHE_WORDS + M68K_BLOCK_CACHE_MAX_WORDS]; /* Opcode and extension words */
+} m68ki_block_cache_block;
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_PMMU_ATC
+/* A PMMU translation cached in the ATC */
+typedef struct
+{
+	unsigned page;  /* Logical address >> m68ki_atc_shift */
+	unsigned root;  /* 1 if translated with the SRP, M68KI_ATC_EMPTY if unused */
+	unsigned delta; /* Physical address - logical address */
+	unsigned write; /* 1 if writes can use the entry without a table search */
+#if M68KI_ATC_HOST
+	uint8_t* host[2]; /* Mapped memory the page reads from and writes to, or NULL */
+#endif /* M68KI_ATC_HOST */
+} m68ki_atc_entry;
+#endif /* M68K_PMMU_ATC */
+
 
 extern m68ki_cpu_core m68ki_cpu;
 extern int              m68ki_remaining_cycles;
@@ -955,11 +1576,92 @@ extern unsigned         m68ki_aerr_address;
 extern unsigned         m68ki_aerr_write_mode;
 extern unsigned         m68ki_aerr_fc;
 
+#if M68K_PENDING_FAULTS
+extern m68ki_cpu_core   m68ki_fault_cpu;
+extern int              m68ki_fault_cycles;
+#endif /* M68K_PENDING_FAULTS */
+
+#if M68K_SPECIALIZE_CPU
+extern void (*m68ki_handler_sets[M68KI_HANDLER_SETS][0x10000])(void);
+extern void (**m68ki_instruction_jump_table)(void);   /* handler set in use */
+#else
+extern void (*m68ki_instruction_jump_table[0x10000])(void);
+#endif /* M68K_SPECIALIZE_CPU */
+
+#if M68K_THREADED_DISPATCH
+#if M68K_SPECIALIZE_CPU
+void m68ki_threaded_execute_0(void);
+void m68ki_threaded_execute_1(void);
+void m68ki_threaded_execute_2(void);
+void m68ki_threaded_execute_3(void);
+extern void (*m68ki_threaded_execute)(void);         /* dispatcher of the handler set in use */
+#else
+void m68ki_threaded_execute(void);
+#endif /* M68K_SPECIALIZE_CPU */
+#endif /* M68K_THREADED_DISPATCH */
+
+#if M68K_BLOCK_CACHE
+extern uint8_t          m68ki_block_cache_pages[];
+extern unsigned         m68ki_block_cache_fetch_pc;
+extern unsigned         m68ki_block_cache_fetch_length;
+extern const uint16_t*  m68ki_block_cache_fetch_words;
+extern unsigned         m68ki_block_cache_fetch_end;
+void m68ki_block_cache_invalidate(unsigned page, unsigned address, unsigned size);
+#endif /* M68K_BLOCK_CACHE */
+#if M68K_FUSED_OPCODES
+extern unsigned         m68ki_fused_pc;
+#endif /* M68K_FUSED_OPCODES */
+#if M68K_STATIC_CODE
+extern unsigned         m68ki_static_code_start;
+extern unsigned         m68ki_static_code_size;
+#endif /* M68K_STATIC_CODE */
+#if M68K_IDLE_SKIP
+void m68ki_idle_poll(void);
+#endif /* M68K_IDLE_SKIP */
+#if M68K_LAZY_FLAGS
+void m68ki_lazy_flags_compute(m68ki_cpu_core* cpu);
+#endif /* M68K_LAZY_FLAGS */
+#if M68K_MEMORY_MAP
+extern uint8_t*         m68ki_map_read_pages[];
+extern uint8_t*         m68ki_map_write_pages[];
+#endif /* M68K_MEMORY_MAP */
+#if M68KI_MAP_REGIONS
+extern const m68k_region* m68ki_map_regions[];
+#endif /* M68KI_MAP_REGIONS */
+#if M68K_DIRTY_PAGES
+extern uint64_t         m68ki_dirty_pages[];
+#endif /* M68K_DIRTY_PAGES */
+#if M68K_RMW_CALLBACKS
+int m68ki_rmw_modify(unsigned* value, void* context);
+#endif /* M68K_RMW_CALLBACKS */
+#if M68KI_CODE_PAGE
+extern const uint8_t*   m68ki_code_page;
+extern unsigned         m68ki_code_page_start;
+extern unsigned         m68ki_code_page_limit;
+void m68ki_code_page_refresh(unsigned address);
+#define m68ki_code_page_invalidate() (m68ki_code_page_limit = 0)
+#endif /* M68KI_CODE_PAGE */
+#if M68K_EVENTS
+void m68ki_event_start(void);
+int  m68ki_event_next(void);
+void m68ki_event_stop(void);
+#endif /* M68K_EVENTS */
+#if M68K_PMMU_ATC
+extern m68ki_atc_entry  m68ki_atc[];
+extern unsigned         m68ki_atc_shift;
+extern unsigned long long m68ki_atc_hits;
+extern unsigned long long m68ki_atc_misses;
+void m68ki_atc_flush(void);
+void m68ki_atc_flush_page(unsigned address, unsigned fc);
+unsigned m68ki_atc_load(unsigned address, unsigned root, unsigned fc, unsigned mode, unsigned size);
+#endif /* M68K_PMMU_ATC */
+
 /* Forward declarations to keep some of the macros happy */
 static inline unsigned m68ki_read_16_fc (unsigned address, unsigned fc);
 static inline unsigned m68ki_read_32_fc (unsigned address, unsigned fc);
 static inline unsigned m68ki_get_ea_ix(unsigned An);
 static inline void m68ki_check_interrupts(void);            /* ASG: check for interrupts */
+static inline void m68ki_exception_address_error(void);
 
 /* quick disassembly (used for logging) */
 char* m68ki_disassemble_quick(unsigned pc, unsigned cpu_type);
@@ -970,22 +1672,351 @@ char* m68ki_disassemble_quick(unsigned pc, unsigned cpu_type);
 /* ======================================================================== */
 
 
+/* -------------------------- Bus Error Rollback -------------------------- */
+
+/* A bus error puts the data and address registers back the way they were
+ * at the start of the instruction.  Rather than copying all of them before
+ * every instruction, anything that changes a register and then goes on to
+ * access the bus saves that register first (only the first save of an
+ * instruction counts).
+ */
+static inline void m68ki_save_da(unsigned reg)
+{
+	if(!(REG_DA_SAVE_MASK & (1 << reg)))
+	{
+		REG_DA_SAVE_MASK |= 1 << reg;
+		REG_DA_SAVE[reg] = REG_DA[reg];
+	}
+}
+
+#define m68ki_save_ax() m68ki_save_da(8 + ((REG_IR >> 9) & 7))
+#define m68ki_save_ay() m68ki_save_da(8 + (REG_IR & 7))
+
+/* Start the journal of a new instruction.  A bus error while stacking the
+ * trace exception of a finished instruction rolls back all of its register
+ * results, so an instruction that may be traced saves every register.
+ */
+static inline void m68ki_start_rollback(void)
+{
+#if M68K_EMULATE_TRACE
+	if(FLAG_T1 | FLAG_T0)
+	{
+		int i;
+
+		for(i = 15; i >= 0; i--)
+			REG_DA_SAVE[i] = REG_DA[i];
+		REG_DA_SAVE_MASK = 0xffff;
+		return;
+	}
+#endif /* M68K_EMULATE_TRACE */
+	REG_DA_SAVE_MASK = 0;
+}
+
+#if M68K_PENDING_FAULTS
+/* Called once a bus or address error exception has been taken.  Keep the
+ * state the exception left the CPU in, and let the instruction run to its
+ * end without any more bus accesses.  Only the first fault of an
+ * instruction counts, as with longjmp().
+ */
+static inline void m68ki_fault(void)
+{
+	if(!CPU_FAULT_PENDING)
+	{
+		m68ki_fault_cpu = m68ki_cpu;
+		m68ki_fault_cycles = GET_CYCLES();
+		CPU_FAULT_PENDING = 1;
+	}
+}
+
+/* At the end of an instruction, throw away anything it did after a fault */
+#define m68ki_rollback_fault() \
+	if(CPU_FAULT_PENDING) \
+	{ \
+		m68ki_cpu = m68ki_fault_cpu; \
+		SET_CYCLES(m68ki_fault_cycles); \
+	}
+
+/* The same, leaving m68k_execute() if the fault stopped the CPU or used up
+ * the timeslice
+ */
+#define m68ki_unwind_fault() \
+	if(CPU_FAULT_PENDING) \
+	{ \
+		m68ki_rollback_fault(); \
+		m68ki_exit_after_fault(); \
+	}
+#else
+#define m68ki_rollback_fault()
+#define m68ki_unwind_fault()
+#endif /* M68K_PENDING_FAULTS */
+
+
+/* ----------------------------- Mapped Memory ---------------------------- */
+
+#if M68K_MEMORY_MAP
+/* Host address of the SIZE bytes at ADDRESS, or NULL if PAGES doesn't map
+ * them all (see m68k_map_memory())
+ */
+static inline uint8_t* m68ki_map_find(uint8_t* const* pages, unsigned address, unsigned size)
+{
+	uint8_t* page = pages[address >> M68K_MEMORY_MAP_PAGE_SHIFT];
+	unsigned offset = address & (M68KI_MAP_PAGE_SIZE - 1);
+
+	return page && offset <= M68KI_MAP_PAGE_SIZE - size ? page + offset : NULL;
+}
+
+#if M68KI_MAP_REGIONS
+/* The device with the SIZE bytes at ADDRESS, or NULL if the callbacks handle
+ * them (see m68k_map_region())
+ */
+static inline const m68k_region* m68ki_region_find(unsigned address, unsigned size)
+{
+	const m68k_region* region = m68ki_map_regions[address >> M68K_MEMORY_MAP_PAGE_SHIFT];
+
+	return region && (address & (M68KI_MAP_PAGE_SIZE - 1)) <= M68KI_MAP_PAGE_SIZE - size ? region : NULL;
+}
+
+/* Nonzero if any of the SIZE bytes at ADDRESS belong to a device */
+static inline int m68ki_region_any(unsigned address, unsigned size)
+{
+	unsigned page = address >> M68K_MEMORY_MAP_PAGE_SHIFT;
+	unsigned last = ADDRESS_68K(address + size - 1) >> M68K_MEMORY_MAP_PAGE_SHIFT;
+
+	do
+		if(m68ki_map_regions[page])
+			return 1;
+	while(page++ < last);
+	return 0;
+}
+#endif /* M68KI_MAP_REGIONS */
+
+#if M68KI_MAP_SWAPPED
+/* Mapped memory holds host-endian words, so the 68k's byte N is at N ^ 1 */
+static inline unsigned m68ki_map_get_8(const uint8_t* host)
+{
+	return *(const uint8_t*)((uintptr_t)host ^ 1);
+}
+static inline void m68ki_map_put_8(uint8_t* host, unsigned value)
+{
+	*(uint8_t*)((uintptr_t)host ^ 1) = value;
+}
+static inline unsigned m68ki_map_get_16(const uint8_t* host)
+{
+	uint16_t word;
+
+	if((uintptr_t)host & 1)
+		return (m68ki_map_get_8(host) << 8) | m68ki_map_get_8(host + 1);
+	memcpy(&word, host, 2);
+	return word;
+}
+static inline unsigned m68ki_map_get_32(const uint8_t* host)
+{
+	return (m68ki_map_get_16(host) << 16) | m68ki_map_get_16(host + 2);
+}
+static inline void m68ki_map_put_16(uint8_t* host, unsigned value)
+{
+	uint16_t word = value;
+
+	if((uintptr_t)host & 1)
+	{
+		m68ki_map_put_8(host, value >> 8);
+		m68ki_map_put_8(host + 1, value);
+	}
+	else
+		memcpy(host, &word, 2);
+}
+static inline void m68ki_map_put_32(uint8_t* host, unsigned value)
+{
+	m68ki_map_put_16(host, value >> 16);
+	m68ki_map_put_16(host + 2, value);
+}
+#else
+/* Mapped memory is big-endian */
+static inline unsigned m68ki_map_get_8(const uint8_t* host)
+{
+	return *host;
+}
+static inline void m68ki_map_put_8(uint8_t* host, unsigned value)
+{
+	*host = value;
+}
+static inline unsigned m68ki_map_get_16(const uint8_t* host)
+{
+	return (host[0] << 8) | host[1];
+}
+static inline unsigned m68ki_map_get_32(const uint8_t* host)
+{
+	return ((unsigned)host[0] << 24) | (host[1] << 16) | (host[2] << 8) | host[3];
+}
+static inline void m68ki_map_put_16(uint8_t* host, unsigned value)
+{
+	host[0] = value >> 8;
+	host[1] = value;
+}
+static inline void m68ki_map_put_32(uint8_t* host, unsigned value)
+{
+	host[0] = value >> 24;
+	host[1] = value >> 16;
+	host[2] = value >> 8;
+	host[3] = value;
+}
+#endif /* M68KI_MAP_SWAPPED */
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_CODE_PAGE
+/* Fetch the instruction stream straight from the code page while ADDRESS is
+ * in it, and look the page up again when it isn't
+ */
+static inline unsigned m68ki_fetch_16(unsigned address)
+{
+	unsigned offset = address - m68ki_code_page_start;
+
+	if(offset < m68ki_code_page_limit)
+		return m68ki_map_get_16(m68ki_code_page + offset);
+	m68ki_code_page_refresh(address);
+	return m68k_read_immediate_16(address);
+}
+static inline unsigned m68ki_fetch_32(unsigned address)
+{
+	unsigned offset = address - m68ki_code_page_start;
+
+	if(offset < m68ki_code_page_limit && offset + 2 < m68ki_code_page_limit)
+		return m68ki_map_get_32(m68ki_code_page + offset);
+	m68ki_code_page_refresh(address);
+	return m68k_read_immediate_32(address);
+}
+#endif /* M68KI_CODE_PAGE */
+
+
 /* ---------------------------- Read Immediate ---------------------------- */
 
 extern unsigned pmmu_translate_addr(unsigned addr_in);
+extern unsigned m68ki_pmmu_walk(unsigned addr_in, unsigned fc, unsigned mode, unsigned size, unsigned* write);
+
+/* Which root pointer translates an access with function code FC: 1 for the
+ * SRP, 0 for the 68030's CRP or the 68040's URP
+ */
+static inline unsigned m68ki_pmmu_root(unsigned fc)
+{
+	return (fc & 4) && (CPU_TYPE_IS_040_PLUS(CPU_TYPE) || (m68ki_cpu.mmu_tc & 0x02000000));
+}
+
+/* Nonzero if the transparent translation register TT matches an access to
+ * ADDRESS with function code FC for MODE (MODE_READ or MODE_WRITE)
+ */
+static inline int m68ki_pmmu_tt_match(unsigned tt, unsigned address, unsigned fc, unsigned mode)
+{
+	return (tt & 0x8000) &&
+		!(((address >> 24) ^ (tt >> 24)) & ~(tt >> 16) & 0xff) &&
+		!((fc ^ (tt >> 4)) & ~tt & 7) &&
+		((tt & 0x100) || !(tt & 0x200) == (mode == MODE_WRITE));
+}
+
+/* The same for a 68040 ITTn/DTTn register, which matches on the S bit of FC
+ * rather than the whole function code
+ */
+static inline int m68ki_pmmu_tt_match_040(unsigned tt, unsigned address, unsigned fc)
+{
+	return (tt & 0x8000) &&
+		!(((address >> 24) ^ (tt >> 24)) & ~(tt >> 16) & 0xff) &&
+		((tt & 0x4000) || !(fc & 4) == !(tt & 0x2000));
+}
+
+/* Nonzero if the access falls in a transparent translation window (TT0/TT1
+ * on the 68030, ITT0/ITT1 or DTT0/DTT1 on the 68040), so the PMMU leaves its
+ * address alone without looking in the ATC or the tables
+ */
+static inline int m68ki_pmmu_transparent(unsigned address, unsigned fc, unsigned mode)
+{
+	if(CPU_TYPE_IS_040_PLUS(CPU_TYPE))
+	{
+		int program = (fc & 3) == FUNCTION_CODE_USER_PROGRAM;
+		unsigned tt0 = program ? m68ki_cpu.mmu_itt0 : m68ki_cpu.mmu_dtt0;
+		unsigned tt1 = program ? m68ki_cpu.mmu_itt1 : m68ki_cpu.mmu_dtt1;
+
+		return ((tt0 | tt1) & 0x8000) &&
+			(m68ki_pmmu_tt_match_040(tt0, address, fc) || m68ki_pmmu_tt_match_040(tt1, address, fc));
+	}
+	return ((m68ki_cpu.mmu_tt0 | m68ki_cpu.mmu_tt1) & 0x8000) &&
+		(m68ki_pmmu_tt_match(m68ki_cpu.mmu_tt0, address, fc, mode) ||
+		 m68ki_pmmu_tt_match(m68ki_cpu.mmu_tt1, address, fc, mode));
+}
+
+#if M68K_PMMU_ATC
+/* The ATC entry for PAGE of ROOT's tables.  Instruction fetches and data
+ * accesses have a half of the ATC each, like the 68040's two ATCs.
+ */
+static inline m68ki_atc_entry* m68ki_atc_slot(unsigned page, unsigned root, unsigned fc)
+{
+	unsigned half = (fc & 3) == FUNCTION_CODE_USER_PROGRAM ? M68K_PMMU_ATC_SIZE : 0;
+
+	return &m68ki_atc[half + ((page ^ root) & (M68K_PMMU_ATC_SIZE - 1))];
+}
+
+/* Translate ADDRESS with the ATC, or walk the tables if it isn't there */
+static inline unsigned m68ki_atc_translate(unsigned address, unsigned fc, unsigned mode, unsigned size)
+{
+	unsigned root = m68ki_pmmu_root(fc);
+	unsigned page = address >> m68ki_atc_shift;
+	const m68ki_atc_entry* entry = m68ki_atc_slot(page, root, fc);
+
+	if(entry->page == page && entry->root == root && (mode != MODE_WRITE || entry->write))
+	{
+		m68ki_atc_hits++;
+		return address + entry->delta;
+	}
+	return m68ki_atc_load(address, root, fc, mode, size);
+}
+#endif /* M68K_PMMU_ATC */
+
+#if M68KI_ATC_HOST
+/* Translate *ADDRESS with the ATC, and return where the SIZE bytes there are
+ * in mapped memory for reading (WRITE 0) or writing (WRITE 1), or NULL if
+ * they aren't or the ATC missed
+ */
+static inline uint8_t* m68ki_atc_translate_host(unsigned* address, unsigned fc, unsigned size, int write)
+{
+	unsigned root = m68ki_pmmu_root(fc);
+	unsigned page = *address >> m68ki_atc_shift;
+	const m68ki_atc_entry* entry = m68ki_atc_slot(page, root, fc);
+
+	if(entry->page == page && entry->root == root && (!write || entry->write))
+	{
+		unsigned offset = *address - (page << m68ki_atc_shift);
+
+		m68ki_atc_hits++;
+		*address += entry->delta;
+		if(entry->host[write] && offset + size <= 1u << m68ki_atc_shift)
+			return entry->host[write] + offset;
+		return NULL;
+	}
+	*address = m68ki_atc_load(*address, root, fc, write ? MODE_WRITE : MODE_READ, size);
+	return NULL;
+}
+#endif /* M68KI_ATC_HOST */
 
 /* Handles all immediate reads, does address error check, function code setting,
  * and prefetching if they are enabled in m68kconf.h
  */
 static inline unsigned m68ki_read_imm_16(void)
 {
+#if M68K_BLOCK_CACHE
+	/* Replaying a cached block, take the word from the block cache */
+	if(REG_PC - m68ki_block_cache_fetch_pc < m68ki_block_cache_fetch_length)
+	{
+		REG_PC += 2;
+		return m68ki_block_cache_fetch_words[(REG_PC - 2 - m68ki_block_cache_fetch_pc) >> 1];
+	}
+#endif /* M68K_BLOCK_CACHE */
+
 	m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
 	m68ki_check_address_error(REG_PC, MODE_READ, FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
 
 #if M68K_SEPARATE_READS
 #if M68K_EMULATE_PMMU
 	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
+	    address = m68ki_pmmu_translate(address, FLAG_S | FUNCTION_CODE_USER_PROGRAM, MODE_READ, 2);
 #endif
 #endif
 
@@ -995,17 +2026,20 @@ static inline unsigned m68ki_read_imm_16(void)
 	if(REG_PC != CPU_PREF_ADDR)
 	{
 		CPU_PREF_ADDR = REG_PC;
-		CPU_PREF_DATA = m68k_read_immediate_16(ADDRESS_68K(CPU_PREF_ADDR));
+		CPU_PREF_DATA = m68ki_fetch_16(ADDRESS_68K(CPU_PREF_ADDR));
 	}
 	result = MASK_OUT_ABOVE_16(CPU_PREF_DATA);
 	REG_PC += 2;
 	CPU_PREF_ADDR = REG_PC;
-	CPU_PREF_DATA = m68k_read_immediate_16(ADDRESS_68K(CPU_PREF_ADDR));
+	CPU_PREF_DATA = m68ki_fetch_16(ADDRESS_68K(CPU_PREF_ADDR));
 	return result;
 }
 #else
 	REG_PC += 2;
-	return m68k_read_immediate_16(ADDRESS_68K(REG_PC-2));
+#if M68K_BLOCK_CACHE
+	m68ki_block_cache_fetch_end = REG_PC;
+#endif /* M68K_BLOCK_CACHE */
+	return m68ki_fetch_16(ADDRESS_68K(REG_PC-2));
 #endif /* M68K_EMULATE_PREFETCH */
 }
 
@@ -1017,10 +2051,18 @@ static inline unsigned m68ki_read_imm_8(void)
 
 static inline unsigned m68ki_read_imm_32(void)
 {
+#if M68K_BLOCK_CACHE
+	if(REG_PC - m68ki_block_cache_fetch_pc < m68ki_block_cache_fetch_length)
+	{
+		unsigned high = m68ki_read_imm_16();
+		return (high << 16) | m68ki_read_imm_16();
+	}
+#endif /* M68K_BLOCK_CACHE */
+
 #if M68K_SEPARATE_READS
 #if M68K_EMULATE_PMMU
 	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
+	    address = m68ki_pmmu_translate(address, FLAG_S | FUNCTION_CODE_USER_PROGRAM, MODE_READ, 4);
 #endif
 #endif
 
@@ -1029,28 +2071,33 @@ static inline unsigned m68ki_read_imm_32(void)
 
 	m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
 	m68ki_check_address_error(REG_PC, MODE_READ, FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
 
 	if(REG_PC != CPU_PREF_ADDR)
 	{
 		CPU_PREF_ADDR = REG_PC;
-		CPU_PREF_DATA = m68k_read_immediate_16(ADDRESS_68K(CPU_PREF_ADDR));
+		CPU_PREF_DATA = m68ki_fetch_16(ADDRESS_68K(CPU_PREF_ADDR));
 	}
 	temp_val = MASK_OUT_ABOVE_16(CPU_PREF_DATA);
 	REG_PC += 2;
 	CPU_PREF_ADDR = REG_PC;
-	CPU_PREF_DATA = m68k_read_immediate_16(ADDRESS_68K(CPU_PREF_ADDR));
+	CPU_PREF_DATA = m68ki_fetch_16(ADDRESS_68K(CPU_PREF_ADDR));
 
 	temp_val = MASK_OUT_ABOVE_32((temp_val << 16) | MASK_OUT_ABOVE_16(CPU_PREF_DATA));
 	REG_PC += 2;
 	CPU_PREF_ADDR = REG_PC;
-	CPU_PREF_DATA = m68k_read_immediate_16(ADDRESS_68K(CPU_PREF_ADDR));
+	CPU_PREF_DATA = m68ki_fetch_16(ADDRESS_68K(CPU_PREF_ADDR));
 
 	return temp_val;
 #else
 	m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
 	m68ki_check_address_error(REG_PC, MODE_READ, FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
 	REG_PC += 4;
-	return m68k_read_immediate_32(ADDRESS_68K(REG_PC-4));
+#if M68K_BLOCK_CACHE
+	m68ki_block_cache_fetch_end = REG_PC;
+#endif /* M68K_BLOCK_CACHE */
+	return m68ki_fetch_32(ADDRESS_68K(REG_PC-4));
 #endif /* M68K_EMULATE_PREFETCH */
 }
 
@@ -1066,95 +2113,599 @@ static inline unsigned m68ki_read_8_fc(unsigned address, unsigned fc)
 {
 	(void)fc;
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
 
 #if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_READ))
+	{
+#if M68KI_ATC_HOST
+		const uint8_t* host = m68ki_atc_translate_host(&address, fc, 1, 0);
+		if(host)
+			return m68ki_map_get_8(host);
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_READ, 1);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
 #endif
 
-	return m68k_read_memory_8(ADDRESS_68K(address));
+#if M68K_MEMORY_MAP
+	{
+		const uint8_t* host = m68ki_map_find(m68ki_map_read_pages, ADDRESS_68K(address), 1);
+		if(host)
+			return m68ki_map_get_8(host);
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 1);
+		if(region && region->read_8)
+			return region->read_8(region->device, ADDRESS_68K(address));
+	}
+#endif /* M68KI_MAP_REGIONS */
+
+	return m68ki_host_read_8(ADDRESS_68K(address), fc);
 }
 static inline unsigned m68ki_read_16_fc(unsigned address, unsigned fc)
 {
 	(void)fc;
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
 	m68ki_check_address_error_010_less(address, MODE_READ, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
 
 #if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_READ))
+	{
+#if M68KI_ATC_HOST
+		const uint8_t* host = m68ki_atc_translate_host(&address, fc, 2, 0);
+		if(host)
+			return m68ki_map_get_16(host);
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_READ, 2);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
 #endif
 
-	return m68k_read_memory_16(ADDRESS_68K(address));
+#if M68K_MEMORY_MAP
+	{
+		const uint8_t* host = m68ki_map_find(m68ki_map_read_pages, ADDRESS_68K(address), 2);
+		if(host)
+			return m68ki_map_get_16(host);
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 2);
+		if(region && region->read_16)
+			return region->read_16(region->device, ADDRESS_68K(address));
+	}
+#endif /* M68KI_MAP_REGIONS */
+
+	return m68ki_host_read_16(ADDRESS_68K(address), fc);
 }
 static inline unsigned m68ki_read_32_fc(unsigned address, unsigned fc)
 {
 	(void)fc;
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
-	m68ki_check_address_error_010_less(address, MODE_READ, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_check_address_error_010_less(address, MODE_READ, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_EMULATE_PMMU
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_READ))
+	{
+#if M68KI_ATC_HOST
+		const uint8_t* host = m68ki_atc_translate_host(&address, fc, 4, 0);
+		if(host)
+			return m68ki_map_get_32(host);
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_READ, 4);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
+#endif
+
+#if M68K_MEMORY_MAP
+	{
+		const uint8_t* host = m68ki_map_find(m68ki_map_read_pages, ADDRESS_68K(address), 4);
+		if(host)
+			return m68ki_map_get_32(host);
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 4);
+		if(region && region->read_32)
+			return region->read_32(region->device, ADDRESS_68K(address));
+	}
+#endif /* M68KI_MAP_REGIONS */
+
+	return m68ki_host_read_32(ADDRESS_68K(address), fc);
+}
+
+#if M68K_BLOCK_CACHE
+/* Invalidate any cached code covered by a write of SIZE bytes at ADDRESS */
+static inline void m68ki_block_cache_write(unsigned address, unsigned size)
+{
+	unsigned first = address >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+	unsigned last = ADDRESS_68K(address + size - 1) >> M68K_BLOCK_CACHE_PAGE_SHIFT;
+
+	if(m68ki_block_cache_is_code(first))
+		m68ki_block_cache_invalidate(first, address, size);
+	if(last != first && m68ki_block_cache_is_code(last))
+		m68ki_block_cache_invalidate(last, address, size);
+}
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_DIRTY_PAGES
+/* Mark the pages covered by a write of SIZE bytes at ADDRESS as dirty */
+static inline void m68ki_dirty_write(unsigned address, unsigned size)
+{
+	unsigned page = address >> M68K_DIRTY_PAGE_SHIFT;
+	unsigned last = ADDRESS_68K(address + size - 1) >> M68K_DIRTY_PAGE_SHIFT;
+
+	do
+		m68ki_dirty_pages[page >> 6] |= (uint64_t)1 << (page & 63);
+	while(++page < last);
+	m68ki_dirty_pages[last >> 6] |= (uint64_t)1 << (last & 63);
+}
+#endif /* M68K_DIRTY_PAGES */
+
+#if M68K_STATIC_CODE
+/* Writing to recompiled code sends it back to the interpreter */
+static inline void m68ki_static_code_write(unsigned address, unsigned size)
+{
+	if(address - m68ki_static_code_start < m68ki_static_code_size ||
+		address + size - 1 - m68ki_static_code_start < m68ki_static_code_size)
+		m68ki_static_code_size = 0;
+}
+#endif /* M68K_STATIC_CODE */
+
+static inline void m68ki_write_8_fc(unsigned address, unsigned fc, unsigned value)
+{
+	(void)fc;
+	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_EMULATE_PMMU
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_WRITE))
+	{
+#if M68KI_ATC_HOST
+		uint8_t* host = m68ki_atc_translate_host(&address, fc, 1, 1);
+		if(host)
+		{
+			m68ki_block_cache_write(ADDRESS_68K(address), 1); /* auto-disable (see m68kcpu.h) */
+			m68ki_static_code_write(ADDRESS_68K(address), 1); /* auto-disable (see m68kcpu.h) */
+			m68ki_dirty_write(ADDRESS_68K(address), 1); /* auto-disable (see m68kcpu.h) */
+			m68ki_map_put_8(host, value);
+			return;
+		}
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_WRITE, 1);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
+#endif
+
+	m68ki_block_cache_write(ADDRESS_68K(address), 1); /* auto-disable (see m68kcpu.h) */
+	m68ki_static_code_write(ADDRESS_68K(address), 1); /* auto-disable (see m68kcpu.h) */
+	m68ki_dirty_write(ADDRESS_68K(address), 1); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_MEMORY_MAP
+	{
+		uint8_t* host = m68ki_map_find(m68ki_map_write_pages, ADDRESS_68K(address), 1);
+		if(host)
+		{
+			m68ki_map_put_8(host, value);
+			return;
+		}
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 1);
+		if(region && region->write_8)
+		{
+			region->write_8(region->device, ADDRESS_68K(address), value);
+			return;
+		}
+	}
+#endif /* M68KI_MAP_REGIONS */
+
+	m68ki_host_write_8(ADDRESS_68K(address), fc, value);
+}
+static inline void m68ki_write_16_fc(unsigned address, unsigned fc, unsigned value)
+{
+	(void)fc;
+	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_check_address_error_010_less(address, MODE_WRITE, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_EMULATE_PMMU
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_WRITE))
+	{
+#if M68KI_ATC_HOST
+		uint8_t* host = m68ki_atc_translate_host(&address, fc, 2, 1);
+		if(host)
+		{
+			m68ki_block_cache_write(ADDRESS_68K(address), 2); /* auto-disable (see m68kcpu.h) */
+			m68ki_static_code_write(ADDRESS_68K(address), 2); /* auto-disable (see m68kcpu.h) */
+			m68ki_dirty_write(ADDRESS_68K(address), 2); /* auto-disable (see m68kcpu.h) */
+			m68ki_map_put_16(host, value);
+			return;
+		}
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_WRITE, 2);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
+#endif
+
+	m68ki_block_cache_write(ADDRESS_68K(address), 2); /* auto-disable (see m68kcpu.h) */
+	m68ki_static_code_write(ADDRESS_68K(address), 2); /* auto-disable (see m68kcpu.h) */
+	m68ki_dirty_write(ADDRESS_68K(address), 2); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_MEMORY_MAP
+	{
+		uint8_t* host = m68ki_map_find(m68ki_map_write_pages, ADDRESS_68K(address), 2);
+		if(host)
+		{
+			m68ki_map_put_16(host, value);
+			return;
+		}
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 2);
+		if(region && region->write_16)
+		{
+			region->write_16(region->device, ADDRESS_68K(address), value);
+			return;
+		}
+	}
+#endif /* M68KI_MAP_REGIONS */
+
+	m68ki_host_write_16(ADDRESS_68K(address), fc, value);
+}
+static inline void m68ki_write_32_fc(unsigned address, unsigned fc, unsigned value)
+{
+	(void)fc;
+	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_check_address_error_010_less(address, MODE_WRITE, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
 
 #if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_WRITE))
+	{
+#if M68KI_ATC_HOST
+		uint8_t* host = m68ki_atc_translate_host(&address, fc, 4, 1);
+		if(host)
+		{
+			m68ki_block_cache_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+			m68ki_static_code_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+			m68ki_dirty_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+			m68ki_map_put_32(host, value);
+			return;
+		}
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_WRITE, 4);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
 #endif
 
-	return m68k_read_memory_32(ADDRESS_68K(address));
-}
+	m68ki_block_cache_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+	m68ki_static_code_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+	m68ki_dirty_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
 
-static inline void m68ki_write_8_fc(unsigned address, unsigned fc, unsigned value)
-{
-	(void)fc;
-	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+#if M68K_MEMORY_MAP
+	{
+		uint8_t* host = m68ki_map_find(m68ki_map_write_pages, ADDRESS_68K(address), 4);
+		if(host)
+		{
+			m68ki_map_put_32(host, value);
+			return;
+		}
+	}
+#endif /* M68K_MEMORY_MAP */
 
-#if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
-#endif
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 4);
+		if(region && region->write_32)
+		{
+			region->write_32(region->device, ADDRESS_68K(address), value);
+			return;
+		}
+	}
+#endif /* M68KI_MAP_REGIONS */
 
-	m68k_write_memory_8(ADDRESS_68K(address), value);
+	m68ki_host_write_32(ADDRESS_68K(address), fc, value);
 }
-static inline void m68ki_write_16_fc(unsigned address, unsigned fc, unsigned value)
+
+#if M68K_SIMULATE_PD_WRITES
+static inline void m68ki_write_32_pd_fc(unsigned address, unsigned fc, unsigned value)
 {
 	(void)fc;
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
 	m68ki_check_address_error_010_less(address, MODE_WRITE, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
 
 #if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
+	if (PMMU_ENABLED && !m68ki_pmmu_transparent(address, fc, MODE_WRITE))
+	{
+#if M68KI_ATC_HOST
+		uint8_t* host = m68ki_atc_translate_host(&address, fc, 4, 1);
+		if(host)
+		{
+			m68ki_block_cache_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+			m68ki_static_code_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+			m68ki_dirty_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+			m68ki_map_put_32(host, value);
+			return;
+		}
+#else
+		address = m68ki_pmmu_translate(address, fc, MODE_WRITE, 4);
+#endif /* M68KI_ATC_HOST */
+		m68ki_skip_write_if_faulted(); /* auto-disable (see m68kcpu.h) */
+	}
 #endif
 
-	m68k_write_memory_16(ADDRESS_68K(address), value);
+	m68ki_block_cache_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+	m68ki_static_code_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+	m68ki_dirty_write(ADDRESS_68K(address), 4); /* auto-disable (see m68kcpu.h) */
+
+#if M68K_MEMORY_MAP
+	{
+		uint8_t* host = m68ki_map_find(m68ki_map_write_pages, ADDRESS_68K(address), 4);
+		if(host)
+		{
+			m68ki_map_put_32(host, value);
+			return;
+		}
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	{
+		const m68k_region* region = m68ki_region_find(ADDRESS_68K(address), 4);
+		if(region && region->write_32)
+		{
+			region->write_32(region->device, ADDRESS_68K(address), value);
+			return;
+		}
+	}
+#endif /* M68KI_MAP_REGIONS */
+
+	m68ki_host_write_32_pd(ADDRESS_68K(address), fc, value);
 }
-static inline void m68ki_write_32_fc(unsigned address, unsigned fc, unsigned value)
+#endif
+
+/* Transfer COUNT values of SIZE (2 or 4) bytes at consecutive addresses from
+ * ADDRESS with one access to mapped memory or one block callback, for MOVEM,
+ * MOVE16 and FMOVEM.  VALUES are in ascending address order.
+ * Returns 0 if the caller has to transfer them one at a time instead: with
+ * an odd address (which may be an address error), a span that wraps around
+ * the address bus, the PMMU on, a fault pending, a device in the way (see
+ * m68k_map_region()), or nothing mapped without M68K_BULK_TRANSFERS.
+ */
+static inline int m68ki_read_block_fc(unsigned address, unsigned fc, unsigned size, unsigned count, unsigned* values)
 {
+#if M68KI_BLOCK_TRANSFERS
+	if((address & 1) || PMMU_ENABLED || m68ki_fault_pending())
+		return 0;
+	if(!count)
+		return 1;
+
 	(void)fc;
+	address = ADDRESS_68K(address);
+	if(ADDRESS_68K(address + size * count - 1) < address)
+		return 0;
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
-	m68ki_check_address_error_010_less(address, MODE_WRITE, fc); /* auto-disable (see m68kcpu.h) */
 
-#if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
-#endif
+#if M68K_MEMORY_MAP
+	{
+		const uint8_t* host = m68ki_map_find(m68ki_map_read_pages, address, size * count);
+		if(host)
+		{
+			for(; count; count--, host += size)
+				*values++ = size == 2 ? m68ki_map_get_16(host) : m68ki_map_get_32(host);
+			return 1;
+		}
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	/* Devices see the values one at a time */
+	if(m68ki_region_any(address, size * count))
+		return 0;
+#endif /* M68KI_MAP_REGIONS */
 
-	m68k_write_memory_32(ADDRESS_68K(address), value);
+#if M68K_BULK_TRANSFERS
+	m68ki_host_read_block(address, fc, size, count, values);
+	return 1;
+#endif /* M68K_BULK_TRANSFERS */
+#endif /* M68KI_BLOCK_TRANSFERS */
+
+	(void)address;
+	(void)fc;
+	(void)size;
+	(void)count;
+	(void)values;
+	return 0;
 }
 
-#if M68K_SIMULATE_PD_WRITES
-static inline void m68ki_write_32_pd_fc(unsigned address, unsigned fc, unsigned value)
+static inline int m68ki_write_block_fc(unsigned address, unsigned fc, unsigned size, unsigned count, const unsigned* values)
 {
+#if M68KI_BLOCK_TRANSFERS
+	if((address & 1) || PMMU_ENABLED || m68ki_fault_pending())
+		return 0;
+	if(!count)
+		return 1;
+
 	(void)fc;
+	address = ADDRESS_68K(address);
+	if(ADDRESS_68K(address + size * count - 1) < address)
+		return 0;
+
+#if M68K_MEMORY_MAP
+	{
+		uint8_t* host = m68ki_map_find(m68ki_map_write_pages, address, size * count);
+		if(host)
+		{
+			m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+			m68ki_block_cache_write(address, size * count); /* auto-disable (see m68kcpu.h) */
+			m68ki_static_code_write(address, size * count); /* auto-disable (see m68kcpu.h) */
+			m68ki_dirty_write(address, size * count); /* auto-disable (see m68kcpu.h) */
+			for(; count; count--, host += size)
+			{
+				if(size == 2)
+					m68ki_map_put_16(host, *values++);
+				else
+					m68ki_map_put_32(host, *values++);
+			}
+			return 1;
+		}
+	}
+#endif /* M68K_MEMORY_MAP */
+
+#if M68KI_MAP_REGIONS
+	if(m68ki_region_any(address, size * count))
+		return 0;
+#endif /* M68KI_MAP_REGIONS */
+
+#if M68K_BULK_TRANSFERS
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
-	m68ki_check_address_error_010_less(address, MODE_WRITE, fc); /* auto-disable (see m68kcpu.h) */
+	m68ki_block_cache_write(address, size * count); /* auto-disable (see m68kcpu.h) */
+	m68ki_static_code_write(address, size * count); /* auto-disable (see m68kcpu.h) */
+	m68ki_dirty_write(address, size * count); /* auto-disable (see m68kcpu.h) */
+	m68ki_host_write_block(address, fc, size, count, values);
+	return 1;
+#endif /* M68K_BULK_TRANSFERS */
+#endif /* M68KI_BLOCK_TRANSFERS */
+
+	(void)address;
+	(void)fc;
+	(void)size;
+	(void)count;
+	(void)values;
+	return 0;
+}
 
-#if M68K_EMULATE_PMMU
-	if (PMMU_ENABLED)
-	    address = pmmu_translate_addr(address);
-#endif
+/* A read-modify-write of one operand (see m68k_rmw_memory_8()) */
+typedef struct
+{
+	unsigned op;      /* M68KI_RMW_* */
+	unsigned mask;    /* mask for the operand size */
+	unsigned operand;
+	unsigned compare; /* for M68KI_RMW_CAS */
+	unsigned value;   /* value read */
+	int      written; /* whether the result was written back */
+} m68ki_rmw;
+
+/* Work out the value RMW writes back in place of *VALUE.
+ * Returns 0 if nothing is written back.
+ */
+static inline int m68ki_rmw_apply(m68ki_rmw* rmw, unsigned* value)
+{
+	unsigned res = rmw->value = *value & rmw->mask;
 
-	m68k_write_memory_32_pd(ADDRESS_68K(address), value);
+	switch(rmw->op)
+	{
+		case M68KI_RMW_ADD: res += rmw->operand; break;
+		case M68KI_RMW_SUB: res -= rmw->operand; break;
+		case M68KI_RMW_AND: res &= rmw->operand; break;
+		case M68KI_RMW_OR:  res |= rmw->operand; break;
+		case M68KI_RMW_EOR: res ^= rmw->operand; break;
+		case M68KI_RMW_NEG: res = 0 - res - rmw->operand; break;
+		case M68KI_RMW_TAS:
+			/* The Genesis/Megadrive games Gargoyles and Ex-Mutants need the TAS writeback
+			   disabled in order to function properly.  Some Amiga software may also rely
+			   on this, but only when accessing specific addresses so additional functionality
+			   will be needed. */
+			if(m68ki_fault_pending() || m68ki_tas_callback() != 1)
+				return 0;
+			res |= rmw->operand;
+			break;
+		case M68KI_RMW_CAS:
+			if(res != rmw->compare)
+				return 0;
+			res = rmw->operand;
+			break;
+	}
+	*value = res & rmw->mask;
+	return 1;
+}
+
+/* Read the SIZE (1, 2 or 4) byte operand at ADDRESS, write back the result
+ * of OP on it, and return the value read.
+ */
+static inline unsigned m68ki_rmw_fc(unsigned address, unsigned fc, unsigned size, unsigned op, unsigned operand, unsigned compare)
+{
+	m68ki_rmw rmw;
+	unsigned value;
+
+	rmw.op = op;
+	rmw.mask = size == 1 ? 0xff : size == 2 ? 0xffff : 0xffffffff;
+	rmw.operand = operand;
+	rmw.compare = compare;
+
+#if M68K_RMW_CALLBACKS
+	if(!PMMU_ENABLED
+#if M68K_MEMORY_MAP
+		&& !m68ki_map_find(m68ki_map_write_pages, ADDRESS_68K(address), size)
+#endif /* M68K_MEMORY_MAP */
+#if M68KI_MAP_REGIONS
+		&& !m68ki_region_any(ADDRESS_68K(address), size)
+#endif /* M68KI_MAP_REGIONS */
+	)
+	{
+		(void)fc;
+		m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
+		if(size != 1)
+		{
+			m68ki_check_address_error_010_less(address, MODE_READ, fc); /* auto-disable (see m68kcpu.h) */
+		}
+		m68ki_skip_read_if_faulted(); /* auto-disable (see m68kcpu.h) */
+
+		address = ADDRESS_68K(address);
+		rmw.value = 0;
+		rmw.written = 0;
+		if(size == 1)
+			m68ki_host_rmw_8(address, fc, m68ki_rmw_modify, &rmw);
+		else if(size == 2)
+			m68ki_host_rmw_16(address, fc, m68ki_rmw_modify, &rmw);
+		else
+			m68ki_host_rmw_32(address, fc, m68ki_rmw_modify, &rmw);
+
+		if(rmw.written && !m68ki_fault_pending())
+		{
+			m68ki_block_cache_write(address, size); /* auto-disable (see m68kcpu.h) */
+			m68ki_static_code_write(address, size); /* auto-disable (see m68kcpu.h) */
+			m68ki_dirty_write(address, size); /* auto-disable (see m68kcpu.h) */
+		}
+		return rmw.value;
+	}
+#endif /* M68K_RMW_CALLBACKS */
+
+	value = size == 1 ? m68ki_read_8_fc(address, fc) : size == 2 ? m68ki_read_16_fc(address, fc) : m68ki_read_32_fc(address, fc);
+	if(m68ki_rmw_apply(&rmw, &value))
+	{
+		if(size == 1)
+			m68ki_write_8_fc(address, fc, value);
+		else if(size == 2)
+			m68ki_write_16_fc(address, fc, value);
+		else
+			m68ki_write_32_fc(address, fc, value);
+	}
+	return rmw.value;
 }
-#endif
 
 /* --------------------- Effective Address Calculation -------------------- */
 
@@ -1345,24 +2896,28 @@ static inline unsigned OPER_PCIX_32(void)  {unsigned ea = EA_PCIX_32();  return
 /* Push/pull data from the stack */
 static inline void m68ki_push_16(unsigned value)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP - 2);
 	m68ki_write_16(REG_SP, value);
 }
 
 static inline void m68ki_push_32(unsigned value)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP - 4);
 	m68ki_write_32(REG_SP, value);
 }
 
 static inline unsigned m68ki_pull_16(void)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP + 2);
 	return m68ki_read_16(REG_SP-2);
 }
 
 static inline unsigned m68ki_pull_32(void)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP + 4);
 	return m68ki_read_32(REG_SP-4);
 }
@@ -1373,21 +2928,25 @@ static inline unsigned m68ki_pull_32(void)
  */
 static inline void m68ki_fake_push_16(void)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP - 2);
 }
 
 static inline void m68ki_fake_push_32(void)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP - 4);
 }
 
 static inline void m68ki_fake_pull_16(void)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP + 2);
 }
 
 static inline void m68ki_fake_pull_32(void)
 {
+	m68ki_save_da(15);
 	REG_SP = MASK_OUT_ABOVE_32(REG_SP + 4);
 }
 
@@ -1396,19 +2955,25 @@ static inline void m68ki_fake_pull_32(void)
 
 /* Jump to a new program location or vector.
  * These functions will also call the pc_changed callback if it was enabled
- * in m68kconf.h.
+ * in m68kconf.h (but not for the rest of an instruction that faulted).
  */
 static inline void m68ki_jump(unsigned new_pc)
 {
 	REG_PC = new_pc;
-	m68ki_pc_changed(REG_PC);
+	if(!m68ki_fault_pending())
+	{
+		m68ki_pc_changed(REG_PC);
+	}
 }
 
 static inline void m68ki_jump_vector(unsigned vector)
 {
 	REG_PC = (vector<<2) + REG_VBR;
 	REG_PC = m68ki_read_data_32(REG_PC);
-	m68ki_pc_changed(REG_PC);
+	if(!m68ki_fault_pending())
+	{
+		m68ki_pc_changed(REG_PC);
+	}
 }
 
 
@@ -1430,7 +2995,10 @@ static inline void m68ki_branch_16(unsigned offset)
 static inline void m68ki_branch_32(unsigned offset)
 {
 	REG_PC += offset;
-	m68ki_pc_changed(REG_PC);
+	if(!m68ki_fault_pending())
+	{
+		m68ki_pc_changed(REG_PC);
+	}
 }
 
 /* ---------------------------- Status Register --------------------------- */
@@ -1441,6 +3009,7 @@ static inline void m68ki_branch_32(unsigned offset)
 static inline void m68ki_set_s_flag(unsigned value)
 {
 	/* Backup the old stack pointer */
+	m68ki_save_da(15);
 	REG_SP_BASE[FLAG_S | ((FLAG_S>>1) & FLAG_M)] = REG_SP;
 	/* Set the S flag */
 	FLAG_S = value;
@@ -1454,6 +3023,7 @@ static inline void m68ki_set_s_flag(unsigned value)
 static inline void m68ki_set_sm_flag(unsigned value)
 {
 	/* Backup the old stack pointer */
+	m68ki_save_da(15);
 	REG_SP_BASE[FLAG_S | ((FLAG_S>>1) & FLAG_M)] = REG_SP;
 	/* Set the S and M flags */
 	FLAG_S = value & SFLAG_SET;
@@ -1479,6 +3049,9 @@ static inline void m68ki_set_ccr(unsigned value)
 	FLAG_Z = !BIT_2(value);
 	FLAG_V = BIT_1(value)  << 6;
 	FLAG_C = BIT_0(value)  << 8;
+#if M68K_LAZY_FLAGS
+	m68ki_cpu.lazy_op = M68KI_LAZY_NONE;
+#endif /* M68K_LAZY_FLAGS */
 }
 
 /* Set the status register but don't check for interrupts */
@@ -1649,6 +3222,53 @@ static inline void m68ki_stack_frame_1000(unsigned pc, unsigned sr, unsigned vec
 	m68ki_push_16(sr);
 }
 
+/* Format 7 stack frame (68040).
+ * This is the 30 word access error frame.  PC stacked is address of the
+ * instruction that faulted, which RTE restarts.  No writebacks are pending.
+ */
+static inline void m68ki_stack_frame_0111(unsigned sr, unsigned vector, unsigned pc, unsigned address, unsigned ssw)
+{
+	/* PUSH DATA LW 3, 2, 1 */
+	m68ki_push_32(0);
+	m68ki_push_32(0);
+	m68ki_push_32(0);
+
+	/* WRITEBACK 1 DATA (PUSH DATA LW 0), WRITEBACK 1 ADDRESS */
+	m68ki_push_32(0);
+	m68ki_push_32(0);
+
+	/* WRITEBACK 2 DATA, WRITEBACK 2 ADDRESS */
+	m68ki_push_32(0);
+	m68ki_push_32(0);
+
+	/* WRITEBACK 3 DATA, WRITEBACK 3 ADDRESS */
+	m68ki_push_32(0);
+	m68ki_push_32(0);
+
+	/* FAULT ADDRESS */
+	m68ki_push_32(address);
+
+	/* WRITEBACK 1, 2, 3 STATUS */
+	m68ki_push_16(0);
+	m68ki_push_16(0);
+	m68ki_push_16(0);
+
+	/* SPECIAL STATUS WORD */
+	m68ki_push_16(ssw);
+
+	/* EFFECTIVE ADDRESS */
+	m68ki_push_32(address);
+
+	/* 0111, VECTOR OFFSET */
+	m68ki_push_16(0x7000 | (vector<<2));
+
+	/* PROGRAM COUNTER */
+	m68ki_push_32(pc);
+
+	/* STATUS REGISTER */
+	m68ki_push_16(sr);
+}
+
 /* Format A stack frame (short bus fault).
  * This is used only by 68020 for bus fault and address error
  * if the error happens at an instruction boundary.
@@ -1844,24 +3464,27 @@ static inline void m68ki_exception_privilege_violation(void)
 	USE_CYCLES(CYC_EXCEPTION[EXCEPTION_PRIVILEGE_VIOLATION] - CYC_INSTRUCTION[REG_IR]);
 }
 
-extern jmp_buf m68ki_bus_error_jmp_buf;
-
-#define m68ki_check_bus_error_trap() setjmp(m68ki_bus_error_jmp_buf)
-
-/* Exception for bus error */
-static inline void m68ki_exception_bus_error(void)
+/* Start processing a bus error: returns 0 if there is no exception to take
+ * (the CPU halted, or the instruction already faulted), or 1 with *SR set
+ * to the status register to stack
+ */
+static inline int m68ki_init_bus_error(unsigned* sr)
 {
 	int i;
 
+	/* The instruction has already been cut short by a fault */
+	if(m68ki_fault_pending())
+		return 0;
+
 	/* If we were processing a bus error, address error, or reset,
 	 * this is a catastrophic failure.
 	 * Halt the CPU
 	 */
 	if(CPU_RUN_MODE == RUN_MODE_BERR_AERR_RESET)
 	{
-m68k_read_memory_8(0x00ffff01);
+m68ki_host_read_8(0x00ffff01, FLAG_S | FUNCTION_CODE_USER_DATA);
 		CPU_STOPPED = STOP_LEVEL_HALT;
-		return;
+		return 0;
 	}
 	CPU_RUN_MODE = RUN_MODE_BERR_AERR_RESET;
 
@@ -1869,14 +3492,41 @@ m68k_read_memory_8(0x00ffff01);
 	USE_CYCLES(CYC_EXCEPTION[EXCEPTION_BUS_ERROR] - CYC_INSTRUCTION[REG_IR]);
 
 	for (i = 15; i >= 0; i--){
-		REG_DA[i] = REG_DA_SAVE[i];
+		if(REG_DA_SAVE_MASK & (1 << i))
+			REG_DA[i] = REG_DA_SAVE[i];
 	}
+	REG_DA_SAVE_MASK = 0;
 
-	unsigned sr = m68ki_init_exception();
+	*sr = m68ki_init_exception();
+	return 1;
+}
+
+/* Exception for bus error */
+static inline void m68ki_exception_bus_error(void)
+{
+	unsigned sr;
+
+	if(!m68ki_init_bus_error(&sr))
+		return;
 	m68ki_stack_frame_1000(REG_PPC, sr, EXCEPTION_BUS_ERROR);
 
 	m68ki_jump_vector(EXCEPTION_BUS_ERROR);
-	longjmp(m68ki_bus_error_jmp_buf, 1);
+	m68ki_fault();
+}
+
+/* Exception for a 68040 access error at logical ADDRESS, described by the
+ * special status word SSW
+ */
+static inline void m68ki_exception_access_error_040(unsigned address, unsigned ssw)
+{
+	unsigned sr;
+
+	if(!m68ki_init_bus_error(&sr))
+		return;
+	m68ki_stack_frame_0111(sr, EXCEPTION_BUS_ERROR, REG_PPC, address, ssw);
+
+	m68ki_jump_vector(EXCEPTION_BUS_ERROR);
+	m68ki_fault();
 }
 
 extern int cpu_log_enabled;
@@ -1918,7 +3568,7 @@ static inline void m68ki_exception_1111(void)
 	USE_CYCLES(CYC_EXCEPTION[EXCEPTION_1111] - CYC_INSTRUCTION[REG_IR]);
 }
 
-#if M68K_ILLG_HAS_CALLBACK == OPT_SPECIFY_HANDLER
+#if M68K_ILLG_HAS_CALLBACK == OPT_SPECIFY_HANDLER && !M68K_USER_CONTEXT
 extern int m68ki_illg_callback(int);
 #endif
 
@@ -1930,7 +3580,7 @@ static inline void m68ki_exception_illegal(void)
 	M68K_DO_LOG((M68K_LOG_FILEHANDLE "%s at %08x: illegal instruction %04x (%s)\n",
 				 m68ki_cpu_names[CPU_TYPE], ADDRESS_68K(REG_PPC), REG_IR,
 				 m68ki_disassemble_quick(ADDRESS_68K(REG_PPC))));
-	if (m68ki_illg_callback(REG_IR))
+	if (!m68ki_fault_pending() && m68ki_illg_callback(REG_IR))
 	    return;
 
 	sr = m68ki_init_exception();
@@ -1971,7 +3621,7 @@ static inline void m68ki_exception_address_error(void)
 	 */
 	if(CPU_RUN_MODE == RUN_MODE_BERR_AERR_RESET)
 	{
-m68k_read_memory_8(0x00ffff01);
+m68ki_host_read_8(0x00ffff01, FLAG_S | FUNCTION_CODE_USER_DATA);
 		CPU_STOPPED = STOP_LEVEL_HALT;
 		return;
 	}
@@ -2066,6 +3716,10 @@ static inline void m68ki_exception_interrupt(unsigned int_level)
 /* ASG: Check for interrupts */
 static inline void m68ki_check_interrupts(void)
 {
+	/* Don't acknowledge anything for an instruction that faulted */
+	if(m68ki_fault_pending())
+		return;
+
 	if(m68ki_cpu.nmi_pending)
 	{
 		m68ki_cpu.nmi_pending = FALSE;
@@ -2076,6 +3730,254 @@ static inline void m68ki_check_interrupts(void)
 }
 
 
+#if M68K_THREADED_DISPATCH
+/* Start an instruction in m68ki_threaded_execute(), the same way the loop in
+ * m68k_execute() does.
+ */
+static M68KI_THREADED_INLINE void m68ki_threaded_fetch(void)
+{
+	m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+	m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+	m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+
+	REG_PPC = REG_PC;
+	m68ki_start_rollback();
+
+	REG_IR = m68ki_read_imm_16();
+}
+
+/* Finish the instruction m68ki_threaded_execute() just ran, and fetch the
+ * next one if there are clocks left.  Returns nonzero if the dispatcher
+ * should jump to the next handler.
+ */
+static M68KI_THREADED_INLINE int m68ki_threaded_next(void)
+{
+	USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+	/* Trace m68k_exception, if necessary */
+	m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+
+	/* Let m68k_execute() unwind a bus or address error */
+	if(m68ki_fault_pending() || GET_CYCLES() <= 0 || m68ki_threaded_leave())
+		return 0;
+
+	m68ki_threaded_fetch();
+	return 1;
+}
+#endif /* M68K_THREADED_DISPATCH */
+
+
+#if M68K_FUSED_OPCODES
+/* Called by a fused handler between its two instructions.  The block cache
+ * sets m68ki_fused_pc to the address of the second instruction before it
+ * calls the fused handler.  If the first instruction stepped on to it with
+ * clocks to spare, finish the first instruction the same way the block cache
+ * would, start the second, clear m68ki_fused_pc and return nonzero.
+ * Otherwise the first instruction is left for the block cache to finish.
+ */
+static inline int m68ki_fused_next(void)
+{
+	if(m68ki_fault_pending() || REG_PC != m68ki_fused_pc || GET_CYCLES() <= CYC_INSTRUCTION[REG_IR])
+		return 0;
+
+#if M68K_EMULATE_TRACE
+	/* Let the block cache take the trace exception */
+	if(m68ki_tracing)
+		return 0;
+#endif /* M68K_EMULATE_TRACE */
+
+	USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+	m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+	m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+
+	REG_PPC = REG_PC;
+	m68ki_start_rollback();
+
+	/* The opcode is in the block being replayed */
+	REG_IR = m68ki_block_cache_fetch_words[(REG_PC - m68ki_block_cache_fetch_pc) >> 1];
+	REG_PC += 2;
+	m68ki_fused_pc = 0;
+	return 1;
+}
+#endif /* M68K_FUSED_OPCODES */
+
+
+#if M68K_IDLE_SKIP
+/* Use up the clocks of count more times round an idle loop */
+static inline void m68ki_idle_skip(int count, int loop_cycles)
+{
+	USE_CYCLES(count * loop_cycles);
+	IDLE_CYCLES += count * loop_cycles;
+}
+
+/* Called by dbf when it has branched.  If it branched to itself, go round as
+ * many more times as the clocks left in the timeslice would have, stopping
+ * short of the counter running out.
+ */
+static inline void m68ki_idle_dbf(unsigned* r_dst)
+{
+	int loop_cycles = CYC_INSTRUCTION[REG_IR] + (int)CYC_DBCC_F_NOEXP;
+	int left = GET_CYCLES() - CYC_INSTRUCTION[REG_IR];
+	int count;
+
+	if(REG_PC != REG_PPC || m68ki_tracing || left <= 0 || loop_cycles <= 0)
+		return;
+
+	/* Every time round that starts before the clocks run out */
+	count = (left - 1) / loop_cycles + 1;
+	if(count > (int)MASK_OUT_ABOVE_16(*r_dst))
+		count = MASK_OUT_ABOVE_16(*r_dst);
+	*r_dst -= count;
+	m68ki_idle_skip(count, loop_cycles);
+}
+#endif /* M68K_IDLE_SKIP */
+
+
+/* MOVEM to memory: store the registers in LIST as SIZE (2 or 4) byte values
+ * from EA up, and return how many there were
+ */
+static inline unsigned m68ki_movem_store(unsigned list, unsigned ea, unsigned size)
+{
+	unsigned values[16];
+	unsigned count = 0;
+	unsigned i;
+
+	for(; list; list &= list - 1)
+		values[count++] = size == 2 ? MASK_OUT_ABOVE_16(REG_DA[m68ki_ctz(list)]) : REG_DA[m68ki_ctz(list)];
+
+	if(size == 2 ? m68ki_write_block_16(ea, count, values) : m68ki_write_block_32(ea, count, values))
+		return count;
+
+	for(i = 0; i < count; i++, ea += size)
+	{
+		if(size == 2)
+			m68ki_write_16(ea, values[i]);
+		else
+			m68ki_write_32(ea, values[i]);
+	}
+	return count;
+}
+
+/* MOVEM to -(An): bit i of LIST is register 15-i, and the registers are
+ * stored from EA down, highest first
+ */
+static inline unsigned m68ki_movem_store_pd(unsigned list, unsigned ea, unsigned size)
+{
+	unsigned values[16];
+	unsigned* first = values + 16;
+	unsigned* value = values + 16;
+	unsigned count;
+
+	for(; list; list &= list - 1)
+		*--first = size == 2 ? MASK_OUT_ABOVE_16(REG_DA[15 - m68ki_ctz(list)]) : REG_DA[15 - m68ki_ctz(list)];
+	count = (unsigned)(values + 16 - first);
+
+	if(size == 2 ? m68ki_write_block_16(ea - count * 2, count, first) : m68ki_write_block_32(ea - count * 4, count, first))
+		return count;
+
+	while(value > first)
+	{
+		ea -= size;
+		value--;
+		if(size == 2)
+			m68ki_write_16(ea, *value);
+		else
+		{
+			/* Low word first */
+			m68ki_write_16(ea + 2, *value & 0xffff);
+			m68ki_write_16(ea, *value >> 16);
+		}
+	}
+	return count;
+}
+
+/* MOVEM from memory: load the registers in LIST from SIZE (2 or 4) byte
+ * values from EA up, and return how many there were
+ */
+static inline unsigned m68ki_movem_load(unsigned list, unsigned ea, unsigned size)
+{
+	unsigned regs[16];
+	unsigned values[16];
+	unsigned count = 0;
+	unsigned i;
+
+	for(; list; list &= list - 1)
+		regs[count++] = m68ki_ctz(list);
+
+	if(size == 2 ? m68ki_read_block_16(ea, count, values) : m68ki_read_block_32(ea, count, values))
+	{
+		for(i = 0; i < count; i++)
+		{
+			m68ki_save_da(regs[i]);
+			REG_DA[regs[i]] = size == 2 ? (unsigned)MAKE_INT_16(MASK_OUT_ABOVE_16(values[i])) : values[i];
+		}
+		return count;
+	}
+
+	for(i = 0; i < count; i++, ea += size)
+	{
+		m68ki_save_da(regs[i]);
+		REG_DA[regs[i]] = size == 2 ? (unsigned)MAKE_INT_16(MASK_OUT_ABOVE_16(m68ki_read_16(ea))) : m68ki_read_32(ea);
+	}
+	return count;
+}
+
+
+#if M68K_STATIC_CODE
+/* The code m68krec generates runs each instruction as
+ *     if(!m68ki_static_start(pc, ir)) return;
+ *     <handler or inlined body>
+ *     if(!m68ki_static_end(ir, next_pc)) return;
+ * which does what the loop in m68k_execute() would.
+ */
+
+/* Get ready to run an instruction.  Returns 0 if the instruction hook moved
+ * the PC, in which case the instruction at the new PC has been run instead.
+ */
+static inline int m68ki_static_start(unsigned pc, unsigned ir)
+{
+	m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+	m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+	m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+
+	REG_PPC = REG_PC;
+	m68ki_start_rollback();
+
+#if M68K_INSTRUCTION_HOOK
+	if(REG_PC != pc)
+	{
+		REG_IR = m68ki_read_imm_16();
+		m68ki_instruction_jump_table[REG_IR]();
+		USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+		m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+		return 0;
+	}
+#endif /* M68K_INSTRUCTION_HOOK */
+
+	REG_IR = ir;
+	REG_PC = pc + 2;
+	return 1;
+}
+
+/* Finish an instruction.  Returns nonzero if it is OK to go on to the
+ * instruction at next_pc.
+ */
+static inline int m68ki_static_end(unsigned ir, unsigned next_pc)
+{
+	/* Let m68k_execute() unwind a bus or address error */
+	if(m68ki_fault_pending())
+		return 0;
+
+	USE_CYCLES(CYC_INSTRUCTION[ir]);
+
+	m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+
+	return REG_PC == next_pc && m68ki_static_code_size && GET_CYCLES() > 0;
+}
+#endif /* M68K_STATIC_CODE */
+
+
 
 /* ======================================================================== */
 /* ============================== END OF FILE ============================= */
@@ -298,6 +298,7 @@ static uint64_t READ_EA_64(int ea_)
 		case 3:		// (An)+
 		{
 			uint32_t ea = REG_A[reg];
+			m68ki_save_da(8 + reg);
 			REG_A[reg] += 8;
 			h1 = m68ki_read_32(ea+0);
 			h2 = m68ki_read_32(ea+4);
@@ -563,6 +564,7 @@ static void WRITE_EA_64(int ea_, uint64_t data)
 		case 4:		// -(An)
 		{
 			uint32_t ea;
+			m68ki_save_da(8 + reg);
 			REG_A[reg] -= 8;
 			ea = REG_A[reg];
 			m68ki_write_32(ea+0, (uint32_t)(data >> 32));
@@ -580,11 +582,14 @@ static void WRITE_EA_64(int ea_, uint64_t data)
 	}
 }
 
-static fp_reg READ_EA_FPE(int ea_)
+/* Read COUNT extended values (3 longs each) from EA into D, in one block
+ * transfer when the memory allows it
+ */
+static void READ_EA_FPE(int ea_, unsigned count, unsigned* d)
 {
-	fp_reg r = { 0 };
 	int mode = (ea_ >> 3) & 0x7;
 	int reg = (ea_ & 0x7);
+	unsigned i;
 
 	// TODO: convert to extended floating-point!
 
@@ -592,25 +597,32 @@ static fp_reg READ_EA_FPE(int ea_)
 	{
 		case 3:		// (An)+
 		{
-			uint32_t d1,d2;
 			uint32_t ea = REG_A[reg];
-			REG_A[reg] += 12;
-			d1 = m68ki_read_32(ea+0);
-			d2 = m68ki_read_32(ea+4);
-			// d3 = m68ki_read_32(ea+8);
-			r.i = (uint64_t)(d1) << 32 | (uint64_t)(d2);
+			m68ki_save_da(8 + reg);
+			REG_A[reg] += 12 * count;
+			if (m68ki_read_block_32(ea, 3 * count, d))
+				break;
+			for (i = 0; i < count; i++, ea += 12, d += 3)
+			{
+				d[0] = m68ki_read_32(ea+0);
+				d[1] = m68ki_read_32(ea+4);
+				// d[2] = m68ki_read_32(ea+8);
+				d[2] = 0;
+			}
 			break;
 		}
 		default:	fatalerror("MC68040: READ_EA_FPE: unhandled mode %d, reg %d, at %08X\n", mode, reg, REG_PC);
 	}
-
-	return r;
 }
 
-static void WRITE_EA_FPE(int ea_, fp_reg fpr)
+/* Write COUNT extended values (3 longs each) from D below EA, in one block
+ * transfer when the memory allows it
+ */
+static void WRITE_EA_FPE(int ea_, unsigned count, const unsigned* d)
 {
 	int mode = (ea_ >> 3) & 0x7;
 	int reg = (ea_ & 0x7);
+	unsigned i;
 
 	// TODO: convert to extended floating-point!
 
@@ -619,18 +631,19 @@ static void WRITE_EA_FPE(int ea_, fp_reg fpr)
 		case 4:		// -(An)
 		{
 			uint32_t ea;
-			REG_A[reg] -= 12;
+			m68ki_save_da(8 + reg);
+			REG_A[reg] -= 12 * count;
 			ea = REG_A[reg];
-			m68ki_write_32(ea+0, (uint32_t)(fpr.i >> 32));
-			m68ki_write_32(ea+4, (uint32_t)(fpr.i));
-			m68ki_write_32(ea+8, 0);
+			if (m68ki_write_block_32(ea, 3 * count, d))
+				break;
+			for (i = 0; i < 3 * count; i++, ea += 4)
+				m68ki_write_32(ea, d[i]);
 			break;
 		}
-		default:	fatalerror("MC68040: WRITE_EA_FPE: unhandled mode %d, reg %d, data %f at %08X\n", mode, reg, fpr.f, REG_PC);
+		default:	fatalerror("MC68040: WRITE_EA_FPE: unhandled mode %d, reg %d at %08X\n", mode, reg, REG_PC);
 	}
 }
 
-
 static void fpgen_rm_reg(uint16_t w2)
 {
 	int ea = REG_IR & 0x3f;
@@ -868,6 +881,7 @@ static void fmovem(uint16_t w2)
 	int dir = (w2 >> 13) & 0x1;
 	int mode = (w2 >> 11) & 0x3;
 	int reglist = w2 & 0xff;
+	unsigned d[24];
 
 	if (dir)	// From FP regs to mem
 	{
@@ -875,14 +889,17 @@ static void fmovem(uint16_t w2)
 		{
 			case 0:		// Static register list, predecrement addressing mode
 			{
-				for (i=0; i < 8; i++)
+				// The first register in the list ends up highest in memory
+				unsigned* value = d + 24;
+				for (; reglist; reglist &= reglist - 1)
 				{
-					if (reglist & (1 << i))
-					{
-						WRITE_EA_FPE(ea, REG_FP[i]);
-						USE_CYCLES(2);
-					}
+					i = m68ki_ctz(reglist);
+					*--value = 0;
+					*--value = (uint32_t)(REG_FP[i].i);
+					*--value = (uint32_t)(REG_FP[i].i >> 32);
+					USE_CYCLES(2);
 				}
+				WRITE_EA_FPE(ea, (unsigned)(d + 24 - value) / 3, value);
 				break;
 			}
 
@@ -895,13 +912,16 @@ static void fmovem(uint16_t w2)
 		{
 			case 2:		// Static register list, postincrement addressing mode
 			{
-				for (i=0; i < 8; i++)
+				unsigned* value = d;
+				unsigned count = 0;
+				for (i = reglist; i; i &= i - 1)
+					count++;
+				READ_EA_FPE(ea, count, d);
+				for (; reglist; reglist &= reglist - 1, value += 3)
 				{
-					if (reglist & (1 << i))
-					{
-						REG_FP[7-i] = READ_EA_FPE(ea);
-						USE_CYCLES(2);
-					}
+					i = m68ki_ctz(reglist);
+					REG_FP[7-i].i = (uint64_t)(value[0]) << 32 | (uint64_t)(value[1]);
+					USE_CYCLES(2);
 				}
 				break;
 			}
@@ -0,0 +1,1220 @@
+/* ======================================================================== */
+/* ========================= LICENSING & COPYRIGHT ======================== */
+/* ======================================================================== */
+/*
+ *                                  MUSASHI
+ *                                Version 4.60
+ *
+ * A portable Motorola M680x0 processor emulation engine.
+ * Copyright Karl Stenerud.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Translates blocks from the block cache to x86-64 code (M68K_JIT).
+ * This file is included by m68kcpu.c.
+ *
+ * A translated block does exactly what m68ki_block_cache_replay() would do
+ * for it, with the loop unrolled and the instruction words, handlers and
+ * clocks turned into constants.  Moves, add, sub, cmp and lea with data
+ * register, address register and (An), (An)+, -(An) and d16(An) operands,
+ * Bcc, DBcc and a few register to register ALU instructions are computed in
+ * place; everything else (FPU and PMMU instructions, exceptions, other
+ * addressing modes) calls the normal opcode handler.  Memory accesses go
+ * straight to pages mapped with m68k_map_memory() when they can, and through
+ * m68ki_read_N() and m68ki_write_N() when they can't.  A block that branches
+ * back to its own start keeps running without returning to m68k_execute().
+ *
+ * While the code runs, rbx points to m68ki_cpu, r12 to m68ki_remaining_cycles
+ * and r13 to the block.  r14 and r15 hold values an instruction needs across
+ * calls.  Everything else is scratch.
+ *
+ * The code buffer is writable only while a block is being translated, and
+ * executable only while it isn't.
+ */
+
+#if M68K_JIT
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+	#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Host registers */
+#define X86_EAX 0
+#define X86_ECX 1
+#define X86_EDX 2
+#define X86_EBX 3
+#define X86_ESI 6
+#define X86_EDI 7
+#define X86_R12 12
+#define X86_R13 13
+#define X86_R14 14
+#define X86_R15 15
+
+/* The /digit of immediate ALU instructions */
+#define X86_ADD 0
+#define X86_OR  1
+#define X86_AND 4
+#define X86_SUB 5
+#define X86_XOR 6
+#define X86_CMP 7
+
+/* Condition codes for jcc and setcc */
+#define X86_CC_B  0x2
+#define X86_CC_E  0x4
+#define X86_CC_NE 0x5
+#define X86_CC_A  0x7
+#define X86_CC_LE 0xe
+#define X86_JMP   -1 /* No condition */
+
+/* Worst case code size for a block */
+#define M68KI_JIT_BLOCK_BYTES (256 + M68K_BLOCK_CACHE_LENGTH*1024)
+
+/* Offsets into m68ki_cpu and the block */
+#define CPU_OFS(FIELD)   ((unsigned)offsetof(m68ki_cpu_core, FIELD))
+#define BLOCK_OFS(FIELD) ((unsigned)offsetof(m68ki_block_cache_block, FIELD))
+#define DREG_OFS(REG)    (CPU_OFS(dar) + (REG)*4)
+#define SAVE_OFS(REG)    (CPU_OFS(dar_save) + (REG)*4)
+
+/* What m68ki_jit_native() did with an instruction */
+#define M68KI_JIT_HANDLER   0 /* Nothing: it needs its opcode handler */
+#define M68KI_JIT_REGISTERS 1 /* Changed registers, and the next instruction follows */
+#define M68KI_JIT_MEMORY    2 /* Accessed memory or branched */
+
+/* Memory accesses are done in place when the address is in a page mapped
+ * with m68k_map_memory(), and the access stays in one page of the map, of
+ * the block cache and of M68K_DIRTY_PAGES.  The function code callback has
+ * to see every access, so it turns this off.
+ */
+#if M68K_MEMORY_MAP && !M68K_EMULATE_FC
+	#define M68KI_JIT_MAPPED 1
+	#if M68K_MEMORY_MAP_PAGE_SHIFT < M68K_BLOCK_CACHE_PAGE_SHIFT
+		#define M68KI_JIT_PAGE_SHIFT M68K_MEMORY_MAP_PAGE_SHIFT
+	#else
+		#define M68KI_JIT_PAGE_SHIFT M68K_BLOCK_CACHE_PAGE_SHIFT
+	#endif
+	#if M68K_DIRTY_PAGES && M68K_DIRTY_PAGE_SHIFT < M68KI_JIT_PAGE_SHIFT
+		#undef M68KI_JIT_PAGE_SHIFT
+		#define M68KI_JIT_PAGE_SHIFT M68K_DIRTY_PAGE_SHIFT
+	#endif
+#else
+	#define M68KI_JIT_MAPPED 0
+#endif /* M68K_MEMORY_MAP && !M68K_EMULATE_FC */
+
+/* Translated code, and the bytes of it used so far */
+static uint8_t* m68ki_jit_code;
+static unsigned m68ki_jit_used;
+
+/* Where the next byte is emitted */
+static uint8_t* m68ki_jit_ptr;
+
+/* Switched by m68k_set_jit() */
+static int      m68ki_jit_enabled = 1;
+
+/* Jumps to the end of the block being translated */
+static uint8_t* m68ki_jit_exits[M68K_BLOCK_CACHE_LENGTH*12 + 8];
+static unsigned m68ki_jit_exit_count;
+
+/* The block being translated, and for the instruction being translated,
+ * where the interpreter would have its PC, the PC last stored to m68ki_cpu
+ * and the registers saved so far (see m68ki_save_da())
+ */
+static const m68ki_block_cache_block* m68ki_jit_block;
+static unsigned m68ki_jit_pc;
+static unsigned m68ki_jit_stored_pc;
+static unsigned m68ki_jit_saved;
+
+/* Lets the address of the code be stored as a function pointer */
+typedef union
+{
+	uint8_t* data;
+	void   (*code)(void);
+} m68ki_jit_pointer;
+
+
+/* ======================================================================== */
+/* =============================== EMITTERS =============================== */
+/* ======================================================================== */
+
+static void m68ki_jit_byte(unsigned value)
+{
+	*m68ki_jit_ptr++ = value;
+}
+
+/* An instruction with no variable parts */
+static void m68ki_jit_bytes(const char* bytes, unsigned count)
+{
+	while(count--)
+		m68ki_jit_byte((uint8_t)*bytes++);
+}
+
+static void m68ki_jit_u32(unsigned value)
+{
+	m68ki_jit_byte(value);
+	m68ki_jit_byte(value >> 8);
+	m68ki_jit_byte(value >> 16);
+	m68ki_jit_byte(value >> 24);
+}
+
+static void m68ki_jit_u64(uint64_t value)
+{
+	m68ki_jit_u32((unsigned)value);
+	m68ki_jit_u32((unsigned)(value >> 32));
+}
+
+/* REX prefix for r8 to r15 as REG and BASE, if either is one */
+static void m68ki_jit_rex(unsigned reg, unsigned base)
+{
+	if((reg | base) & 8)
+		m68ki_jit_byte(0x40 | ((reg >> 1) & 4) | (base >> 3));
+}
+
+/* op r32, [base + disp32] (or the /digit form of op) */
+static void m68ki_jit_op_mem(unsigned op, unsigned reg, unsigned base, unsigned disp)
+{
+	m68ki_jit_rex(reg, base);
+	m68ki_jit_byte(op);
+	m68ki_jit_byte(0x80 | ((reg & 7) << 3) | (base & 7));
+	if((base & 7) == 4)
+		m68ki_jit_byte(0x24);
+	m68ki_jit_u32(disp);
+}
+
+/* op r/m32, r32 between registers */
+static void m68ki_jit_op_reg(unsigned op, unsigned dst, unsigned src)
+{
+	m68ki_jit_rex(src, dst);
+	m68ki_jit_byte(op);
+	m68ki_jit_byte(0xc0 | ((src & 7) << 3) | (dst & 7));
+}
+
+#define m68ki_jit_load(REG, BASE, DISP)   m68ki_jit_op_mem(0x8b, REG, BASE, DISP)
+#define m68ki_jit_store(BASE, DISP, REG)  m68ki_jit_op_mem(0x89, REG, BASE, DISP)
+#define m68ki_jit_mov(DST, SRC)           m68ki_jit_op_reg(0x89, DST, SRC)
+#define m68ki_jit_add(DST, SRC)           m68ki_jit_op_reg(0x01, DST, SRC)
+#define m68ki_jit_sub(DST, SRC)           m68ki_jit_op_reg(0x29, DST, SRC)
+#define m68ki_jit_and(DST, SRC)           m68ki_jit_op_reg(0x21, DST, SRC)
+#define m68ki_jit_or(DST, SRC)            m68ki_jit_op_reg(0x09, DST, SRC)
+#define m68ki_jit_xor(DST, SRC)           m68ki_jit_op_reg(0x31, DST, SRC)
+#define m68ki_jit_test(DST, SRC)          m68ki_jit_op_reg(0x85, DST, SRC)
+
+/* mov [base + disp32], al/ax/eax for a SIZE byte value */
+static void m68ki_jit_store_size(unsigned size, unsigned base, unsigned disp)
+{
+	if(size == 2)
+		m68ki_jit_byte(0x66);
+	m68ki_jit_op_mem(size == 1 ? 0x88 : 0x89, X86_EAX, base, disp);
+}
+
+/* mov dword [base + disp32], imm32 */
+static void m68ki_jit_store_imm(unsigned base, unsigned disp, unsigned value)
+{
+	m68ki_jit_op_mem(0xc7, 0, base, disp);
+	m68ki_jit_u32(value);
+}
+
+/* sub dword [base + disp32], imm32 */
+static void m68ki_jit_sub_imm(unsigned base, unsigned disp, unsigned value)
+{
+	m68ki_jit_op_mem(0x81, 5, base, disp);
+	m68ki_jit_u32(value);
+}
+
+/* cmp dword [base + disp32], imm32 */
+static void m68ki_jit_cmp_imm(unsigned base, unsigned disp, unsigned value)
+{
+	m68ki_jit_op_mem(0x81, 7, base, disp);
+	m68ki_jit_u32(value);
+}
+
+/* or dword [base + disp32], imm32 */
+static void m68ki_jit_or_imm(unsigned base, unsigned disp, unsigned value)
+{
+	m68ki_jit_op_mem(0x81, 1, base, disp);
+	m68ki_jit_u32(value);
+}
+
+/* add/or/and/sub/xor/cmp r32, imm32 */
+static void m68ki_jit_alu_imm(unsigned op, unsigned reg, unsigned value)
+{
+	m68ki_jit_op_reg(0x81, reg, op);
+	m68ki_jit_u32(value);
+}
+
+/* mov r32, imm32 */
+static void m68ki_jit_mov_imm(unsigned reg, unsigned value)
+{
+	m68ki_jit_byte(0xb8 + reg);
+	m68ki_jit_u32(value);
+}
+
+/* mov r64, imm64 */
+static void m68ki_jit_mov_imm64(unsigned reg, uint64_t value)
+{
+	m68ki_jit_byte(0x48 | (reg >> 3));
+	m68ki_jit_byte(0xb8 + (reg & 7));
+	m68ki_jit_u64(value);
+}
+
+/* shr r32, imm8 */
+static void m68ki_jit_shr(unsigned reg, unsigned shift)
+{
+	m68ki_jit_byte(0xc1);
+	m68ki_jit_byte(0xe8 | reg);
+	m68ki_jit_byte(shift);
+}
+
+/* not r32 */
+static void m68ki_jit_not(unsigned reg)
+{
+	m68ki_jit_byte(0xf7);
+	m68ki_jit_byte(0xd0 | reg);
+}
+
+/* setcc r8; movzx r32, r8 (for eax to ebx) */
+static void m68ki_jit_setcc(unsigned cc, unsigned reg)
+{
+	m68ki_jit_byte(0x0f);
+	m68ki_jit_byte(0x90 | cc);
+	m68ki_jit_byte(0xc0 | reg);
+	m68ki_jit_byte(0x0f);
+	m68ki_jit_byte(0xb6);
+	m68ki_jit_byte(0xc0 | (reg << 3) | reg);
+}
+
+/* Call a C function */
+static void m68ki_jit_call(void (*function)(void))
+{
+	m68ki_jit_mov_imm64(X86_EAX, (uintptr_t)function);
+	m68ki_jit_byte(0xff);
+	m68ki_jit_byte(0xd0);
+}
+
+/* jcc (or jmp for X86_JMP) forward, to where m68ki_jit_land() is called */
+static uint8_t* m68ki_jit_jump(int cc)
+{
+	if(cc == X86_JMP)
+		m68ki_jit_byte(0xe9);
+	else
+	{
+		m68ki_jit_byte(0x0f);
+		m68ki_jit_byte(0x80 | cc);
+	}
+	m68ki_jit_u32(0);
+	return m68ki_jit_ptr - 4;
+}
+
+/* Point a jump at the next byte emitted */
+static void m68ki_jit_land(uint8_t* jump)
+{
+	unsigned offset = (unsigned)(m68ki_jit_ptr - (jump + 4));
+
+	jump[0] = offset;
+	jump[1] = offset >> 8;
+	jump[2] = offset >> 16;
+	jump[3] = offset >> 24;
+}
+
+/* jcc to the end of the block */
+static void m68ki_jit_exit_if(unsigned cc)
+{
+	m68ki_jit_exits[m68ki_jit_exit_count++] = m68ki_jit_jump(cc);
+}
+
+
+/* ======================================================================== */
+/* ============================ MEMORY ACCESSES =========================== */
+/* ======================================================================== */
+
+/* Accesses that can't be done in place */
+static unsigned m68ki_jit_read_8(unsigned address)
+{
+	return m68ki_read_8(address);
+}
+static unsigned m68ki_jit_read_16(unsigned address)
+{
+	return m68ki_read_16(address);
+}
+static unsigned m68ki_jit_read_32(unsigned address)
+{
+	return m68ki_read_32(address);
+}
+static void m68ki_jit_write_8(unsigned address, unsigned value)
+{
+	m68ki_write_8(address, value);
+}
+static void m68ki_jit_write_16(unsigned address, unsigned value)
+{
+	m68ki_write_16(address, value);
+}
+static void m68ki_jit_write_32(unsigned address, unsigned value)
+{
+	m68ki_write_32(address, value);
+}
+
+/* Store the PC the interpreter would have, for anything that calls out */
+static void m68ki_jit_sync_pc(void)
+{
+	if(m68ki_jit_pc != m68ki_jit_stored_pc)
+	{
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), m68ki_jit_pc);
+		m68ki_jit_stored_pc = m68ki_jit_pc;
+	}
+}
+
+/* Leave the block if a bus or address error is pending, as the replay loop
+ * does (see m68ki_fault())
+ */
+static void m68ki_jit_fault_check(void)
+{
+#if M68K_PENDING_FAULTS
+	m68ki_jit_cmp_imm(X86_EBX, CPU_OFS(fault_pending), 0);
+	m68ki_jit_exit_if(X86_CC_NE);
+#endif /* M68K_PENDING_FAULTS */
+}
+
+#if M68KI_JIT_MAPPED
+/* Find the address in edi in mapped memory, leaving the host page in r8 and
+ * the offset into it in rcx.  Everything that has to go through
+ * m68ki_read_N() or m68ki_write_N() jumps to SLOW instead; returns the
+ * number of jumps.
+ */
+static unsigned m68ki_jit_map_find(unsigned size, uint8_t** pages, int write, uint8_t** slow)
+{
+	unsigned count = 0;
+
+	/* mov edx, edi; and edx, address_mask */
+	m68ki_jit_mov(X86_EDX, X86_EDI);
+	m68ki_jit_op_mem(0x23, X86_EDX, X86_EBX, CPU_OFS(address_mask));
+
+	/* Odd addresses are misaligned (or an address error) */
+	if(size > 1)
+	{
+		m68ki_jit_bytes("\xf6\xc2\x01", 3); /* test dl, 1 */
+		slow[count++] = m68ki_jit_jump(X86_CC_NE);
+	}
+
+	/* An even long can still run into the next page */
+	if(size == 4)
+	{
+		m68ki_jit_mov(X86_ECX, X86_EDX);
+		m68ki_jit_alu_imm(X86_AND, X86_ECX, (1 << M68KI_JIT_PAGE_SHIFT) - 1);
+		m68ki_jit_alu_imm(X86_CMP, X86_ECX, (1 << M68KI_JIT_PAGE_SHIFT) - 4);
+		slow[count++] = m68ki_jit_jump(X86_CC_A);
+	}
+
+#if M68K_EMULATE_PMMU
+	m68ki_jit_cmp_imm(X86_EBX, CPU_OFS(pmmu_enabled), 0);
+	slow[count++] = m68ki_jit_jump(X86_CC_NE);
+#endif /* M68K_EMULATE_PMMU */
+
+	/* Writes to cached code have to invalidate it */
+	if(write)
+	{
+		m68ki_jit_mov(X86_EAX, X86_EDX);
+		m68ki_jit_shr(X86_EAX, M68K_BLOCK_CACHE_PAGE_SHIFT);
+		m68ki_jit_mov_imm64(8, (uintptr_t)m68ki_block_cache_pages);
+		m68ki_jit_bytes("\x41\x0f\xa3\x00", 4);     /* bt [r8], eax */
+		slow[count++] = m68ki_jit_jump(X86_CC_B);
+	}
+
+	m68ki_jit_mov(X86_EAX, X86_EDX);
+	m68ki_jit_shr(X86_EAX, M68K_MEMORY_MAP_PAGE_SHIFT);
+	m68ki_jit_mov_imm64(8, (uintptr_t)pages);
+	m68ki_jit_bytes("\x4d\x8b\x04\xc0", 4);         /* mov r8, [r8 + rax*8] */
+	m68ki_jit_bytes("\x4d\x85\xc0", 3);             /* test r8, r8 */
+	slow[count++] = m68ki_jit_jump(X86_CC_E);
+
+	m68ki_jit_mov(X86_ECX, X86_EDX);
+	m68ki_jit_alu_imm(X86_AND, X86_ECX, M68KI_MAP_PAGE_SIZE - 1);
+#if M68KI_MAP_SWAPPED
+	if(size == 1)
+		m68ki_jit_alu_imm(X86_XOR, X86_ECX, 1);
+#endif /* M68KI_MAP_SWAPPED */
+	return count;
+}
+#endif /* M68KI_JIT_MAPPED */
+
+/* Read SIZE bytes at the address in edi into eax */
+static void m68ki_jit_read(unsigned size)
+{
+#if M68KI_JIT_MAPPED
+	uint8_t* slow[4];
+	unsigned count = m68ki_jit_map_find(size, m68ki_map_read_pages, 0, slow);
+	uint8_t* done;
+
+	if(size == 1)
+		m68ki_jit_bytes("\x41\x0f\xb6\x04\x08", 5); /* movzx eax, byte [r8 + rcx] */
+	else if(size == 2)
+	{
+		m68ki_jit_bytes("\x41\x0f\xb7\x04\x08", 5); /* movzx eax, word [r8 + rcx] */
+		if(!M68KI_MAP_SWAPPED)
+			m68ki_jit_bytes("\x66\xc1\xc0\x08", 4); /* rol ax, 8 */
+	}
+	else
+	{
+		m68ki_jit_bytes("\x41\x8b\x04\x08", 4);     /* mov eax, [r8 + rcx] */
+		if(M68KI_MAP_SWAPPED)
+			m68ki_jit_bytes("\xc1\xc0\x10", 3);     /* rol eax, 16 */
+		else
+			m68ki_jit_bytes("\x0f\xc8", 2);         /* bswap eax */
+	}
+	done = m68ki_jit_jump(X86_JMP);
+	while(count--)
+		m68ki_jit_land(slow[count]);
+#endif /* M68KI_JIT_MAPPED */
+
+	m68ki_jit_call(size == 1 ? (void (*)(void))m68ki_jit_read_8 :
+					size == 2 ? (void (*)(void))m68ki_jit_read_16 :
+					(void (*)(void))m68ki_jit_read_32);
+	m68ki_jit_fault_check();
+
+#if M68KI_JIT_MAPPED
+	m68ki_jit_land(done);
+#endif /* M68KI_JIT_MAPPED */
+}
+
+/* Write the SIZE byte value in esi to the address in edi */
+static void m68ki_jit_write(unsigned size)
+{
+#if M68KI_JIT_MAPPED && !M68K_STATIC_CODE
+	uint8_t* slow[5];
+	unsigned count = m68ki_jit_map_find(size, m68ki_map_write_pages, 1, slow);
+	uint8_t* done;
+
+#if M68K_DIRTY_PAGES
+	m68ki_jit_shr(X86_EDX, M68K_DIRTY_PAGE_SHIFT);
+	m68ki_jit_mov_imm64(X86_EAX, (uintptr_t)m68ki_dirty_pages);
+	m68ki_jit_bytes("\x0f\xab\x10", 3);             /* bts [rax], edx */
+#endif /* M68K_DIRTY_PAGES */
+
+	if(size == 1)
+		m68ki_jit_bytes("\x41\x88\x34\x08", 4);     /* mov [r8 + rcx], sil */
+	else if(size == 2)
+	{
+		if(!M68KI_MAP_SWAPPED)
+			m68ki_jit_bytes("\x66\xc1\xc6\x08", 4); /* rol si, 8 */
+		m68ki_jit_bytes("\x66\x41\x89\x34\x08", 5); /* mov [r8 + rcx], si */
+	}
+	else
+	{
+		if(M68KI_MAP_SWAPPED)
+			m68ki_jit_bytes("\xc1\xc6\x10", 3);     /* rol esi, 16 */
+		else
+			m68ki_jit_bytes("\x0f\xce", 2);         /* bswap esi */
+		m68ki_jit_bytes("\x41\x89\x34\x08", 4);     /* mov [r8 + rcx], esi */
+	}
+	done = m68ki_jit_jump(X86_JMP);
+	while(count--)
+		m68ki_jit_land(slow[count]);
+#endif /* M68KI_JIT_MAPPED && !M68K_STATIC_CODE */
+
+	m68ki_jit_call(size == 1 ? (void (*)(void))m68ki_jit_write_8 :
+					size == 2 ? (void (*)(void))m68ki_jit_write_16 :
+					(void (*)(void))m68ki_jit_write_32);
+	m68ki_jit_fault_check();
+
+#if M68KI_JIT_MAPPED && !M68K_STATIC_CODE
+	m68ki_jit_land(done);
+#endif /* M68KI_JIT_MAPPED && !M68K_STATIC_CODE */
+}
+
+
+/* ======================================================================== */
+/* ========================= NATIVE INSTRUCTIONS ========================== */
+/* ======================================================================== */
+
+/* All bits of a SIZE byte operand */
+#define M68KI_JIT_MASK(SIZE) ((SIZE) == 4 ? 0xffffffff : (1u << (SIZE)*8) - 1)
+
+/* The next extension word of the instruction */
+static unsigned m68ki_jit_imm_16(void)
+{
+	unsigned word = m68ki_jit_block->words[(m68ki_jit_pc - m68ki_jit_block->pc) >> 1];
+
+	m68ki_jit_pc += 2;
+	return word;
+}
+
+/* Save register REG (0-15) before the instruction first changes it */
+static void m68ki_jit_save_da(unsigned reg)
+{
+	if(m68ki_jit_saved & (1 << reg))
+		return;
+	m68ki_jit_saved |= 1 << reg;
+	m68ki_jit_load(X86_EAX, X86_EBX, DREG_OFS(reg));
+	m68ki_jit_store(X86_EBX, SAVE_OFS(reg), X86_EAX);
+	m68ki_jit_or_imm(X86_EBX, CPU_OFS(dar_save_mask), 1 << reg);
+}
+
+/* Nonzero if a SIZE byte operand in EA mode MODE can be read in place */
+static int m68ki_jit_source_mode(unsigned size, unsigned mode)
+{
+	return mode <= 5 && (mode != 1 || size != 1);
+}
+
+/* Put the address of the SIZE byte operand in EA mode MODE (2 to 5) of
+ * address register REG in edi, the way the EA_AY_* macros work it out
+ */
+static void m68ki_jit_ea(unsigned size, unsigned mode, unsigned reg)
+{
+	unsigned step = size == 1 && reg == 7 ? 2 : size; /* A7 stays even */
+
+	if(mode == 3 || mode == 4)
+		m68ki_jit_save_da(8 + reg);
+	m68ki_jit_load(X86_EDI, X86_EBX, DREG_OFS(8 + reg));
+	if(mode == 3)         /* (An)+ */
+	{
+		m68ki_jit_mov(X86_EAX, X86_EDI);
+		m68ki_jit_alu_imm(X86_ADD, X86_EAX, step);
+		m68ki_jit_store(X86_EBX, DREG_OFS(8 + reg), X86_EAX);
+	}
+	else if(mode == 4)    /* -(An) */
+	{
+		m68ki_jit_alu_imm(X86_SUB, X86_EDI, step);
+		m68ki_jit_store(X86_EBX, DREG_OFS(8 + reg), X86_EDI);
+	}
+	else if(mode == 5)    /* d16(An) */
+		m68ki_jit_alu_imm(X86_ADD, X86_EDI, MASK_OUT_ABOVE_32(MAKE_INT_16(m68ki_jit_imm_16())));
+}
+
+/* Read the SIZE byte operand in EA mode MODE, register REG, into eax */
+static void m68ki_jit_read_ea(unsigned size, unsigned mode, unsigned reg)
+{
+	if(mode < 2)
+	{
+		m68ki_jit_load(X86_EAX, X86_EBX, DREG_OFS(mode*8 + reg));
+		if(size < 4)
+			m68ki_jit_alu_imm(X86_AND, X86_EAX, M68KI_JIT_MASK(size));
+		return;
+	}
+	m68ki_jit_ea(size, mode, reg);
+	m68ki_jit_sync_pc();
+	m68ki_jit_read(size);
+}
+
+/* Write the SIZE byte value in r14 to the address in edi */
+static void m68ki_jit_write_ea(unsigned size, unsigned mode)
+{
+	m68ki_jit_sync_pc();
+	if(size == 4 && mode == 4)
+	{
+		/* -(An) writes the low word first */
+		m68ki_jit_mov(X86_R15, X86_EDI);
+		m68ki_jit_alu_imm(X86_ADD, X86_EDI, 2);
+		m68ki_jit_mov(X86_ESI, X86_R14);
+		m68ki_jit_alu_imm(X86_AND, X86_ESI, 0xffff);
+		m68ki_jit_write(2);
+		m68ki_jit_mov(X86_EDI, X86_R15);
+		m68ki_jit_mov(X86_ESI, X86_R14);
+		m68ki_jit_shr(X86_ESI, 16);
+		m68ki_jit_write(2);
+		return;
+	}
+	m68ki_jit_mov(X86_ESI, X86_R14);
+	m68ki_jit_write(size);
+}
+
+/* All of N, Z, V and C have been set in place, so forget any that an
+ * interpreted instruction left to be worked out later (see M68K_LAZY_FLAGS)
+ */
+static void m68ki_jit_drop_lazy_flags(void)
+{
+#if M68K_LAZY_FLAGS
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(lazy_op), M68KI_LAZY_NONE);
+#endif /* M68K_LAZY_FLAGS */
+}
+
+/* Set the flags the way m68k_in.c does for a SIZE byte result in eax with
+ * V and C clear, and store the result to data register REG unless it is
+ * negative.
+ */
+static void m68ki_jit_logic_flags(unsigned size, int reg)
+{
+	if(reg >= 0)
+		m68ki_jit_store_size(size, X86_EBX, DREG_OFS(reg));
+	m68ki_jit_store(X86_EBX, CPU_OFS(not_z_flag), X86_EAX);
+	if(size > 1)
+		m68ki_jit_shr(X86_EAX, size*8 - 8);
+	m68ki_jit_store(X86_EBX, CPU_OFS(n_flag), X86_EAX);
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(v_flag), VFLAG_CLEAR);
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(c_flag), CFLAG_CLEAR);
+	m68ki_jit_drop_lazy_flags();
+}
+
+/* Add (or subtract) the SIZE byte src in ecx and dst in edx, setting N, Z,
+ * V, C and optionally X like m68k_in.c does, and store the result to data
+ * register REG unless it is negative.
+ */
+static void m68ki_jit_arith(unsigned size, int subtract, int set_x, int reg)
+{
+	unsigned shift = size*8 - 8;
+
+	m68ki_jit_mov(X86_EAX, X86_EDX);
+	if(subtract)
+		m68ki_jit_sub(X86_EAX, X86_ECX);
+	else
+		m68ki_jit_add(X86_EAX, X86_ECX);
+	if(reg >= 0)
+		m68ki_jit_store_size(size, X86_EBX, DREG_OFS(reg));
+
+	/* Z = res, without the carry out */
+	m68ki_jit_mov(X86_ESI, X86_EAX);
+	if(size < 4)
+		m68ki_jit_alu_imm(X86_AND, X86_ESI, M68KI_JIT_MASK(size));
+	m68ki_jit_store(X86_EBX, CPU_OFS(not_z_flag), X86_ESI);
+
+	/* N = res >> shift */
+	m68ki_jit_mov(X86_ESI, X86_EAX);
+	if(shift)
+		m68ki_jit_shr(X86_ESI, shift);
+	m68ki_jit_store(X86_EBX, CPU_OFS(n_flag), X86_ESI);
+
+	if(subtract)
+	{
+		/* V = ((src ^ dst) & (res ^ dst)) >> shift */
+		m68ki_jit_mov(X86_ESI, X86_ECX);
+		m68ki_jit_xor(X86_ESI, X86_EDX);
+		m68ki_jit_mov(X86_EDI, X86_EAX);
+		m68ki_jit_xor(X86_EDI, X86_EDX);
+	}
+	else
+	{
+		/* V = ((src ^ res) & (dst ^ res)) >> shift */
+		m68ki_jit_mov(X86_ESI, X86_ECX);
+		m68ki_jit_xor(X86_ESI, X86_EAX);
+		m68ki_jit_mov(X86_EDI, X86_EDX);
+		m68ki_jit_xor(X86_EDI, X86_EAX);
+	}
+	m68ki_jit_and(X86_ESI, X86_EDI);
+	if(shift)
+		m68ki_jit_shr(X86_ESI, shift);
+	m68ki_jit_store(X86_EBX, CPU_OFS(v_flag), X86_ESI);
+
+	if(size < 4)
+	{
+		/* C = res >> shift, which keeps the carry out */
+		m68ki_jit_mov(X86_ESI, X86_EAX);
+		if(shift)
+			m68ki_jit_shr(X86_ESI, shift);
+	}
+	else
+	{
+		if(subtract)
+		{
+			/* C = ((src & res) | (~dst & (src | res))) >> 23 */
+			m68ki_jit_mov(X86_ESI, X86_ECX);
+			m68ki_jit_and(X86_ESI, X86_EAX);
+			m68ki_jit_mov(X86_EDI, X86_ECX);
+			m68ki_jit_or(X86_EDI, X86_EAX);
+			m68ki_jit_not(X86_EDX);
+			m68ki_jit_and(X86_EDI, X86_EDX);
+		}
+		else
+		{
+			/* C = ((src & dst) | (~res & (src | dst))) >> 23 */
+			m68ki_jit_mov(X86_ESI, X86_ECX);
+			m68ki_jit_and(X86_ESI, X86_EDX);
+			m68ki_jit_mov(X86_EDI, X86_ECX);
+			m68ki_jit_or(X86_EDI, X86_EDX);
+			m68ki_jit_not(X86_EAX);
+			m68ki_jit_and(X86_EDI, X86_EAX);
+		}
+		m68ki_jit_or(X86_ESI, X86_EDI);
+		m68ki_jit_shr(X86_ESI, 23);
+	}
+	m68ki_jit_store(X86_EBX, CPU_OFS(c_flag), X86_ESI);
+	if(set_x)
+		m68ki_jit_store(X86_EBX, CPU_OFS(x_flag), X86_ESI);
+	m68ki_jit_drop_lazy_flags();
+}
+
+/* Set eax to 1 if condition CC (2 to 15) is true and 0 if not, like the
+ * COND_* macros in m68kcpu.h.  Each even condition is the opposite of the
+ * odd one after it.
+ */
+static void m68ki_jit_cond(unsigned cc)
+{
+	/* LS = CS || EQ, and LE = LT || EQ */
+	if(cc == 2 || cc == 3 || cc == 14 || cc == 15)
+	{
+		m68ki_jit_cmp_imm(X86_EBX, CPU_OFS(not_z_flag), 0);
+		m68ki_jit_setcc(X86_CC_E, X86_ECX);
+	}
+
+	switch(cc | 1)
+	{
+		case 3:   /* LS */
+		case 5:   /* CS */
+			m68ki_jit_load(X86_EAX, X86_EBX, CPU_OFS(c_flag));
+			m68ki_jit_shr(X86_EAX, 8);
+			break;
+		case 7:   /* EQ */
+			m68ki_jit_cmp_imm(X86_EBX, CPU_OFS(not_z_flag), 0);
+			m68ki_jit_setcc(X86_CC_E, X86_EAX);
+			break;
+		case 9:   /* VS */
+			m68ki_jit_load(X86_EAX, X86_EBX, CPU_OFS(v_flag));
+			m68ki_jit_shr(X86_EAX, 7);
+			break;
+		case 11:  /* MI */
+			m68ki_jit_load(X86_EAX, X86_EBX, CPU_OFS(n_flag));
+			m68ki_jit_shr(X86_EAX, 7);
+			break;
+		default:  /* LT and LE */
+			m68ki_jit_load(X86_EAX, X86_EBX, CPU_OFS(n_flag));
+			m68ki_jit_op_mem(0x33, X86_EAX, X86_EBX, CPU_OFS(v_flag)); /* xor eax, [v_flag] */
+			m68ki_jit_shr(X86_EAX, 7);
+			break;
+	}
+	m68ki_jit_alu_imm(X86_AND, X86_EAX, 1);
+	if(cc == 2 || cc == 3 || cc == 14 || cc == 15)
+		m68ki_jit_or(X86_EAX, X86_ECX);
+	if(!(cc & 1))
+		m68ki_jit_alu_imm(X86_XOR, X86_EAX, 1);
+}
+
+/* move <ea>, <ea> */
+static int m68ki_jit_move(unsigned ir)
+{
+	unsigned size = (ir & 0x3000) == 0x1000 ? 1 : (ir & 0x3000) == 0x3000 ? 2 : 4;
+	unsigned src_mode = (ir >> 3) & 7;
+	unsigned dst_mode = (ir >> 6) & 7;
+	unsigned rx = (ir >> 9) & 7;
+
+	/* movea is left to its handler */
+	if(!m68ki_jit_source_mode(size, src_mode) || dst_mode == 1 || dst_mode > 5)
+		return M68KI_JIT_HANDLER;
+
+	m68ki_jit_read_ea(size, src_mode, ir & 7);
+	if(dst_mode == 0)
+	{
+		m68ki_jit_logic_flags(size, rx);
+		return src_mode < 2 ? M68KI_JIT_REGISTERS : M68KI_JIT_MEMORY;
+	}
+
+	/* The source is read before the destination address is worked out, and
+	 * the flags are set after the write
+	 */
+	m68ki_jit_mov(X86_R14, X86_EAX);
+	m68ki_jit_ea(size, dst_mode, rx);
+	m68ki_jit_write_ea(size, dst_mode);
+	m68ki_jit_mov(X86_EAX, X86_R14);
+	m68ki_jit_logic_flags(size, -1);
+	return M68KI_JIT_MEMORY;
+}
+
+/* add/sub/cmp <ea>, Dn */
+static int m68ki_jit_add_sub(unsigned ir)
+{
+	unsigned size = 1 << ((ir >> 6) & 3);
+	unsigned mode = (ir >> 3) & 7;
+	unsigned rx = (ir >> 9) & 7;
+
+	if(!m68ki_jit_source_mode(size, mode))
+		return M68KI_JIT_HANDLER;
+
+	m68ki_jit_read_ea(size, mode, ir & 7);
+	m68ki_jit_mov(X86_ECX, X86_EAX);
+	m68ki_jit_load(X86_EDX, X86_EBX, DREG_OFS(rx));
+	if(size < 4)
+		m68ki_jit_alu_imm(X86_AND, X86_EDX, M68KI_JIT_MASK(size));
+	if((ir & 0xf000) == 0xb000)
+		m68ki_jit_arith(size, 1, 0, -1);
+	else
+		m68ki_jit_arith(size, (ir & 0xf000) == 0x9000, 1, rx);
+	return mode < 2 ? M68KI_JIT_REGISTERS : M68KI_JIT_MEMORY;
+}
+
+/* Bcc, bra */
+static int m68ki_jit_bcc(const m68ki_block_cache_instr* instr)
+{
+	unsigned cc = (instr->ir >> 8) & 0xf;
+	unsigned offset = MASK_OUT_ABOVE_8(instr->ir);
+	unsigned next = instr->pc + (offset ? 2 : 4);
+	unsigned target;
+	uint8_t* not_taken;
+	uint8_t* done;
+
+	/* bsr, bcc.l (or an odd branch on the 68000), tracing, and conditions
+	 * that need the lazy flags worked out are left to the handler
+	 */
+	if(cc == 1 || offset == 0xff || M68K_EMULATE_TRACE || (cc > 1 && M68K_LAZY_FLAGS))
+		return M68KI_JIT_HANDLER;
+
+	target = MASK_OUT_ABOVE_32(instr->pc + 2 + (offset ? MAKE_INT_8(offset) : MAKE_INT_16(m68ki_jit_imm_16())));
+
+	if(cc == 0)
+	{
+		/* Branching to itself uses up the timeslice in the handler */
+		if(target == instr->pc)
+			return M68KI_JIT_HANDLER;
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), target);
+		return M68KI_JIT_MEMORY;
+	}
+
+	/* So do short loops that M68K_IDLE_SKIP looks at */
+	if(M68K_IDLE_SKIP && instr->pc - target - 2 <= 6)
+		return M68KI_JIT_HANDLER;
+
+	m68ki_jit_cond(cc);
+	m68ki_jit_test(X86_EAX, X86_EAX);
+	not_taken = m68ki_jit_jump(X86_CC_E);
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), target);
+	done = m68ki_jit_jump(X86_JMP);
+	m68ki_jit_land(not_taken);
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), next);
+	m68ki_jit_sub_imm(X86_R12, 0, offset ? CYC_BCC_NOTAKE_B : CYC_BCC_NOTAKE_W);
+	m68ki_jit_land(done);
+	return M68KI_JIT_MEMORY;
+}
+
+/* DBcc, dbf, dbt */
+static int m68ki_jit_dbcc(const m68ki_block_cache_instr* instr)
+{
+	unsigned cc = (instr->ir >> 8) & 0xf;
+	unsigned reg = instr->ir & 7;
+	unsigned next = instr->pc + 4;
+	unsigned target;
+	uint8_t* cond_true = NULL;
+	uint8_t* expired;
+	uint8_t* done;
+
+	/* Tracing, conditions that need the lazy flags worked out and the
+	 * dbf loops that M68K_IDLE_SKIP looks at are left to the handler
+	 */
+	if(M68K_EMULATE_TRACE || (cc > 1 && M68K_LAZY_FLAGS) || (cc == 1 && M68K_IDLE_SKIP))
+		return M68KI_JIT_HANDLER;
+
+	target = MASK_OUT_ABOVE_32(instr->pc + 2 + MAKE_INT_16(m68ki_jit_imm_16()));
+
+	if(cc == 0)
+	{
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), next);
+		return M68KI_JIT_REGISTERS;
+	}
+
+	if(cc > 1)
+	{
+		m68ki_jit_cond(cc);
+		m68ki_jit_test(X86_EAX, X86_EAX);
+		cond_true = m68ki_jit_jump(X86_CC_NE);
+	}
+
+	/* Dn.w -= 1, and branch unless it went past 0 */
+	m68ki_jit_load(X86_EAX, X86_EBX, DREG_OFS(reg));
+	m68ki_jit_alu_imm(X86_SUB, X86_EAX, 1);
+	m68ki_jit_store_size(2, X86_EBX, DREG_OFS(reg));
+	m68ki_jit_alu_imm(X86_AND, X86_EAX, 0xffff);
+	m68ki_jit_alu_imm(X86_CMP, X86_EAX, 0xffff);
+	expired = m68ki_jit_jump(X86_CC_E);
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), target);
+	m68ki_jit_sub_imm(X86_R12, 0, CYC_DBCC_F_NOEXP);
+	done = m68ki_jit_jump(X86_JMP);
+	m68ki_jit_land(expired);
+	m68ki_jit_sub_imm(X86_R12, 0, CYC_DBCC_F_EXP);
+	if(cond_true)
+		m68ki_jit_land(cond_true);
+	m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), next);
+	m68ki_jit_land(done);
+	return M68KI_JIT_MEMORY;
+}
+
+/* Translate an instruction in place, from the PC after its opcode word */
+static int m68ki_jit_native(const m68ki_block_cache_instr* instr)
+{
+	unsigned ir = instr->ir;
+	unsigned rx = (ir >> 9) & 7;
+	unsigned ry = ir & 7;
+	unsigned quick = (((ir >> 9) - 1) & 7) + 1;
+	int native = M68KI_JIT_REGISTERS;
+
+	m68ki_jit_pc = m68ki_jit_stored_pc = instr->pc + 2;
+	m68ki_jit_saved = 0;
+
+	if((ir & 0xf000) == 0x6000)
+		return m68ki_jit_bcc(instr);
+	if((ir & 0xf0f8) == 0x50c8)
+		return m68ki_jit_dbcc(instr);
+
+	if((ir & 0xf100) == 0x7000)         /* moveq #i, Dx */
+	{
+		unsigned res = MASK_OUT_ABOVE_32(MAKE_INT_8(MASK_OUT_ABOVE_8(ir)));
+
+		m68ki_jit_store_imm(X86_EBX, DREG_OFS(rx), res);
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(n_flag), NFLAG_32(res));
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(not_z_flag), res);
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(v_flag), VFLAG_CLEAR);
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(c_flag), CFLAG_CLEAR);
+		m68ki_jit_drop_lazy_flags();
+		return M68KI_JIT_REGISTERS;
+	}
+
+	switch(ir & 0xf1f8)
+	{
+		case 0x4080:                        /* tst.l Dy */
+			if(rx != 5)
+				return M68KI_JIT_HANDLER;
+			m68ki_jit_load(X86_EAX, X86_EBX, DREG_OFS(ry));
+			m68ki_jit_logic_flags(4, -1);
+			return M68KI_JIT_REGISTERS;
+		case 0x8080:                        /* or.l Dy, Dx */
+		case 0xc080:                        /* and.l Dy, Dx */
+			m68ki_jit_load(X86_EAX, X86_EBX, DREG_OFS(rx));
+			m68ki_jit_load(X86_ECX, X86_EBX, DREG_OFS(ry));
+			if(ir & 0x4000)
+				m68ki_jit_and(X86_EAX, X86_ECX);
+			else
+				m68ki_jit_or(X86_EAX, X86_ECX);
+			m68ki_jit_logic_flags(4, rx);
+			return M68KI_JIT_REGISTERS;
+		case 0xb180:                        /* eor.l Dx, Dy */
+			m68ki_jit_load(X86_EAX, X86_EBX, DREG_OFS(ry));
+			m68ki_jit_load(X86_ECX, X86_EBX, DREG_OFS(rx));
+			m68ki_jit_xor(X86_EAX, X86_ECX);
+			m68ki_jit_logic_flags(4, ry);
+			return M68KI_JIT_REGISTERS;
+		case 0x5080:                        /* addq.l #q, Dy */
+		case 0x5180:                        /* subq.l #q, Dy */
+			m68ki_jit_mov_imm(X86_ECX, quick);
+			m68ki_jit_load(X86_EDX, X86_EBX, DREG_OFS(ry));
+			m68ki_jit_arith(4, ir & 0x0100, 1, ry);
+			return M68KI_JIT_REGISTERS;
+	}
+
+	switch(ir >> 12)
+	{
+		case 0x1:                           /* move <ea>, <ea> */
+		case 0x2:
+		case 0x3:
+			native = m68ki_jit_move(ir);
+			break;
+		case 0x4:                           /* lea (Ay)/d16(Ay), Ax */
+			if((ir & 0x01c0) != 0x01c0 || (((ir >> 3) & 7) != 2 && ((ir >> 3) & 7) != 5))
+				return M68KI_JIT_HANDLER;
+			m68ki_jit_ea(4, (ir >> 3) & 7, ry);
+			m68ki_jit_store(X86_EBX, DREG_OFS(8 + rx), X86_EDI);
+			break;
+		case 0x9:                           /* sub <ea>, Dn */
+		case 0xb:                           /* cmp <ea>, Dn */
+		case 0xd:                           /* add <ea>, Dn */
+			if(((ir >> 6) & 7) > 2)
+				return M68KI_JIT_HANDLER;
+			native = m68ki_jit_add_sub(ir);
+			break;
+		default:
+			return M68KI_JIT_HANDLER;
+	}
+
+	/* The handler would leave the PC after the extension words */
+	if(native)
+		m68ki_jit_sync_pc();
+	return native;
+}
+
+
+/* ======================================================================== */
+/* ============================== TRANSLATION ============================= */
+/* ======================================================================== */
+
+#if M68K_EMULATE_TRACE
+/* Everything the replay loop does after an instruction */
+static void m68ki_jit_end_instr(void)
+{
+	m68ki_exception_if_trace();
+}
+#endif /* M68K_EMULATE_TRACE */
+
+/* Forget all translations */
+static void m68ki_jit_forget(void)
+{
+	unsigned i;
+
+	for(i = 0; i < M68K_BLOCK_CACHE_BLOCKS; i++)
+	{
+		m68ki_block_cache[i].jit = NULL;
+		m68ki_block_cache[i].hits = 0;
+	}
+	m68ki_jit_used = 0;
+}
+
+/* Make the code buffer writable or executable.  The host won't give us
+ * executable memory if this fails, so stay in the interpreter.
+ */
+static int m68ki_jit_protect(int prot)
+{
+	if(mprotect(m68ki_jit_code, M68K_JIT_CODE_SIZE, prot) == 0)
+		return 1;
+	m68ki_jit_forget();
+	m68ki_jit_enabled = 0;
+	return 0;
+}
+
+/* Forget all translations, and get the code buffer if we don't have one */
+static void m68ki_jit_reset(void)
+{
+	m68ki_jit_forget();
+
+	if(!m68ki_jit_code)
+	{
+		void* code = mmap(NULL, M68K_JIT_CODE_SIZE, PROT_READ | PROT_WRITE,
+						MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(code == MAP_FAILED)
+			m68ki_jit_enabled = 0;
+		else
+			m68ki_jit_code = code;
+	}
+}
+
+/* Check everything m68ki_block_cache_replay() checks between instructions */
+static void m68ki_jit_emit_continue(unsigned next_pc)
+{
+	m68ki_jit_cmp_imm(X86_EBX, CPU_OFS(pc), next_pc);
+	m68ki_jit_exit_if(X86_CC_NE);
+	m68ki_jit_cmp_imm(X86_R13, BLOCK_OFS(valid), 0);
+	m68ki_jit_exit_if(X86_CC_E);
+#if M68KI_EMULATE_FC
+	m68ki_jit_load(X86_EAX, X86_EBX, CPU_OFS(s_flag));
+	m68ki_jit_alu_imm(X86_OR, X86_EAX, FUNCTION_CODE_USER_PROGRAM);
+	m68ki_jit_op_mem(0x3b, X86_EAX, X86_R13, BLOCK_OFS(fc));
+	m68ki_jit_exit_if(X86_CC_NE);
+#endif /* M68KI_EMULATE_FC */
+	m68ki_jit_cmp_imm(X86_R12, 0, 0);
+	m68ki_jit_exit_if(X86_CC_LE);
+}
+
+/* Translate a block */
+static void m68ki_jit_compile(m68ki_block_cache_block* block)
+{
+	const m68ki_block_cache_instr* instr;
+	m68ki_jit_pointer entry;
+	uint8_t* top;
+	unsigned i;
+
+	if(!m68ki_jit_code || m68ki_jit_used + M68KI_JIT_BLOCK_BYTES > M68K_JIT_CODE_SIZE)
+	{
+		m68ki_jit_reset();
+		if(!m68ki_jit_enabled)
+			return;
+	}
+	if(!m68ki_jit_protect(PROT_READ | PROT_WRITE))
+		return;
+
+	entry.data = m68ki_jit_ptr = m68ki_jit_code + m68ki_jit_used;
+	m68ki_jit_exit_count = 0;
+	m68ki_jit_block = block;
+
+	/* push rbx; push r12; push r13; push r14; push r15 (which also aligns
+	 * the stack for calls)
+	 */
+	m68ki_jit_bytes("\x53\x41\x54\x41\x55\x41\x56\x41\x57", 9);
+	m68ki_jit_mov_imm64(X86_EBX, (uintptr_t)&m68ki_cpu);
+	m68ki_jit_mov_imm64(X86_R12, (uintptr_t)&m68ki_remaining_cycles);
+	m68ki_jit_mov_imm64(X86_R13, (uintptr_t)block);
+	top = m68ki_jit_ptr;
+
+	for(i = 0, instr = block->instr; i < block->count; i++, instr++)
+	{
+		int native;
+
+#if M68K_EMULATE_TRACE || M68KI_EMULATE_FC || M68K_INSTRUCTION_HOOK
+		/* mov rdi, instr */
+		m68ki_jit_mov_imm64(X86_EDI, (uintptr_t)instr);
+		m68ki_jit_call((void (*)(void))m68ki_block_cache_start_instr);
+		m68ki_jit_test(X86_EAX, X86_EAX);
+		m68ki_jit_exit_if(X86_CC_NE);
+#else
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(ppc), instr->pc);
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(dar_save_mask), 0);
+#endif /* M68K_EMULATE_TRACE || M68KI_EMULATE_FC || M68K_INSTRUCTION_HOOK */
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(ir), instr->ir);
+		m68ki_jit_store_imm(X86_EBX, CPU_OFS(pc), instr->pc + 2);
+
+		native = m68ki_jit_native(instr);
+		if(!native)
+		{
+			m68ki_jit_call(instr->handler);
+			m68ki_jit_fault_check();
+		}
+		if(instr->cycles)
+			m68ki_jit_sub_imm(X86_R12, 0, instr->cycles);
+
+#if M68K_EMULATE_TRACE
+		m68ki_jit_call(m68ki_jit_end_instr);
+		native = M68KI_JIT_HANDLER; /* A trace exception can go anywhere */
+#endif /* M68K_EMULATE_TRACE */
+
+		if(i + 1 == block->count)
+			break;
+		if(native == M68KI_JIT_REGISTERS)
+		{
+			m68ki_jit_cmp_imm(X86_R12, 0, 0);
+			m68ki_jit_exit_if(X86_CC_LE);
+		}
+		else
+			m68ki_jit_emit_continue(instr[1].pc);
+	}
+
+	/* Go round again if the block branched back to itself and
+	 * m68k_execute() would run it next.
+	 */
+	m68ki_jit_emit_continue(block->pc);
+	m68ki_jit_cmp_imm(X86_EBX, CPU_OFS(pmmu_enabled), 0);
+	m68ki_jit_exit_if(X86_CC_NE);
+	m68ki_jit_load(X86_EAX, X86_EBX, CPU_OFS(s_flag));
+	m68ki_jit_alu_imm(X86_OR, X86_EAX, FUNCTION_CODE_USER_PROGRAM);
+	m68ki_jit_op_mem(0x3b, X86_EAX, X86_R13, BLOCK_OFS(fc));
+	m68ki_jit_exit_if(X86_CC_NE);
+	m68ki_jit_mov_imm64(X86_EAX, (uintptr_t)&m68ki_jit_enabled);
+	m68ki_jit_cmp_imm(X86_EAX, 0, 0);
+	m68ki_jit_exit_if(X86_CC_E);
+	m68ki_jit_byte(0xe9);
+	m68ki_jit_u32((unsigned)(top - (m68ki_jit_ptr + 4)));
+
+	/* Every exit ends up here */
+	for(i = 0; i < m68ki_jit_exit_count; i++)
+		m68ki_jit_land(m68ki_jit_exits[i]);
+
+	/* pop r15; pop r14; pop r13; pop r12; pop rbx; ret */
+	m68ki_jit_bytes("\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5b\xc3", 10);
+
+	if(!m68ki_jit_protect(PROT_READ | PROT_EXEC))
+		return;
+	m68ki_jit_used = m68ki_jit_ptr - m68ki_jit_code;
+	block->jit = entry.code;
+}
+
+/* Run a translated block */
+static void m68ki_jit_run(m68ki_block_cache_block* block)
+{
+	/* Immediate reads come from the cached words, as when replaying */
+	m68ki_block_cache_fetch_pc = block->pc;
+	m68ki_block_cache_fetch_words = block->words;
+	m68ki_block_cache_fetch_length = block->length;
+
+	block->jit();
+
+	m68ki_block_cache_fetch_length = 0;
+}
+
+#endif /* M68K_JIT */
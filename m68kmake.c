@@ -39,10 +39,13 @@
  * It requires an input file to function (default m68k_in.c), but you can
  * specify your own like so:
  *
- * m68kmake <output path> <input file>
+ * m68kmake <output path> <input file> <fused opcode list>
  *
- * where output path is the path where the output files should be placed, and
- * input file is the file to use for input.
+ * where output path is the path where the output files should be placed,
+ * input file is the file to use for input, and fused opcode list is a file
+ * to use instead of the M68KMAKE_FUSED_OPCODES section of the input file.
+ * It holds one pair of opcode handler names per line, and can be made from an
+ * execution profile of the opcodes the guest runs most often in a row.
  *
  * If you modify the input file greatly from its released form, you may have
  * to tweak the configuration section a bit since I'm using static allocation
@@ -80,13 +83,17 @@ static const char g_version[] = "4.60";
 #define MAX_LINE_LENGTH                 200	/* length of 1 line */
 #define MAX_BODY_LENGTH                 300	/* Number of lines in 1 function */
 #define MAX_REPLACE_LENGTH               30	/* Max number of replace strings */
-#define MAX_INSERT_LENGTH              5000	/* Max size of insert piece */
+#define MAX_INSERT_LENGTH              8000	/* Max size of insert piece */
 #define MAX_NAME_LENGTH                  30	/* Max length of ophandler name */
 #define MAX_SPEC_PROC_LENGTH              4	/* Max length of special processing str */
 #define MAX_SPEC_EA_LENGTH                5	/* Max length of specified EA str */
 #define EA_ALLOWED_LENGTH                11	/* Max length of ea allowed str */
 #define MAX_OPCODE_INPUT_TABLE_LENGTH  1000	/* Max length of opcode handler tbl */
 #define MAX_OPCODE_OUTPUT_TABLE_LENGTH 3000	/* Max length of opcode handler tbl */
+#define MAX_FUSED_OPCODE_TABLE_LENGTH   200	/* Max number of fused handlers */
+#define MAX_FLAGLESS_OPCODE_TABLE_LENGTH 200	/* Max number of flagless handlers */
+#define MAX_FLAGS_UNUSED_TABLE_LENGTH   100	/* Max number of handlers that leave the flags alone */
+#define MAX_THREADED_OPCODE_TABLE_LENGTH 400	/* Max number of threaded handlers */
 
 /* Default filenames */
 #define FILENAME_INPUT      "m68k_in.c"
@@ -105,6 +112,14 @@ static const char g_version[] = "4.60";
 #define ID_TABLE_FOOTER         ID_BASE "_TABLE_FOOTER"
 #define ID_TABLE_BODY           ID_BASE "_TABLE_BODY"
 #define ID_TABLE_START          ID_BASE "_TABLE_START"
+#define ID_FUSED_OPCODES        ID_BASE "_FUSED_OPCODES"
+#define ID_FUSED_OPCODES_START  ID_BASE "_FUSED_OPCODES_START"
+#define ID_FLAGLESS_OPCODES     ID_BASE "_FLAGLESS_OPCODES"
+#define ID_FLAGLESS_OPCODES_START ID_BASE "_FLAGLESS_OPCODES_START"
+#define ID_FLAGS_UNUSED_OPCODES ID_BASE "_FLAGS_UNUSED_OPCODES"
+#define ID_FLAGS_UNUSED_OPCODES_START ID_BASE "_FLAGS_UNUSED_OPCODES_START"
+#define ID_THREADED_OPCODES     ID_BASE "_THREADED_OPCODES"
+#define ID_THREADED_OPCODES_START ID_BASE "_THREADED_OPCODES_START"
 #define ID_OPHANDLER_HEADER     ID_BASE "_OPCODE_HANDLER_HEADER"
 #define ID_OPHANDLER_FOOTER     ID_BASE "_OPCODE_HANDLER_FOOTER"
 #define ID_OPHANDLER_BODY       ID_BASE "_OPCODE_HANDLER_BODY"
@@ -208,6 +223,33 @@ typedef struct
 } body_struct;
 
 
+/* A pair of opcode handlers to fuse into one */
+typedef struct
+{
+	char first[MAX_NAME_LENGTH];          /* handler of the first instruction */
+	char second[MAX_NAME_LENGTH];         /* handler of the instruction after it */
+	char* first_body;                     /* their function bodies, once generated */
+	char* second_body;
+} fused_opcode_struct;
+
+
+/* An opcode handler to make a version of that doesn't set N, Z, V and C, or
+ * one that leaves them alone
+ */
+typedef struct
+{
+	char name[MAX_NAME_LENGTH];           /* opcode handler */
+	char* body;                           /* its function body, once generated */
+} flagless_opcode_struct;
+
+
+/* An opcode handler that gets its own dispatch jump in threaded dispatch */
+typedef struct
+{
+	char name[MAX_NAME_LENGTH];           /* opcode handler */
+} threaded_opcode_struct;
+
+
 /* Holds a sequence of search / replace strings */
 typedef struct
 {
@@ -230,6 +272,7 @@ opcode_struct* find_opcode(char* name, int size, char* spec_proc, char* spec_ea)
 opcode_struct* find_illegal_opcode(void);
 int extract_opcode_info(char* src, char* name, int* size, char* spec_proc, char* spec_ea);
 void add_replace_string(replace_struct* replace, char* search_str, char* replace_str);
+int body_uses_flags(body_struct* body);
 void write_body(FILE* filep, body_struct* body, replace_struct* replace);
 void get_base_name(char* base_name, opcode_struct* op);
 void write_function_name(FILE* filep, char* base_name);
@@ -242,6 +285,22 @@ void generate_opcode_handler(FILE* filep, body_struct* body, replace_struct* rep
 void generate_opcode_ea_variants(FILE* filep, body_struct* body, replace_struct* replace, opcode_struct* op);
 void generate_opcode_cc_variants(FILE* filep, body_struct* body, replace_struct* replace, opcode_struct* op_in, int offset);
 void process_opcode_handlers(FILE* filep);
+opcode_struct* find_output_opcode(char* name);
+char* get_body(body_struct* body, replace_struct* replace);
+void read_fused_opcodes(FILE* file);
+void keep_fused_bodies(body_struct* body, replace_struct* replace, char* base_name);
+void write_fused_handlers(FILE* filep);
+void write_fused_table(FILE* filep);
+void read_flagless_opcodes(FILE* file);
+void keep_flagless_body(body_struct* body, replace_struct* replace, char* base_name);
+void write_flagless_handlers(FILE* filep);
+void write_flagless_table(FILE* filep);
+void read_flags_unused_opcodes(FILE* file);
+void keep_flags_unused_body(body_struct* body, replace_struct* replace, char* base_name);
+void write_flags_unused_table(FILE* filep);
+void read_threaded_opcodes(FILE* file);
+int is_threaded_opcode(char* name);
+void write_threaded_dispatcher(FILE* filep);
 void populate_table(void);
 void read_insert(char* insert);
 
@@ -254,6 +313,9 @@ void read_insert(char* insert);
 /* Name of the input file */
 char g_input_filename[M68K_MAX_PATH] = FILENAME_INPUT;
 
+/* Name of the fused opcode list, if it isn't in the input file */
+char g_fused_filename[M68K_MAX_PATH] = "";
+
 /* File handles */
 FILE* g_input_file = NULL;
 FILE* g_prototype_file = NULL;
@@ -269,6 +331,22 @@ opcode_struct g_opcode_input_table[MAX_OPCODE_INPUT_TABLE_LENGTH];
 opcode_struct g_opcode_output_table[MAX_OPCODE_OUTPUT_TABLE_LENGTH];
 int g_opcode_output_table_length = 0;
 
+/* Pairs of opcode handlers to fuse */
+fused_opcode_struct g_fused_opcode_table[MAX_FUSED_OPCODE_TABLE_LENGTH];
+int g_fused_opcode_table_length = 0;
+
+/* Opcode handlers to make flagless versions of */
+flagless_opcode_struct g_flagless_opcode_table[MAX_FLAGLESS_OPCODE_TABLE_LENGTH];
+int g_flagless_opcode_table_length = 0;
+
+/* Opcode handlers that neither use nor set N, Z, V and C */
+flagless_opcode_struct g_flags_unused_opcode_table[MAX_FLAGS_UNUSED_TABLE_LENGTH];
+int g_flags_unused_opcode_table_length = 0;
+
+/* Opcode handlers to give their own dispatch jump */
+threaded_opcode_struct g_threaded_opcode_table[MAX_THREADED_OPCODE_TABLE_LENGTH];
+int g_threaded_opcode_table_length = 0;
+
 const ea_info_struct g_ea_info_table[13] =
 {/* fname    ea        mask  match */
 	{"",     "",       0x00, 0x00}, /* EA_MODE_NONE */
@@ -730,7 +808,38 @@ void add_replace_string(replace_struct* replace, char* search_str, char* replace
 	strcpy(replace->replace[replace->length++][1], replace_str);
 }
 
-/* Write a function body while replacing any selected strings */
+/* Check if a function body looks at N, Z, V or C, or changes only some of
+ * them.  Names ending in _ are prefixes, the others must be whole names
+ * (so VFLAG_CLEAR isn't taken for FLAG_C).
+ */
+int body_uses_flags(body_struct* body)
+{
+	static const char* names[] = {"FLAG_N", "FLAG_Z", "FLAG_V", "FLAG_C", "COND_", ID_OPHANDLER_CC, ID_OPHANDLER_NOT_CC};
+	int i;
+	unsigned j;
+	size_t length;
+	char* ptr;
+
+	for(i=0;i<body->length;i++)
+		for(j=0;j<sizeof(names)/sizeof(*names);j++)
+		{
+			length = strlen(names[j]);
+			for(ptr = strstr(body->body[i], names[j]);ptr != NULL;ptr = strstr(ptr+1, names[j]))
+			{
+				if(ptr > body->body[i] && (isalnum((unsigned char)ptr[-1]) || ptr[-1] == '_'))
+					continue;
+				if(names[j][length-1] != '_' && (isalnum((unsigned char)ptr[length]) || ptr[length] == '_'))
+					continue;
+				return 1;
+			}
+		}
+	return 0;
+}
+
+/* Write a function body while replacing any selected strings.
+ * If the body uses the flags, it starts by making them current in case the
+ * last instruction left them to be worked out later (see M68K_LAZY_FLAGS).
+ */
 void write_body(FILE* filep, body_struct* body, replace_struct* replace)
 {
 	int i;
@@ -739,6 +848,7 @@ void write_body(FILE* filep, body_struct* body, replace_struct* replace)
 	char output[MAX_LINE_LENGTH+1];
 	char temp_buff[MAX_LINE_LENGTH+1];
 	int found;
+	int sync = body_uses_flags(body);
 
 	for(i=0;i<body->length;i++)
 	{
@@ -765,6 +875,8 @@ void write_body(FILE* filep, body_struct* body, replace_struct* replace)
 				error_exit("Unknown " ID_BASE " directive [%s]", output);
 		}
 		fprintf(filep, "%s\n", output);
+		if(i == 0 && sync && strcmp(output, "{") == 0)
+			fprintf(filep, "\tm68ki_lazy_flags_sync();\n");
 	}
 	fprintf(filep, "\n\n");
 }
@@ -784,7 +896,10 @@ void get_base_name(char* base_name, opcode_struct* op)
 /* Write the name of an opcode handler function */
 void write_function_name(FILE* filep, char* base_name)
 {
-	fprintf(filep, "static void %s(void)\n", base_name);
+	if(is_threaded_opcode(base_name))
+		fprintf(filep, "static M68KI_THREADED_INLINE void M68KI_OP(%s)(void)\n", base_name);
+	else
+		fprintf(filep, "static void M68KI_OP(%s)(void)\n", base_name);
 }
 
 void add_opcode_output_table_entry(opcode_struct* op, char* name)
@@ -829,8 +944,8 @@ void write_table_entry(FILE* filep, opcode_struct* op)
 {
 	int i;
 
-	fprintf(filep, "\t{%-28s, 0x%04x, 0x%04x, {",
-		op->name, op->op_mask, op->op_match);
+	fprintf(filep, "\t{M68KI_OP_HANDLER(%s),%*s 0x%04x, 0x%04x, {",
+		op->name, strlen(op->name) < 28 ? (int)(28 - strlen(op->name)) : 0, "", op->op_mask, op->op_match);
 
 	for(i=0;i<NUM_CPUS;i++)
 	{
@@ -862,13 +977,14 @@ void set_opcode_struct(opcode_struct* src, opcode_struct* dst, int ea_mode)
 void generate_opcode_handler(FILE* filep, body_struct* body, replace_struct* replace, opcode_struct* opinfo, int ea_mode)
 {
 	char str[MAX_LINE_LENGTH+1];
+	char base_name[MAX_LINE_LENGTH+1];
 	opcode_struct* op = malloc(sizeof(opcode_struct));
 
 	/* Set the opcode structure and write the tables, prototypes, etc */
 	set_opcode_struct(opinfo, op, ea_mode);
-	get_base_name(str, op);
-	add_opcode_output_table_entry(op, str);
-	write_function_name(filep, str);
+	get_base_name(base_name, op);
+	add_opcode_output_table_entry(op, base_name);
+	write_function_name(filep, base_name);
 
 	/* Add any replace strings needed */
 	if(ea_mode != EA_MODE_NONE)
@@ -889,6 +1005,9 @@ void generate_opcode_handler(FILE* filep, body_struct* body, replace_struct* rep
 
 	/* Now write the function body with the selected replace strings */
 	write_body(filep, body, replace);
+	keep_fused_bodies(body, replace, base_name);
+	keep_flagless_body(body, replace, base_name);
+	keep_flags_unused_body(body, replace, base_name);
 	g_num_functions++;
 	free(op);
 }
@@ -1057,6 +1176,412 @@ void process_opcode_handlers(FILE* filep)
 }
 
 
+/* Find an opcode handler that has been generated */
+opcode_struct* find_output_opcode(char* name)
+{
+	int i;
+
+	for(i=0;i<g_opcode_output_table_length;i++)
+		if(strcmp(g_opcode_output_table[i].name, name) == 0)
+			return g_opcode_output_table + i;
+	return NULL;
+}
+
+/* Get a function body with any selected strings replaced */
+char* get_body(body_struct* body, replace_struct* replace)
+{
+	FILE* filep = tmpfile();
+	char* text;
+	long length;
+
+	if(filep == NULL)
+		perror_exit("Unable to create temporary file");
+	write_body(filep, body, replace);
+	length = ftell(filep);
+	rewind(filep);
+
+	if((text = malloc(length + 1)) == NULL)
+		error_exit("Out of memory");
+	length = fread(text, 1, length, filep);
+	fclose(filep);
+
+	/* Drop the blank lines write_body() puts after the closing brace */
+	while(length > 0 && text[length-1] == '\n')
+		length--;
+	text[length] = 0;
+	return text;
+}
+
+/* Read pairs of opcode handler names until an input separator or EOF */
+void read_fused_opcodes(FILE* file)
+{
+	char buff[MAX_LINE_LENGTH+1];
+	char first[MAX_LINE_LENGTH+1];
+	char second[MAX_LINE_LENGTH+1];
+	fused_opcode_struct* fused;
+
+	while(fgetline(buff, MAX_LINE_LENGTH, file) >= 0)
+	{
+		if(strcmp(buff, ID_INPUT_SEPARATOR) == 0)
+			break;
+		if(buff[skip_spaces(buff)] == 0)
+			continue;
+
+		if(sscanf(buff, "%s %s", first, second) != 2)
+			error_exit("Malformed fused opcode pair [%s]", buff);
+		if(strlen(first) + 8 >= MAX_NAME_LENGTH || strlen(second) + 8 >= MAX_NAME_LENGTH)
+			error_exit("Opcode handler name too long [%s]", buff);
+		if(g_fused_opcode_table_length >= MAX_FUSED_OPCODE_TABLE_LENGTH)
+			error_exit("Fused opcode table overflow");
+
+		/* Handlers are named as in the generated code, less the m68k_op_ */
+		fused = g_fused_opcode_table + g_fused_opcode_table_length++;
+		sprintf(fused->first, "m68k_op_%s", first);
+		sprintf(fused->second, "m68k_op_%s", second);
+	}
+}
+
+/* Keep the body of an opcode handler if it is part of a fused pair */
+void keep_fused_bodies(body_struct* body, replace_struct* replace, char* base_name)
+{
+	fused_opcode_struct* fused;
+
+	for(fused = g_fused_opcode_table;fused < g_fused_opcode_table + g_fused_opcode_table_length;fused++)
+	{
+		if(strcmp(fused->first, base_name) == 0)
+			fused->first_body = get_body(body, replace);
+		if(strcmp(fused->second, base_name) == 0)
+			fused->second_body = get_body(body, replace);
+	}
+}
+
+/* Write a body inside of another function, indented by one level */
+static void write_inner_body(FILE* filep, char* text)
+{
+	char* line;
+
+	for(line = strtok(text, "\n");line != NULL;line = strtok(NULL, "\n"))
+		fprintf(filep, "\t%s\n", line);
+}
+
+/* Write a handler for each pair of opcode handlers that runs them both.
+ * The second body only runs if m68ki_fused_next() says so, which also covers
+ * a return from the middle of the first one.
+ */
+void write_fused_handlers(FILE* filep)
+{
+	fused_opcode_struct* fused;
+	opcode_struct* op;
+
+	if(g_fused_opcode_table_length == 0)
+		return;
+
+	fprintf(filep, "#if M68K_FUSED_OPCODES\n");
+	for(fused = g_fused_opcode_table;fused < g_fused_opcode_table + g_fused_opcode_table_length;fused++)
+	{
+		op = find_output_opcode(fused->first);
+		if(op == NULL)
+			error_exit("Unknown opcode handler in fused pair: %s", fused->first);
+		/* A privileged instruction could change the address space under us */
+		if(memchr(op->cpu_mode, 'S', NUM_CPUS) != NULL)
+			error_exit("Fused pair begins with a privileged instruction: %s", fused->first);
+		if(find_output_opcode(fused->second) == NULL)
+			error_exit("Unknown opcode handler in fused pair: %s", fused->second);
+
+		fprintf(filep, "static void M68KI_OP(m68k_fused_%s__%s)(void)\n{\n", fused->first+8, fused->second+8);
+		write_inner_body(filep, fused->first_body);
+		fprintf(filep, "\tif(!m68ki_fused_next())\n\t\treturn;\n");
+		write_inner_body(filep, fused->second_body);
+		fprintf(filep, "}\n\n\n");
+		g_num_functions++;
+	}
+	fprintf(filep, "#endif /* M68K_FUSED_OPCODES */\n\n\n");
+}
+
+/* Write the table the block cache looks fused handlers up in */
+void write_fused_table(FILE* filep)
+{
+	fused_opcode_struct* fused;
+
+	fprintf(filep, "#if M68K_FUSED_OPCODES\n");
+	fprintf(filep, "static const m68ki_fused_handler_struct m68ki_fused_handler_table[] =\n{\n");
+	for(fused = g_fused_opcode_table;fused < g_fused_opcode_table + g_fused_opcode_table_length;fused++)
+		fprintf(filep, "\t{M68KI_OP_HANDLER(%s), M68KI_OP_HANDLER(%s), M68KI_OP_HANDLER(m68k_fused_%s__%s)},\n",
+			fused->first, fused->second, fused->first+8, fused->second+8);
+	fprintf(filep, "\t{M68KI_NO_FUSED_HANDLER, M68KI_NO_FUSED_HANDLER, M68KI_NO_FUSED_HANDLER}\n};\n");
+	fprintf(filep, "#endif /* M68K_FUSED_OPCODES */\n\n\n");
+}
+
+/* Read opcode handler names until an input separator */
+void read_flagless_opcodes(FILE* file)
+{
+	char buff[MAX_LINE_LENGTH+1];
+	char name[MAX_LINE_LENGTH+1];
+	flagless_opcode_struct* flagless;
+	char* ptr;
+	int length;
+
+	while(fgetline(buff, MAX_LINE_LENGTH, file) >= 0)
+	{
+		if(strcmp(buff, ID_INPUT_SEPARATOR) == 0)
+			return;
+
+		for(ptr = buff;sscanf(ptr, "%s%n", name, &length) == 1;ptr += length)
+		{
+			if(strlen(name) + 8 >= MAX_NAME_LENGTH)
+				error_exit("Opcode handler name too long [%s]", name);
+			if(g_flagless_opcode_table_length >= MAX_FLAGLESS_OPCODE_TABLE_LENGTH)
+				error_exit("Flagless opcode table overflow");
+
+			flagless = g_flagless_opcode_table + g_flagless_opcode_table_length++;
+			sprintf(flagless->name, "m68k_op_%s", name);
+		}
+	}
+	error_exit("Premature EOF while reading flagless opcodes");
+}
+
+/* Keep the body of an opcode handler if it is to have a flagless version */
+void keep_flagless_body(body_struct* body, replace_struct* replace, char* base_name)
+{
+	flagless_opcode_struct* flagless;
+
+	for(flagless = g_flagless_opcode_table;flagless < g_flagless_opcode_table + g_flagless_opcode_table_length;flagless++)
+		if(strcmp(flagless->name, base_name) == 0)
+			flagless->body = get_body(body, replace);
+}
+
+/* Turn the m68ki_set_*_flags_* calls in a body into m68ki_skip_*_flags_*.
+ * Returns the number of calls changed.
+ */
+static int skip_flags(char* dst, char* src)
+{
+	static const char* const kinds[] = {"logic", "add", "sub", "cmp"};
+	char set[MAX_LINE_LENGTH+1];
+	int count = 0;
+	int i;
+
+	while(*src)
+	{
+		for(i = 0;i < (int)(sizeof(kinds)/sizeof(*kinds));i++)
+		{
+			sprintf(set, "m68ki_set_%s_flags_", kinds[i]);
+			if(strncmp(src, set, strlen(set)) == 0)
+				break;
+		}
+		if(i < (int)(sizeof(kinds)/sizeof(*kinds)))
+		{
+			dst += sprintf(dst, "m68ki_skip_%s_flags_", kinds[i]);
+			src += strlen(set);
+			count++;
+		}
+		else
+			*dst++ = *src++;
+	}
+	*dst = 0;
+	return count;
+}
+
+/* Write a version of each listed opcode handler that leaves N, Z, V and C
+ * alone.  The block cache only uses it when the next instruction sets them.
+ */
+void write_flagless_handlers(FILE* filep)
+{
+	flagless_opcode_struct* flagless;
+	char* text;
+
+	if(g_flagless_opcode_table_length == 0)
+		return;
+
+	fprintf(filep, "#if M68K_FLAGLESS_OPCODES\n");
+	for(flagless = g_flagless_opcode_table;flagless < g_flagless_opcode_table + g_flagless_opcode_table_length;flagless++)
+	{
+		if(find_output_opcode(flagless->name) == NULL)
+			error_exit("Unknown flagless opcode handler: %s", flagless->name);
+		/* write_body() syncs the flags in handlers that use them */
+		if(strstr(flagless->body, "m68ki_lazy_flags_sync") != NULL)
+			error_exit("Flagless opcode handler uses the flags: %s", flagless->name);
+
+		if((text = malloc(strlen(flagless->body) * 2 + 1)) == NULL)
+			error_exit("Out of memory");
+		if(skip_flags(text, flagless->body) == 0)
+			error_exit("Flagless opcode handler doesn't set the flags: %s", flagless->name);
+
+		fprintf(filep, "static void M68KI_OP(m68k_flagless_%s)(void)\n%s\n\n\n", flagless->name+8, text);
+		free(text);
+		g_num_functions++;
+	}
+	fprintf(filep, "#endif /* M68K_FLAGLESS_OPCODES */\n\n\n");
+}
+
+/* Write the table the block cache looks flagless handlers up in */
+void write_flagless_table(FILE* filep)
+{
+	flagless_opcode_struct* flagless;
+
+	fprintf(filep, "#if M68K_FLAGLESS_OPCODES\n");
+	fprintf(filep, "static const m68ki_flagless_handler_struct m68ki_flagless_handler_table[] =\n{\n");
+	for(flagless = g_flagless_opcode_table;flagless < g_flagless_opcode_table + g_flagless_opcode_table_length;flagless++)
+		fprintf(filep, "\t{M68KI_OP_HANDLER(%s), M68KI_OP_HANDLER(m68k_flagless_%s)},\n",
+			flagless->name, flagless->name+8);
+	fprintf(filep, "\t{M68KI_NO_FLAGLESS_HANDLER, M68KI_NO_FLAGLESS_HANDLER}\n};\n");
+	fprintf(filep, "#endif /* M68K_FLAGLESS_OPCODES */\n\n\n");
+}
+
+/* Read opcode handler names until an input separator */
+void read_flags_unused_opcodes(FILE* file)
+{
+	char buff[MAX_LINE_LENGTH+1];
+	char name[MAX_LINE_LENGTH+1];
+	flagless_opcode_struct* unused;
+	char* ptr;
+	int length;
+
+	while(fgetline(buff, MAX_LINE_LENGTH, file) >= 0)
+	{
+		if(strcmp(buff, ID_INPUT_SEPARATOR) == 0)
+			return;
+
+		for(ptr = buff;sscanf(ptr, "%s%n", name, &length) == 1;ptr += length)
+		{
+			if(strlen(name) + 8 >= MAX_NAME_LENGTH)
+				error_exit("Opcode handler name too long [%s]", name);
+			if(g_flags_unused_opcode_table_length >= MAX_FLAGS_UNUSED_TABLE_LENGTH)
+				error_exit("Flags unused opcode table overflow");
+
+			unused = g_flags_unused_opcode_table + g_flags_unused_opcode_table_length++;
+			sprintf(unused->name, "m68k_op_%s", name);
+		}
+	}
+	error_exit("Premature EOF while reading flags unused opcodes");
+}
+
+/* Keep the body of an opcode handler if it is listed as leaving the flags alone */
+void keep_flags_unused_body(body_struct* body, replace_struct* replace, char* base_name)
+{
+	flagless_opcode_struct* unused;
+
+	for(unused = g_flags_unused_opcode_table;unused < g_flags_unused_opcode_table + g_flags_unused_opcode_table_length;unused++)
+		if(strcmp(unused->name, base_name) == 0)
+			unused->body = get_body(body, replace);
+}
+
+/* Write the table the block cache looks handlers that leave the flags alone
+ * up in.  Their bodies are checked for anything that could use or set the
+ * flags, take an exception, access memory or take extra clocks.
+ */
+void write_flags_unused_table(FILE* filep)
+{
+	static const char* const banned[] =
+	{
+		"FLAG_", "COND_", "m68ki_lazy_flags", "m68ki_set_", "m68ki_get_sr",
+		"m68ki_read_", "m68ki_write_", "OPER_A", "OPER_P", "m68ki_exception",
+		"m68ki_trace", "USE_CYCLES"
+	};
+	flagless_opcode_struct* unused;
+	int i;
+
+	fprintf(filep, "#if M68K_FLAGLESS_OPCODES\n");
+	fprintf(filep, "static const m68ki_flags_unused_handler_struct m68ki_flags_unused_handler_table[] =\n{\n");
+	for(unused = g_flags_unused_opcode_table;unused < g_flags_unused_opcode_table + g_flags_unused_opcode_table_length;unused++)
+	{
+		if(find_output_opcode(unused->name) == NULL || unused->body == NULL)
+			error_exit("Unknown flags unused opcode handler: %s", unused->name);
+		for(i = 0;i < (int)(sizeof(banned)/sizeof(*banned));i++)
+			if(strstr(unused->body, banned[i]) != NULL)
+				error_exit("Flags unused opcode handler uses %s: %s", banned[i], unused->name);
+
+		fprintf(filep, "\t{M68KI_OP_HANDLER(%s)},\n", unused->name);
+	}
+	fprintf(filep, "\t{M68KI_NO_FLAGLESS_HANDLER}\n};\n");
+	fprintf(filep, "#endif /* M68K_FLAGLESS_OPCODES */\n\n\n");
+}
+
+/* Read opcode handler names until an input separator */
+void read_threaded_opcodes(FILE* file)
+{
+	char buff[MAX_LINE_LENGTH+1];
+	char name[MAX_LINE_LENGTH+1];
+	threaded_opcode_struct* threaded;
+	char* ptr;
+	int length;
+
+	while(fgetline(buff, MAX_LINE_LENGTH, file) >= 0)
+	{
+		if(strcmp(buff, ID_INPUT_SEPARATOR) == 0)
+			return;
+
+		for(ptr = buff;sscanf(ptr, "%s%n", name, &length) == 1;ptr += length)
+		{
+			if(strlen(name) + 8 >= MAX_NAME_LENGTH)
+				error_exit("Opcode handler name too long [%s]", name);
+			if(g_threaded_opcode_table_length >= MAX_THREADED_OPCODE_TABLE_LENGTH)
+				error_exit("Threaded opcode table overflow");
+
+			threaded = g_threaded_opcode_table + g_threaded_opcode_table_length++;
+			sprintf(threaded->name, "m68k_op_%s", name);
+		}
+	}
+	error_exit("Premature EOF while reading threaded opcodes");
+}
+
+/* Check if an opcode handler gets a dispatch jump of its own */
+int is_threaded_opcode(char* name)
+{
+	threaded_opcode_struct* threaded;
+
+	for(threaded = g_threaded_opcode_table;threaded < g_threaded_opcode_table + g_threaded_opcode_table_length;threaded++)
+		if(strcmp(threaded->name, name) == 0)
+			return 1;
+	return 0;
+}
+
+/* Write the threaded dispatcher.  Each listed opcode handler gets a label
+ * that calls it and then jumps straight to the label of the next opcode, so
+ * that every one of them has a dispatch branch of its own.  All other opcodes
+ * share a label that calls their handler through the jump table.
+ */
+void write_threaded_dispatcher(FILE* filep)
+{
+	threaded_opcode_struct* threaded;
+
+	fprintf(filep, "#if M68K_THREADED_DISPATCH\n");
+	fprintf(filep, "/* Labels as values and computed goto are GNU extensions */\n");
+	fprintf(filep, "#pragma GCC diagnostic push\n");
+	fprintf(filep, "#pragma GCC diagnostic ignored \"-Wpedantic\"\n\n");
+	fprintf(filep, "/* Run instructions until m68ki_threaded_next() says to stop */\n");
+	fprintf(filep, "void M68KI_OP(m68ki_threaded_execute)(void)\n{\n");
+	fprintf(filep, "\tstatic const m68ki_threaded_label_struct hot[] =\n\t{\n");
+	for(threaded = g_threaded_opcode_table;threaded < g_threaded_opcode_table + g_threaded_opcode_table_length;threaded++)
+	{
+		if(find_output_opcode(threaded->name) == NULL)
+			error_exit("Unknown threaded opcode handler: %s", threaded->name);
+		fprintf(filep, "\t\t{M68KI_OP(%s), &&%s},\n", threaded->name, threaded->name+8);
+	}
+	fprintf(filep, "\t\t{NULL, &&other}\n\t};\n");
+	fprintf(filep, "\tstatic const void* labels[0x10000];\n");
+	fprintf(filep, "\tconst m68ki_threaded_label_struct* h;\n");
+	fprintf(filep, "\tint i;\n\n");
+	fprintf(filep, "\t/* Point each opcode at the label of its handler */\n");
+	fprintf(filep, "\tif(labels[0] == NULL)\n");
+	fprintf(filep, "\t\tfor(i = 0;i < 0x10000;i++)\n\t\t{\n");
+	fprintf(filep, "\t\t\tfor(h = hot;h->handler && h->handler != m68ki_instruction_jump_table[i];h++)\n\t\t\t\t;\n");
+	fprintf(filep, "\t\t\tlabels[i] = h->label;\n\t\t}\n\n");
+	fprintf(filep, "\tm68ki_threaded_fetch();\n");
+	fprintf(filep, "\tgoto *labels[REG_IR];\n\n");
+	for(threaded = g_threaded_opcode_table;threaded < g_threaded_opcode_table + g_threaded_opcode_table_length;threaded++)
+	{
+		fprintf(filep, "%s:\n", threaded->name+8);
+		fprintf(filep, "\tM68KI_OP(%s)();\n", threaded->name);
+		fprintf(filep, "\tif(m68ki_threaded_next())\n\t\tgoto *labels[REG_IR];\n\treturn;\n\n");
+	}
+	fprintf(filep, "other:\n");
+	fprintf(filep, "\tm68ki_instruction_jump_table[REG_IR]();\n");
+	fprintf(filep, "\tif(m68ki_threaded_next())\n\t\tgoto *labels[REG_IR];\n");
+	fprintf(filep, "}\n\n");
+	fprintf(filep, "#pragma GCC diagnostic pop\n");
+	fprintf(filep, "#endif /* M68K_THREADED_DISPATCH */\n\n\n");
+}
+
 /* Populate the opcode handler table from the input file */
 void populate_table(void)
 {
@@ -1235,6 +1760,10 @@ int main(int argc, char **argv)
 	int ophandler_footer_read = 0;
 	int table_body_read = 0;
 	int ophandler_body_read = 0;
+	int fused_opcodes_read = 0;
+	int flagless_opcodes_read = 0;
+	int flags_unused_opcodes_read = 0;
+	int threaded_opcodes_read = 0;
 
 	printf("\n\tMusashi v%s 68000, 68008, 68010, 68EC020, 68020, 68EC030, 68030, 68EC040, 68040 emulator\n", g_version);
 	printf("\t\tCopyright Karl Stenerud (kstenerud@gmail.com)\n\n");
@@ -1251,6 +1780,8 @@ int main(int argc, char **argv)
 			strcat(output_path, "/");
 		if(argc > 2)
 			strcpy(g_input_filename, argv[2]);
+		if(argc > 3)
+			strcpy(g_fused_filename, argv[3]);
 	}
 
 
@@ -1266,6 +1797,17 @@ int main(int argc, char **argv)
 	if((g_input_file=fopen(g_input_filename, "rt")) == NULL)
 		perror_exit("can't open %s for input", g_input_filename);
 
+	/* A fused opcode list given on the command line replaces the built in one */
+	if(g_fused_filename[0])
+	{
+		FILE* fused_file;
+
+		if((fused_file=fopen(g_fused_filename, "rt")) == NULL)
+			perror_exit("can't open %s for input", g_fused_filename);
+		read_fused_opcodes(fused_file);
+		fclose(fused_file);
+	}
+
 
 	/* Get to the first section of the input file */
 	section_id[0] = 0;
@@ -1321,6 +1863,65 @@ int main(int argc, char **argv)
 			read_insert(ophandler_footer_insert);
 			ophandler_footer_read = 1;
 		}
+		else if(strcmp(section_id, ID_FUSED_OPCODES) == 0)
+		{
+			if(fused_opcodes_read)
+				error_exit("Duplicate fused opcode section");
+
+			/* Skip the description */
+			while(strcmp(section_id, ID_FUSED_OPCODES_START) != 0)
+				if(fgetline(section_id, MAX_LINE_LENGTH, g_input_file) < 0)
+					error_exit("Premature EOF while reading fused opcodes");
+
+			if(g_fused_filename[0])
+			{
+				while(strcmp(section_id, ID_INPUT_SEPARATOR) != 0)
+					if(fgetline(section_id, MAX_LINE_LENGTH, g_input_file) < 0)
+						error_exit("Premature EOF while reading fused opcodes");
+			}
+			else
+				read_fused_opcodes(g_input_file);
+			fused_opcodes_read = 1;
+		}
+		else if(strcmp(section_id, ID_FLAGLESS_OPCODES) == 0)
+		{
+			if(flagless_opcodes_read)
+				error_exit("Duplicate flagless opcode section");
+
+			/* Skip the description */
+			while(strcmp(section_id, ID_FLAGLESS_OPCODES_START) != 0)
+				if(fgetline(section_id, MAX_LINE_LENGTH, g_input_file) < 0)
+					error_exit("Premature EOF while reading flagless opcodes");
+
+			read_flagless_opcodes(g_input_file);
+			flagless_opcodes_read = 1;
+		}
+		else if(strcmp(section_id, ID_FLAGS_UNUSED_OPCODES) == 0)
+		{
+			if(flags_unused_opcodes_read)
+				error_exit("Duplicate flags unused opcode section");
+
+			/* Skip the description */
+			while(strcmp(section_id, ID_FLAGS_UNUSED_OPCODES_START) != 0)
+				if(fgetline(section_id, MAX_LINE_LENGTH, g_input_file) < 0)
+					error_exit("Premature EOF while reading flags unused opcodes");
+
+			read_flags_unused_opcodes(g_input_file);
+			flags_unused_opcodes_read = 1;
+		}
+		else if(strcmp(section_id, ID_THREADED_OPCODES) == 0)
+		{
+			if(threaded_opcodes_read)
+				error_exit("Duplicate threaded opcode section");
+
+			/* Skip the description */
+			while(strcmp(section_id, ID_THREADED_OPCODES_START) != 0)
+				if(fgetline(section_id, MAX_LINE_LENGTH, g_input_file) < 0)
+					error_exit("Premature EOF while reading threaded opcodes");
+
+			read_threaded_opcodes(g_input_file);
+			threaded_opcodes_read = 1;
+		}
 		else if(strcmp(section_id, ID_TABLE_BODY) == 0)
 		{
 			if(!prototype_header_read)
@@ -1352,7 +1953,13 @@ int main(int argc, char **argv)
 
 			fprintf(g_table_file, "%s\n\n", ophandler_header_insert);
 			process_opcode_handlers(g_table_file);
+			write_fused_handlers(g_table_file);
+			write_flagless_handlers(g_table_file);
+			write_threaded_dispatcher(g_table_file);
 			fprintf(g_table_file, "%s\n\n", ophandler_footer_insert);
+			write_fused_table(g_table_file);
+			write_flagless_table(g_table_file);
+			write_flags_unused_table(g_table_file);
 
 			ophandler_body_read = 1;
 		}
@@ -38,9 +38,10 @@
 */
 
 /*
-	pmmu_translate_addr: perform 68851/68030-style PMMU address translation
+	pmmu_walk: perform 68851/68030-style PMMU address translation, through the
+	supervisor root pointer's tables if supervisor is set and SRP is enabled
 */
-unsigned pmmu_translate_addr(unsigned addr_in)
+static unsigned pmmu_walk(unsigned addr_in, int supervisor)
 {
 	uint32_t addr_out, tbl_entry = 0, tbl_entry2, tamode = 0, tbmode = 0, tcmode = 0;
 	unsigned root_aptr, root_limit, tofs, is, abits, bbits, cbits;
@@ -50,7 +51,7 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 	addr_out = addr_in;
 
 	// if SRP is enabled and we're in supervisor mode, use it
-	if ((m68ki_cpu.mmu_tc & 0x02000000) && (m68ki_get_sr() & 0x2000))
+	if ((m68ki_cpu.mmu_tc & 0x02000000) && supervisor)
 	{
 		root_aptr = m68ki_cpu.mmu_srp_aptr;
 		root_limit = m68ki_cpu.mmu_srp_limit;
@@ -83,7 +84,7 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 		case 2:	// valid 4 byte descriptors
 			tofs *= 4;
 //			fprintf(stderr,"PMMU: reading table A entry at %08x\n", tofs + (root_aptr & 0xfffffffc));
-			tbl_entry = m68k_read_memory_32( tofs + (root_aptr & 0xfffffffc));
+			tbl_entry = m68ki_host_read_32(tofs + (root_aptr & 0xfffffffc), FUNCTION_CODE_SUPERVISOR_DATA);
 			tamode = tbl_entry & 3;
 //			fprintf(stderr,"PMMU: addr %08x entry %08x mode %x tofs %x\n", addr_in, tbl_entry, tamode, tofs);
 			break;
@@ -91,8 +92,8 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 		case 3: // valid 8 byte descriptors
 			tofs *= 8;
 //			fprintf(stderr,"PMMU: reading table A entries at %08x\n", tofs + (root_aptr & 0xfffffffc));
-			tbl_entry2 = m68k_read_memory_32( tofs + (root_aptr & 0xfffffffc));
-			tbl_entry = m68k_read_memory_32( tofs + (root_aptr & 0xfffffffc)+4);
+			tbl_entry2 = m68ki_host_read_32(tofs + (root_aptr & 0xfffffffc), FUNCTION_CODE_SUPERVISOR_DATA);
+			tbl_entry = m68ki_host_read_32(tofs + (root_aptr & 0xfffffffc)+4, FUNCTION_CODE_SUPERVISOR_DATA);
 			tamode = tbl_entry2 & 3;
 //			fprintf(stderr,"PMMU: addr %08x entry %08x entry2 %08x mode %x tofs %x\n", addr_in, tbl_entry, tbl_entry2, tamode, tofs);
 			break;
@@ -112,7 +113,7 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 		case 2: // 4-byte table B descriptor
 			tofs *= 4;
 //			fprintf(stderr,"PMMU: reading table B entry at %08x\n", tofs + tptr);
-			tbl_entry = m68k_read_memory_32( tofs + tptr);
+			tbl_entry = m68ki_host_read_32(tofs + tptr, FUNCTION_CODE_SUPERVISOR_DATA);
 			tbmode = tbl_entry & 3;
 //			fprintf(stderr,"PMMU: addr %08x entry %08x mode %x tofs %x\n", addr_in, tbl_entry, tbmode, tofs);
 			break;
@@ -120,8 +121,8 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 		case 3: // 8-byte table B descriptor
 			tofs *= 8;
 //			fprintf(stderr,"PMMU: reading table B entries at %08x\n", tofs + tptr);
-			tbl_entry2 = m68k_read_memory_32( tofs + tptr);
-			tbl_entry = m68k_read_memory_32( tofs + tptr + 4);
+			tbl_entry2 = m68ki_host_read_32(tofs + tptr, FUNCTION_CODE_SUPERVISOR_DATA);
+			tbl_entry = m68ki_host_read_32(tofs + tptr + 4, FUNCTION_CODE_SUPERVISOR_DATA);
 			tbmode = tbl_entry2 & 3;
 //			fprintf(stderr,"PMMU: addr %08x entry %08x entry2 %08x mode %x tofs %x\n", addr_in, tbl_entry, tbl_entry2, tbmode, tofs);
 			break;
@@ -151,7 +152,7 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 			case 2: // 4-byte table C descriptor
 				tofs *= 4;
 //				fprintf(stderr,"PMMU: reading table C entry at %08x\n", tofs + tptr);
-				tbl_entry = m68k_read_memory_32(tofs + tptr);
+				tbl_entry = m68ki_host_read_32(tofs + tptr, FUNCTION_CODE_SUPERVISOR_DATA);
 				tcmode = tbl_entry & 3;
 //				fprintf(stderr,"PMMU: addr %08x entry %08x mode %x tofs %x\n", addr_in, tbl_entry, tbmode, tofs);
 				break;
@@ -159,8 +160,8 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 			case 3: // 8-byte table C descriptor
 				tofs *= 8;
 //				fprintf(stderr,"PMMU: reading table C entries at %08x\n", tofs + tptr);
-				tbl_entry2 = m68k_read_memory_32(tofs + tptr);
-				tbl_entry = m68k_read_memory_32(tofs + tptr + 4);
+				tbl_entry2 = m68ki_host_read_32(tofs + tptr, FUNCTION_CODE_SUPERVISOR_DATA);
+				tbl_entry = m68ki_host_read_32(tofs + tptr + 4, FUNCTION_CODE_SUPERVISOR_DATA);
 				tcmode = tbl_entry2 & 3;
 //				fprintf(stderr,"PMMU: addr %08x entry %08x entry2 %08x mode %x tofs %x\n", addr_in, tbl_entry, tbl_entry2, tbmode, tofs);
 				break;
@@ -201,6 +202,204 @@ unsigned pmmu_translate_addr(unsigned addr_in)
 	return addr_out;
 }
 
+/*
+	pmmu_walk_040: perform 68040-style address translation through the SRP's
+	tables if supervisor is set, else the URP's, for a read or a write.  The
+	tables always have three levels, indexed by 7, 7 and 6 bits of the
+	address (5 with 8K pages).  Sets the used and modified bits the access
+	needs, and returns the MMUSR a PTEST would give: R (bit 0) is clear if
+	there is no page.
+*/
+static unsigned pmmu_walk_040(unsigned addr_in, int supervisor, int write, unsigned *addr_out)
+{
+	unsigned page_mask = (m68ki_cpu.mmu_tc & 0x4000) ? 0x1fff : 0xfff;
+	unsigned tptr = supervisor ? m68ki_cpu.mmu_srp_aptr : m68ki_cpu.mmu_urp_aptr;
+	unsigned daddr, desc, wp = 0, level;
+
+	*addr_out = addr_in;
+
+	// root and pointer tables: 128 4-byte descriptors each
+	for (level = 0; level < 2; level++)
+	{
+		daddr = (tptr & 0xfffffe00) + (level ? (addr_in >> 16) & 0x1fc : (addr_in >> 23) & 0x1fc);
+		desc = m68ki_host_read_32(daddr, FUNCTION_CODE_SUPERVISOR_DATA);
+		if (!(desc & 2))	// invalid
+			return 0;
+		if (!(desc & 8))	// set the used bit
+			m68ki_host_write_32(daddr, FUNCTION_CODE_SUPERVISOR_DATA, desc | 8);
+		wp |= desc & 4;
+		tptr = desc;
+	}
+
+	// page table: 64 (or 32) 4-byte descriptors
+	if (page_mask == 0x1fff)
+		daddr = (tptr & 0xffffff80) + ((addr_in >> 11) & 0x7c);
+	else
+		daddr = (tptr & 0xffffff00) + ((addr_in >> 10) & 0xfc);
+	desc = m68ki_host_read_32(daddr, FUNCTION_CODE_SUPERVISOR_DATA);
+	if ((desc & 3) == 2)	// indirect
+	{
+		daddr = desc & 0xfffffffc;
+		desc = m68ki_host_read_32(daddr, FUNCTION_CODE_SUPERVISOR_DATA);
+	}
+	if (!(desc & 1))	// invalid
+		return 0;
+	wp |= desc & 4;
+
+	// set the used bit, and the modified bit for a write the page allows
+	if (!(desc & 0x80) || supervisor)
+	{
+		unsigned history = (write && !wp) ? 0x18 : 0x08;
+
+		if ((desc & history) != history)
+		{
+			desc |= history;
+			m68ki_host_write_32(daddr, FUNCTION_CODE_SUPERVISOR_DATA, desc);
+		}
+	}
+
+	*addr_out = (desc & ~page_mask) | (addr_in & page_mask);
+	return (*addr_out & 0xfffff000) | (desc & 0x7f0) | wp | 1;
+}
+
+/*
+	m68ki_pmmu_walk: translate addr_in for a size byte access with function
+	code fc.  A 68040 raises an access error for an access its tables don't
+	allow.  Sets *write if writes to the page can skip the tables.
+*/
+unsigned m68ki_pmmu_walk(unsigned addr_in, unsigned fc, unsigned mode, unsigned size, unsigned *write)
+{
+	unsigned root = m68ki_pmmu_root(fc);
+	unsigned addr_out, mmusr;
+
+	if (!CPU_TYPE_IS_040_PLUS(CPU_TYPE))
+	{
+		if (write)
+			*write = 1;
+		return pmmu_walk(addr_in, root);
+	}
+
+	mmusr = pmmu_walk_040(addr_in, root, mode == MODE_WRITE, &addr_out);
+	if (!(mmusr & 1) || ((mmusr & 4) && mode == MODE_WRITE) || ((mmusr & 0x80) && !root))
+	{
+		// SSW: ATC fault, RW, SIZE (long 0, byte 1, word 2) and TM (the FC)
+		unsigned ssw = 0x400 | (mode == MODE_READ ? 0x100 : 0) | ((size & 3) << 5) | (fc & 7);
+
+		m68ki_cpu.mmu_sr_040 = mmusr;
+		m68ki_exception_access_error_040(addr_in, ssw);
+		return addr_in;
+	}
+	if (write)
+		*write = (mmusr & 0x14) == 0x10;
+	return addr_out;
+}
+
+#if M68K_PMMU_ATC
+/*
+	m68ki_atc_flush: forget every cached translation, and work out the ATC
+	page size from the TC.  Every address in a page takes the same path
+	through the tables, so it is translated by the same offset.
+*/
+void m68ki_atc_flush(void)
+{
+	unsigned bits = ((m68ki_cpu.mmu_tc>>16)&0xf) + ((m68ki_cpu.mmu_tc>>12)&0xf) +
+					((m68ki_cpu.mmu_tc>>8)&0xf) + ((m68ki_cpu.mmu_tc>>4)&0xf);
+	int i;
+
+	if (CPU_TYPE_IS_040_PLUS(CPU_TYPE))
+		m68ki_atc_shift = (m68ki_cpu.mmu_tc & 0x4000) ? 13 : 12;
+	else
+		m68ki_atc_shift = bits >= 32 ? 0 : bits ? 32 - bits : 31;
+	for (i = 0; i < 2 * M68K_PMMU_ATC_SIZE; i++)
+		m68ki_atc[i].root = M68KI_ATC_EMPTY;
+}
+
+/*
+	m68ki_atc_flush_page: forget the translations of address's page in the
+	address space of function code fc
+*/
+void m68ki_atc_flush_page(unsigned address, unsigned fc)
+{
+	unsigned root = m68ki_pmmu_root(fc);
+	unsigned page = address >> m68ki_atc_shift;
+	m68ki_atc_entry *entry = m68ki_atc_slot(page, root, FUNCTION_CODE_USER_DATA);
+
+	if (entry->page == page && entry->root == root)
+		entry->root = M68KI_ATC_EMPTY;
+	entry = m68ki_atc_slot(page, root, FUNCTION_CODE_USER_PROGRAM);
+	if (entry->page == page && entry->root == root)
+		entry->root = M68KI_ATC_EMPTY;
+}
+
+/*
+	m68ki_atc_load: walk the tables for addr_in and cache the translation
+*/
+unsigned m68ki_atc_load(unsigned addr_in, unsigned root, unsigned fc, unsigned mode, unsigned size)
+{
+	unsigned page = addr_in >> m68ki_atc_shift;
+	m68ki_atc_entry *entry = m68ki_atc_slot(page, root, fc);
+	unsigned write;
+	unsigned addr_out = m68ki_pmmu_walk(addr_in, fc, mode, size, &write);
+
+	m68ki_atc_misses++;
+	if (m68ki_fault_pending())
+		return addr_out;
+	entry->page = page;
+	entry->root = root;
+	entry->delta = addr_out - addr_in;
+	entry->write = write;
+#if M68KI_ATC_HOST
+	{
+		// point straight at the page if it is all in one page of mapped memory
+		unsigned start = ADDRESS_68K((page << m68ki_atc_shift) + entry->delta);
+		unsigned size = 1u << m68ki_atc_shift;
+
+		entry->host[0] = size <= M68KI_MAP_PAGE_SIZE ? m68ki_map_find(m68ki_map_read_pages, start, size) : NULL;
+		entry->host[1] = size <= M68KI_MAP_PAGE_SIZE && write ? m68ki_map_find(m68ki_map_write_pages, start, size) : NULL;
+	}
+#endif /* M68KI_ATC_HOST */
+	return addr_out;
+}
+#endif /* M68K_PMMU_ATC */
+
+/*
+	pmmu_translate_addr: translate addr_in for an access in the current mode
+*/
+unsigned pmmu_translate_addr(unsigned addr_in)
+{
+	return m68ki_pmmu_translate(addr_in, FLAG_S | FUNCTION_CODE_USER_PROGRAM, MODE_READ, 2);
+}
+
+/*
+	pmmu_ea_address: the address of a control addressing mode operand
+*/
+static uint32_t pmmu_ea_address(int ea)
+{
+	int mode = (ea >> 3) & 0x7;
+	int reg = (ea & 0x7);
+
+	switch (mode)
+	{
+		case 2:		// (An)
+			return REG_A[reg];
+		case 5:		// (d16, An)
+			return EA_AY_DI_32();
+		case 6:		// (An) + (Xn) + d8
+			return EA_AY_IX_32();
+		case 7:
+			switch (reg)
+			{
+				case 0:		// (xxx).W
+					return EA_AW_32();
+				case 1:		// (xxx).L
+					return EA_AL_32();
+			}
+			break;
+	}
+	fatalerror("680x0 PMMU: unhandled EA mode %d, reg %d at %08X\n", mode, reg, REG_PC);
+	return 0;
+}
+
 /*
 
 	m68881_mmu_ops: COP 0 MMU opcode handling
@@ -233,17 +432,35 @@ void m68881_mmu_ops(void)
 
 				if ((modes & 0xfde0) == 0x2000)	// PLOAD
 				{
-					fprintf(stderr,"680x0: unhandled PLOAD\n");
+					uint32_t addr = pmmu_ea_address(ea);
+					unsigned fc;
+
+					if (modes & 0x10)	// immediate
+						fc = modes & 7;
+					else if (modes & 0x08)	// Dn
+						fc = REG_D[modes & 7] & 7;
+					else
+						fc = (modes & 1) ? REG_DFC : REG_SFC;
+
+#if M68K_PMMU_ATC
+					if (PMMU_ENABLED && !m68ki_pmmu_transparent(addr, fc, (modes & 0x200) ? MODE_READ : MODE_WRITE))
+						m68ki_atc_load(addr, m68ki_pmmu_root(fc), fc, (modes & 0x200) ? MODE_READ : MODE_WRITE, 4);
+#endif /* M68K_PMMU_ATC */
+					(void)addr;
+					(void)fc;
 					return;
 				}
 				else if ((modes & 0xe200) == 0x2000)	// PFLUSH
 				{
-					fprintf(stderr,"680x0: unhandled PFLUSH PC=%x\n", REG_PC);
+					// flushing by FC and EA flushes everything
+					if (((modes>>10) & 7) == 6)
+						pmmu_ea_address(ea);
+					m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				else if (modes == 0xa000)	// PFLUSHR
 				{
-					fprintf(stderr,"680x0: unhandled PFLUSHR\n");
+					m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 					return;
 				}
 				else if (modes == 0x2800)	// PVALID (FORMAT 1)
@@ -266,6 +483,22 @@ void m68881_mmu_ops(void)
 					switch ((modes>>13) & 0x7)
 					{
 						case 0:	// MC68030/040 form with FD bit
+							if (((modes>>10) & 6) == 2)	// MC68030 transparent translation registers
+							{
+								unsigned *tt = ((modes>>10) & 1) ? &m68ki_cpu.mmu_tt1 : &m68ki_cpu.mmu_tt0;
+
+								if (modes & 0x200)
+								{
+									WRITE_EA_32(ea, *tt);
+								}
+								else
+								{
+									*tt = READ_EA_32(ea);
+									m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+								}
+								break;
+							}
+							/* fall through */
 						case 2:	// MC68881 form, FD never set
 							if (modes & 0x200)
 							{
@@ -294,6 +527,8 @@ void m68881_mmu_ops(void)
 								{
 									case 0:	// translation control register
 										m68ki_cpu.mmu_tc = READ_EA_32(ea);
+										m68ki_code_page_invalidate(); /* auto-disable (see m68kcpu.h) */
+										m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 
 										if (m68ki_cpu.mmu_tc & 0x80000000)
 										{
@@ -309,12 +544,14 @@ void m68881_mmu_ops(void)
 										temp64 = READ_EA_64(ea);
 										m68ki_cpu.mmu_srp_limit = (temp64>>32) & 0xffffffff;
 										m68ki_cpu.mmu_srp_aptr = temp64 & 0xffffffff;
+										m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 										break;
 
 									case 3:	// CPU root pointer
 										temp64 = READ_EA_64(ea);
 										m68ki_cpu.mmu_crp_limit = (temp64>>32) & 0xffffffff;
 										m68ki_cpu.mmu_crp_aptr = temp64 & 0xffffffff;
+										m68ki_atc_flush(); /* auto-disable (see m68kcpu.h) */
 										break;
 
 									default:
@@ -348,3 +585,20 @@ void m68881_mmu_ops(void)
 		}
 	}
 }
+
+/*
+
+	m68040_ptest: PTESTR/PTESTW, look address up for a read or a write in
+	the DFC's address space and leave the result in the MMUSR
+
+*/
+
+void m68040_ptest(unsigned address, int write)
+{
+	unsigned fc = REG_DFC, addr_out;
+
+	if (m68ki_pmmu_transparent(address, fc, write ? MODE_WRITE : MODE_READ))
+		m68ki_cpu.mmu_sr_040 = (address & 0xfffff000) | 3;	// T and R
+	else
+		m68ki_cpu.mmu_sr_040 = pmmu_walk_040(address, fc & 4, write, &addr_out);
+}
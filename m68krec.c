@@ -0,0 +1,542 @@
+/* ======================================================================== */
+/* ========================= LICENSING & COPYRIGHT ======================== */
+/* ======================================================================== */
+/*
+ *                                  MUSASHI
+ *                                Version 4.60
+ *
+ * A portable Motorola M680x0 processor emulation engine.
+ * Copyright Karl Stenerud.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+/* ======================================================================== */
+/* =========================== STATIC RECOMPILER ========================== */
+/* ======================================================================== */
+/*
+ * This program recompiles a ROM image to C ahead of time, for hosts that
+ * can't generate code at runtime.  It follows the code from the entry points
+ * you give it, and writes a C function for every block it finds (a run of
+ * instructions up to the next change of flow) to stdout:
+ *
+ * m68krec <cpu type> <rom image> <load address> <entry point> [entry point...]
+ *
+ * where cpu type is one of 68000, 68010, 68ec020, 68020, 68ec030, 68030,
+ * 68ec040, 68lc040 or 68040, and the addresses may be given in hex with a
+ * 0x prefix.
+ *
+ * The output has to be compiled with the same m68kconf.h as the rest of
+ * Musashi, with M68K_STATIC_CODE turned on.  Call m68krec_install() to
+ * start using it.
+ *
+ * Each instruction in a block calls the opcode handler the interpreter would
+ * use, except for a few register to register instructions whose handlers
+ * are copied in so that the compiler can work on them with the rest of the
+ * block.  Flags, timing, exceptions and memory accesses are therefore the
+ * same as when interpreting, and the output works for any CPU type.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include "m68k.h"
+
+
+/* ======================================================================== */
+/* ============================= CONFIGURATION ============================ */
+/* ======================================================================== */
+
+#define MAX_BLOCK_LENGTH    64   /* Most instructions in a block */
+#define MAX_TARGETS         2    /* Most places one instruction can go next */
+
+
+/* ======================================================================== */
+/* ============================== PROTOTYPES ============================== */
+/* ======================================================================== */
+
+/* What an instruction does to the flow of the program */
+typedef struct
+{
+	int      ends_block;         /* Changes the flow of the program */
+	int      count;              /* Number of known places it goes next */
+	unsigned target[MAX_TARGETS];
+} flow_struct;
+
+void error_exit(const char* fmt, ...);
+unsigned read_rom_16(unsigned address);
+unsigned read_rom_32(unsigned address);
+int in_rom(unsigned address, unsigned size);
+void get_flow(unsigned pc, unsigned ir, unsigned size, flow_struct* flow);
+void add_block(unsigned pc);
+void find_blocks(void);
+int write_inline_handler(FILE* filep, unsigned ir);
+void write_block(FILE* filep, unsigned pc);
+void write_dispatcher(FILE* filep);
+
+
+/* ======================================================================== */
+/* ================================= DATA ================================= */
+/* ======================================================================== */
+
+static unsigned char* g_rom;             /* The ROM image */
+static unsigned       g_rom_start;       /* Address it is loaded at */
+static unsigned       g_rom_size;
+static unsigned       g_cpu_type;        /* For decoding the instructions */
+static const char*    g_rom_filename;
+
+static unsigned char* g_block_start;     /* One flag per ROM word */
+static unsigned*      g_worklist;        /* Blocks found but not looked at */
+static unsigned       g_worklist_length;
+static unsigned       g_block_count;
+
+static const struct
+{
+	const char* name;
+	unsigned    type;
+} g_cpu_types[] =
+{
+	{"68000",   M68K_CPU_TYPE_68000},
+	{"68010",   M68K_CPU_TYPE_68010},
+	{"68ec020", M68K_CPU_TYPE_68EC020},
+	{"68020",   M68K_CPU_TYPE_68020},
+	{"68ec030", M68K_CPU_TYPE_68EC030},
+	{"68030",   M68K_CPU_TYPE_68030},
+	{"68ec040", M68K_CPU_TYPE_68EC040},
+	{"68lc040", M68K_CPU_TYPE_68LC040},
+	{"68040",   M68K_CPU_TYPE_68040},
+};
+
+/* Handlers that are copied into the blocks.  In the body, DX and DY are
+ * replaced with the registers, and QUICK with the immediate data.
+ * These must match the handlers in m68k_in.c.
+ */
+static const struct
+{
+	unsigned    mask;
+	unsigned    match;
+	const char* body;
+} g_inline_handlers[] =
+{
+	/* moveq */
+	{0xf100, 0x7000,
+		"unsigned res = DX = MAKE_INT_8(QUICK);\n"
+		"m68ki_set_logic_flags_32(res);\n"},
+	/* move.l Dy, Dx */
+	{0xf1f8, 0x2000,
+		"unsigned res = DY;\n"
+		"DX = res;\n"
+		"m68ki_set_logic_flags_32(res);\n"},
+	/* tst.l Dy */
+	{0xfff8, 0x4a80,
+		"unsigned res = DY;\n"
+		"m68ki_set_logic_flags_32(res);\n"},
+	/* and.l Dy, Dx */
+	{0xf1f8, 0xc080,
+		"unsigned res = DX &= DY;\n"
+		"m68ki_set_logic_flags_32(res);\n"},
+	/* or.l Dy, Dx */
+	{0xf1f8, 0x8080,
+		"unsigned res = DX |= DY;\n"
+		"m68ki_set_logic_flags_32(res);\n"},
+	/* eor.l Dx, Dy */
+	{0xf1f8, 0xb180,
+		"unsigned res = DY ^= DX;\n"
+		"m68ki_set_logic_flags_32(res);\n"},
+	/* add.l Dy, Dx */
+	{0xf1f8, 0xd080,
+		"unsigned src = DY;\n"
+		"unsigned dst = DX;\n"
+		"unsigned res = src + dst;\n"
+		"m68ki_set_add_flags_32(src, dst, res);\n"
+		"DX = MASK_OUT_ABOVE_32(res);\n"},
+	/* sub.l Dy, Dx */
+	{0xf1f8, 0x9080,
+		"unsigned src = DY;\n"
+		"unsigned dst = DX;\n"
+		"unsigned res = dst - src;\n"
+		"m68ki_set_sub_flags_32(src, dst, res);\n"
+		"DX = MASK_OUT_ABOVE_32(res);\n"},
+	/* cmp.l Dy, Dx */
+	{0xf1f8, 0xb080,
+		"unsigned src = DY;\n"
+		"unsigned dst = DX;\n"
+		"unsigned res = dst - src;\n"
+		"m68ki_set_cmp_flags_32(src, dst, res);\n"},
+	/* addq.l #q, Dy */
+	{0xf1f8, 0x5080,
+		"unsigned src = QUICK;\n"
+		"unsigned dst = DY;\n"
+		"unsigned res = src + dst;\n"
+		"m68ki_set_add_flags_32(src, dst, res);\n"
+		"DY = MASK_OUT_ABOVE_32(res);\n"},
+	/* subq.l #q, Dy */
+	{0xf1f8, 0x5180,
+		"unsigned src = QUICK;\n"
+		"unsigned dst = DY;\n"
+		"unsigned res = dst - src;\n"
+		"m68ki_set_sub_flags_32(src, dst, res);\n"
+		"DY = MASK_OUT_ABOVE_32(res);\n"},
+};
+
+
+/* ======================================================================== */
+/* =========================== UTILITY FUNCTIONS ========================== */
+/* ======================================================================== */
+
+/* Print an error message and exit with status error */
+void error_exit(const char* fmt, ...)
+{
+	va_list args;
+	fprintf(stderr, "m68krec: ");
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	exit(EXIT_FAILURE);
+}
+
+/* Check that size bytes at address are in the ROM */
+int in_rom(unsigned address, unsigned size)
+{
+	return address - g_rom_start < g_rom_size && address + size - g_rom_start <= g_rom_size;
+}
+
+unsigned read_rom_16(unsigned address)
+{
+	if(!in_rom(address, 2))
+		return 0;
+	address -= g_rom_start;
+	return (g_rom[address] << 8) | g_rom[address+1];
+}
+
+unsigned read_rom_32(unsigned address)
+{
+	return (read_rom_16(address) << 16) | read_rom_16(address + 2);
+}
+
+/* The disassembler reads the ROM through these */
+unsigned m68k_read_disassembler_8(unsigned address)
+{
+	return read_rom_16(address & ~1) >> (address & 1 ? 0 : 8) & 0xff;
+}
+
+unsigned m68k_read_disassembler_16(unsigned address)
+{
+	return read_rom_16(address);
+}
+
+unsigned m68k_read_disassembler_32(unsigned address)
+{
+	return read_rom_32(address);
+}
+
+
+/* ======================================================================== */
+/* ============================= CODE DISCOVERY =========================== */
+/* ======================================================================== */
+
+/* Work out where the instruction at pc can go next */
+void get_flow(unsigned pc, unsigned ir, unsigned size, flow_struct* flow)
+{
+	unsigned mode = (ir >> 3) & 7;
+	unsigned reg = ir & 7;
+	int falls_through = 1;
+	unsigned target = 0;
+	int has_target = 0;
+
+	flow->ends_block = 1;
+	flow->count = 0;
+
+	if((ir & 0xf000) == 0x6000)                      /* bra, bsr, bcc */
+	{
+		unsigned offset = ir & 0xff;
+		has_target = 1;
+		if(offset == 0)
+			target = pc + 2 + (int16_t)read_rom_16(pc + 2);
+		else if(offset == 0xff && g_cpu_type != M68K_CPU_TYPE_68000 && g_cpu_type != M68K_CPU_TYPE_68010)
+			target = pc + 2 + read_rom_32(pc + 2);
+		else
+			target = pc + 2 + (int8_t)offset;
+		falls_through = (ir & 0x0f00) != 0;
+	}
+	else if((ir & 0xf0f8) == 0x50c8)                 /* dbcc */
+	{
+		has_target = 1;
+		target = pc + 2 + (int16_t)read_rom_16(pc + 2);
+	}
+	else if((ir & 0xff80) == 0x4e80)                 /* jsr, jmp */
+	{
+		/* Only absolute and PC relative targets can be worked out */
+		has_target = mode == 7 && reg <= 2;
+		if(mode == 7 && reg == 0)
+			target = (int16_t)read_rom_16(pc + 2);
+		else if(mode == 7 && reg == 1)
+			target = read_rom_32(pc + 2);
+		else if(mode == 7 && reg == 2)
+			target = pc + 2 + (int16_t)read_rom_16(pc + 2);
+		falls_through = !(ir & 0x0040);
+	}
+	else if((ir & 0xfff8) == 0x4e70 && ir != 0x4e70 && ir != 0x4e71 && ir != 0x4e72 && ir != 0x4e76)
+		falls_through = 0;                           /* rte, rtd, rts, rtr */
+	else if(ir == 0x4afc || (ir & 0xf000) == 0xa000 || (ir & 0xfff8) == 0x4848)
+		falls_through = 0;                           /* illegal, line a, bkpt */
+	else if((ir & 0xfff0) == 0x4e40 || ir == 0x4e72 || (ir & 0xf000) == 0xf000)
+		;                                            /* trap, stop, line f */
+	else
+		flow->ends_block = 0;
+
+	if(has_target && !(target & 1) && in_rom(target, 2))
+		flow->target[flow->count++] = target;
+	if(falls_through && flow->ends_block && in_rom(pc + size, 2))
+		flow->target[flow->count++] = pc + size;
+}
+
+/* Remember a block to look at */
+void add_block(unsigned pc)
+{
+	unsigned index = (pc - g_rom_start) >> 1;
+
+	if(g_block_start[index])
+		return;
+	g_block_start[index] = 1;
+	g_worklist[g_worklist_length++] = pc;
+	g_block_count++;
+}
+
+/* Follow the code from the entry points to find every block */
+void find_blocks(void)
+{
+	char buff[100];
+
+	while(g_worklist_length)
+	{
+		unsigned pc = g_worklist[--g_worklist_length];
+		int length;
+
+		for(length = 0; length < MAX_BLOCK_LENGTH; length++)
+		{
+			unsigned ir = read_rom_16(pc);
+			unsigned size;
+			flow_struct flow;
+			int i;
+
+			if(!in_rom(pc, 2) || !m68k_is_valid_instruction(ir, g_cpu_type))
+				break;
+			size = m68k_disassemble(buff, pc, g_cpu_type);
+			if(!in_rom(pc, size))
+				break;
+
+			get_flow(pc, ir, size, &flow);
+			for(i = 0; i < flow.count; i++)
+				add_block(flow.target[i]);
+			if(flow.ends_block)
+				break;
+			pc += size;
+		}
+
+		/* Not code after all */
+		if(length == 0)
+		{
+			g_block_start[(pc - g_rom_start) >> 1] = 0;
+			g_block_count--;
+		}
+	}
+}
+
+
+/* ======================================================================== */
+/* ============================ CODE GENERATION =========================== */
+/* ======================================================================== */
+
+/* Write a copy of the handler for ir if it has one in g_inline_handlers.
+ * Returns 0 if the handler has to be called.
+ */
+int write_inline_handler(FILE* filep, unsigned ir)
+{
+	unsigned i;
+	const char* p;
+
+	for(i = 0; i < sizeof(g_inline_handlers) / sizeof(*g_inline_handlers); i++)
+		if((ir & g_inline_handlers[i].mask) == g_inline_handlers[i].match)
+			break;
+	if(i == sizeof(g_inline_handlers) / sizeof(*g_inline_handlers))
+		return 0;
+
+	fprintf(filep, "\t{\n\t\t");
+	for(p = g_inline_handlers[i].body; *p; p++)
+	{
+		if(strncmp(p, "DX", 2) == 0)
+			fprintf(filep, "REG_D[%u]", (ir >> 9) & 7), p++;
+		else if(strncmp(p, "DY", 2) == 0)
+			fprintf(filep, "REG_D[%u]", ir & 7), p++;
+		else if(strncmp(p, "QUICK", 5) == 0)
+		{
+			if((ir & 0xf000) == 0x7000)
+				fprintf(filep, "0x%02x", ir & 0xff);
+			else
+				fprintf(filep, "%u", (((ir >> 9) - 1) & 7) + 1);
+			p += 4;
+		}
+		else if(*p == '\n')
+			fputs(p[1] ? "\n\t\t" : "\n", filep);
+		else
+			fputc(*p, filep);
+	}
+	fprintf(filep, "\t}\n");
+	return 1;
+}
+
+/* Write the function for the block at pc */
+void write_block(FILE* filep, unsigned pc)
+{
+	unsigned start = pc;
+	unsigned size[MAX_BLOCK_LENGTH];
+	flow_struct flow;
+	char buff[100];
+	int loops = 0;
+	int count;
+	int i;
+
+	/* Find the end of the block, and whether it jumps back to its start */
+	for(count = 0; count < MAX_BLOCK_LENGTH; count++)
+	{
+		unsigned ir = read_rom_16(pc);
+
+		if(!in_rom(pc, 2) || !m68k_is_valid_instruction(ir, g_cpu_type))
+			break;
+		size[count] = m68k_disassemble(buff, pc, g_cpu_type);
+		if(!in_rom(pc, size[count]))
+			break;
+		get_flow(pc, ir, size[count], &flow);
+		pc += size[count];
+		if(flow.ends_block)
+		{
+			for(i = 0; i < flow.count; i++)
+				if(flow.target[i] == start)
+					loops = 1;
+			count++;
+			break;
+		}
+	}
+
+	fprintf(filep, "static void m68krec_%08x(void)\n{\n", start);
+	if(loops)
+		fprintf(filep, "top:\n");
+
+	for(i = 0, pc = start; i < count; pc += size[i++])
+	{
+		unsigned ir = read_rom_16(pc);
+
+		m68k_disassemble(buff, pc, g_cpu_type);
+		fprintf(filep, "\t/* %08x: %s */\n", pc, buff);
+		fprintf(filep, "\tif(!m68ki_static_start(0x%08x, 0x%04x))\n\t\treturn;\n", pc, ir);
+		if(!write_inline_handler(filep, ir))
+			fprintf(filep, "\tm68ki_instruction_jump_table[0x%04x]();\n", ir);
+		if(i + 1 < count)
+			fprintf(filep, "\tif(!m68ki_static_end(0x%04x, 0x%08x))\n\t\treturn;\n\n", ir, pc + size[i]);
+		else if(loops)
+			fprintf(filep, "\tif(m68ki_static_end(0x%04x, 0x%08x) && !PMMU_ENABLED)\n\t\tgoto top;\n", ir, start);
+		else
+			fprintf(filep, "\tm68ki_static_end(0x%04x, 0x%08x);\n", ir, pc + size[i]);
+	}
+	fprintf(filep, "}\n\n\n");
+}
+
+/* Write the function m68k_execute() calls to find the blocks */
+void write_dispatcher(FILE* filep)
+{
+	unsigned i;
+
+	fprintf(filep, "/* Run the block at pc.  Returns 0 if there isn't one. */\n");
+	fprintf(filep, "int m68krec_execute(unsigned pc)\n{\n\tswitch(pc)\n\t{\n");
+	for(i = 0; i < g_rom_size / 2; i++)
+		if(g_block_start[i])
+			fprintf(filep, "\t\tcase 0x%08x: m68krec_%08x(); return 1;\n", g_rom_start + i*2, g_rom_start + i*2);
+	fprintf(filep, "\t}\n\treturn 0;\n}\n\n");
+
+	fprintf(filep, "/* Start running the recompiled code */\n");
+	fprintf(filep, "void m68krec_install(void)\n{\n");
+	fprintf(filep, "\tm68k_set_static_code(0x%08x, 0x%08x, m68krec_execute);\n}\n", g_rom_start, g_rom_size);
+}
+
+
+/* ======================================================================== */
+/* ================================= MAIN ================================= */
+/* ======================================================================== */
+
+int main(int argc, char **argv)
+{
+	FILE* filep;
+	unsigned i;
+	int arg;
+
+	if(argc < 5)
+		error_exit("usage: m68krec <cpu type> <rom image> <load address> <entry point> [entry point...]");
+
+	for(i = 0; i < sizeof(g_cpu_types) / sizeof(*g_cpu_types); i++)
+		if(strcmp(argv[1], g_cpu_types[i].name) == 0)
+			g_cpu_type = g_cpu_types[i].type;
+	if(!g_cpu_type)
+		error_exit("unknown cpu type %s", argv[1]);
+
+	/* Load the ROM */
+	g_rom_filename = argv[2];
+	if((filep = fopen(g_rom_filename, "rb")) == NULL)
+		error_exit("can't open %s", g_rom_filename);
+	fseek(filep, 0, SEEK_END);
+	g_rom_size = ftell(filep) & ~1;
+	fseek(filep, 0, SEEK_SET);
+	g_rom = malloc(g_rom_size + 1);
+	g_block_start = calloc(g_rom_size / 2 + 1, 1);
+	g_worklist = malloc((g_rom_size / 2 + 1) * sizeof(*g_worklist));
+	if(!g_rom || !g_block_start || !g_worklist)
+		error_exit("out of memory");
+	if(fread(g_rom, 1, g_rom_size, filep) != g_rom_size)
+		error_exit("can't read %s", g_rom_filename);
+	fclose(filep);
+	g_rom_start = strtoul(argv[3], NULL, 0);
+
+	for(arg = 4; arg < argc; arg++)
+	{
+		unsigned pc = strtoul(argv[arg], NULL, 0);
+		if((pc & 1) || !in_rom(pc, 2))
+			error_exit("entry point %s is not in the ROM", argv[arg]);
+		add_block(pc);
+	}
+
+	find_blocks();
+
+	printf("/* Recompiled from %s by m68krec.  Do not edit. */\n\n", g_rom_filename);
+	printf("#include \"m68kcpu.h\"\n\n");
+	printf("#if M68K_STATIC_CODE\n\n");
+	for(i = 0; i < g_rom_size / 2; i++)
+		if(g_block_start[i])
+			write_block(stdout, g_rom_start + i*2);
+	write_dispatcher(stdout);
+	printf("\n#endif /* M68K_STATIC_CODE */\n");
+
+	fprintf(stderr, "m68krec: %u blocks\n", g_block_count);
+	return 0;
+}
@@ -0,0 +1,79 @@
+/* Cost of dispatching instructions in m68k_execute(), running a loop of
+ * short register and memory instructions.  Build with M68K_THREADED_DISPATCH
+ * on and off to compare the two dispatchers, and with optimization:
+ *   make clean && make CFLAGS="-O2" bench
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "m68k.h"
+#include "host.h"
+
+#define SLICES 300
+#define SLICE_CYCLES 1000000
+#define ROUNDS 5
+
+static double seconds(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Best time per million clocks over a number of rounds, in milliseconds */
+static double measure(void)
+{
+	double best = 0;
+	int round;
+	int i;
+
+	for(round = 0; round < ROUNDS; round++)
+	{
+		double start;
+		double t;
+
+		m68k_pulse_reset();
+		start = seconds();
+		for(i = 0; i < SLICES; i++)
+			m68k_execute(SLICE_CYCLES);
+		t = seconds() - start;
+		if(round == 0 || t < best)
+			best = t;
+	}
+	return best / (SLICES * (SLICE_CYCLES / 1e6)) * 1e3;
+}
+
+int main(void)
+{
+	static const unsigned short code[] =
+	{
+		0x41f9, 0x0001, 0x0000, /* outer: lea $10000, a0 */
+		0x303c, 0x0fff,         /*        move.w #$fff, d0 */
+		0x2218,                 /* inner: move.l (a0)+, d1 */
+		0xd481,                 /*        add.l d1, d2 */
+		0xb583,                 /*        eor.l d2, d3 */
+		0x2803,                 /*        move.l d3, d4 */
+		0xe28c,                 /*        lsr.l #1, d4 */
+		0xca84,                 /*        and.l d4, d5 */
+		0xbc85,                 /*        cmp.l d5, d6 */
+		0x6702,                 /*        beq.s skip */
+		0x8c81,                 /*        or.l d1, d6 */
+		0x51c8, 0xffec,         /* skip:  dbf d0, inner */
+		0x60de                  /*        bra.s outer */
+	};
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(code) / sizeof(*code); i++)
+		host_poke_16(0x400 + i*2, code[i]);
+	for(i = 0; i < 0x10000; i += 4)
+		host_poke_32(0x10000 + i, i * 0x9e3779b9);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+
+	printf("m68k_execute(): %5.3f ms per million clocks\n", measure());
+	return 0;
+}
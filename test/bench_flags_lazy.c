@@ -0,0 +1,3 @@
+/* bench_flags.c, built with M68K_LAZY_FLAGS on by bench_flags_lazy_conf.h */
+
+#include "bench_flags.c"
@@ -0,0 +1,64 @@
+/* Cost of running the CPU one instruction per call, with m68k_execute(1)
+ * and with m68k_step().  Build with M68K_PENDING_FAULTS on and off to
+ * compare the two ways of handling faults, and with optimization:
+ *   make clean && make CFLAGS="-O2" bench
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "m68k.h"
+#include "host.h"
+
+#define CALLS 20000000
+#define ROUNDS 11
+
+static double seconds(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Best time per call over a number of rounds, in nanoseconds */
+static double measure(int step)
+{
+	double best = 0;
+	int round;
+	int i;
+
+	for(round = 0; round < ROUNDS; round++)
+	{
+		double start;
+		double t;
+
+		m68k_pulse_reset();
+		m68k_execute(1);
+		start = seconds();
+		if(step)
+			for(i = 0; i < CALLS; i++)
+				m68k_step();
+		else
+			for(i = 0; i < CALLS; i++)
+				m68k_execute(1);
+		t = (seconds() - start) / CALLS * 1e9;
+		if(round == 0 || t < best)
+			best = t;
+	}
+	return best;
+}
+
+int main(void)
+{
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	host_poke_16(0x400, 0x5280);      /* addq.l #1, d0 */
+	host_poke_16(0x402, 0x60fc);      /* bra.s $400 */
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+
+	printf("m68k_execute(1): %5.1f ns per call\n", measure(0));
+	printf("m68k_step():     %5.1f ns per call\n", measure(1));
+	return 0;
+}
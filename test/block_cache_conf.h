@@ -0,0 +1,6 @@
+/* Configuration for block_cache_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_BLOCK_CACHE
+#define M68K_BLOCK_CACHE OPT_ON
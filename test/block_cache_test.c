@@ -0,0 +1,100 @@
+/* M68K_BLOCK_CACHE: cached code is invalidated by CPU writes and by
+ * m68k_invalidate_block_cache(), and blocks recorded by one CPU are not
+ * replayed by another, even when both contexts are loaded from one buffer
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define CONTEXT_CYCLES 10000
+
+static unsigned poke_code(unsigned address, const unsigned short* code, int words)
+{
+	int i;
+
+	for(i = 0; i < words; i++)
+		host_poke_16(address + i*2, code[i]);
+	return address + words*2;
+}
+
+/* Run the CPU saved in CONTEXT from BUFFER, and return how far it got */
+static unsigned run_context(void* buffer, void* context, unsigned size)
+{
+	memcpy(buffer, context, size);
+	m68k_set_context(buffer);
+	m68k_execute(CONTEXT_CYCLES);
+	return m68k_get_reg(NULL, M68K_REG_D1);
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x4eb8, 0x0500,         /* jsr $500.w */
+		0x2400,                 /* move.l d0, d2 */
+		0x31fc, 0x7003, 0x0500, /* move.w #$7003, $500.w */
+		0x4eb8, 0x0500,         /* jsr $500.w */
+		0x60fe                  /* bra.s * */
+	};
+	static const unsigned short subroutine[] =
+	{
+		0x7001,                 /* moveq #1, d0 */
+		0x4e75                  /* rts */
+	};
+	static const unsigned short loop[] =
+	{
+		0x5281,                 /* addq.l #1, d1 */
+		0x4eb8, 0x0500,         /* jsr $500.w */
+		0x60f8                  /* bra.s loop */
+	};
+	unsigned size = m68k_context_size();
+	void* buffer = malloc(size);
+	void* cpu_000 = malloc(size);
+	void* cpu_020 = malloc(size);
+	unsigned alone;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	poke_code(0x400, program, sizeof(program) / sizeof(*program));
+	poke_code(0x500, subroutine, sizeof(subroutine) / sizeof(*subroutine));
+	poke_code(0x600, loop, sizeof(loop) / sizeof(*loop));
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	m68k_execute(1000);
+	host_check(m68k_get_reg(NULL, M68K_REG_D2) == 1, "first call runs the code as loaded");
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 3, "a CPU write invalidates the cached code");
+
+	host_poke_16(0x500, 0x7004);      /* moveq #4, d0 */
+	m68k_set_reg(M68K_REG_PC, 0x40c);
+	m68k_execute(1000);
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 3, "a host write is not seen until it is reported");
+
+	m68k_invalidate_block_cache(0x500, 2);
+	m68k_set_reg(M68K_REG_PC, 0x40c);
+	m68k_execute(1000);
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 4, "m68k_invalidate_block_cache() drops the cached code");
+
+	/* Two CPUs of different types, run in turn from the same buffer */
+	host_poke_32(0x004, 0x600);
+	m68k_set_cpu_type(M68K_CPU_TYPE_68020);
+	m68k_pulse_reset();
+	m68k_get_context(cpu_020);
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	m68k_get_context(cpu_000);
+
+	alone = run_context(buffer, cpu_020, size);
+	m68k_flush_block_cache();
+	host_check(run_context(buffer, cpu_000, size) != alone, "the CPU types take different times");
+	host_check(run_context(buffer, cpu_020, size) == alone, "a CPU doesn't replay blocks recorded by another");
+
+	free(buffer);
+	free(cpu_000);
+	free(cpu_020);
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for bulk_transfer_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_BULK_TRANSFERS
+#define M68K_BULK_TRANSFERS OPT_ON
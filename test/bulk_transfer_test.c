@@ -0,0 +1,111 @@
+/* M68K_BULK_TRANSFERS: MOVEM, MOVE16 and FMOVEM move all their registers
+ * with one block callback, and one memory callback per value when the block
+ * transfer is declined
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define FP_SOURCE     0x2000
+#define FP_DEST       0x3000
+#define MOVEM_SOURCE  0x2100
+#define MOVEM_DEST    0x3100
+#define LINE_SOURCE   0x2200
+#define LINE_DEST     0x3200
+
+static unsigned reads;
+static unsigned writes;
+static unsigned largest;
+
+void m68k_read_memory_block(M68K_USER_PARAM unsigned address, unsigned size, unsigned count, unsigned* values)
+{
+	reads++;
+	if(size * count > largest)
+		largest = size * count;
+	for(; count; count--, address += size)
+		*values++ = size == 2 ? host_peek_16(address) : host_peek_32(address);
+}
+
+void m68k_write_memory_block(M68K_USER_PARAM unsigned address, unsigned size, unsigned count, const unsigned* values)
+{
+	writes++;
+	if(size * count > largest)
+		largest = size * count;
+	for(; count; count--, address += size)
+	{
+		if(size == 2)
+			host_poke_16(address, *values++);
+		else
+			host_poke_32(address, *values++);
+	}
+}
+
+/* Run the program with the data at ODD bytes past the even addresses, and
+ * report if it moved all the data
+ */
+static int run(unsigned odd)
+{
+	unsigned i;
+	int ok = 1;
+
+	for(i = 0; i < 0x2000; i += 4)
+		host_poke_32(FP_SOURCE + i, i < 0x1000 ? i * 0x9e3779b9 + 1 : 0);
+	reads = writes = largest = 0;
+	host_watch_count = 0;
+
+	m68k_pulse_reset();
+	m68k_step();
+	m68k_set_reg(M68K_REG_A0, FP_DEST + odd);
+	m68k_set_reg(M68K_REG_A1, FP_SOURCE + odd);
+	m68k_set_reg(M68K_REG_A2, MOVEM_SOURCE + odd);
+	m68k_set_reg(M68K_REG_A3, LINE_SOURCE);
+	m68k_set_reg(M68K_REG_A4, LINE_DEST);
+	m68k_set_reg(M68K_REG_A5, MOVEM_DEST + odd);
+	m68k_execute(1000);
+
+	/* FMOVEM moves the upper 64 bits of each extended value */
+	for(i = 0; i < 8 * 12; i += 12)
+		ok &= host_peek_32(FP_DEST - 8*12 + odd + i) == host_peek_32(FP_SOURCE + odd + i)
+		   && host_peek_32(FP_DEST - 8*12 + odd + i + 4) == host_peek_32(FP_SOURCE + odd + i + 4);
+	for(i = 0; i < 8 * 4; i += 4)
+		ok &= host_peek_32(MOVEM_DEST - 8*4 + odd + i) == host_peek_32(MOVEM_SOURCE + odd + i);
+	for(i = 0; i < 16; i += 4)
+		ok &= host_peek_32(LINE_DEST + i) == host_peek_32(LINE_SOURCE + i);
+	return ok;
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0xf219, 0xd0ff,         /* fmovem.x (a1)+, fp0-fp7 */
+		0xf220, 0xe0ff,         /* fmovem.x fp0-fp7, -(a0) */
+		0x4cd2, 0x00ff,         /* movem.l (a2), d0-d7 */
+		0x48e5, 0xff00,         /* movem.l d0-d7, -(a5) */
+		0xf623, 0xc000,         /* move16 (a3)+, (a4)+ */
+		0x60fe                  /* bra.s * */
+	};
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+	host_watch_start = FP_SOURCE;
+	host_watch_end = FP_SOURCE + 0x2000;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68040);
+
+	host_check(run(0), "the data is moved");
+	host_check(reads == 3 && writes == 3, "each instruction makes one block transfer");
+	host_check(largest == 8 * 12, "FMOVEM moves all its registers in one block");
+	host_check(host_watch_count == 0, "the block transfers don't use the memory callbacks");
+
+	host_check(run(1), "the data is moved from odd addresses");
+	host_check(reads == 1 && writes == 1, "block transfers from odd addresses are declined");
+	host_check(host_watch_count != 0, "declined block transfers use the memory callbacks");
+
+	return host_result();
+}
@@ -0,0 +1,112 @@
+/* M68K_MEMORY_MAP: code in mapped memory is fetched without the callbacks,
+ * across a call out to unmapped memory and on into the next page, and a
+ * change to the mapping or to the code itself is seen by the next fetch
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define PAGE_A      0x100000
+#define PAGE_B      0x110000
+#define PAGE_SIZE   0x10000
+#define ENTRY       0x10fff0
+#define END         0x110006  /* bra.s * */
+
+static const unsigned short code_a[] =
+{
+	0x7001,                 /* moveq #1, d0 */
+	0x4eb8, 0x0400,         /* jsr $400.w */
+	0x2200,                 /* move.l d0, d1 */
+	0x4e71,                 /* nop */
+	0x283c, 0xaabb, 0xccdd  /* move.l #$aabbccdd, d4 (ends the page) */
+};
+
+static const unsigned short code_b[] =
+{
+	0x7402,                 /* moveq #2, d2 */
+	0x363c, 0x1234,         /* move.w #$1234, d3 */
+	0x60fe                  /* bra.s * */
+};
+
+static const unsigned short subroutine[] =
+{
+	0x7a05,                 /* moveq #5, d5 */
+	0x4e75                  /* rts */
+};
+
+static unsigned char page_a[PAGE_SIZE];
+static unsigned char page_b[PAGE_SIZE];
+static unsigned char page_c[PAGE_SIZE];
+
+static void put_code(unsigned char* page, unsigned offset, const unsigned short* code, unsigned words)
+{
+	unsigned i;
+
+	for(i = 0; i < words; i++)
+	{
+		page[offset + i*2] = code[i] >> 8;
+		page[offset + i*2 + 1] = code[i] & 0xff;
+	}
+}
+
+static void run(void)
+{
+	int r;
+
+	m68k_pulse_reset();
+	for(r = 0; r < 8; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+	host_watch_count = 0;
+	m68k_execute(1000);
+}
+
+int main(void)
+{
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, ENTRY);       /* Initial PC */
+	for(i = 0; i < sizeof(subroutine) / sizeof(*subroutine); i++)
+		host_poke_16(0x400 + i*2, subroutine[i]);
+	put_code(page_a, ENTRY - PAGE_A, code_a, sizeof(code_a) / sizeof(*code_a));
+	put_code(page_b, 0, code_b, sizeof(code_b) / sizeof(*code_b));
+	put_code(page_c, 0, code_b, sizeof(code_b) / sizeof(*code_b));
+	page_c[END - PAGE_B] = 0x7c;      /* moveq #9, d6 */
+	page_c[END - PAGE_B + 1] = 0x09;
+	page_c[END - PAGE_B + 2] = 0x60;  /* bra.s * */
+	page_c[END - PAGE_B + 3] = 0xfe;
+	host_watch_start = PAGE_A;
+	host_watch_end = PAGE_B + PAGE_SIZE;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_map_memory(PAGE_A, PAGE_SIZE, page_a, M68K_MAP_READ);
+	m68k_map_memory(PAGE_B, PAGE_SIZE, page_b, M68K_MAP_READ);
+
+	run();
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == END && m68k_get_reg(NULL, M68K_REG_D1) == 1 &&
+			m68k_get_reg(NULL, M68K_REG_D5) == 5 && m68k_get_reg(NULL, M68K_REG_D3) == 0x1234,
+			"code runs from mapped memory, through a call to unmapped memory");
+	host_check(m68k_get_reg(NULL, M68K_REG_D4) == 0xaabbccdd && m68k_get_reg(NULL, M68K_REG_D2) == 2,
+			"code runs on from the end of one mapped page into the next");
+	host_check(host_watch_count == 0, "mapped code isn't fetched through the callbacks");
+
+	page_a[ENTRY - PAGE_A + 1] = 7;   /* moveq #7, d0 */
+	run();
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 7, "a change to mapped code is seen");
+
+	/* Switch the page the CPU is looping in */
+	m68k_map_memory(PAGE_B, PAGE_SIZE, page_c, M68K_MAP_READ);
+	m68k_execute(100);
+	host_check(m68k_get_reg(NULL, M68K_REG_D6) == 9, "code is fetched from the new mapping of a page");
+
+	m68k_map_memory(PAGE_B, PAGE_SIZE, NULL, 0);
+	for(i = 0; i < sizeof(code_b) / sizeof(*code_b); i++)
+		host_poke_16(PAGE_B + i*2, code_b[i]);
+	run();
+	host_check(m68k_get_reg(NULL, M68K_REG_D2) == 2 && m68k_get_reg(NULL, M68K_REG_PC) == END &&
+			host_watch_count > 0, "code is fetched through the callbacks once the page is unmapped");
+
+	return host_result();
+}
@@ -0,0 +1,9 @@
+/* Configuration for dirty_pages_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_DIRTY_PAGES
+#define M68K_DIRTY_PAGES OPT_ON
+
+#undef M68K_MEMORY_MAP
+#define M68K_MEMORY_MAP OPT_ON
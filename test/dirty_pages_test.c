@@ -0,0 +1,75 @@
+/* M68K_DIRTY_PAGES: every page the CPU writes to, in mapped memory or
+ * through the callbacks, is returned once, in ascending order, and pages
+ * only the host wrote to or the CPU only read are not
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define MAPPED      0x100000
+#define MAPPED_SIZE 0x10000
+#define PAGE_SHIFT  12          /* M68K_DIRTY_PAGE_SHIFT */
+
+static const unsigned short program[] =
+{
+	0x41f9, 0x0010, 0x2000,         /* lea $102000, a0 */
+	0x43f9, 0x0020, 0x0ffe,         /* lea $200ffe, a1 */
+	0x1080,                         /* move.b d0, (a0) */
+	0x2280,                         /* move.l d0, (a1) (two pages) */
+	0x2039, 0x0030, 0x0000,         /* move.l $300000, d0 */
+	0x48f9, 0x00ff, 0x0040, 0x0000, /* movem.l d0-d7, $400000 */
+	0x33c0, 0x0010, 0x5000,         /* move.w d0, $105000 */
+	0x60fe                          /* bra.s * */
+};
+
+/* The pages the program writes to, in ascending order */
+static const unsigned written[] =
+{
+	0x102000 >> PAGE_SHIFT,
+	0x105000 >> PAGE_SHIFT,
+	0x200000 >> PAGE_SHIFT,
+	0x201000 >> PAGE_SHIFT,
+	0x400000 >> PAGE_SHIFT
+};
+
+#define WRITTEN (sizeof(written) / sizeof(*written))
+
+static unsigned char mapped[MAPPED_SIZE];
+
+int main(void)
+{
+	unsigned pages[16];
+	unsigned count;
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_map_memory(MAPPED, MAPPED_SIZE, mapped, M68K_MAP_RW);
+	m68k_pulse_reset();
+	m68k_get_dirty_pages(pages, 16);  /* Start from clean */
+
+	host_poke_32(0x500000, 1);        /* The host's own write */
+	m68k_execute(1000);
+
+	count = m68k_get_dirty_pages(pages, 16);
+	host_check(count == WRITTEN && memcmp(pages, written, sizeof(written)) == 0,
+			"the pages written to are returned in order");
+	host_check(m68k_get_dirty_pages(pages, 16) == 0, "returned pages are clean again");
+
+	m68k_pulse_reset();
+	m68k_execute(1000);
+	count = m68k_get_dirty_pages(pages, 2);
+	host_check(count == 2 && pages[0] == written[0] && pages[1] == written[1], "max pages are returned at a time");
+	count = m68k_get_dirty_pages(pages, 16);
+	host_check(count == WRITTEN - 2 && memcmp(pages, written + 2, sizeof(written) - 2 * sizeof(*written)) == 0,
+			"the rest are returned by the next call");
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for events_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_EVENTS
+#define M68K_EVENTS OPT_ON
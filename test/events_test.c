@@ -0,0 +1,156 @@
+/* M68K_EVENTS: events fire in the order they are due, at the end of the
+ * instruction running when they come due, whatever the timeslice length.
+ * A periodic event doesn't drift, a cancelled one doesn't fire, and each
+ * CPU context only fires its own events.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "m68k.h"
+#include "host.h"
+
+#define LONGEST     10      /* Clocks of the longest instruction in the loop */
+#define MAX_FIRED   64
+#define ONE_SHOTS   8
+
+static const unsigned short program[] =
+{
+	0x4e71,                 /* loop: nop */
+	0x5281,                 /*       addq.l #1, d1 */
+	0x60fa                  /*       bra.s loop */
+};
+
+/* The events that fired, and when */
+static int fired[MAX_FIRED];
+static unsigned long long fired_at[MAX_FIRED];
+static int fired_count;
+
+/* One-shot events, armed for delays[] clocks, which are due in order[] */
+static const int delays[ONE_SHOTS] = {500, 100, 300, 310, 700, 50, 650, 200};
+static const int order[ONE_SHOTS] = {5, 1, 7, 2, 3, 0, 6, 4};
+static int handles[ONE_SHOTS];
+static int periodic;
+
+static void record(int event)
+{
+	if(fired_count < MAX_FIRED)
+	{
+		fired[fired_count] = event;
+		fired_at[fired_count++] = m68k_get_time();
+	}
+}
+
+static void one_shot(int event)
+{
+	record(event);
+}
+
+static void repeat(int event)
+{
+	record(event);
+	m68k_set_event(event, 1000);
+}
+
+/* Check that the one-shot events fired in order, each as soon as it was due */
+static int in_order(unsigned long long start)
+{
+	int i;
+
+	if(fired_count != ONE_SHOTS)
+		return 0;
+	for(i = 0; i < ONE_SHOTS; i++)
+	{
+		unsigned long long due = start + delays[order[i]];
+
+		if(fired[i] != handles[order[i]] || fired_at[i] < due || fired_at[i] >= due + LONGEST)
+			return 0;
+	}
+	return 1;
+}
+
+static void run(int slice, unsigned long long until)
+{
+	while(m68k_get_time() < until)
+		m68k_execute(slice);
+}
+
+int main(void)
+{
+	static const int slices[] = {1, 7, 100, 100000};
+	unsigned size = m68k_context_size();
+	void* cpu_a = malloc(size);
+	void* cpu_b = malloc(size);
+	unsigned long long start;
+	char what[80];
+	unsigned i;
+	int e;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	for(e = 0; e < ONE_SHOTS; e++)
+		handles[e] = m68k_add_event(one_shot);
+	periodic = m68k_add_event(repeat);
+
+	/* Armed out of order */
+	for(i = 0; i < sizeof(slices) / sizeof(*slices); i++)
+	{
+		start = m68k_get_time();
+		for(e = 0; e < ONE_SHOTS; e++)
+			m68k_set_event(handles[e], delays[e]);
+		fired_count = 0;
+		run(slices[i], start + 1000);
+		sprintf(what, "%d clock timeslices: events fire in order when due", slices[i]);
+		host_check(in_order(start), what);
+	}
+
+	/* A periodic event, with a one-shot cancelled before it was due */
+	start = m68k_get_time();
+	m68k_set_event(periodic, 1000);
+	m68k_set_event(handles[0], 2500);
+	fired_count = 0;
+	run(7, start + 2000);
+	m68k_cancel_event(handles[0]);
+	run(7, start + 10500);
+	m68k_cancel_event(periodic);
+	for(e = 0; e < fired_count; e++)
+	{
+		unsigned long long when = start + (e + 1) * 1000;
+
+		if(fired[e] != periodic || fired_at[e] < when || fired_at[e] >= when + LONGEST)
+			break;
+	}
+	host_check(fired_count == 10 && e == 10, "a periodic event fires on time, and a cancelled one doesn't");
+
+	/* Two CPUs, each with an event of its own */
+	m68k_get_context(cpu_a);
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	e = m68k_add_event(one_shot);
+	m68k_set_event(e, 200);
+	m68k_get_context(cpu_b);
+
+	m68k_set_context(cpu_a);
+	m68k_set_event(handles[1], 300);
+	fired_count = 0;
+	start = m68k_get_time();
+	run(100, start + 1000);
+	host_check(fired_count == 1 && fired[0] == handles[1], "a CPU only fires its own events");
+
+	m68k_get_context(cpu_a);
+	m68k_set_context(cpu_b);
+	fired_count = 0;
+	run(100, 1000);
+	host_check(fired_count == 1 && fired[0] == e && m68k_get_time() < start,
+			"each CPU keeps its own clock");
+
+	free(cpu_a);
+	free(cpu_b);
+	return host_result();
+}
@@ -0,0 +1,9 @@
+/* Configuration for flagless_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_BLOCK_CACHE
+#define M68K_BLOCK_CACHE OPT_ON
+
+#undef M68K_FLAGLESS_OPCODES
+#define M68K_FLAGLESS_OPCODES OPT_ON
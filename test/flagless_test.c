@@ -0,0 +1,114 @@
+/* M68K_FLAGLESS_OPCODES: a loop whose flags are set again past instructions
+ * that leave them alone, read in between, and live at the end of a full
+ * block leaves the registers, SR and clocks just as running one instruction
+ * at a time does, with timeslices that end anywhere
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define END         0x42c   /* bra.s * */
+#define MAX_SLICES  4000
+
+static const unsigned short program[] =
+{
+	0x7e40,                 /*       moveq #64, d7 */
+	0xd480,                 /* loop: add.l d0, d2 */
+	0x41e8, 0x0004,         /*       lea 4(a0), a0 */
+	0x5289,                 /*       addq.l #1, a1 */
+	0xb682,                 /*       cmp.l d2, d3 */
+	0x2241,                 /*       movea.l d1, a1 */
+	0x40c5,                 /*       move sr, d5 */
+	0xd885,                 /*       add.l d5, d4 */
+	0xc141,                 /*       exg d0, d1 */
+	0x2602,                 /*       move.l d2, d3 */
+	0x93c8,                 /*       suba.l a0, a1 */
+	0x2448,                 /*       movea.l a0, a2 */
+	0xd5c4,                 /*       adda.l d4, a2 */
+	0x548a,                 /*       addq.l #2, a2 */
+	0x5389,                 /*       subq.l #1, a1 */
+	0xc54b,                 /*       exg a2, a3 */
+	0x9481,                 /*       sub.l d1, d2 */
+	0x6502,                 /*       bcs.s +2 */
+	0x5286,                 /*       addq.l #1, d6 */
+	0x5387,                 /*       subq.l #1, d7 */
+	0x66d6,                 /*       bne.s loop */
+	0x60fe                  /*       bra.s * */
+};
+
+/* Everything compared between the two runs, after each timeslice */
+typedef struct
+{
+	unsigned regs[MAX_SLICES][18];
+	int cycles[MAX_SLICES];
+	int slices;
+} state;
+
+/* Run one timeslice the way m68k_execute() does, one instruction at a time */
+static int step_slice(int cycles)
+{
+	int used = 0;
+
+	while(used < cycles)
+	{
+		unsigned pc = m68k_get_reg(NULL, M68K_REG_PC);
+		int step = m68k_step();
+
+		/* A branch to itself uses up the timeslice (see USE_ALL_CYCLES()) */
+		if(pc == END)
+			return cycles - (cycles - used) % step + step;
+		used += step;
+	}
+	return used;
+}
+
+static void run(state* s, int slice, int cached)
+{
+	int r;
+
+	memset(s, 0, sizeof(*s));
+	m68k_flush_block_cache();
+	m68k_pulse_reset();
+	m68k_step(); /* The reset */
+	for(r = 0; r < 15; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+	m68k_set_reg(M68K_REG_D0, 0x9e3779b9);
+	m68k_set_reg(M68K_REG_D1, 0x7f4a7c15);
+
+	for(s->slices = 0; s->slices < MAX_SLICES && m68k_get_reg(NULL, M68K_REG_PC) != END; s->slices++)
+	{
+		s->cycles[s->slices] = cached ? m68k_execute(slice) : step_slice(slice);
+		for(r = 0; r < 16; r++)
+			s->regs[s->slices][r] = m68k_get_reg(NULL, (m68k_register_t)(M68K_REG_D0 + r));
+		s->regs[s->slices][16] = m68k_get_reg(NULL, M68K_REG_PC);
+		s->regs[s->slices][17] = m68k_get_reg(NULL, M68K_REG_SR);
+	}
+}
+
+int main(void)
+{
+	static const int slices[] = {3, 5, 7, 11, 13, 33, 100, 1000, 100000};
+	static state cached;
+	static state stepped;
+	char what[80];
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+
+	for(i = 0; i < sizeof(slices) / sizeof(*slices); i++)
+	{
+		run(&stepped, slices[i], 0);
+		run(&cached, slices[i], 1);
+		sprintf(what, "%d clock timeslices: flagless handlers leave the flags as stepping", slices[i]);
+		host_check(cached.slices < MAX_SLICES && memcmp(&cached, &stepped, sizeof(cached)) == 0, what);
+	}
+	return host_result();
+}
@@ -0,0 +1,117 @@
+/* M68K_FUSED_OPCODES: a loop made of fused pairs leaves the registers,
+ * memory and clocks just as running one instruction at a time does, with
+ * timeslices that end anywhere, including between the two halves of a pair
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define END         0x436   /* bra.s * */
+#define MAX_SLICES  2000
+
+static const unsigned short program[] =
+{
+	0x41f9, 0x0001, 0x0000, /*       lea $10000, a0 */
+	0x43f9, 0x0001, 0x1000, /*       lea $11000, a1 */
+	0x303c, 0x003f,         /*       move.w #63, d0 */
+	0x22d8,                 /* copy: move.l (a0)+, (a1)+ */
+	0x51c8, 0xfffc,         /*       dbf d0, copy */
+	0x7e64,                 /*       moveq #100, d7 */
+	0xd487,                 /* loop: add.l d7, d2 */
+	0xb483,                 /*       cmp.l d3, d2 */
+	0x6202,                 /*       bhi.s +2 */
+	0x5284,                 /*       addq.l #1, d4 */
+	0x0c42, 0x0040,         /*       cmpi.w #$40, d2 */
+	0x6602,                 /*       bne.s +2 */
+	0x5285,                 /*       addq.l #1, d5 */
+	0x4a82,                 /*       tst.l d2 */
+	0x6b02,                 /*       bmi.s +2 */
+	0x5286,                 /*       addq.l #1, d6 */
+	0x2602,                 /*       move.l d2, d3 */
+	0xe68b,                 /*       lsr.l #3, d3 */
+	0x5387,                 /*       subq.l #1, d7 */
+	0x66e2,                 /*       bne.s loop */
+	0x60fe                  /*       bra.s * */
+};
+
+/* Everything compared between the two runs, after each timeslice */
+typedef struct
+{
+	unsigned regs[MAX_SLICES][17];
+	int cycles[MAX_SLICES];
+	int slices;
+	unsigned data[64];
+} state;
+
+/* Run one timeslice the way m68k_execute() does, one instruction at a time */
+static int step_slice(int cycles)
+{
+	int used = 0;
+
+	while(used < cycles)
+	{
+		unsigned pc = m68k_get_reg(NULL, M68K_REG_PC);
+		int step = m68k_step();
+
+		/* A branch to itself uses up the timeslice (see USE_ALL_CYCLES()) */
+		if(pc == END)
+			return cycles - (cycles - used) % step + step;
+		used += step;
+	}
+	return used;
+}
+
+static void run(state* s, int slice, int fused)
+{
+	int i;
+	int r;
+
+	memset(s, 0, sizeof(*s));
+	for(i = 0; i < 0x100; i += 4)
+	{
+		host_poke_32(0x10000 + i, i * 0x9e3779b9);
+		host_poke_32(0x11000 + i, 0);
+	}
+	m68k_pulse_reset();
+	m68k_step(); /* The reset */
+	for(r = 0; r < 15; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+
+	for(s->slices = 0; s->slices < MAX_SLICES && m68k_get_reg(NULL, M68K_REG_PC) != END; s->slices++)
+	{
+		s->cycles[s->slices] = fused ? m68k_execute(slice) : step_slice(slice);
+		for(r = 0; r < 16; r++)
+			s->regs[s->slices][r] = m68k_get_reg(NULL, (m68k_register_t)(M68K_REG_D0 + r));
+		s->regs[s->slices][16] = m68k_get_reg(NULL, M68K_REG_PC);
+	}
+	for(i = 0; i < 64; i++)
+		s->data[i] = host_peek_32(0x11000 + i*4);
+}
+
+int main(void)
+{
+	static const int slices[] = {5, 7, 13, 33, 100, 1000, 100000};
+	static state fused;
+	static state unfused;
+	char what[80];
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+
+	for(i = 0; i < sizeof(slices) / sizeof(*slices); i++)
+	{
+		run(&unfused, slices[i], 0);
+		run(&fused, slices[i], 1);
+		sprintf(what, "%d clock timeslices: fused pairs run as unfused", slices[i]);
+		host_check(fused.slices < MAX_SLICES && memcmp(&fused, &unfused, sizeof(fused)) == 0, what);
+	}
+	return host_result();
+}
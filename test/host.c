@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define RAM_SIZE 0x1000000
+
+static unsigned char ram[RAM_SIZE];
+static int failures;
+
+unsigned host_bus_error_start;
+unsigned host_bus_error_end;
+
+unsigned host_watch_start;
+unsigned host_watch_end;
+unsigned host_watch_count;
+
+void* host_user;
+
+/* Pass the user context on to bus_access() (see M68K_USER_CONTEXT) */
+#if M68K_USER_CONTEXT
+	#define HOST_USER user,
+#else
+	#define HOST_USER
+#endif
+
+/* Count an access, and raise a bus error if it's to be faulted.  Returns
+ * nonzero if it raised one.
+ */
+static int bus_access(M68K_USER_PARAM unsigned address)
+{
+#if M68K_USER_CONTEXT
+	host_user = user;
+#endif
+	if(address >= host_watch_start && address < host_watch_end)
+		host_watch_count++;
+	if(address >= host_bus_error_start && address < host_bus_error_end)
+	{
+		m68k_pulse_bus_error();
+		return 1;
+	}
+	return 0;
+}
+
+void host_poke_16(unsigned address, unsigned value)
+{
+	ram[address & (RAM_SIZE-1)] = value >> 8;
+	ram[(address+1) & (RAM_SIZE-1)] = value;
+}
+
+void host_poke_32(unsigned address, unsigned value)
+{
+	host_poke_16(address, value >> 16);
+	host_poke_16(address+2, value);
+}
+
+unsigned host_peek_16(unsigned address)
+{
+	return (ram[address & (RAM_SIZE-1)] << 8) | ram[(address+1) & (RAM_SIZE-1)];
+}
+
+unsigned host_peek_32(unsigned address)
+{
+	return (host_peek_16(address) << 16) | host_peek_16(address+2);
+}
+
+unsigned char* host_memory(void)
+{
+	return ram;
+}
+
+void host_check(int ok, const char* what)
+{
+	printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+	if(!ok)
+		failures++;
+}
+
+int host_result(void)
+{
+	return failures != 0;
+}
+
+unsigned m68k_read_memory_8(M68K_USER_PARAM unsigned address)
+{
+	return bus_access(HOST_USER address) ? 0 : ram[address & (RAM_SIZE-1)];
+}
+
+unsigned m68k_read_memory_16(M68K_USER_PARAM unsigned address)
+{
+	return bus_access(HOST_USER address) ? 0 : host_peek_16(address);
+}
+
+unsigned m68k_read_memory_32(M68K_USER_PARAM unsigned address)
+{
+	return bus_access(HOST_USER address) ? 0 : host_peek_32(address);
+}
+
+void m68k_write_memory_8(M68K_USER_PARAM unsigned address, unsigned value)
+{
+	if(!bus_access(HOST_USER address))
+		ram[address & (RAM_SIZE-1)] = value;
+}
+
+void m68k_write_memory_16(M68K_USER_PARAM unsigned address, unsigned value)
+{
+	if(!bus_access(HOST_USER address))
+		host_poke_16(address, value);
+}
+
+void m68k_write_memory_32(M68K_USER_PARAM unsigned address, unsigned value)
+{
+	if(!bus_access(HOST_USER address))
+		host_poke_32(address, value);
+}
+
+unsigned m68k_read_disassembler_8(unsigned address)
+{
+	return ram[address & (RAM_SIZE-1)];
+}
+
+unsigned m68k_read_disassembler_16(unsigned address)
+{
+	return host_peek_16(address);
+}
+
+unsigned m68k_read_disassembler_32(unsigned address)
+{
+	return host_peek_32(address);
+}
@@ -0,0 +1,38 @@
+#ifndef HOST__HEADER
+#define HOST__HEADER
+
+/* A bare machine for the tests: 16MB of RAM, which raises a bus error on
+ * any access from host_bus_error_start up to host_bus_error_end, and counts
+ * the accesses to a window of it.
+ */
+
+extern unsigned host_bus_error_start;
+extern unsigned host_bus_error_end;
+
+/* Number of calls to the memory callbacks for addresses from
+ * host_watch_start up to host_watch_end
+ */
+extern unsigned host_watch_start;
+extern unsigned host_watch_end;
+extern unsigned host_watch_count;
+
+/* The user context passed to the last memory callback, with
+ * M68K_USER_CONTEXT on
+ */
+extern void* host_user;
+
+void host_poke_16(unsigned address, unsigned value);
+void host_poke_32(unsigned address, unsigned value);
+unsigned host_peek_16(unsigned address);
+unsigned host_peek_32(unsigned address);
+
+/* The RAM itself, big-endian, for m68k_map_memory() */
+unsigned char* host_memory(void);
+
+/* Report a check, and remember if it failed */
+void host_check(int ok, const char* what);
+
+/* 0 if every check passed, 1 otherwise */
+int host_result(void);
+
+#endif /* HOST__HEADER */
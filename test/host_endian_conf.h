@@ -0,0 +1,9 @@
+/* Configuration for host_endian_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_MEMORY_MAP
+#define M68K_MEMORY_MAP OPT_ON
+
+#undef M68K_MEMORY_MAP_HOST_ENDIAN
+#define M68K_MEMORY_MAP_HOST_ENDIAN OPT_ON
@@ -0,0 +1,79 @@
+/* M68K_MEMORY_MAP_HOST_ENDIAN: m68k_swap_memory() converts an image to the
+ * mapped layout and back, and the CPU sees the same bytes, words and long
+ * words in it, in code and data, as in a big-endian image
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define PAGE        0x100000
+#define PAGE_SIZE   0x10000
+#define DATA        0x100
+
+static const unsigned short program[] =
+{
+	0x41f9, 0x0010, 0x0100,         /* lea $100100, a0 */
+	0x1010,                         /* move.b (a0), d0 */
+	0x1228, 0x0001,                 /* move.b 1(a0), d1 */
+	0x3410,                         /* move.w (a0), d2 */
+	0x2610,                         /* move.l (a0), d3 */
+	0x3828, 0x0002,                 /* move.w 2(a0), d4 */
+	0x117c, 0x00a5, 0x0008,         /* move.b #$a5, 8(a0) */
+	0x317c, 0x1234, 0x000a,         /* move.w #$1234, 10(a0) */
+	0x217c, 0xdead, 0xbeef, 0x000c, /* move.l #$deadbeef, 12(a0) */
+	0x60fe                          /* bra.s * */
+};
+
+static unsigned char image[PAGE_SIZE];
+static unsigned short mapped[PAGE_SIZE / 2];
+static unsigned char saved[PAGE_SIZE];
+
+int main(void)
+{
+	static const unsigned char data[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	static const unsigned char written[] = {0xa5, 0x00, 0x12, 0x34, 0xde, 0xad, 0xbe, 0xef};
+	static const unsigned short one = 1;
+	int little_endian = *(const unsigned char*)&one;
+	unsigned char* bytes = (unsigned char*)mapped;
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, PAGE);        /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+	{
+		image[i*2] = program[i] >> 8;
+		image[i*2 + 1] = program[i] & 0xff;
+	}
+	memcpy(image + DATA, data, sizeof(data));
+
+	m68k_swap_memory(mapped, image, PAGE_SIZE);
+	m68k_swap_memory(saved, mapped, PAGE_SIZE);
+	host_check(memcmp(saved, image, PAGE_SIZE) == 0, "an image converted and back is unchanged");
+	host_check(little_endian ? bytes[0] == image[1] && bytes[1] == image[0] : memcmp(bytes, image, PAGE_SIZE) == 0,
+			"mapped memory is in host-endian words");
+	m68k_swap_memory(saved, saved, PAGE_SIZE);
+	host_check(memcmp(saved, bytes, PAGE_SIZE) == 0, "an image can be converted in place");
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	if(little_endian)
+		host_check(!m68k_map_memory(PAGE, PAGE_SIZE, bytes + 1, M68K_MAP_RW), "an odd host address isn't mapped");
+	host_check(m68k_map_memory(PAGE, PAGE_SIZE, mapped, M68K_MAP_RW), "the converted image is mapped");
+
+	m68k_pulse_reset();
+	m68k_execute(1000);
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == PAGE + sizeof(program) - 2, "code runs from the converted image");
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 0x01 && m68k_get_reg(NULL, M68K_REG_D1) == 0x02,
+			"bytes read as in the big-endian image");
+	host_check(m68k_get_reg(NULL, M68K_REG_D2) == 0x0102 && m68k_get_reg(NULL, M68K_REG_D4) == 0x0304,
+			"words read as in the big-endian image");
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == 0x01020304, "long words read as in the big-endian image");
+
+	m68k_swap_memory(saved, mapped, PAGE_SIZE);
+	host_check(memcmp(saved + DATA + 8, written, sizeof(written)) == 0,
+			"bytes, words and long words written land as in the big-endian image");
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for idle_skip_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_IDLE_SKIP
+#define M68K_IDLE_SKIP OPT_ON
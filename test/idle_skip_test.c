@@ -0,0 +1,118 @@
+/* M68K_IDLE_SKIP: skipping a dbf to itself, a tst of memory polled until
+ * the host changes it and a btst of a register leaves the registers and
+ * clocks of every timeslice just as running one instruction at a time does
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define END         0x41c   /* bra.s * */
+#define STATUS      0x20000
+#define MAX_SLICES  10000
+#define SET_STATUS  30000   /* Clocks before the host writes to STATUS */
+#define SET_D3      40000   /* Clocks before the host sets d3 */
+#define RUN_CYCLES  60000
+
+static const unsigned short program[] =
+{
+	0x303c, 0x07cf,         /*       move.w #1999, d0 */
+	0x51c8, 0xfffe,         /*       dbf d0, * */
+	0x7201,                 /*       moveq #1, d1 */
+	0x41f9, 0x0002, 0x0000, /*       lea $20000, a0 */
+	0x4a10,                 /* poll: tst.b (a0) */
+	0x67fc,                 /*       beq.s poll */
+	0x7402,                 /*       moveq #2, d2 */
+	0x0803, 0x0000,         /* wait: btst #0, d3 */
+	0x67fa,                 /*       beq.s wait */
+	0x60fe                  /*       bra.s * */
+};
+
+/* Everything compared between the two runs, after each timeslice */
+typedef struct
+{
+	unsigned regs[MAX_SLICES][17];
+	int cycles[MAX_SLICES];
+	int slices;
+} state;
+
+static int idle_read(unsigned address)
+{
+	return address == STATUS;
+}
+
+/* Run one timeslice the way m68k_execute() does, one instruction at a time */
+static int step_slice(int cycles)
+{
+	int used = 0;
+
+	while(used < cycles)
+	{
+		unsigned pc = m68k_get_reg(NULL, M68K_REG_PC);
+		int step = m68k_step();
+
+		/* A branch to itself uses up the timeslice (see USE_ALL_CYCLES()) */
+		if(pc == END)
+			return cycles - (cycles - used) % step + step;
+		used += step;
+	}
+	return used;
+}
+
+static void run(state* s, int slice, int skip)
+{
+	int total = 0;
+	int r;
+
+	memset(s, 0, sizeof(*s));
+	host_poke_16(STATUS, 0);
+	m68k_pulse_reset();
+	m68k_step(); /* The reset */
+	for(r = 0; r < 15; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+
+	for(; s->slices < MAX_SLICES && total < RUN_CYCLES; s->slices++)
+	{
+		if(total >= SET_STATUS)
+			host_poke_16(STATUS, 0x8000);
+		if(total >= SET_D3)
+			m68k_set_reg(M68K_REG_D3, 1);
+		total += s->cycles[s->slices] = skip ? m68k_execute(slice) : step_slice(slice);
+		for(r = 0; r < 16; r++)
+			s->regs[s->slices][r] = m68k_get_reg(NULL, (m68k_register_t)(M68K_REG_D0 + r));
+		s->regs[s->slices][16] = m68k_get_reg(NULL, M68K_REG_PC);
+	}
+}
+
+int main(void)
+{
+	static const int slices[] = {20, 100, 1000, 25000};
+	static state skipped;
+	static state stepped;
+	unsigned long long idle;
+	char what[80];
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_set_idle_read_callback(idle_read);
+
+	for(i = 0; i < sizeof(slices) / sizeof(*slices); i++)
+	{
+		run(&stepped, slices[i], 0);
+		idle = m68k_get_idle_cycles();
+		run(&skipped, slices[i], 1);
+		sprintf(what, "%d clock timeslices: clocks are skipped", slices[i]);
+		host_check(m68k_get_idle_cycles() > idle, what);
+		sprintf(what, "%d clock timeslices: skipped loops take the clocks of running them", slices[i]);
+		host_check(m68k_get_reg(NULL, M68K_REG_PC) == END && m68k_get_reg(NULL, M68K_REG_D2) == 2 &&
+				memcmp(&skipped, &stepped, sizeof(skipped)) == 0, what);
+	}
+	return host_result();
+}
@@ -0,0 +1,12 @@
+/* Configuration for jit_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_BLOCK_CACHE
+#define M68K_BLOCK_CACHE OPT_ON
+
+#undef M68K_JIT
+#define M68K_JIT OPT_ON
+
+#undef M68K_MEMORY_MAP
+#define M68K_MEMORY_MAP OPT_ON
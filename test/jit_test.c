@@ -0,0 +1,232 @@
+/* M68K_JIT: each instruction form the JIT translates in place leaves the
+ * registers, SR, memory and clocks just as the interpreter does, on memory
+ * mapped with m68k_map_memory() and on memory behind the callbacks
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define CODE        0x1000
+#define MAPPED      0x010000
+#define UNMAPPED    0x810000
+#define DATA_SIZE   0x2000
+#define LOOPS       200
+#define RUN_CYCLES  40000
+
+#define MAX_WORDS   8
+#define MAX_FORMS   256
+
+/* An instruction form, with the instructions that set up its flags */
+typedef struct
+{
+	unsigned short words[MAX_WORDS];
+	int count;
+} form;
+
+/* Everything compared between the two runs */
+typedef struct
+{
+	unsigned regs[18];
+	int cycles;
+	unsigned short data[DATA_SIZE / 2];
+} state;
+
+static form forms[MAX_FORMS];
+static int form_count;
+
+static form* add_form(void)
+{
+	form* f = &forms[form_count++];
+
+	f->count = 0;
+	return f;
+}
+
+static void add_word(form* f, unsigned word)
+{
+	f->words[f->count++] = word;
+}
+
+/* EA mode MODE with the register the tests use for it */
+static unsigned ea(unsigned mode, int source)
+{
+	switch(mode)
+	{
+		case 0:  return source ? 1 : 2;   /* d1 / d2 */
+		case 1:  return 8 | 2;            /* a2 */
+		default: return (mode << 3) | (source ? 0 : 1); /* a0 / a1 */
+	}
+}
+
+static void make_forms(void)
+{
+	static const unsigned size_codes[] = {0x1000, 0x3000, 0x2000};
+	static const unsigned alu[] = {0xd000, 0x9000, 0xb000};
+	unsigned s, src, dst, op, cc;
+	form* f;
+
+	/* move <ea>, <ea> */
+	for(s = 0; s < 3; s++)
+		for(src = 0; src <= 5; src++)
+			for(dst = 0; dst <= 5; dst++)
+			{
+				if(dst == 1 || (src == 1 && s == 0))
+					continue;
+				f = add_form();
+				add_word(f, size_codes[s] | ((ea(dst, 0) & 7) << 9) | ((ea(dst, 0) >> 3) << 6) | ea(src, 1));
+				if(src == 5)
+					add_word(f, 0x0010);
+				if(dst == 5)
+					add_word(f, 0xffe0);
+			}
+
+	/* A7 stays even for bytes */
+	add_word(add_form(), 0x141f);     /* move.b (a7)+, d2 */
+	add_word(add_form(), 0x1f01);     /* move.b d1, -(a7) */
+
+	/* add/sub/cmp <ea>, d2 */
+	for(op = 0; op < 3; op++)
+		for(s = 0; s < 3; s++)
+			for(src = 0; src <= 5; src++)
+			{
+				if(src == 1 && s == 0)
+					continue;
+				f = add_form();
+				add_word(f, alu[op] | (2 << 9) | (s << 6) | ea(src, 1));
+				if(src == 5)
+					add_word(f, 0x0010);
+			}
+
+	/* lea (a0), a3 and lea -$20(a0), a3 */
+	add_word(add_form(), 0x47d0);
+	f = add_form();
+	add_word(f, 0x47e8);
+	add_word(f, 0xffe0);
+
+	/* Bcc over an addq, after a cmp that sets the flags */
+	for(cc = 0; cc < 16; cc++)
+	{
+		if(cc == 1)
+			continue;
+		f = add_form();
+		add_word(f, 0xbc81);          /* cmp.l d1, d6 */
+		add_word(f, 0x6002 | (cc << 8));
+		add_word(f, 0x5283);          /* addq.l #1, d3 */
+
+		f = add_form();
+		add_word(f, 0xbc81);
+		add_word(f, 0x6000 | (cc << 8));
+		add_word(f, 0x0004);
+		add_word(f, 0x5283);
+	}
+
+	/* DBcc d0 over an addq */
+	for(cc = 0; cc < 16; cc++)
+	{
+		f = add_form();
+		add_word(f, 0xbc81);
+		add_word(f, 0x50c8 | (cc << 8));
+		add_word(f, 0x0004);
+		add_word(f, 0x5283);
+	}
+}
+
+/* Run a form LOOPS times from a known state */
+static void run(state* s, const form* f, unsigned data, int jit)
+{
+	static const unsigned short tail[] =
+	{
+		0x40e6,         /* move sr, -(a6) */
+		0xd284,         /* add.l d4, d1 */
+		0x5387,         /* subq.l #1, d7 */
+		0x6600,         /* bne.w loop */
+		0,
+		0x60fe          /* bra.s * */
+	};
+	unsigned address = CODE;
+	int i;
+
+	for(i = 0; i < f->count; i++, address += 2)
+		host_poke_16(address, f->words[i]);
+	for(i = 0; i < 6; i++, address += 2)
+		host_poke_16(address, i == 4 ? (CODE - address) & 0xffff : tail[i]);
+	for(i = 0; i < DATA_SIZE; i += 4)
+		host_poke_32(data + i, i * 0x9e3779b9 + 0x1234567);
+
+	m68k_pulse_reset();
+	m68k_set_jit(jit);
+	m68k_set_reg(M68K_REG_SR, 0x2704);
+	m68k_set_reg(M68K_REG_PC, CODE);
+	m68k_set_reg(M68K_REG_D0, 40);
+	m68k_set_reg(M68K_REG_D1, 0x80017fff);
+	m68k_set_reg(M68K_REG_D2, 0x12345678);
+	m68k_set_reg(M68K_REG_D3, 0);
+	m68k_set_reg(M68K_REG_D4, 0x3c6ef373);
+	m68k_set_reg(M68K_REG_D5, 0);
+	m68k_set_reg(M68K_REG_D6, 0x7fff8001);
+	m68k_set_reg(M68K_REG_D7, LOOPS);
+	m68k_set_reg(M68K_REG_A0, data + 0x800);
+	m68k_set_reg(M68K_REG_A1, data + 0x1000);
+	m68k_set_reg(M68K_REG_A2, 0x1234abcd);
+	m68k_set_reg(M68K_REG_A3, 0);
+	m68k_set_reg(M68K_REG_A6, data + DATA_SIZE);
+	m68k_set_reg(M68K_REG_A7, data + 0x1800);
+
+	s->cycles = m68k_execute(RUN_CYCLES);
+	for(i = 0; i < 16; i++)
+		s->regs[i] = m68k_get_reg(NULL, (m68k_register_t)(M68K_REG_D0 + i));
+	s->regs[16] = m68k_get_reg(NULL, M68K_REG_PC);
+	s->regs[17] = m68k_get_reg(NULL, M68K_REG_SR);
+	for(i = 0; i < DATA_SIZE / 2; i++)
+		s->data[i] = host_peek_16(data + i*2);
+}
+
+int main(void)
+{
+	static const struct
+	{
+		int type;
+		const char* name;
+	} cpus[] =
+	{
+		{M68K_CPU_TYPE_68000, "68000"},
+		{M68K_CPU_TYPE_68020, "68020"}
+	};
+	static state jit;
+	static state interpreter;
+	char what[80];
+	unsigned c, m;
+	int i;
+
+	make_forms();
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, CODE);        /* Initial PC */
+
+	m68k_init();
+	m68k_map_memory(0, 0x800000, host_memory(), M68K_MAP_RW);
+
+	for(c = 0; c < sizeof(cpus) / sizeof(*cpus); c++)
+		for(m = 0; m < 2; m++)
+		{
+			int differ = 0;
+
+			m68k_set_cpu_type(cpus[c].type);
+			for(i = 0; i < form_count; i++)
+			{
+				run(&jit, &forms[i], m ? UNMAPPED : MAPPED, 1);
+				run(&interpreter, &forms[i], m ? UNMAPPED : MAPPED, 0);
+				if(memcmp(&jit, &interpreter, sizeof(jit)) != 0)
+				{
+					printf("  %04x %04x differs\n", forms[i].words[0], forms[i].words[1]);
+					differ++;
+				}
+			}
+			sprintf(what, "%s, %s memory: %d forms run as when interpreted", cpus[c].name,
+					m ? "unmapped" : "mapped", form_count);
+			host_check(differ == 0, what);
+		}
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for lazy_flags_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_LAZY_FLAGS
+#define M68K_LAZY_FLAGS OPT_ON
@@ -0,0 +1,107 @@
+/* M68K_LAZY_FLAGS: each instruction that sets the flags lazily leaves the
+ * same condition codes as computing them straight away, as seen by MOVE
+ * from SR, by m68k_get_reg() and in an exception frame
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define CODE 0x400
+
+/* An instruction, its operands in d0 and d1, and the CCR before and after */
+typedef struct
+{
+	unsigned short words[2];
+	unsigned d0;
+	unsigned d1;
+	unsigned ccr_in;
+	unsigned ccr_out;
+	const char* name;
+} flag_case;
+
+static const flag_case cases[] =
+{
+	{{0x2200},         0x00000000, 0x00000000, 0x1f, 0x14, "move.l zero"},
+	{{0x2200},         0x80000000, 0x00000000, 0x03, 0x08, "move.l negative"},
+	{{0x3200},         0x00010000, 0x00000000, 0x00, 0x04, "move.w zero"},
+	{{0x72ff},         0x00000000, 0x00000000, 0x04, 0x08, "moveq"},
+	{{0x4a40},         0x12348000, 0x00000000, 0x10, 0x18, "tst.w"},
+	{{0x4281},         0x00000000, 0x12345678, 0x0b, 0x04, "clr.l"},
+	{{0xc280},         0xf0f0f0f0, 0x0f0f0f0f, 0x13, 0x14, "and.l"},
+	{{0x8240},         0x00008000, 0x00000000, 0x00, 0x08, "or.w"},
+	{{0xb181},         0x00005555, 0x00005555, 0x00, 0x04, "eor.l"},
+	{{0x4601},         0x00000000, 0x0000007f, 0x00, 0x08, "not.b"},
+	{{0xd280},         0x00000001, 0x7fffffff, 0x00, 0x0a, "add.l overflow"},
+	{{0xd280},         0x00000001, 0xffffffff, 0x00, 0x15, "add.l carry"},
+	{{0xd200},         0x00000080, 0x00000080, 0x00, 0x17, "add.b carry and overflow"},
+	{{0x9280},         0x00000001, 0x00000000, 0x00, 0x19, "sub.l borrow"},
+	{{0x9280},         0x00000001, 0x80000000, 0x00, 0x02, "sub.l overflow"},
+	{{0xb280},         0x00000005, 0x00000005, 0x10, 0x14, "cmp.l equal"},
+	{{0xb280},         0x00000001, 0x00000000, 0x00, 0x09, "cmp.l lower"},
+	{{0x5201},         0x00000000, 0x0000007f, 0x00, 0x0a, "addq.b"},
+	{{0x5341},         0x00000000, 0x00000000, 0x00, 0x19, "subq.w"},
+	{{0x0641, 0x8000}, 0x00000000, 0x00008000, 0x00, 0x17, "addi.w"},
+	{{0x0c01, 0x0080}, 0x00000000, 0x0000007f, 0x10, 0x1b, "cmpi.b"},
+	{{0x4481},         0x00000000, 0x80000000, 0x00, 0x1b, "neg.l"}
+};
+
+/* Run the case's instruction, followed by INSTRUCTION, from a known state */
+static void run(const flag_case* c, unsigned instruction)
+{
+	unsigned address = CODE;
+	int r;
+
+	host_poke_16(address, c->words[0]);
+	address += 2;
+	if(c->words[1])
+	{
+		host_poke_16(address, c->words[1]);
+		address += 2;
+	}
+	host_poke_16(address, instruction);
+
+	for(r = 0; r < 8; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+	m68k_set_reg(M68K_REG_D0, c->d0);
+	m68k_set_reg(M68K_REG_D1, c->d1);
+	m68k_set_reg(M68K_REG_A7, 0x1000);
+	m68k_set_reg(M68K_REG_SR, 0x2700 | c->ccr_in);
+	m68k_set_reg(M68K_REG_PC, CODE);
+	m68k_step();
+	m68k_step();
+}
+
+int main(void)
+{
+	char what[80];
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, CODE);        /* Initial PC */
+	host_poke_32(0x080, 0x600);       /* TRAP #0 vector */
+	host_poke_16(0x600, 0x3e17);      /* move.w (a7), d7 */
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	m68k_step();
+
+	for(i = 0; i < sizeof(cases) / sizeof(*cases); i++)
+	{
+		const flag_case* c = &cases[i];
+		int ok;
+
+		run(c, 0x40c7);               /* move sr, d7 */
+		ok = (m68k_get_reg(NULL, M68K_REG_D7) & 0x1f) == c->ccr_out;
+		run(c, 0x4e71);               /* nop */
+		ok &= (m68k_get_reg(NULL, M68K_REG_SR) & 0x1f) == c->ccr_out;
+		run(c, 0x4e40);               /* trap #0 */
+		m68k_step();
+		ok &= (m68k_get_reg(NULL, M68K_REG_D7) & 0x1f) == c->ccr_out;
+		sprintf(what, "%s sets the flags", c->name);
+		host_check(ok, what);
+	}
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for memory_fc_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_MEMORY_FC
+#define M68K_MEMORY_FC OPT_ON
@@ -0,0 +1,101 @@
+/* M68K_MEMORY_FC: each access reaches the memory functions with its function
+ * code: supervisor and user, program and data, and the SFC and DFC of MOVES
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define DATA 0x2000
+
+/* The function code of the last access to each long word, plus 1 */
+static unsigned fc_at[0x1000];
+
+static void note(unsigned address, unsigned fc)
+{
+	if(address < 0x4000)
+		fc_at[address >> 2] = fc + 1;
+}
+
+unsigned m68k_read_memory_8_fc(M68K_USER_PARAM unsigned address, unsigned fc)
+{
+	note(address, fc);
+	return host_peek_16(address & ~1) >> (address & 1 ? 0 : 8) & 0xff;
+}
+
+unsigned m68k_read_memory_16_fc(M68K_USER_PARAM unsigned address, unsigned fc)
+{
+	note(address, fc);
+	return host_peek_16(address);
+}
+
+unsigned m68k_read_memory_32_fc(M68K_USER_PARAM unsigned address, unsigned fc)
+{
+	note(address, fc);
+	return host_peek_32(address);
+}
+
+void m68k_write_memory_8_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value)
+{
+	unsigned word = host_peek_16(address & ~1);
+
+	note(address, fc);
+	host_poke_16(address & ~1, address & 1 ? (word & 0xff00) | value : (word & 0xff) | value << 8);
+}
+
+void m68k_write_memory_16_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value)
+{
+	note(address, fc);
+	host_poke_16(address, value);
+}
+
+void m68k_write_memory_32_fc(M68K_USER_PARAM unsigned address, unsigned fc, unsigned value)
+{
+	note(address, fc);
+	host_poke_32(address, value);
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x2010,                 /* move.l (a0), d0 */
+		0x2280,                 /* move.l d0, (a1) */
+		0x0e92, 0x1000,         /* moves.l (a2), d1 */
+		0x0e93, 0x1800,         /* moves.l d1, (a3) */
+		0x46fc, 0x0000,         /* move #0, sr */
+		0x2414,                 /* move.l (a4), d2 */
+		0x2a82,                 /* move.l d2, (a5) */
+		0x4ef8, 0x0500          /* jmp $500.w */
+	};
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+	host_poke_16(0x500, 0x60fe);      /* bra.s * */
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68010);
+	m68k_pulse_reset();
+	m68k_step();
+	for(i = 0; i < 6; i++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_A0 + i), DATA + i * 4);
+	m68k_set_reg(M68K_REG_SFC, 3);
+	m68k_set_reg(M68K_REG_DFC, 4);
+	for(i = 0; i < sizeof(fc_at) / sizeof(*fc_at); i++)
+		fc_at[i] = 0;
+	m68k_execute(1000);
+
+	host_check(fc_at[0x400 >> 2] == 6 + 1, "supervisor fetches are supervisor program accesses");
+	host_check(fc_at[(DATA + 0) >> 2] == 5 + 1 && fc_at[(DATA + 4) >> 2] == 5 + 1,
+			"supervisor reads and writes are supervisor data accesses");
+	host_check(fc_at[(DATA + 8) >> 2] == 3 + 1, "moves reads with the SFC");
+	host_check(fc_at[(DATA + 12) >> 2] == 4 + 1, "moves writes with the DFC");
+	host_check(fc_at[(DATA + 16) >> 2] == 1 + 1 && fc_at[(DATA + 20) >> 2] == 1 + 1,
+			"user reads and writes are user data accesses");
+	host_check(fc_at[0x500 >> 2] == 2 + 1, "user fetches are user program accesses");
+
+	return host_result();
+}
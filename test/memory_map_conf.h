@@ -0,0 +1,6 @@
+/* Configuration for memory_map_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_MEMORY_MAP
+#define M68K_MEMORY_MAP OPT_ON
@@ -0,0 +1,84 @@
+/* M68K_MEMORY_MAP: the CPU reads and writes mapped RAM directly, reads
+ * mapped ROM directly but sends its writes to the callbacks, and uses the
+ * callbacks for accesses that cross into the next page and for memory that
+ * was unmapped again
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define RAM_START   0x100000
+#define RAM_SIZE    0x20000
+#define ROM_START   0x200000
+#define ROM_SIZE    0x10000
+
+static const unsigned short program[] =
+{
+	0x41f9, 0x0010, 0x0000,         /* lea $100000, a0 */
+	0x43f9, 0x0020, 0x0000,         /* lea $200000, a1 */
+	0x20bc, 0x1234, 0x5678,         /* move.l #$12345678, (a0) */
+	0x3210,                         /* move.w (a0), d1 */
+	0x1428, 0x0003,                 /* move.b 3(a0), d2 */
+	0x2611,                         /* move.l (a1), d3 */
+	0x22bc, 0x1122, 0x3344,         /* move.l #$11223344, (a1) */
+	0x23fc, 0x5566, 0x7788, 0x0010, 0xfffe, /* move.l #$55667788, $10fffe */
+	0x3810,                         /* move.w (a0), d4 */
+	0x60fe                          /* bra.s * */
+};
+
+static unsigned char ram[RAM_SIZE];
+static unsigned char rom[ROM_SIZE];
+
+static void run(void)
+{
+	int r;
+
+	m68k_pulse_reset();
+	for(r = 0; r < 8; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+	host_watch_count = 0;
+	m68k_execute(1000);
+}
+
+int main(void)
+{
+	static const unsigned char stored[] = {0x12, 0x34, 0x56, 0x78};
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+	rom[0] = 0xde;
+	rom[1] = 0xad;
+	rom[2] = 0xbe;
+	rom[3] = 0xef;
+	host_watch_start = RAM_START;
+	host_watch_end = ROM_START + ROM_SIZE;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	host_check(!m68k_map_memory(RAM_START + 0x100, 0x10000, ram, M68K_MAP_RW), "an unaligned range isn't mapped");
+	host_check(m68k_map_memory(RAM_START, RAM_SIZE, ram, M68K_MAP_RW) &&
+			m68k_map_memory(ROM_START, ROM_SIZE, rom, M68K_MAP_READ), "aligned ranges are mapped");
+
+	run();
+	host_check(memcmp(ram, stored, 4) == 0 && host_peek_32(RAM_START) == 0, "writes to RAM go to the mapped memory");
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 0x1234 && m68k_get_reg(NULL, M68K_REG_D2) == 0x78,
+			"reads from RAM come from the mapped memory");
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == 0xdeadbeef, "reads from ROM come from the mapped memory");
+	host_check(rom[0] == 0xde && host_peek_32(ROM_START) == 0x11223344, "writes to ROM go to the callbacks");
+	host_check(host_peek_32(RAM_START + 0xfffe) == 0x55667788 && ram[0xfffe] == 0,
+			"a long word across two pages goes to the callbacks");
+	host_check(host_watch_count == 2, "only those two accesses reach the callbacks");
+
+	/* Handing the RAM back to the callbacks */
+	m68k_map_memory(RAM_START, RAM_SIZE, NULL, 0);
+	run();
+	host_check(m68k_get_reg(NULL, M68K_REG_D4) == 0x1234 && host_peek_32(RAM_START) == 0x12345678,
+			"unmapped RAM goes to the callbacks");
+
+	return host_result();
+}
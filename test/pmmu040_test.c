@@ -0,0 +1,79 @@
+/* A 68040 page fault: the access error frame tells the handler which page
+ * faulted, and RTE restarts the instruction once the handler has mapped it
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define ROOT_TABLE    0x10000
+#define POINTER_TABLE 0x10200
+#define LOW_PAGES     0x10400  /* Maps 0x00000-0x3ffff to itself */
+#define FAULT_PAGES   0x10500  /* Maps 0x40000-0x7ffff, empty to begin with */
+#define FAULT_ADDRESS 0x40010
+#define PHYSICAL_PAGE 0x20000
+
+static unsigned poke_code(unsigned address, const unsigned short* code, int words)
+{
+	int i;
+
+	for(i = 0; i < words; i++)
+		host_poke_16(address + i*2, code[i]);
+	return address + words*2;
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x203c, ROOT_TABLE >> 16, ROOT_TABLE & 0xffff, /* move.l #ROOT_TABLE, d0 */
+		0x4e7b, 0x0806,                                /* movec d0, urp */
+		0x4e7b, 0x0807,                                /* movec d0, srp */
+		0x203c, 0x0000, 0x8000,                        /* move.l #$8000, d0 */
+		0x4e7b, 0x0003,                                /* movec d0, tc */
+		0xf518,                                        /* pflusha */
+		0x207c, FAULT_ADDRESS >> 16, FAULT_ADDRESS & 0xffff, /* movea.l #FAULT_ADDRESS, a0 */
+		0x2210,                                        /* move.l (a0), d1 */
+		0x60fe,                                        /* bra.s * */
+	};
+	static const unsigned short handler[] =
+	{
+		0x23fc, PHYSICAL_PAGE >> 16, 1, FAULT_PAGES >> 16, FAULT_PAGES & 0xffff, /* move.l #PHYSICAL_PAGE|1, FAULT_PAGES */
+		0x3c2f, 0x0006,                                /* move.w (6, a7), d6 */
+		0x382f, 0x000c,                                /* move.w (12, a7), d4 */
+		0x262f, 0x0014,                                /* move.l (20, a7), d3 */
+		0x5285,                                        /* addq.l #1, d5 */
+		0x4e73,                                        /* rte */
+	};
+	unsigned end;
+	int i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	host_poke_32(0x008, 0x600);       /* Access error vector */
+	end = poke_code(0x400, program, sizeof(program) / sizeof(program[0])) - 2;
+	poke_code(0x600, handler, sizeof(handler) / sizeof(handler[0]));
+
+	host_poke_32(ROOT_TABLE, POINTER_TABLE | 2);
+	host_poke_32(POINTER_TABLE, LOW_PAGES | 2);
+	host_poke_32(POINTER_TABLE + 4, FAULT_PAGES | 2);
+	for(i = 0; i < 64; i++)
+		host_poke_32(LOW_PAGES + i*4, (i << 12) | 1);
+	host_poke_32(PHYSICAL_PAGE + (FAULT_ADDRESS & 0xfff), 0xdeadbeef);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68040);
+	m68k_pulse_reset();
+	for(i = 0; i < 100 && m68k_get_reg(NULL, M68K_REG_PC) != end; i++)
+		m68k_step();
+
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == end, "program ran to the end");
+	host_check(m68k_get_reg(NULL, M68K_REG_D5) == 1, "one access error");
+	host_check(m68k_get_reg(NULL, M68K_REG_D6) == 0x7008, "format 7 frame");
+	host_check(m68k_get_reg(NULL, M68K_REG_D4) == 0x505, "SSW: ATC fault, long read of supervisor data");
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == FAULT_ADDRESS, "fault address is the logical address");
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 0xdeadbeef, "restarted instruction read the new page");
+	host_check(m68k_get_reg(NULL, M68K_REG_SP) == 0x1000, "RTE popped the whole frame");
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for pmmu_atc_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_PMMU_ATC
+#define M68K_PMMU_ATC OPT_ON
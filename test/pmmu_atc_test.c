@@ -0,0 +1,87 @@
+/* M68K_PMMU_ATC: translations are cached until the guest flushes them, with
+ * PFLUSH of the page, PFLUSHA or a write to the TC
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define ROOT_TABLE    0x10000
+#define POINTER_TABLE 0x10200
+#define LOW_PAGES     0x10400  /* Maps 0x00000-0x3ffff to itself */
+#define HIGH_PAGES    0x10500  /* Maps 0x40000-0x7ffff */
+#define LOGICAL       0x40010
+
+static unsigned poke_code(unsigned address, const unsigned short* code, int words)
+{
+	int i;
+
+	for(i = 0; i < words; i++)
+		host_poke_16(address + i*2, code[i]);
+	return address + words*2;
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x203c, ROOT_TABLE >> 16, ROOT_TABLE & 0xffff, /* move.l #ROOT_TABLE, d0 */
+		0x4e7b, 0x0806,                                /* movec d0, urp */
+		0x4e7b, 0x0807,                                /* movec d0, srp */
+		0x4e7b, 0x7003,                                /* movec d7, tc */
+		0xf518,                                        /* pflusha */
+		0x7005,                                        /* moveq #5, d0 */
+		0x4e7b, 0x0001,                                /* movec d0, dfc */
+		0x207c, LOGICAL >> 16, LOGICAL & 0xffff,       /* movea.l #LOGICAL, a0 */
+		0x2210,                                        /* move.l (a0), d1 */
+		0x23fc, 0x0002, 0x1001, HIGH_PAGES >> 16, HIGH_PAGES & 0xffff, /* move.l #$21001, HIGH_PAGES */
+		0x2410,                                        /* move.l (a0), d2 */
+		0xf508,                                        /* pflush (a0) */
+		0x2610,                                        /* move.l (a0), d3 */
+		0x23fc, 0x0002, 0x2001, HIGH_PAGES >> 16, HIGH_PAGES & 0xffff, /* move.l #$22001, HIGH_PAGES */
+		0x2810,                                        /* move.l (a0), d4 */
+		0x4e7b, 0x7003,                                /* movec d7, tc */
+		0x2a10,                                        /* move.l (a0), d5 */
+		0x23fc, 0x0002, 0x1001, HIGH_PAGES >> 16, HIGH_PAGES & 0xffff, /* move.l #$21001, HIGH_PAGES */
+		0xf518,                                        /* pflusha */
+		0x2c10,                                        /* move.l (a0), d6 */
+		0x60fe,                                        /* bra.s * */
+	};
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned end;
+	int i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	end = poke_code(0x400, program, sizeof(program) / sizeof(program[0])) - 2;
+
+	host_poke_32(ROOT_TABLE, POINTER_TABLE | 2);
+	host_poke_32(POINTER_TABLE, LOW_PAGES | 2);
+	host_poke_32(POINTER_TABLE + 4, HIGH_PAGES | 2);
+	for(i = 0; i < 64; i++)
+		host_poke_32(LOW_PAGES + i*4, (i << 12) | 1);
+	host_poke_32(HIGH_PAGES, 0x20001);
+	host_poke_32(0x20000 + (LOGICAL & 0xfff), 0x11111111);
+	host_poke_32(0x21000 + (LOGICAL & 0xfff), 0x22222222);
+	host_poke_32(0x22000 + (LOGICAL & 0xfff), 0x33333333);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68040);
+	m68k_pulse_reset();
+	m68k_set_reg(M68K_REG_D7, 0x8000);
+	for(i = 0; i < 100 && m68k_get_reg(NULL, M68K_REG_PC) != end; i++)
+		m68k_step();
+	m68k_get_atc_stats(&hits, &misses);
+
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == end, "program ran to the end");
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 0x11111111, "the page is translated");
+	host_check(m68k_get_reg(NULL, M68K_REG_D2) == 0x11111111, "a changed descriptor isn't seen until it is flushed");
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == 0x22222222, "PFLUSH of the page flushes its translation");
+	host_check(m68k_get_reg(NULL, M68K_REG_D4) == 0x22222222, "the new translation is cached");
+	host_check(m68k_get_reg(NULL, M68K_REG_D5) == 0x33333333, "a write to the TC flushes the cache");
+	host_check(m68k_get_reg(NULL, M68K_REG_D6) == 0x22222222, "PFLUSHA flushes the cache");
+	host_check(hits > misses, "most translations are found in the cache");
+
+	return host_result();
+}
@@ -0,0 +1,83 @@
+/* 68030 transparent translation: an access that TT0 or TT1 matches on
+ * address, function code and direction skips the ATC and the tables, and
+ * one they don't match is translated
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define TABLE_A       0x10000  /* Early termination descriptors, 16MB each */
+#define REGISTERS     0x3100   /* Values for the PMOVEs */
+#define PHYSICAL      0x3000   /* Where 0x01003000 and 0x02003000 are without translation */
+#define TRANSLATED    0x403000 /* Where the tables put them */
+
+static unsigned poke_code(unsigned address, const unsigned short* code, int words)
+{
+	int i;
+
+	for(i = 0; i < words; i++)
+		host_poke_16(address + i*2, code[i]);
+	return address + words*2;
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0xf010, 0x4c00,                 /* pmove (a0), crp */
+		0xf011, 0x4000,                 /* pmove (a1), tc */
+		0x2239, 0x0100, 0x3000,         /* move.l $01003000, d1 */
+		0xf012, 0x0800,                 /* pmove (a2), tt0 */
+		0x2439, 0x0100, 0x3000,         /* move.l $01003000, d2 */
+		0xf013, 0x0800,                 /* pmove (a3), tt0 */
+		0x2639, 0x0100, 0x3000,         /* move.l $01003000, d3 */
+		0x23c6, 0x0100, 0x3004,         /* move.l d6, $01003004 */
+		0xf014, 0x0c00,                 /* pmove (a4), tt1 */
+		0x2839, 0x0200, 0x3000,         /* move.l $02003000, d4 */
+		0x46fc, 0x0000,                 /* move #0, sr */
+		0x2a39, 0x0200, 0x3000,         /* move.l $02003000, d5 */
+		0x60fe                          /* bra.s * */
+	};
+	unsigned end;
+	int i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	end = poke_code(0x400, program, sizeof(program) / sizeof(program[0])) - 2;
+
+	host_poke_32(TABLE_A + 0, 0x000001);      /* 0x00xxxxxx to itself */
+	host_poke_32(TABLE_A + 4, 0x400001);      /* 0x01xxxxxx to 0x40xxxx */
+	host_poke_32(TABLE_A + 8, 0x400001);      /* 0x02xxxxxx to 0x40xxxx */
+	host_poke_32(REGISTERS + 0x00, 0x00000002);   /* CRP: 4 byte descriptors */
+	host_poke_32(REGISTERS + 0x04, TABLE_A);
+	host_poke_32(REGISTERS + 0x08, 0x80c08c00);   /* TC: 4K pages, 8 bits in table A */
+	host_poke_32(REGISTERS + 0x0c, 0x01008107);   /* 0x01xxxxxx, any FC, reads and writes */
+	host_poke_32(REGISTERS + 0x10, 0x01008207);   /* 0x01xxxxxx, any FC, reads only */
+	host_poke_32(REGISTERS + 0x14, 0x02008110);   /* 0x02xxxxxx, user data only */
+	host_poke_32(PHYSICAL, 0x11111111);
+	host_poke_32(TRANSLATED, 0x44444444);
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68030);
+	m68k_pulse_reset();
+	m68k_set_reg(M68K_REG_A0, REGISTERS + 0x00);
+	m68k_set_reg(M68K_REG_A1, REGISTERS + 0x08);
+	m68k_set_reg(M68K_REG_A2, REGISTERS + 0x0c);
+	m68k_set_reg(M68K_REG_A3, REGISTERS + 0x10);
+	m68k_set_reg(M68K_REG_A4, REGISTERS + 0x14);
+	m68k_set_reg(M68K_REG_D6, 0xcafef00d);
+	for(i = 0; i < 100 && m68k_get_reg(NULL, M68K_REG_PC) != end; i++)
+		m68k_step();
+
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == end, "program ran to the end");
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 0x44444444, "an access no TT matches is translated");
+	host_check(m68k_get_reg(NULL, M68K_REG_D2) == 0x11111111, "a TT0 match skips a translation in the ATC");
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == 0x11111111, "a read-only TT0 matches reads");
+	host_check(host_peek_32(TRANSLATED + 4) == 0xcafef00d && host_peek_32(PHYSICAL + 4) != 0xcafef00d,
+			"a read-only TT0 doesn't match writes");
+	host_check(m68k_get_reg(NULL, M68K_REG_D4) == 0x44444444, "TT1 doesn't match another function code");
+	host_check(m68k_get_reg(NULL, M68K_REG_D5) == 0x11111111, "TT1 matches its function code");
+
+	return host_result();
+}
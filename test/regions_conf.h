@@ -0,0 +1,12 @@
+/* Configuration for regions_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_MEMORY_MAP
+#define M68K_MEMORY_MAP OPT_ON
+
+#undef M68K_MEMORY_MAP_PAGE_SHIFT
+#define M68K_MEMORY_MAP_PAGE_SHIFT 12
+
+#undef M68K_MEMORY_REGIONS
+#define M68K_MEMORY_REGIONS OPT_ON
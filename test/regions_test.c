@@ -0,0 +1,142 @@
+/* M68K_MEMORY_REGIONS: accesses to a region go to its device's handler for
+ * the access size, a NULL handler leaves them to the callbacks, memory
+ * mapped for a direction takes precedence, and an unmapped region is left
+ * to the callbacks again
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define DEVICE      0x20000
+#define SHADOW      0x21000
+#define PAGE_SIZE   0x1000
+
+/* The handler calls the device has seen */
+typedef struct
+{
+	unsigned calls;
+	unsigned size;
+	unsigned address;
+	unsigned value;
+	int wrong_device;
+} device;
+
+static device dev;
+static unsigned char shadow[PAGE_SIZE];
+
+static void note(void* d, unsigned size, unsigned address, unsigned value)
+{
+	dev.wrong_device |= d != &dev;
+	dev.calls++;
+	dev.size = size;
+	dev.address = address;
+	dev.value = value;
+}
+
+static unsigned dev_read_8(void* d, unsigned address)
+{
+	note(d, 1, address, 0);
+	return 0x5a;
+}
+
+static unsigned dev_read_32(void* d, unsigned address)
+{
+	note(d, 4, address, 0);
+	return address ^ 0xdeadbeef;
+}
+
+static void dev_write_8(void* d, unsigned address, unsigned value)
+{
+	note(d, 1, address, value);
+}
+
+static void dev_write_16(void* d, unsigned address, unsigned value)
+{
+	note(d, 2, address, value);
+}
+
+static void dev_write_32(void* d, unsigned address, unsigned value)
+{
+	note(d, 4, address, value);
+}
+
+static const m68k_region region =
+{
+	&dev,
+	dev_read_8, NULL, dev_read_32,
+	dev_write_8, dev_write_16, dev_write_32
+};
+
+/* Run an instruction from a known state */
+static void step(unsigned short w0, unsigned short w1, unsigned short w2)
+{
+	int r;
+
+	host_poke_16(0x400, w0);
+	host_poke_16(0x402, w1);
+	host_poke_16(0x404, w2);
+	m68k_pulse_reset();
+	m68k_step();
+	for(r = 0; r < 8; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0x11223344 * (r + 1));
+	dev.calls = 0;
+	host_watch_count = 0;
+	m68k_step();
+}
+
+int main(void)
+{
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	host_poke_32(DEVICE + 8, 0xcafef00d);
+	host_poke_16(DEVICE + 2, 0x1357);
+	shadow[0] = 0x24;
+	shadow[1] = 0x68;
+	host_watch_start = DEVICE;
+	host_watch_end = SHADOW + PAGE_SIZE;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_map_memory(0, 0x10000, host_memory(), M68K_MAP_RW);
+	m68k_map_memory(SHADOW, PAGE_SIZE, shadow, M68K_MAP_READ);
+	host_check(m68k_map_region(DEVICE, 2 * PAGE_SIZE, &region), "a region is mapped");
+	host_check(!m68k_map_region(DEVICE + 2, PAGE_SIZE, &region), "a region must be page aligned");
+
+	step(0x13c0, 0x0002, 0x0001);     /* move.b d0, $20001 */
+	host_check(dev.calls == 1 && dev.size == 1 && dev.address == DEVICE + 1 && dev.value == 0x44
+			&& host_watch_count == 0, "a byte write goes to the byte handler");
+
+	step(0x23c2, 0x0002, 0x0004);     /* move.l d2, $20004 */
+	host_check(dev.calls == 1 && dev.size == 4 && dev.address == DEVICE + 4 && dev.value == 0x336699cc
+			&& host_watch_count == 0, "a long word write goes to the long word handler");
+
+	step(0x1839, 0x0002, 0x0000);     /* move.b $20000, d4 */
+	host_check(dev.calls == 1 && m68k_get_reg(NULL, M68K_REG_D4) == 0x55ab005a,
+			"a byte read comes from the byte handler");
+
+	step(0x2639, 0x0002, 0x0008);     /* move.l $20008, d3 */
+	host_check(dev.calls == 1 && m68k_get_reg(NULL, M68K_REG_D3) == ((DEVICE + 8) ^ 0xdeadbeef),
+			"a long word read comes from the long word handler");
+
+	step(0x3239, 0x0002, 0x0002);     /* move.w $20002, d1 */
+	host_check(dev.calls == 0 && host_watch_count == 1 && (m68k_get_reg(NULL, M68K_REG_D1) & 0xffff) == 0x1357,
+			"a NULL handler leaves the access to the callbacks");
+
+	step(0x3c39, 0x0002, 0x1000);     /* move.w $21000, d6 */
+	host_check(dev.calls == 0 && host_watch_count == 0 && (m68k_get_reg(NULL, M68K_REG_D6) & 0xffff) == 0x2468,
+			"reads of memory mapped for reading don't go to the region");
+
+	step(0x33c5, 0x0002, 0x1000);     /* move.w d5, $21000 */
+	host_check(dev.calls == 1 && dev.size == 2 && dev.address == SHADOW && dev.value == 0x3398
+			&& shadow[0] == 0x24, "writes to memory mapped only for reading go to the region");
+
+	host_check(!dev.wrong_device, "the handlers get the device");
+
+	m68k_map_region(DEVICE, PAGE_SIZE, NULL);
+	step(0x2639, 0x0002, 0x0008);     /* move.l $20008, d3 */
+	host_check(dev.calls == 0 && host_watch_count == 1 && m68k_get_reg(NULL, M68K_REG_D3) == 0xcafef00d,
+			"an unmapped region is left to the callbacks");
+
+	return host_result();
+}
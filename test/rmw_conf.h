@@ -0,0 +1,6 @@
+/* Configuration for rmw_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_RMW_CALLBACKS
+#define M68K_RMW_CALLBACKS OPT_ON
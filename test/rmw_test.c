@@ -0,0 +1,104 @@
+/* M68K_RMW_CALLBACKS: instructions that modify a memory operand in place
+ * make one read-modify-write callback for it, which writes back only when
+ * told to, instead of a read callback and a write callback
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define DATA 0x2000
+
+static unsigned calls[5];
+static unsigned writes;
+
+/* Carry out one read-modify-write of SIZE bytes on the host RAM */
+static void rmw(unsigned address, unsigned size, int (*modify)(unsigned* value, void* context), void* context)
+{
+	unsigned value;
+
+	calls[size]++;
+	if(size == 1)
+		value = host_peek_16(address) >> 8;
+	else if(size == 2)
+		value = host_peek_16(address);
+	else
+		value = host_peek_32(address);
+
+	if(!modify(&value, context))
+		return;
+	writes++;
+	if(size == 1)
+		host_poke_16(address, (value << 8) | (host_peek_16(address) & 0xff));
+	else if(size == 2)
+		host_poke_16(address, value);
+	else
+		host_poke_32(address, value);
+}
+
+void m68k_rmw_memory_8(M68K_USER_PARAM unsigned address, int (*modify)(unsigned* value, void* context), void* context)
+{
+	rmw(address, 1, modify, context);
+}
+
+void m68k_rmw_memory_16(M68K_USER_PARAM unsigned address, int (*modify)(unsigned* value, void* context), void* context)
+{
+	rmw(address, 2, modify, context);
+}
+
+void m68k_rmw_memory_32(M68K_USER_PARAM unsigned address, int (*modify)(unsigned* value, void* context), void* context)
+{
+	rmw(address, 4, modify, context);
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x5690,                 /* addq.l #3, (a0) */
+		0x4ad1,                 /* tas (a1) */
+		0x05d2,                 /* bset d2, (a2) */
+		0x4453,                 /* neg.w (a3) */
+		0x0ed4, 0x0040,         /* cas.l d0, d1, (a4) */
+		0x0ed5, 0x0040,         /* cas.l d0, d1, (a5) */
+		0x60fe                  /* bra.s * */
+	};
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+	host_poke_32(DATA + 0x00, 0x7ffffffe);
+	host_poke_16(DATA + 0x10, 0x0512);
+	host_poke_16(DATA + 0x20, 0x0100);
+	host_poke_16(DATA + 0x30, 0x0001);
+	host_poke_32(DATA + 0x40, 0x12345678);
+	host_poke_32(DATA + 0x50, 0x9abcdef0);
+	host_watch_start = DATA;
+	host_watch_end = DATA + 0x100;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68020);
+	m68k_pulse_reset();
+	m68k_step();
+	m68k_set_reg(M68K_REG_D0, 0x12345678);
+	m68k_set_reg(M68K_REG_D1, 0xcafef00d);
+	m68k_set_reg(M68K_REG_D2, 4);
+	for(i = 0; i < 6; i++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_A0 + i), DATA + i * 0x10);
+	m68k_execute(1000);
+
+	host_check(host_peek_32(DATA + 0x00) == 0x80000001, "addq adds to the operand");
+	host_check(host_peek_16(DATA + 0x10) == 0x8512, "tas sets bit 7 of the operand byte alone");
+	host_check(host_peek_16(DATA + 0x20) == 0x1100, "bset sets the bit");
+	host_check(host_peek_16(DATA + 0x30) == 0xffff, "neg negates the operand");
+	host_check(host_peek_32(DATA + 0x40) == 0xcafef00d, "a matching cas stores the update");
+	host_check(host_peek_32(DATA + 0x50) == 0x9abcdef0, "a failed cas leaves the operand alone");
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 0x9abcdef0, "a failed cas loads the compare register");
+	host_check(calls[1] == 2 && calls[2] == 1 && calls[4] == 3, "each operand takes one callback of its size");
+	host_check(writes == 5, "the callback writes back only when told to");
+	host_check(host_watch_count == 0, "the operands don't go through the read and write callbacks");
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for rollback_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_EMULATE_TRACE
+#define M68K_EMULATE_TRACE OPT_ON
@@ -0,0 +1,46 @@
+/* A bus error puts the data and address registers back the way they were at
+ * the start of the instruction, also when it is taken while stacking the
+ * trace exception of an instruction that has finished
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+int main(void)
+{
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	host_poke_32(0x008, 0x500);       /* Bus error vector */
+	host_poke_16(0x400, 0x2218);      /* move.l (a0)+, d1 */
+	host_poke_16(0x402, 0x7005);      /* moveq #5, d0 */
+	host_poke_16(0x500, 0x4e71);      /* nop */
+	host_bus_error_start = 0xe00000;
+	host_bus_error_end = 0xf00000;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	m68k_step(); /* The reset */
+
+	m68k_set_reg(M68K_REG_A0, 0xe00000);
+	m68k_set_reg(M68K_REG_D1, 0x1111);
+	m68k_step();
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == 0x500, "bus error taken");
+	host_check(m68k_get_reg(NULL, M68K_REG_A0) == 0xe00000, "postincrement rolled back");
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 0x1111, "destination left alone");
+
+	/* Trace the moveq with the stack in the bus error window, so that
+	 * stacking the trace exception faults (and then halts the CPU)
+	 */
+	m68k_pulse_reset();
+	m68k_step();
+	m68k_set_reg(M68K_REG_PC, 0x402);
+	m68k_set_reg(M68K_REG_SR, 0xa700);
+	m68k_set_reg(M68K_REG_SP, 0xe00100);
+	m68k_set_reg(M68K_REG_D0, 0x12345678);
+	m68k_step();
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 0x12345678, "traced instruction rolled back");
+
+	return host_result();
+}
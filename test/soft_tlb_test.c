@@ -0,0 +1,117 @@
+/* M68K_PMMU_ATC with M68K_MEMORY_MAP: translated accesses to mapped memory
+ * go through the ATC entry straight to the host memory behind the physical
+ * page, accesses to memory that isn't mapped still reach the callbacks, and
+ * remapping memory drops the host pointers the ATC held
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define ROOT_TABLE    0x10000
+#define POINTER_TABLE 0x10200
+#define LOW_PAGES     0x10400  /* Maps 0x00000-0x3ffff to itself */
+#define HIGH_PAGES    0x10500  /* Maps 0x40000-0x7ffff */
+#define RAM_PAGE      0x20000  /* Physical pages behind 0x40000, 0x41000 and 0x42000 */
+#define UNMAPPED_PAGE 0x80000
+#define OTHER_PAGE    0x90000
+#define PAGE_SIZE     0x1000
+
+static unsigned char other[PAGE_SIZE];
+static unsigned char remapped[PAGE_SIZE];
+
+static unsigned peek_32(const unsigned char* p)
+{
+	return (unsigned)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static unsigned poke_code(unsigned address, const unsigned short* code, int words)
+{
+	int i;
+
+	for(i = 0; i < words; i++)
+		host_poke_16(address + i*2, code[i]);
+	return address + words*2;
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x203c, ROOT_TABLE >> 16, ROOT_TABLE & 0xffff, /* move.l #ROOT_TABLE, d0 */
+		0x4e7b, 0x0806,                                /* movec d0, urp */
+		0x4e7b, 0x0807,                                /* movec d0, srp */
+		0x4e7b, 0x7003,                                /* movec d7, tc */
+		0xf518,                                        /* pflusha */
+		0x207c, 0x0004, 0x0010,                        /* movea.l #$40010, a0 */
+		0x227c, 0x0004, 0x1010,                        /* movea.l #$41010, a1 */
+		0x247c, 0x0004, 0x2010,                        /* movea.l #$42010, a2 */
+		0x2210,                                        /* move.l (a0), d1 */
+		0x2146, 0x0004,                                /* move.l d6, 4(a0) */
+		0x2411,                                        /* move.l (a1), d2 */
+		0x2612,                                        /* move.l (a2), d3 */
+		0x2546, 0x0004,                                /* move.l d6, 4(a2) */
+		0x7863,                                        /* moveq #99, d4 */
+		0xda90,                                        /* loop: add.l (a0), d5 */
+		0x51cc, 0xfffc,                                /* dbf d4, loop */
+		0x60fe,                                        /* bra.s * */
+	};
+	static const unsigned short reread[] =
+	{
+		0x2612,                                        /* move.l (a2), d3 */
+		0x60fe,                                        /* bra.s * */
+	};
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned end;
+	int i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	end = poke_code(0x400, program, sizeof(program) / sizeof(program[0])) - 2;
+	poke_code(0x600, reread, sizeof(reread) / sizeof(reread[0]));
+
+	host_poke_32(ROOT_TABLE, POINTER_TABLE | 2);
+	host_poke_32(POINTER_TABLE, LOW_PAGES | 2);
+	host_poke_32(POINTER_TABLE + 4, HIGH_PAGES | 2);
+	for(i = 0; i < 64; i++)
+		host_poke_32(LOW_PAGES + i*4, (i << 12) | 1);
+	host_poke_32(HIGH_PAGES + 0, RAM_PAGE | 1);
+	host_poke_32(HIGH_PAGES + 4, UNMAPPED_PAGE | 1);
+	host_poke_32(HIGH_PAGES + 8, OTHER_PAGE | 1);
+	host_poke_32(RAM_PAGE + 0x10, 0x11111111);
+	host_poke_32(UNMAPPED_PAGE + 0x10, 0x22222222);
+	other[0x10] = other[0x11] = other[0x12] = other[0x13] = 0x33;
+	remapped[0x10] = remapped[0x11] = remapped[0x12] = remapped[0x13] = 0x44;
+	host_watch_start = UNMAPPED_PAGE;
+	host_watch_end = UNMAPPED_PAGE + PAGE_SIZE;
+
+	m68k_init();
+	m68k_map_memory(0, 0x40000, host_memory(), M68K_MAP_RW);
+	m68k_map_memory(OTHER_PAGE, PAGE_SIZE, other, M68K_MAP_RW);
+	m68k_set_cpu_type(M68K_CPU_TYPE_68040);
+	m68k_pulse_reset();
+	m68k_set_reg(M68K_REG_D5, 0);
+	m68k_set_reg(M68K_REG_D6, 0xcafef00d);
+	m68k_set_reg(M68K_REG_D7, 0x8000);
+	for(i = 0; i < 1000 && m68k_get_reg(NULL, M68K_REG_PC) != end; i++)
+		m68k_step();
+	m68k_get_atc_stats(&hits, &misses);
+
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == end, "program ran to the end");
+	host_check(m68k_get_reg(NULL, M68K_REG_D1) == 0x11111111, "a translated read comes from the mapped page");
+	host_check(host_peek_32(RAM_PAGE + 0x14) == 0xcafef00d, "a translated write lands in the mapped page");
+	host_check(m68k_get_reg(NULL, M68K_REG_D2) == 0x22222222 && host_watch_count == 1,
+			"memory that isn't mapped goes to the callbacks");
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == 0x33333333 && peek_32(other + 0x14) == 0xcafef00d,
+			"each page reaches the host memory behind its physical page");
+	host_check(m68k_get_reg(NULL, M68K_REG_D5) == 100 * 0x11111111u, "repeated reads see the same memory");
+	host_check(hits > 100 && misses < 20, "translations are found in the ATC");
+
+	m68k_map_memory(OTHER_PAGE, PAGE_SIZE, remapped, M68K_MAP_RW);
+	m68k_set_reg(M68K_REG_PC, 0x600);
+	m68k_step();
+	host_check(m68k_get_reg(NULL, M68K_REG_D3) == 0x44444444, "remapping memory drops the ATC's host pointers");
+
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for specialize_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_SPECIALIZE_CPU
+#define M68K_SPECIALIZE_CPU OPT_ON
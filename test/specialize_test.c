@@ -0,0 +1,69 @@
+/* M68K_SPECIALIZE_CPU: the handler set of each CPU family takes exactly as
+ * many clocks as the generic handlers, for the instructions whose timing
+ * m68k_set_cpu_type() sets up separately from the cycle tables
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+#define CPU_TYPES 5
+#define INSTRUCTIONS 11
+
+static const unsigned short program[] =
+{
+	0x7000,                 /* moveq #0, d0 */
+	0x6602,                 /* bne.s (not taken) */
+	0x6600, 0x0002,         /* bne.w (not taken) */
+	0x7201,                 /* moveq #1, d1 */
+	0x51c9, 0x0002,         /* dbf d1, next (taken) */
+	0x51c9, 0x0002,         /* dbf d1, next (expired) */
+	0x50c2,                 /* st d2 */
+	0x48a7, 0xc000,         /* movem.w d0-d1, -(sp) */
+	0x48e7, 0xc000,         /* movem.l d0-d1, -(sp) */
+	0xe78b,                 /* lsl.l #3, d3 */
+	0x4e70                  /* reset */
+};
+
+/* Clocks taken by each instruction of program[], as timed by the generic
+ * handlers
+ */
+static const struct
+{
+	unsigned type;
+	const char* name;
+	int cycles[INSTRUCTIONS];
+} cpus[CPU_TYPES] =
+{
+	{M68K_CPU_TYPE_68000, "68000", {4, 8, 12, 4, 10, 14, 6, 16, 24, 20, 132}},
+	{M68K_CPU_TYPE_68010, "68010", {4, 6, 10, 4, 12, 18, 4, 16, 24, 20, 130}},
+	{M68K_CPU_TYPE_68020, "68020", {2, 4, 6, 2, 6, 10, 4, 12, 12, 7, 518}},
+	{M68K_CPU_TYPE_68030, "68030", {2, 4, 6, 2, 6, 10, 4, 12, 12, 7, 518}},
+	{M68K_CPU_TYPE_68040, "68040", {2, 4, 6, 2, 6, 10, 4, 12, 12, 7, 518}}
+};
+
+int main(void)
+{
+	char what[80];
+	unsigned i;
+	int cpu;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+
+	m68k_init();
+	for(cpu = 0; cpu < CPU_TYPES; cpu++)
+	{
+		m68k_set_cpu_type(cpus[cpu].type);
+		m68k_pulse_reset();
+		m68k_step(); /* The reset */
+		for(i = 0; i < INSTRUCTIONS; i++)
+			if(m68k_step() != cpus[cpu].cycles[i])
+				break;
+		sprintf(what, "%s handler set times the program like the generic handlers", cpus[cpu].name);
+		host_check(i == INSTRUCTIONS, what);
+	}
+	return host_result();
+}
@@ -0,0 +1,6 @@
+/* Configuration for static_code_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_STATIC_CODE
+#define M68K_STATIC_CODE OPT_ON
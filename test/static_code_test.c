@@ -0,0 +1,158 @@
+/* M68K_STATIC_CODE: a ROM recompiled by m68krec runs just as it does when
+ * interpreted, and a write to the ROM by the CPU or
+ * m68k_invalidate_block_cache() turns the recompiled code off.
+ *
+ * Built with WRITE_ROM defined, this writes the ROM image for m68krec
+ * instead (see the Makefile).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "m68k.h"
+#include "host.h"
+
+#define ROM_START   0x400
+#define ROM_END     0x42a   /* bra.s * */
+#define SUBROUTINE  0x440
+#define DATA        0x10000
+#define SLICES      40
+#define SLICE       333
+
+static const unsigned short rom[] =
+{
+	0x41f9, 0x0001, 0x0000, /*       lea $10000, a0 */
+	0x7000,                 /*       moveq #0, d0 */
+	0x7200,                 /*       moveq #0, d1 */
+	0x343c, 0x00c7,         /*       move.w #199, d2 */
+	0xd282,                 /* loop: add.l d2, d1 */
+	0x20c1,                 /*       move.l d1, (a0)+ */
+	0xb383,                 /*       eor.l d1, d3 */
+	0xe28b,                 /*       lsr.l #1, d3 */
+	0x51ca, 0xfff6,         /*       dbf d2, loop */
+	0x4eb8, 0x0440,         /*       jsr $440.w */
+	0x2800,                 /*       move.l d0, d4 */
+	0x31fc, 0x7003, 0x0440, /*       move.w #$7003, $440.w */
+	0x4eb8, 0x0440,         /*       jsr $440.w */
+	0x60fe,                 /*       bra.s * */
+	0x4e71, 0x4e71, 0x4e71, 0x4e71, 0x4e71,
+	0x4e71, 0x4e71, 0x4e71, 0x4e71, 0x4e71,
+	0x7001,                 /* $440: moveq #1, d0 */
+	0x4e75                  /*       rts */
+};
+
+#define ROM_SIZE    (sizeof(rom))
+
+#ifdef WRITE_ROM
+
+int main(int argc, char** argv)
+{
+	FILE* filep;
+	unsigned i;
+
+	if(argc != 2 || (filep = fopen(argv[1], "wb")) == NULL)
+		return 1;
+	for(i = 0; i < sizeof(rom) / sizeof(*rom); i++)
+	{
+		fputc(rom[i] >> 8, filep);
+		fputc(rom[i] & 0xff, filep);
+	}
+	return fclose(filep) != 0;
+}
+
+#else
+
+/* From static_code_rom.c, written by m68krec */
+int m68krec_execute(unsigned pc);
+void m68krec_install(void);
+
+/* Everything compared between the two runs, after each slice */
+typedef struct
+{
+	unsigned regs[SLICES][18];
+	int cycles[SLICES];
+	unsigned data[200];
+} state;
+
+static int blocks_run;
+
+static int counted_execute(unsigned pc)
+{
+	int ran = m68krec_execute(pc);
+
+	blocks_run += ran;
+	return ran;
+}
+
+static void load_rom(void)
+{
+	unsigned i;
+
+	for(i = 0; i < sizeof(rom) / sizeof(*rom); i++)
+		host_poke_16(ROM_START + i*2, rom[i]);
+}
+
+/* Run the ROM from reset in slices, with or without the recompiled code */
+static void run(state* s, int recompiled)
+{
+	int i;
+	int r;
+
+	load_rom();
+	m68k_set_static_code(ROM_START, ROM_SIZE, recompiled ? counted_execute : NULL);
+	m68k_pulse_reset();
+	for(r = 0; r < 8; r++)
+		m68k_set_reg((m68k_register_t)(M68K_REG_D0 + r), 0);
+	blocks_run = 0;
+	for(i = 0; i < SLICES; i++)
+	{
+		s->cycles[i] = m68k_execute(SLICE);
+		for(r = 0; r < 16; r++)
+			s->regs[i][r] = m68k_get_reg(NULL, (m68k_register_t)(M68K_REG_D0 + r));
+		s->regs[i][16] = m68k_get_reg(NULL, M68K_REG_PC);
+		s->regs[i][17] = m68k_get_reg(NULL, M68K_REG_SR);
+	}
+	for(i = 0; i < 200; i++)
+		s->data[i] = host_peek_32(DATA + i*4);
+}
+
+int main(void)
+{
+	static state recompiled;
+	static state interpreted;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, ROM_START);   /* Initial PC */
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+
+	run(&interpreted, 0);
+	run(&recompiled, 1);
+	host_check(blocks_run > 0, "the recompiled code is run");
+	host_check(recompiled.regs[SLICES-1][16] == ROM_END, "the ROM runs to the end");
+	host_check(memcmp(&recompiled, &interpreted, sizeof(recompiled)) == 0,
+			"registers, clocks and memory are the same as when interpreted");
+	host_check(m68k_get_reg(NULL, M68K_REG_D4) == 1 && m68k_get_reg(NULL, M68K_REG_D0) == 3,
+			"a CPU write to the ROM turns the recompiled code off");
+
+	/* m68krec_install() turns it back on, and m68k_invalidate_block_cache()
+	 * off again
+	 */
+	load_rom();
+	m68krec_install();
+	m68k_pulse_reset();
+	m68k_execute(SLICES * SLICE);
+	host_check(m68k_get_reg(NULL, M68K_REG_D0) == 3, "m68krec_install() runs the ROM");
+
+	load_rom();
+	m68k_set_static_code(ROM_START, ROM_SIZE, counted_execute);
+	m68k_invalidate_block_cache(SUBROUTINE, 2);
+	m68k_pulse_reset();
+	blocks_run = 0;
+	m68k_execute(SLICES * SLICE);
+	host_check(blocks_run == 0, "m68k_invalidate_block_cache() turns the recompiled code off");
+
+	return host_result();
+}
+
+#endif /* WRITE_ROM */
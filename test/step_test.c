@@ -0,0 +1,36 @@
+/* m68k_step() runs exactly one instruction, even when it takes a bus error */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+int main(void)
+{
+	int cycles;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	host_poke_32(0x008, 0x500);       /* Bus error vector */
+	host_poke_16(0x400, 0x81f9);      /* divs.w $e00000.l, d0 */
+	host_poke_32(0x402, 0xe00000);
+	host_poke_16(0x500, 0x4e71);      /* nop */
+	host_poke_16(0x502, 0x4e71);      /* nop */
+	host_bus_error_start = 0xe00000;
+	host_bus_error_end = 0xf00000;
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_pulse_reset();
+	m68k_step(); /* The reset */
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == 0x400, "reset");
+
+	cycles = m68k_step();
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == 0x500, "bus error stops at the handler");
+	host_check(cycles >= 0, "bus error doesn't return negative cycles");
+
+	cycles = m68k_step();
+	host_check(m68k_get_reg(NULL, M68K_REG_PC) == 0x502, "next step runs one instruction of the handler");
+	host_check(cycles == 4, "nop takes 4 cycles");
+
+	return host_result();
+}
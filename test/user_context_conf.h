@@ -0,0 +1,16 @@
+/* Configuration for user_context_test.c */
+
+#include "m68kconf.h"
+
+#undef M68K_USER_CONTEXT
+#define M68K_USER_CONTEXT OPT_ON
+
+#undef M68K_EMULATE_RESET
+#define M68K_EMULATE_RESET OPT_ON
+
+#undef M68K_EMULATE_INT_ACK
+#define M68K_EMULATE_INT_ACK OPT_SPECIFY_HANDLER
+#undef M68K_INT_ACK_CALLBACK
+#define M68K_INT_ACK_CALLBACK(U, A) test_int_ack(U, A)
+
+int test_int_ack(void* user, int int_level);
@@ -0,0 +1,73 @@
+/* M68K_USER_CONTEXT: the memory functions, the callbacks set at run time
+ * and the handlers named with OPT_SPECIFY_HANDLER all get the user context
+ * of the CPU that is running
+ */
+
+#include <stdio.h>
+#include "m68k.h"
+#include "host.h"
+
+static void* reset_user;
+static void* int_ack_user;
+
+static void reset_instr(void* user)
+{
+	reset_user = user;
+}
+
+int test_int_ack(void* user, int int_level)
+{
+	(void)int_level;
+	int_ack_user = user;
+	return M68K_INT_ACK_AUTOVECTOR;
+}
+
+/* Run the program and the interrupt for the machine at USER, and report if
+ * every callback got USER
+ */
+static int run(void* user)
+{
+	reset_user = int_ack_user = host_user = NULL;
+
+	m68k_set_user_context(user);
+	m68k_pulse_reset();
+	m68k_execute(1000);
+	if(host_user != user)
+		return 0;
+	m68k_set_irq(1);
+	m68k_execute(1000);
+	m68k_set_irq(0);
+	return reset_user == user && int_ack_user == user && host_user == user
+		&& m68k_get_reg(NULL, M68K_REG_PC) == 0x600;
+}
+
+int main(void)
+{
+	static const unsigned short program[] =
+	{
+		0x46fc, 0x2000,         /* move #$2000, sr */
+		0x4e70,                 /* reset */
+		0x21c0, 0x2000,         /* move.l d0, $2000.w */
+		0x60fe                  /* bra.s * */
+	};
+	static int machine_a;
+	static int machine_b;
+	unsigned i;
+
+	host_poke_32(0x000, 0x1000);      /* Initial SSP */
+	host_poke_32(0x004, 0x400);       /* Initial PC */
+	host_poke_32(0x064, 0x600);       /* Level 1 autovector */
+	for(i = 0; i < sizeof(program) / sizeof(*program); i++)
+		host_poke_16(0x400 + i*2, program[i]);
+	host_poke_16(0x600, 0x60fe);      /* bra.s * */
+
+	m68k_init();
+	m68k_set_cpu_type(M68K_CPU_TYPE_68000);
+	m68k_set_reset_instr_callback(reset_instr);
+
+	host_check(run(&machine_a), "every callback gets the user context");
+	host_check(run(&machine_b), "every callback gets a new user context");
+	host_check(m68k_get_user_context() == &machine_b, "the user context can be read back");
+
+	return host_result();
+}